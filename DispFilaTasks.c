@@ -17,6 +17,21 @@
 #include "lib/ssd1306.h"
 #include "final.pio.h"
 #include "lib/font.h"
+#include "lib/flash_log.h"
+#include "lib/captura.h"
+#include "lib/telemetria.h"
+#include "lib/tlog.h"
+#include "lib/painel.h"
+#include "lib/config.h"
+#include "lib/config_flash.h"
+#include "lib/calibracao.h"
+#include "lib/em_ram.h"
+#include "lib/medir.h"
+#include "lib/relogio.h"
+#include "lib/shell.h"
+#include "lib/mqtt.h"
+#include "lib/http.h"
+#include "lib/modbus.h"
 #include "FreeRTOS.h"
 #include "queue.h"
 #include "task.h"
@@ -36,11 +51,15 @@
 #define BUZZER 21
 #define LED_MATRIX_PIN 7
 
-#define LIMIAR_AGUA 70.0f
-#define LIMIAR_CHUVA 80.0f
-
 #define NUM_LEDS 25
 
+// Uma amostra a cada FLASH_LOG_DECIMACAO leituras vai para o log em flash,
+// comprimida com serie_comp; transicoes de alerta sao sempre registradas.
+#define FLASH_LOG_DECIMACAO 10
+
+// Amostras do anel de captura usadas na media de cada leitura
+#define AMOSTRAS_MEDIA 64
+
 // -------------------- Structs --------------------
 // Estrutura para armazenar os dados lidos dos sensores simulados
 typedef struct {
@@ -53,28 +72,84 @@ typedef struct {
 // Fila global para troca de dados entre as tarefas
 QueueHandle_t xQueueSensores;
 
+// -------------------- Log em flash --------------------
+// Amostras periódicas são comprimidas incrementalmente; cada bloco cheio
+// (ou mais velho que FLASH_LOG_DESCARGA_MS) vira uma página do log.
+static uint8_t bloco_serie[REGISTRO_LOG_TAMANHO_DADOS];
+static serie_comp_t serie;
+static uint32_t inicio_bloco_ms;
+
 // -------------------- Prototipos --------------------
 void vJoystickTask(void *params);
 void vDisplayTask(void *params);
 void vLedRgbTask(void *params);
 void vBuzzerTask(void *params);
 void vMatrizLedTask(void *params);
+static void registrar_alerta_no_log(uint16_t nivel_c, uint16_t chuva_c, bool alerta);
+static void registrar_amostra_no_log(uint16_t nivel_c, uint16_t chuva_c);
+static bool gravar_captura(const void *bloco, size_t tamanho, uint16_t amostras);
+static void enviar_telemetria(tipo_telemetria_t tipo, uint16_t nivel_c, uint16_t chuva_c, bool alerta);
+static void enviar_contadores(void);
+static void publicar_estado(uint16_t nivel_c, uint16_t chuva_c, bool alerta, uint32_t alertas,
+                            uint32_t leituras, const config_estacao_t *config);
+static bool avaliar_alerta(uint16_t nivel_c, uint16_t chuva_c, const config_estacao_t *config);
+static void buzzer_nivel(uint slice, uint16_t nivel);
+static void matriz_preencher(uint32_t cor);
+static void ajustar_display(uint32_t hz);
+static void ajustar_buzzer(uint32_t hz);
+static void ajustar_matriz(uint32_t hz);
 
 // -------------------- Main --------------------
 int main() {
     stdio_init_all();
 
+    // Limiares, periodos e padroes de saida ajustaveis pelo shell USB; a
+    // ultima configuracao salva e copiada direto da flash (sem parsing)
+    config_init();
+    config_flash_carregar();
+    calibracao_init();
+
     // Criação da fila para comunicação entre tarefas
     // Capacidade: 5 elementos do tipo dados_sensor_t
     xQueueSensores = xQueueCreate(5, sizeof(dados_sensor_t));
 
+    // Recupera a posicao do log circular em flash (busca binaria, rapida)
+    flash_log_init();
+
+    // Clock em economia; sobe durante alertas e capturas (vRelogioTask)
+    relogio_init();
+
+    // ADC em aquisicao continua por DMA; as janelas de disparo vao para o log
+    captura_init(gravar_captura);
+    relogio_registrar(captura_ajustar_relogio);
+
+    // Telemetria binaria (COBS + CRC) pelo CDC da USB
+    telemetria_init();
+
+    // Lotes e alertas para o broker MQTT pelo Wi-Fi
+    mqtt_init();
+
+    // Retrato JSON do estado para o navegador do tecnico (HTTP e SSE)
+    http_init();
+
+    // Registradores para o SCADA: Modbus RTU no RS-485 e Modbus TCP
+    modbus_init();
+
     // Criação das tarefas do FreeRTOS
     // Cada tarefa recebe um ponteiro para função, nome, tamanho da stack, parâmetros, prioridade e handle
     xTaskCreate(vJoystickTask, "Joystick", 256, NULL, 1, NULL);
-    xTaskCreate(vDisplayTask, "Display", 512, NULL, 1, NULL);
+    xTaskCreate(vDisplayTask, "Display", 256, NULL, 1, NULL); // sem printf, a pilha cabe em 1 KB
     xTaskCreate(vLedRgbTask, "LED RGB", 256, NULL, 1, NULL);
     xTaskCreate(vBuzzerTask, "Buzzer", 256, NULL, 1, NULL);
     xTaskCreate(vMatrizLedTask, "Matriz", 256, NULL, 1, NULL); // opcional
+    xTaskCreate(vFlashLogTask, "FlashLog", 256, NULL, 1, NULL);
+    xTaskCreate(vCapturaTask, "Captura", 256, NULL, 2, NULL); // precisa copiar a janela antes do anel dar a volta
+    xTaskCreate(vTelemetriaTask, "Telemetria", 256, NULL, 1, NULL);
+    xTaskCreate(vShellTask, "Shell", 256, NULL, tskIDLE_PRIORITY, NULL); // so roda com a CPU ociosa
+    xTaskCreate(vRelogioTask, "Relogio", 256, NULL, 2, NULL); // troca de clock sem esperar a leitura
+    xTaskCreate(vMqttTask, "MQTT", 512, NULL, 1, NULL); // pilha para o driver do CYW43
+    xTaskCreate(vHttpTask, "HTTP", 512, NULL, 1, NULL); // tcp_output chega ao driver do CYW43
+    xTaskCreate(vModbusTask, "Modbus", 512, NULL, 2, NULL); // acorda pela UART; o FIN das ociosas passa pelo CYW43
 
     // Inicia o escalonador do FreeRTOS
     vTaskStartScheduler();
@@ -84,24 +159,40 @@ int main() {
 
 // -------------------- Tarefa: Leitura Joystick --------------------
 // Esta tarefa simula a leitura dos sensores de nível de água e chuva usando ADC.
-// Os valores lidos são convertidos em porcentagem e enviados para a fila.
-// Se algum valor ultrapassar o limiar, o campo 'alerta' é ativado.
+// O ADC é amostrado continuamente por DMA (captura.c); cada leitura é a média
+// das amostras mais recentes. Os valores são convertidos em porcentagem pela
+// tabela de calibracao do canal (calibracao.c) e
+// enviados para a fila. Se algum valor ultrapassar o limiar, o campo 'alerta' é ativado.
 void vJoystickTask(void *params) {
-    adc_init();
-    adc_gpio_init(ADC_NIVEL_AGUA);
-    adc_gpio_init(ADC_VOLUME_CHUVA);
+    bool alerta_anterior = false;
+    uint32_t leituras = 0;
+    uint32_t alertas = 0;
+    config_estacao_t config;
+    serie_comp_iniciar(&serie, bloco_serie, sizeof(bloco_serie));
 
     while (true) {
-        adc_select_input(0); // ADC0 - Y
-        uint16_t raw_y = adc_read();
-        float nivel = (raw_y / 4095.0f) * 100.0f;
+        medir_desde_tick(MEDIDA_DESPERTAR); // acabou de sair do vTaskDelay
+        relogio_amostrar_latencia();
+
+        // Copia da configuracao valida para todo o ciclo
+        config_obter(&config);
+
+        medir_preparar();
+        uint32_t inicio_leitura = medir_inicio();
 
-        adc_select_input(1); // ADC1 - X
-        uint16_t raw_x = adc_read();
-        float chuva = (raw_x / 4095.0f) * 100.0f;
+        // Contagens convertidas pela tabela de calibracao de cada canal
+        uint16_t raw_y = captura_media(0, AMOSTRAS_MEDIA); // ADC0 - Y
+        uint16_t nivel_c = calibracao_aplicar(0, raw_y);   // centesimos de %
+
+        uint16_t raw_x = captura_media(1, AMOSTRAS_MEDIA); // ADC1 - X
+        uint16_t chuva_c = calibracao_aplicar(1, raw_x);
 
         // Verifica se algum valor ultrapassou o limiar
-        bool alerta = (nivel >= LIMIAR_AGUA || chuva >= LIMIAR_CHUVA);
+        bool alerta = avaliar_alerta(nivel_c, chuva_c, &config);
+        medir_fim(MEDIDA_LEITURA, inicio_leitura);
+
+        float nivel = nivel_c / 100.0f;
+        float chuva = chuva_c / 100.0f;
 
         // Preenche a struct com os dados lidos
         dados_sensor_t dados = {
@@ -112,8 +203,134 @@ void vJoystickTask(void *params) {
 
         // Envia os dados para a fila (não bloqueante)
         xQueueSend(xQueueSensores, &dados, 0);
-        vTaskDelay(pdMS_TO_TICKS(100)); // Aguarda 100ms
+
+        // Telemetria e log em flash apenas copiam para RAM; o envio e a
+        // gravação ficam com vTelemetriaTask e vFlashLogTask. Vão os mesmos
+        // centésimos que decidiram o alerta: o host reavalia os limiares
+        // sobre eles e chega ao mesmo resultado
+        enviar_telemetria(TELEMETRIA_AMOSTRA, nivel_c, chuva_c, alerta);
+        mqtt_amostra(nivel_c, chuva_c, alerta, config.mqtt_lote);
+        if (alerta != alerta_anterior) {
+            captura_disparar();
+            registrar_alerta_no_log(nivel_c, chuva_c, alerta);
+            enviar_telemetria(TELEMETRIA_ALERTA, nivel_c, chuva_c, alerta);
+            mqtt_alerta(nivel_c, chuva_c, alerta);
+            TLOG("alerta=%u nivel=%u chuva=%u (centesimos)", alerta, nivel_c, chuva_c);
+            relogio_pedir(RELOGIO_MOTIVO_ALERTA, alerta);
+            alerta_anterior = alerta;
+            alertas += alerta;
+        }
+        publicar_estado(nivel_c, chuva_c, alerta, alertas, ++leituras, &config);
+        if (leituras % FLASH_LOG_DECIMACAO == 0) {
+            registrar_amostra_no_log(nivel_c, chuva_c);
+            enviar_contadores();
+        }
+        vTaskDelay(pdMS_TO_TICKS(config.periodo_amostra_ms)); // 100ms por padrao
+    }
+}
+
+static bool EM_RAM(avaliar_alerta)(uint16_t nivel_c, uint16_t chuva_c, const config_estacao_t *config) {
+    return nivel_c >= config->limiar_agua || chuva_c >= config->limiar_chuva;
+}
+
+// Leitura no formato compacto do log (centésimos de %)
+static void registrar_alerta_no_log(uint16_t nivel_c, uint16_t chuva_c, bool alerta) {
+    registro_log_t registro = {
+        .tempo_ms = to_ms_since_boot(get_absolute_time()),
+        .nivel_agua = nivel_c,
+        .volume_chuva = chuva_c,
+        .tipo = REGISTRO_ALERTA,
+        .alerta = alerta
+    };
+    flash_log_registrar(&registro);
+}
+
+static void registrar_amostra_no_log(uint16_t nivel_c, uint16_t chuva_c) {
+    amostra_comp_t amostra = {
+        .tempo_ms = to_ms_since_boot(get_absolute_time()),
+        .nivel_agua = nivel_c,
+        .volume_chuva = chuva_c
+    };
+
+    if (serie.amostras > 0 && amostra.tempo_ms - inicio_bloco_ms >= FLASH_LOG_DESCARGA_MS) {
+        flash_log_registrar_serie(&serie);
+        serie_comp_iniciar(&serie, bloco_serie, sizeof(bloco_serie));
+    }
+    if (!serie_comp_adicionar(&serie, &amostra)) {
+        flash_log_registrar_serie(&serie);
+        serie_comp_iniciar(&serie, bloco_serie, sizeof(bloco_serie));
+        serie_comp_adicionar(&serie, &amostra);
     }
+    if (serie.amostras == 1)
+        inicio_bloco_ms = amostra.tempo_ms;
+}
+
+static void enviar_telemetria(tipo_telemetria_t tipo, uint16_t nivel_c, uint16_t chuva_c, bool alerta) {
+    telemetria_amostra_t amostra = {
+        .tempo_ms = to_ms_since_boot(get_absolute_time()),
+        .nivel_agua = nivel_c,
+        .volume_chuva = chuva_c,
+        .alerta = alerta
+    };
+    telemetria_enviar(tipo, &amostra, sizeof(amostra));
+}
+
+static void enviar_contadores(void) {
+    telemetria_contadores_t contadores = {
+        .tempo_ms = to_ms_since_boot(get_absolute_time()),
+        .telemetria_descartados = telemetria_descartados(),
+        .log_descartados = flash_log_descartados(),
+        .capturas_perdidas = captura_perdidas(),
+        .tlog_descartados = tlog_descartados()
+    };
+    telemetria_enviar(TELEMETRIA_CONTADORES, &contadores, sizeof(contadores));
+}
+
+// Estado para o HTTP (so remonta o retrato se algo mudou) e imagem dos
+// registradores do Modbus, publicada inteira a cada leitura
+static void publicar_estado(uint16_t nivel_c, uint16_t chuva_c, bool alerta, uint32_t alertas,
+                            uint32_t leituras, const config_estacao_t *config) {
+    mqtt_estatistica_t mqtt;
+    mqtt_obter(&mqtt);
+    http_estado_t estado = {
+        .nivel_c = nivel_c,
+        .chuva_c = chuva_c,
+        .alerta = alerta,
+        .alertas = alertas,
+        .telemetria_descartados = telemetria_descartados(),
+        .log_descartados = flash_log_descartados(),
+        .capturas_perdidas = captura_perdidas(),
+        .tlog_descartados = tlog_descartados(),
+        .mqtt_conectado = mqtt.conectado,
+        .mqtt_publicadas = mqtt.publicadas,
+        .mqtt_pendentes = mqtt.pendentes,
+        .mqtt_descartadas = mqtt.descartadas
+    };
+    http_atualizar(&estado);
+
+    bool nivel_acima = nivel_c >= config->limiar_agua;
+    bool chuva_acima = chuva_c >= config->limiar_chuva;
+    uint16_t *imagem = modbus_imagem_escrever();
+    imagem[MODBUS_ENT_NIVEL] = nivel_c;
+    imagem[MODBUS_ENT_CHUVA] = chuva_c;
+    imagem[MODBUS_ENT_SEVERIDADE] = (uint16_t)(nivel_acima + chuva_acima);
+    imagem[MODBUS_ENT_BITS] = (uint16_t)((alerta ? MODBUS_BIT_ALERTA : 0) |
+                                         (nivel_acima ? MODBUS_BIT_NIVEL_ACIMA : 0) |
+                                         (chuva_acima ? MODBUS_BIT_CHUVA_ACIMA : 0) |
+                                         (mqtt.conectado ? MODBUS_BIT_MQTT_CONECTADO : 0));
+    modbus_escrever32(imagem, MODBUS_ENT_LEITURAS, leituras);
+    modbus_escrever32(imagem, MODBUS_ENT_TEMPO_MS, to_ms_since_boot(get_absolute_time()));
+    modbus_escrever32(imagem, MODBUS_ENT_ALERTAS, alertas);
+    modbus_escrever32(imagem, MODBUS_ENT_TELEMETRIA_DESCARTADOS, estado.telemetria_descartados);
+    modbus_escrever32(imagem, MODBUS_ENT_LOG_DESCARTADOS, estado.log_descartados);
+    modbus_escrever32(imagem, MODBUS_ENT_CAPTURAS_PERDIDAS, estado.capturas_perdidas);
+    modbus_escrever32(imagem, MODBUS_ENT_TLOG_DESCARTADOS, estado.tlog_descartados);
+    modbus_imagem_publicar();
+}
+
+// Destino das janelas de captura: uma página do log por bloco
+static bool gravar_captura(const void *bloco, size_t tamanho, uint16_t amostras) {
+    return flash_log_registrar_bloco(REGISTRO_LOG_MAGIA_CAPTURA, bloco, tamanho, amostras);
 }
 
 // -------------------- Tarefa: Display OLED --------------------
@@ -122,6 +339,7 @@ void vJoystickTask(void *params) {
 void vDisplayTask(void *params) {
     ssd1306_t display;
     i2c_init(I2C_PORT, 400 * 1000);
+    relogio_registrar(ajustar_display);
     gpio_set_function(I2C_SDA, GPIO_FUNC_I2C);
     gpio_set_function(I2C_SCL, GPIO_FUNC_I2C);
     gpio_pull_up(I2C_SDA);
@@ -131,47 +349,32 @@ void vDisplayTask(void *params) {
     ssd1306_config(&display);
 
     dados_sensor_t dados;
-
-    char buffer[5]; // Buffer para armazenar a string
-    int contador = 0;
-    bool cor = true;
+    config_estacao_t config;
 
     while (true) {
         // Aguarda novos dados na fila (bloqueante)
         if (xQueueReceive(xQueueSensores, &dados, portMAX_DELAY) == pdTRUE) {
-            ssd1306_fill(&display, false);
-
-            ssd1306_fill(&display, !cor);                          // Limpa o display
-            ssd1306_rect(&display, 3, 3, 122, 60, cor, !cor);      // Desenha um retângulo
-            ssd1306_line(&display, 3, 25, 123, 25, cor);           // Desenha uma linha
-            ssd1306_line(&display, 3, 37, 123, 37, cor);           // Desenha uma linha
-            ssd1306_line(&display, 63, 41, 63, 60, cor);           // Linha vertical entre "Nivel" e "Chuva"
-
-            // Exibe mensagem de alerta ou modo normal
-            if (dados.alerta) {
-                ssd1306_draw_string(&display, "Enchente Lida", 12, 6); // Desenha uma string
-                ssd1306_draw_string(&display, "Evacuar agora", 12, 16);  // Desenha uma string
-                ssd1306_draw_string(&display, "  EMERGENCIA", 10, 28);   // Desenha uma string
-            } else {
-                ssd1306_draw_string(&display, "CEPEDI   TIC37", 8, 6); // Desenha uma string
-                ssd1306_draw_string(&display, "EMBARCATECH", 20, 16);  // Desenha uma string
-                ssd1306_draw_string(&display, "   FreeRTOS", 10, 28);   // Desenha uma string
-            }
-
-            ssd1306_draw_string(&display, "Nivel", 10, 41);        // Desenha uma string
-            ssd1306_draw_string(&display, "Chuva", 78, 41);        // Desenha uma string
-            sprintf(buffer, "%.1f%%", dados.nivel_agua);            // Converte em string a leitura do ADC
-            ssd1306_draw_string(&display, buffer, 10, 52);          // Desenha uma string
-            sprintf(buffer, "%.1f%%", dados.volume_chuva);          // Converte em string a leitura do ADC
-            ssd1306_draw_string(&display, buffer, 80, 52);          // Desenha uma string
+            painel_desenhar(&display,
+                            (uint16_t)(dados.nivel_agua * 10.0f + 0.5f),
+                            (uint16_t)(dados.volume_chuva * 10.0f + 0.5f),
+                            dados.alerta);
 
+            relogio_bloquear();                                     // o clock nao troca no meio do quadro
             ssd1306_send_data(&display);                            // Atualiza o display
-            sleep_ms(500);                                          // Aguarda 500ms
+            relogio_liberar();
+            config_obter(&config);
+            vTaskDelay(pdMS_TO_TICKS(config.periodo_display_ms));   // 500ms por padrao
 
         }
     }
 }
 
+// A taxa do I2C e derivada do clk_sys
+static void ajustar_display(uint32_t hz) {
+    (void)hz;
+    i2c_set_baudrate(I2C_PORT, 400 * 1000);
+}
+
 // -------------------- Tarefa: LED RGB --------------------
 // Esta tarefa controla o LED RGB conforme o estado de alerta.
 // Recebe dados da fila e acende o LED vermelho (alerta) ou verde (normal).
@@ -184,6 +387,8 @@ void vLedRgbTask(void *params) {
     uint slice_g = pwm_gpio_to_slice_num(LED_G);
     uint slice_b = pwm_gpio_to_slice_num(LED_B);
 
+    // So o duty cycle importa para o brilho; a frequencia do PWM pode
+    // acompanhar o clock sem reajuste (relogio.h)
     pwm_set_wrap(slice_r, 255);
     pwm_set_wrap(slice_g, 255);
     pwm_set_wrap(slice_b, 255);
@@ -220,30 +425,40 @@ void vBuzzerTask(void *params) {
     gpio_set_function(BUZZER, GPIO_FUNC_PWM);
     uint slice = pwm_gpio_to_slice_num(BUZZER);
     pwm_set_wrap(slice, 12500); // 10 kHz base
-    pwm_set_clkdiv(slice, 125.0f);
+    relogio_registrar(ajustar_buzzer); // divisor para contar a 1 MHz em qualquer clock
     pwm_set_enabled(slice, true);
 
     dados_sensor_t dados;
+    config_estacao_t config;
 
     while (true) {
         // Aguarda novos dados na fila
         if (xQueueReceive(xQueueSensores, &dados, portMAX_DELAY) == pdTRUE) {
+            config_obter(&config);
             if (dados.alerta) {
                 // Ativa o buzzer (50% duty cycle)
-                pwm_set_chan_level(slice, pwm_gpio_to_channel(BUZZER), 6250);
-                vTaskDelay(pdMS_TO_TICKS(200));
+                buzzer_nivel(slice, 6250);
+                vTaskDelay(pdMS_TO_TICKS(config.buzzer_ligado_ms));
                 // Desativa o buzzer
-                pwm_set_chan_level(slice, pwm_gpio_to_channel(BUZZER), 0);
-                vTaskDelay(pdMS_TO_TICKS(300));
+                buzzer_nivel(slice, 0);
+                vTaskDelay(pdMS_TO_TICKS(config.buzzer_desligado_ms));
             } else {
                 // Mantém o buzzer desligado
-                pwm_set_chan_level(slice, pwm_gpio_to_channel(BUZZER), 0);
-                vTaskDelay(pdMS_TO_TICKS(500));
+                buzzer_nivel(slice, 0);
+                vTaskDelay(pdMS_TO_TICKS(config.buzzer_ligado_ms + config.buzzer_desligado_ms));
             }
         }
     }
 }
 
+static void EM_RAM(buzzer_nivel)(uint slice, uint16_t nivel) {
+    pwm_set_chan_level(slice, pwm_gpio_to_channel(BUZZER), nivel);
+}
+
+static void ajustar_buzzer(uint32_t hz) {
+    pwm_set_clkdiv(pwm_gpio_to_slice_num(BUZZER), hz / 1000000.0f);
+}
+
 // -------------------- Tarefa: Matriz de LEDs --------------------
 // Esta tarefa controla uma matriz de LEDs via PIO.
 // Acende todos os LEDs de vermelho em alerta ou verde no modo normal.
@@ -255,18 +470,35 @@ void vMatrizLedTask(void *params) {
     uint offset = pio_add_program(pio, &final_program);
     sm = pio_claim_unused_sm(pio, true);
     final_program_init(pio, sm, offset, LED_MATRIX_PIN);
+    relogio_registrar(ajustar_matriz);
 
     dados_sensor_t dados;
+    config_estacao_t config;
 
     while (true) {
         // Aguarda novos dados na fila
         if (xQueueReceive(xQueueSensores, &dados, portMAX_DELAY) == pdTRUE) {
-            // Define cor: vermelho para alerta, verde para normal
-            uint32_t cor = dados.alerta ? 0x00FF0000 : 0xFF000000;
-            for (int i = 0; i < NUM_LEDS; i++) {
-                pio_sm_put_blocking(pio, sm, cor);
-            }
+            // Define cor: vermelho para alerta, verde para normal (ajustaveis)
+            config_obter(&config);
+            uint32_t cor = dados.alerta ? config.cor_alerta : config.cor_normal;
+            uint32_t inicio = medir_inicio();
+            relogio_bloquear(); // os bits WS2812 dependem do divisor do PIO
+            matriz_preencher(cor);
+            relogio_liberar();
+            medir_fim(MEDIDA_MATRIZ, inicio);
         }
         vTaskDelay(pdMS_TO_TICKS(500)); // Atualiza a cada 500ms
     }
 }
+
+// Mantem o PIO em 8 MHz (10 ciclos por bit WS2812) em qualquer clock
+static void ajustar_matriz(uint32_t hz) {
+    pio_sm_set_clkdiv(pio, sm, hz / 8000000.0f);
+}
+
+// Envia a mesma cor para todos os LEDs; o PIO gera a temporizacao WS2812
+static void EM_RAM(matriz_preencher)(uint32_t cor) {
+    for (int i = 0; i < NUM_LEDS; i++) {
+        pio_sm_put_blocking(pio, sm, cor);
+    }
+}
@@ -0,0 +1,116 @@
+#include "adc_dma.h"
+#include "hardware/adc.h"
+#include "hardware/dma.h"
+#include "hardware/irq.h"
+
+typedef enum {
+    BUFFER_LIVRE,
+    BUFFER_DMA,   // destino de um canal de DMA
+    BUFFER_CHEIO, // na fila de envio
+    BUFFER_USB    // em transferencia
+} estado_buffer_t;
+
+static adc_dma_buffer_t buffers[ADC_DMA_BUFFERS];
+static volatile uint8_t estado[ADC_DMA_BUFFERS];
+
+// Fila de buffers cheios: a interrupcao produz, o laco principal consome
+static volatile uint8_t fila[ADC_DMA_BUFFERS];
+static volatile uint32_t fila_cabeca, fila_cauda;
+
+static int canais[2];
+static uint8_t buffer_do_canal[2];
+static uint32_t sequencia;
+static volatile uint32_t overruns;
+
+static int8_t buffer_livre(void) {
+    for (int8_t i = 0; i < ADC_DMA_BUFFERS; i++) {
+        if (estado[i] == BUFFER_LIVRE)
+            return i;
+    }
+    return -1;
+}
+
+static void __not_in_flash_func(dma_adc_handler)(void) {
+    for (int c = 0; c < 2; c++) {
+        uint32_t mascara = 1u << canais[c];
+        if (!(dma_hw->ints1 & mascara))
+            continue;
+        dma_hw->ints1 = mascara;
+
+        uint8_t cheio = buffer_do_canal[c];
+        adc_dma_buffer_t *b = &buffers[cheio];
+        b->cabecalho.sequencia = sequencia++;
+        b->cabecalho.amostras = ADC_STREAM_AMOSTRAS;
+
+        int8_t proximo = buffer_livre();
+        if (proximo < 0) {
+            // USB atrasada: descarta este buffer e reutiliza-o
+            overruns++;
+            proximo = cheio;
+        } else {
+            b->cabecalho.overruns = (uint16_t)overruns;
+            estado[cheio] = BUFFER_CHEIO;
+            fila[fila_cabeca % ADC_DMA_BUFFERS] = cheio;
+            fila_cabeca++;
+        }
+
+        // O outro canal ja esta escrevendo; este so precisa do novo destino.
+        // A contagem de transferencias e recarregada a cada disparo.
+        estado[proximo] = BUFFER_DMA;
+        buffer_do_canal[c] = (uint8_t)proximo;
+        dma_channel_set_write_addr(canais[c], buffers[proximo].amostras, false);
+    }
+}
+
+static void configurar_canal(int c, bool iniciar) {
+    dma_channel_config cfg = dma_channel_get_default_config(canais[c]);
+    channel_config_set_transfer_data_size(&cfg, DMA_SIZE_16);
+    channel_config_set_read_increment(&cfg, false);
+    channel_config_set_write_increment(&cfg, true);
+    channel_config_set_dreq(&cfg, DREQ_ADC);
+    channel_config_set_chain_to(&cfg, canais[c ^ 1]);
+
+    estado[c] = BUFFER_DMA;
+    buffer_do_canal[c] = (uint8_t)c;
+    dma_channel_set_irq1_enabled(canais[c], true);
+    dma_channel_configure(canais[c], &cfg, buffers[c].amostras, &adc_hw->fifo,
+                          ADC_STREAM_AMOSTRAS, iniciar);
+}
+
+void adc_dma_init(void) {
+    adc_init();
+    adc_gpio_init(26);
+    adc_gpio_init(27);
+    adc_select_input(0);
+    adc_set_round_robin(0x03);
+    adc_fifo_setup(true, true, 1, true, false); // bit 15 marca erro de conversao
+    adc_set_clkdiv(48000000.0f / ADC_STREAM_TAXA_HZ - 1.0f); // 96 ciclos: taxa maxima
+
+    canais[0] = dma_claim_unused_channel(true);
+    canais[1] = dma_claim_unused_channel(true);
+    configurar_canal(1, false);
+    configurar_canal(0, true);
+
+    irq_set_exclusive_handler(DMA_IRQ_1, dma_adc_handler);
+    irq_set_priority(DMA_IRQ_1, 0); // mais alta: a latencia limita a folga do FIFO do ADC
+    irq_set_enabled(DMA_IRQ_1, true);
+
+    adc_run(true);
+}
+
+adc_dma_buffer_t *adc_dma_proximo(void) {
+    if (fila_cauda == fila_cabeca)
+        return NULL;
+    uint8_t i = fila[fila_cauda % ADC_DMA_BUFFERS];
+    fila_cauda++;
+    estado[i] = BUFFER_USB;
+    return &buffers[i];
+}
+
+void adc_dma_liberar(adc_dma_buffer_t *buffer) {
+    estado[buffer - buffers] = BUFFER_LIVRE;
+}
+
+uint32_t adc_dma_overruns(void) {
+    return overruns;
+}
@@ -0,0 +1,29 @@
+#ifndef ADC_DMA_H
+#define ADC_DMA_H
+
+#include "pico/stdlib.h"
+#include "adc_stream_proto.h"
+
+// -------------------- Aquisicao do ADC em buffers grandes --------------------
+// Dois canais de DMA encadeados (ping-pong) mantem o ADC sempre com destino:
+// quando um termina, o outro ja esta escrevendo, e a interrupcao so aponta o
+// canal que terminou para o proximo buffer livre. Buffers cheios entram numa
+// fila e sao enviados a USB sem copia.
+
+#define ADC_DMA_BUFFERS 6
+
+typedef struct {
+    adc_stream_cabecalho_t cabecalho;
+    uint16_t amostras[ADC_STREAM_AMOSTRAS];
+} adc_dma_buffer_t;
+
+void adc_dma_init(void);
+
+// Proximo buffer cheio, em ordem, ou NULL. O buffer pertence a quem chamou
+// ate ser devolvido com adc_dma_liberar.
+adc_dma_buffer_t *adc_dma_proximo(void);
+void adc_dma_liberar(adc_dma_buffer_t *buffer);
+
+uint32_t adc_dma_overruns(void);
+
+#endif
@@ -0,0 +1,27 @@
+#ifndef ADC_STREAM_PROTO_H
+#define ADC_STREAM_PROTO_H
+
+#include <stdint.h>
+
+// -------------------- Protocolo do modo de streaming do ADC --------------------
+// Cada buffer cheio vira uma unica transferencia bulk IN: cabecalho de 8
+// bytes seguido das amostras cruas de 16 bits (12 bits uteis, bit 15 =
+// erro de conversao), intercaladas ADC0, ADC1, ADC0... O tamanho total nao
+// e multiplo de 64, entao o ultimo pacote curto delimita a transferencia.
+
+#define ADC_STREAM_VID        0xCAFE
+#define ADC_STREAM_PID        0x4001
+#define ADC_STREAM_EP_IN      0x81
+#define ADC_STREAM_AMOSTRAS   4096 // por buffer
+#define ADC_STREAM_TAXA_HZ    500000
+
+typedef struct {
+    uint32_t sequencia; // buffers produzidos desde o inicio (lacunas = perdas)
+    uint16_t overruns;  // buffers descartados por falta de espaco ate aqui
+    uint16_t amostras;
+} adc_stream_cabecalho_t;
+
+#define ADC_STREAM_TRANSFERENCIA \
+    (sizeof(adc_stream_cabecalho_t) + ADC_STREAM_AMOSTRAS * sizeof(uint16_t))
+
+#endif
@@ -0,0 +1,29 @@
+// -----------------------------------------------------------------------------
+// Modo de diagnostico: streaming do ADC bruto pela USB
+// Descricao: firmware separado da estacao (gera AdcStream.uf2). O ADC roda
+// na taxa maxima em round-robin (GPIO 26 e 27) e os buffers do DMA sao
+// enviados por um endpoint bulk vendor, sem copia, para tools/adc_captura.
+// O LED vermelho acende se algum buffer for descartado.
+// -----------------------------------------------------------------------------
+
+#include "pico/stdlib.h"
+#include "tusb.h"
+#include "adc_dma.h"
+#include "usb_stream.h"
+
+#define LED_R 13
+
+int main() {
+    gpio_init(LED_R);
+    gpio_set_dir(LED_R, GPIO_OUT);
+
+    tud_init(0);
+    adc_dma_init();
+
+    while (true) {
+        tud_task();
+        usb_stream_servico();
+        gpio_put(LED_R, adc_dma_overruns() > 0);
+    }
+    return 0;
+}
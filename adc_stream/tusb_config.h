@@ -0,0 +1,18 @@
+#ifndef TUSB_CONFIG_H
+#define TUSB_CONFIG_H
+
+// Configuracao do TinyUSB para o modo de streaming do ADC: apenas device,
+// nenhuma classe padrao. A interface vendor e tratada por um driver de
+// aplicacao (usb_stream.c), que transfere direto dos buffers do DMA.
+
+#define CFG_TUSB_RHPORT0_MODE  OPT_MODE_DEVICE
+#define CFG_TUSB_OS            OPT_OS_PICO
+#define CFG_TUD_ENDPOINT0_SIZE 64
+
+#define CFG_TUD_CDC    0
+#define CFG_TUD_MSC    0
+#define CFG_TUD_HID    0
+#define CFG_TUD_MIDI   0
+#define CFG_TUD_VENDOR 0
+
+#endif
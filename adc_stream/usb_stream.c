@@ -0,0 +1,154 @@
+#include "usb_stream.h"
+#include "adc_dma.h"
+#include "tusb.h"
+#include "device/usbd_pvt.h"
+
+_Static_assert(ADC_STREAM_TRANSFERENCIA % 64 != 0,
+               "a transferencia precisa terminar em pacote curto (ou enviar ZLP)");
+
+// -------------------- Descritores --------------------
+static const tusb_desc_device_t descritor_dispositivo = {
+    .bLength = sizeof(tusb_desc_device_t),
+    .bDescriptorType = TUSB_DESC_DEVICE,
+    .bcdUSB = 0x0200,
+    .bDeviceClass = 0x00,
+    .bDeviceSubClass = 0x00,
+    .bDeviceProtocol = 0x00,
+    .bMaxPacketSize0 = CFG_TUD_ENDPOINT0_SIZE,
+    .idVendor = ADC_STREAM_VID,
+    .idProduct = ADC_STREAM_PID,
+    .bcdDevice = 0x0100,
+    .iManufacturer = 1,
+    .iProduct = 2,
+    .iSerialNumber = 0,
+    .bNumConfigurations = 1
+};
+
+#define CONFIG_TOTAL (TUD_CONFIG_DESC_LEN + 9 + 7)
+
+static const uint8_t descritor_configuracao[] = {
+    TUD_CONFIG_DESCRIPTOR(1, 1, 0, CONFIG_TOTAL, 0x00, 100),
+    // Interface 0: vendor, um endpoint bulk IN
+    9, TUSB_DESC_INTERFACE, 0, 0, 1, TUSB_CLASS_VENDOR_SPECIFIC, 0x00, 0x00, 0,
+    7, TUSB_DESC_ENDPOINT, ADC_STREAM_EP_IN, TUSB_XFER_BULK, U16_TO_U8S_LE(64), 0
+};
+
+static const char *strings[] = { "", "EstacaoCheias", "Streaming ADC" };
+
+uint8_t const *tud_descriptor_device_cb(void) {
+    return (uint8_t const *)&descritor_dispositivo;
+}
+
+uint8_t const *tud_descriptor_configuration_cb(uint8_t index) {
+    (void)index;
+    return descritor_configuracao;
+}
+
+uint16_t const *tud_descriptor_string_cb(uint8_t index, uint16_t langid) {
+    static uint16_t utf16[32];
+    (void)langid;
+    uint8_t n;
+
+    if (index == 0) {
+        utf16[1] = 0x0409; // ingles (EUA)
+        n = 1;
+    } else {
+        if (index >= sizeof(strings) / sizeof(strings[0]))
+            return NULL;
+        const char *s = strings[index];
+        for (n = 0; s[n] && n < 31; n++)
+            utf16[1 + n] = (uint16_t)s[n];
+    }
+    utf16[0] = (uint16_t)((TUSB_DESC_STRING << 8) | (2 * n + 2));
+    return utf16;
+}
+
+// -------------------- Driver de aplicacao --------------------
+// O driver vendor do TinyUSB copia os dados para um FIFO proprio; aqui o
+// endpoint e tratado diretamente e cada transferencia aponta para o buffer
+// do DMA.
+
+static uint8_t porta;
+static bool aberto;
+static adc_dma_buffer_t *em_envio;
+
+static void stream_init(void) {
+    aberto = false;
+    em_envio = NULL;
+}
+
+static void stream_reset(uint8_t rhport) {
+    (void)rhport;
+    if (em_envio) {
+        adc_dma_liberar(em_envio);
+        em_envio = NULL;
+    }
+    aberto = false;
+}
+
+static uint16_t stream_open(uint8_t rhport, tusb_desc_interface_t const *intf, uint16_t max_len) {
+    if (intf->bInterfaceClass != TUSB_CLASS_VENDOR_SPECIFIC)
+        return 0;
+
+    uint16_t tamanho = sizeof(tusb_desc_interface_t) + sizeof(tusb_desc_endpoint_t);
+    if (max_len < tamanho)
+        return 0;
+
+    tusb_desc_endpoint_t const *ep = (tusb_desc_endpoint_t const *)tu_desc_next(intf);
+    if (!usbd_edpt_open(rhport, ep))
+        return 0;
+
+    porta = rhport;
+    aberto = true;
+    return tamanho;
+}
+
+static bool stream_control_xfer_cb(uint8_t rhport, uint8_t stage, tusb_control_request_t const *request) {
+    (void)rhport;
+    (void)stage;
+    (void)request;
+    return false;
+}
+
+static bool stream_xfer_cb(uint8_t rhport, uint8_t ep_addr, xfer_result_t result, uint32_t bytes) {
+    (void)rhport;
+    (void)result;
+    (void)bytes;
+    if (ep_addr == ADC_STREAM_EP_IN && em_envio) {
+        adc_dma_liberar(em_envio);
+        em_envio = NULL;
+    }
+    return true;
+}
+
+static const usbd_class_driver_t driver_stream = {
+    .init = stream_init,
+    .reset = stream_reset,
+    .open = stream_open,
+    .control_xfer_cb = stream_control_xfer_cb,
+    .xfer_cb = stream_xfer_cb,
+    .sof = NULL
+};
+
+usbd_class_driver_t const *usbd_app_driver_get_cb(uint8_t *quantidade) {
+    *quantidade = 1;
+    return &driver_stream;
+}
+
+// -------------------- Envio --------------------
+void usb_stream_servico(void) {
+    if (!aberto || em_envio)
+        return;
+
+    adc_dma_buffer_t *b = adc_dma_proximo();
+    if (!b)
+        return;
+
+    // tud_task e este servico rodam no mesmo laco, entao nao ha disputa pelo
+    // endpoint e o claim/release do TinyUSB e dispensavel.
+    em_envio = b;
+    if (!usbd_edpt_xfer(porta, ADC_STREAM_EP_IN, (uint8_t *)b, ADC_STREAM_TRANSFERENCIA)) {
+        adc_dma_liberar(b);
+        em_envio = NULL;
+    }
+}
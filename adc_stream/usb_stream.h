@@ -0,0 +1,8 @@
+#ifndef USB_STREAM_H
+#define USB_STREAM_H
+
+// Inicia a proxima transferencia bulk quando o endpoint estiver livre e
+// houver buffer cheio. Chamar no laco principal, junto com tud_task().
+void usb_stream_servico(void);
+
+#endif
@@ -0,0 +1,98 @@
+#include <string.h>
+#include "calibracao.h"
+#include "captura.h"
+#include "em_ram.h"
+
+#define ADC_MAXIMO (CALIBRACAO_ENTRADAS - 1)
+#define VALOR_MAXIMO 10000 // 100,00%
+#define PONTO_PROXIMO 16   // contagens: medir de novo no mesmo lugar substitui o ponto
+
+// Uma tabela por canal mais uma reserva para a reconstrucao (24 KB)
+static uint16_t tabelas[CONFIG_CANAIS + 1][CALIBRACAO_ENTRADAS];
+static uint16_t *volatile ativa[CONFIG_CANAIS];
+static uint16_t *reserva;
+static calibracao_canal_t construida[CONFIG_CANAIS];
+
+// -------------------- Construcao --------------------
+static void construir(uint16_t *tabela, const calibracao_canal_t *curva) {
+    if (curva->pontos < 2) {
+        for (uint32_t bruto = 0; bruto < CALIBRACAO_ENTRADAS; bruto++)
+            tabela[bruto] = (uint16_t)((bruto * VALOR_MAXIMO + ADC_MAXIMO / 2) / ADC_MAXIMO);
+        return;
+    }
+
+    uint8_t seg = 0;
+    for (uint32_t bruto = 0; bruto < CALIBRACAO_ENTRADAS; bruto++) {
+        if (bruto <= curva->bruto[0]) {
+            tabela[bruto] = curva->valor[0];
+            continue;
+        }
+        while (seg + 2 < curva->pontos && bruto > curva->bruto[seg + 1])
+            seg++;
+        if (bruto >= curva->bruto[curva->pontos - 1]) {
+            tabela[bruto] = curva->valor[curva->pontos - 1];
+            continue;
+        }
+
+        int32_t b0 = curva->bruto[seg], b1 = curva->bruto[seg + 1];
+        int32_t v0 = curva->valor[seg], v1 = curva->valor[seg + 1];
+        int32_t num = ((int32_t)bruto - b0) * (v1 - v0);
+        int32_t den = b1 - b0;
+        // Divisao arredondada (num pode ser negativo em curvas decrescentes)
+        int32_t v = v0 + (num >= 0 ? (num + den / 2) / den : (num - den / 2) / den);
+        tabela[bruto] = (uint16_t)v;
+    }
+}
+
+void calibracao_init(void) {
+    config_estacao_t c;
+    config_obter(&c);
+    for (uint canal = 0; canal < CONFIG_CANAIS; canal++) {
+        construir(tabelas[canal], &c.calibracao[canal]);
+        ativa[canal] = tabelas[canal];
+        construida[canal] = c.calibracao[canal];
+    }
+    reserva = tabelas[CONFIG_CANAIS];
+}
+
+void calibracao_atualizar(const config_estacao_t *c) {
+    for (uint canal = 0; canal < CONFIG_CANAIS; canal++) {
+        if (memcmp(&construida[canal], &c->calibracao[canal], sizeof(calibracao_canal_t)) == 0)
+            continue;
+
+        construir(reserva, &c->calibracao[canal]);
+        // A troca e um unico store de ponteiro; a tabela antiga vira reserva.
+        uint16_t *antiga = ativa[canal];
+        ativa[canal] = reserva;
+        reserva = antiga;
+        construida[canal] = c->calibracao[canal];
+    }
+}
+
+uint16_t EM_RAM(calibracao_aplicar)(uint canal, uint16_t bruto) {
+    return ativa[canal][bruto & ADC_MAXIMO];
+}
+
+// -------------------- Medicao de pontos --------------------
+bool calibracao_medir_ponto(calibracao_canal_t *curva, uint canal, uint16_t valor) {
+    uint16_t bruto = captura_media(canal, CALIBRACAO_AMOSTRAS_PONTO);
+    uint8_t i = 0;
+
+    while (i < curva->pontos && curva->bruto[i] + PONTO_PROXIMO < bruto)
+        i++;
+    if (i < curva->pontos && curva->bruto[i] <= bruto + PONTO_PROXIMO) {
+        curva->bruto[i] = bruto;
+        curva->valor[i] = valor;
+        return true;
+    }
+    if (curva->pontos == CONFIG_CALIBRACAO_PONTOS)
+        return false;
+
+    // Insere mantendo a ordem por contagem
+    memmove(&curva->bruto[i + 1], &curva->bruto[i], (curva->pontos - i) * sizeof(uint16_t));
+    memmove(&curva->valor[i + 1], &curva->valor[i], (curva->pontos - i) * sizeof(uint16_t));
+    curva->bruto[i] = bruto;
+    curva->valor[i] = valor;
+    curva->pontos++;
+    return true;
+}
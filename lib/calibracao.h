@@ -0,0 +1,33 @@
+#ifndef CALIBRACAO_H
+#define CALIBRACAO_H
+
+#include "pico/stdlib.h"
+#include "config.h"
+
+// -------------------- Calibracao dos canais do ADC --------------------
+// Cada canal tem uma tabela de 4096 entradas, indexada pela contagem de 12
+// bits, com o valor calibrado em centesimos de %. A curva (config.h) e
+// linear por partes entre os pontos medidos e saturada fora deles; ela so
+// e percorrida na reconstrucao da tabela. Aplicar a calibracao e uma
+// leitura de tabela por amostra.
+
+#define CALIBRACAO_ENTRADAS 4096
+#define CALIBRACAO_AMOSTRAS_PONTO 1024 // media usada ao medir um ponto
+
+// Monta as tabelas a partir da curva da configuracao ativa.
+void calibracao_init(void);
+
+// Reconstroi a tabela dos canais cuja curva mudou em c. A tabela nova e
+// montada a parte e trocada de uma vez; quem le nunca ve uma tabela
+// parcial. Chamar de uma unica tarefa (o shell) ou antes do escalonador.
+void calibracao_atualizar(const config_estacao_t *c);
+
+// Contagem bruta -> centesimos de %.
+uint16_t calibracao_aplicar(uint canal, uint16_t bruto);
+
+// Mede a contagem atual do canal e a registra na curva como o valor dado
+// (substitui um ponto com contagem proxima). Retorna false se a curva
+// estiver cheia.
+bool calibracao_medir_ponto(calibracao_canal_t *curva, uint canal, uint16_t valor);
+
+#endif
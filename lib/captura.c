@@ -0,0 +1,190 @@
+#include <string.h>
+#include "captura.h"
+#include "tlog.h"
+#include "interp_hw.h"
+#include "em_ram.h"
+#include "relogio.h"
+#include "hardware/clocks.h"
+#include "hardware/adc.h"
+#include "hardware/dma.h"
+#include "hardware/irq.h"
+#include "FreeRTOS.h"
+#include "task.h"
+
+typedef enum {
+    CAPTURA_OCIOSA,
+    CAPTURA_AGUARDANDO_POS, // disparada, esperando as amostras pos-disparo
+    CAPTURA_DESCARREGANDO   // janela congelada, sendo entregue ao destino
+} estado_captura_t;
+
+// O DMA usa o modo anel no endereco de escrita, que exige alinhamento
+// natural ao tamanho do anel.
+static uint16_t anel[CAPTURA_ANEL] __attribute__((aligned(1u << CAPTURA_ANEL_BITS)));
+static uint16_t janela[CAPTURA_JANELA];
+
+static int canal_dma = -1;
+static captura_destino_t destino;
+
+static volatile bool pedido;
+static volatile uint32_t pos_pedido;
+static volatile uint32_t tempo_pedido_ms;
+static volatile estado_captura_t estado = CAPTURA_OCIOSA;
+static uint32_t perdidas;
+static uint32_t creditos = CAPTURA_CREDITOS;
+static uint32_t recarga_ms; // inicio da recarga em curso
+
+// -------------------- DMA --------------------
+static inline uint32_t posicao_escrita(void) {
+    return (uint32_t)(dma_hw->ch[canal_dma].write_addr - (uintptr_t)anel) / sizeof(uint16_t);
+}
+
+// A contagem de transferencias e finita; ao terminar, rearma o canal. O
+// endereco de escrita continua de onde parou, dentro do anel.
+static void EM_RAM(dma_captura_handler)(void) {
+    dma_hw->ints0 = 1u << canal_dma;
+    dma_channel_set_trans_count(canal_dma, 0xFFFFFFFFu, true);
+}
+
+void captura_init(captura_destino_t destino_blocos) {
+    destino = destino_blocos;
+
+    adc_init();
+    adc_gpio_init(CAPTURA_GPIO_NIVEL);
+    adc_gpio_init(CAPTURA_GPIO_CHUVA);
+    adc_select_input(0);
+    adc_set_round_robin(0x03);
+    adc_fifo_setup(true, true, 1, false, false);
+    captura_ajustar_relogio(0);
+
+    canal_dma = dma_claim_unused_channel(true);
+    dma_channel_config c = dma_channel_get_default_config(canal_dma);
+    channel_config_set_transfer_data_size(&c, DMA_SIZE_16);
+    channel_config_set_read_increment(&c, false);
+    channel_config_set_write_increment(&c, true);
+    channel_config_set_ring(&c, true, CAPTURA_ANEL_BITS);
+    channel_config_set_dreq(&c, DREQ_ADC);
+
+    dma_channel_set_irq0_enabled(canal_dma, true);
+    irq_set_exclusive_handler(DMA_IRQ_0, dma_captura_handler);
+    irq_set_enabled(DMA_IRQ_0, true);
+
+    dma_channel_configure(canal_dma, &c, anel, &adc_hw->fifo, 0xFFFFFFFFu, true);
+    adc_run(true);
+}
+
+void captura_ajustar_relogio(uint32_t hz_sys) {
+    (void)hz_sys;
+    adc_set_clkdiv((float)clock_get_hz(clk_adc) / CAPTURA_TAXA_HZ - 1.0f);
+}
+
+// -------------------- Leitura --------------------
+// O anel comeca no ADC0 e tem tamanho par, entao o indice par e sempre o
+// nivel e o impar a chuva. O percurso do anel e feito pelo interp0.
+uint16_t EM_RAM(captura_media)(uint canal, uint n) {
+    uint32_t pos = posicao_escrita() & ~1u;
+    uint32_t soma = interp_hw_anel_somar(anel, CAPTURA_ANEL_BITS, pos - 2 + canal, -2, n);
+    return (uint16_t)(soma / n);
+}
+
+// Devolve os creditos vencidos desde a ultima recarga. Com o balde cheio o
+// relogio da recarga fica parado no instante atual.
+static void recarregar(uint32_t agora_ms) {
+    uint32_t novos = (agora_ms - recarga_ms) / CAPTURA_RECARGA_MS;
+    creditos += novos;
+    recarga_ms += novos * CAPTURA_RECARGA_MS;
+    if (creditos >= CAPTURA_CREDITOS) {
+        creditos = CAPTURA_CREDITOS;
+        recarga_ms = agora_ms;
+    }
+}
+
+bool EM_RAM(captura_disparar)(void) {
+    uint32_t agora_ms = to_ms_since_boot(get_absolute_time());
+    recarregar(agora_ms);
+    if (estado != CAPTURA_OCIOSA || pedido || creditos == 0) {
+        perdidas++;
+        return false;
+    }
+    creditos--;
+    pos_pedido = posicao_escrita() & ~1u;
+    tempo_pedido_ms = agora_ms;
+    pedido = true;
+    return true;
+}
+
+uint32_t captura_perdidas(void) {
+    return perdidas;
+}
+
+// -------------------- Tarefa --------------------
+static void congelar_janela(uint32_t inicio) {
+    interp_hw_anel_copiar(janela, anel, CAPTURA_ANEL_BITS, inicio, CAPTURA_JANELA);
+}
+
+void vCapturaTask(void *params) {
+    struct {
+        cabecalho_captura_t cabecalho;
+        uint16_t amostras[REGISTRO_LOG_CAPTURA_POR_PAGINA];
+    } bloco;
+
+    uint32_t pos_anterior = posicao_escrita();
+    uint32_t absoluta = 0;    // amostras escritas desde o boot
+    uint32_t disparo_abs = 0; // posicao absoluta do disparo
+    uint32_t disparo_pos = 0; // posicao no anel do disparo
+    uint16_t entregues = 0;
+    TickType_t ultimo = xTaskGetTickCount();
+
+    while (true) {
+        vTaskDelayUntil(&ultimo, pdMS_TO_TICKS(CAPTURA_PERIODO_MS));
+
+        uint32_t pos = posicao_escrita();
+        absoluta += (pos - pos_anterior) & (CAPTURA_ANEL - 1);
+        pos_anterior = pos;
+
+        if (estado == CAPTURA_OCIOSA && pedido) {
+            disparo_pos = pos_pedido;
+            disparo_abs = absoluta - ((pos - disparo_pos) & (CAPTURA_ANEL - 1));
+            bloco.cabecalho.tempo_disparo_ms = tempo_pedido_ms;
+            estado = CAPTURA_AGUARDANDO_POS;
+            pedido = false;
+            // Descarregar a janela para a flash e trabalho em lote
+            relogio_pedir(RELOGIO_MOTIVO_CAPTURA, true);
+        }
+
+        if (estado == CAPTURA_AGUARDANDO_POS) {
+            uint32_t depois = absoluta - disparo_abs;
+            if (depois > CAPTURA_ANEL - CAPTURA_PRE) {
+                // A tarefa atrasou demais e o inicio da janela ja foi sobrescrito
+                perdidas++;
+                TLOG("captura: janela sobrescrita (%u amostras apos o disparo)", depois);
+                estado = CAPTURA_OCIOSA;
+                relogio_pedir(RELOGIO_MOTIVO_CAPTURA, false);
+            } else if (depois >= CAPTURA_POS) {
+                congelar_janela(disparo_pos - CAPTURA_PRE);
+                TLOG("captura: janela congelada em %u", disparo_pos);
+                entregues = 0;
+                estado = CAPTURA_DESCARREGANDO;
+            }
+        }
+
+        // Entrega tantos blocos quanto o destino aceitar neste ciclo
+        while (estado == CAPTURA_DESCARREGANDO) {
+            uint16_t n = CAPTURA_JANELA - entregues;
+            if (n > REGISTRO_LOG_CAPTURA_POR_PAGINA)
+                n = REGISTRO_LOG_CAPTURA_POR_PAGINA;
+
+            bloco.cabecalho.taxa_hz = CAPTURA_TAXA_HZ;
+            bloco.cabecalho.inicio = entregues;
+            bloco.cabecalho.pre_disparo = CAPTURA_PRE;
+            memcpy(bloco.amostras, &janela[entregues], n * sizeof(uint16_t));
+            if (!destino(&bloco, sizeof(bloco.cabecalho) + n * sizeof(uint16_t), n))
+                break;
+
+            entregues += n;
+            if (entregues == CAPTURA_JANELA) {
+                estado = CAPTURA_OCIOSA;
+                relogio_pedir(RELOGIO_MOTIVO_CAPTURA, false);
+            }
+        }
+    }
+}
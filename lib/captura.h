@@ -0,0 +1,53 @@
+#ifndef CAPTURA_H
+#define CAPTURA_H
+
+#include "pico/stdlib.h"
+#include "registro_log.h"
+
+// -------------------- Captura pre/pos-disparo --------------------
+// O ADC roda livre em round-robin (ADC0 = nivel, ADC1 = chuva) e o DMA
+// escreve continuamente num anel em RAM, sem participacao da CPU. Num
+// disparo (transicao de alerta) a janela com CAPTURA_PRE amostras antes e
+// CAPTURA_POS depois e congelada e entregue em blocos ao destino, em
+// segundo plano, enquanto a aquisicao continua.
+
+#define CAPTURA_GPIO_NIVEL 26   // ADC0
+#define CAPTURA_GPIO_CHUVA 27   // ADC1
+#define CAPTURA_TAXA_HZ   20000 // soma dos dois canais (10 kHz por canal)
+#define CAPTURA_ANEL_BITS 14    // anel de 2^14 bytes = 8192 amostras
+#define CAPTURA_ANEL      ((1u << CAPTURA_ANEL_BITS) / sizeof(uint16_t))
+#define CAPTURA_PRE       2048
+#define CAPTURA_POS       2048
+#define CAPTURA_JANELA    (CAPTURA_PRE + CAPTURA_POS)
+#define CAPTURA_PERIODO_MS 10   // periodo de verificacao da tarefa
+
+// Orcamento de capturas: cada janela ocupa cerca de 36 paginas do log, que
+// dividem o anel da flash com a serie. Sao aceitas ate CAPTURA_CREDITOS
+// seguidas e depois uma a cada CAPTURA_RECARGA_MS: em regime, 12 por dia
+// (~430 paginas, cerca de 10% do anel).
+#define CAPTURA_CREDITOS   3
+#define CAPTURA_RECARGA_MS (2u * 60u * 60u * 1000u)
+
+// Recebe um bloco pronto (cabecalho + amostras). Retorna false se nao
+// puder aceitar agora; o mesmo bloco e oferecido de novo depois.
+typedef bool (*captura_destino_t)(const void *bloco, size_t tamanho, uint16_t amostras);
+
+// Configura ADC e DMA e inicia a aquisicao continua.
+void captura_init(captura_destino_t destino);
+
+// Media das ultimas n amostras do canal (0 = nivel, 1 = chuva), em contagens.
+uint16_t captura_media(uint canal, uint n);
+
+// Solicita uma captura centrada no instante atual. Ignorada (e contada) se
+// ainda houver uma captura em andamento ou se o orcamento tiver acabado.
+bool captura_disparar(void);
+
+void vCapturaTask(void *params);
+
+// Recalcula o divisor do ADC. O ADC usa o clk_adc (PLL da USB), entao uma
+// troca do clk_sys nao o afeta; registrado em relogio.h por garantia.
+void captura_ajustar_relogio(uint32_t hz_sys);
+
+uint32_t captura_perdidas(void);
+
+#endif
@@ -0,0 +1,43 @@
+#include "cobs.h"
+
+size_t cobs_codificar(const uint8_t *entrada, size_t tamanho, uint8_t *saida) {
+    size_t escrita = 1;
+    size_t posicao_codigo = 0;
+    uint8_t codigo = 1;
+
+    for (size_t i = 0; i < tamanho; i++) {
+        if (entrada[i] == 0) {
+            saida[posicao_codigo] = codigo;
+            posicao_codigo = escrita++;
+            codigo = 1;
+        } else {
+            saida[escrita++] = entrada[i];
+            if (++codigo == 0xFF) {
+                saida[posicao_codigo] = codigo;
+                posicao_codigo = escrita++;
+                codigo = 1;
+            }
+        }
+    }
+    saida[posicao_codigo] = codigo;
+    return escrita;
+}
+
+size_t cobs_decodificar(const uint8_t *entrada, size_t tamanho, uint8_t *saida) {
+    size_t lida = 0;
+    size_t escrita = 0;
+
+    while (lida < tamanho) {
+        uint8_t codigo = entrada[lida++];
+        if (codigo == 0 || lida + codigo - 1 > tamanho)
+            return 0;
+        for (uint8_t i = 1; i < codigo; i++) {
+            if (entrada[lida] == 0)
+                return 0;
+            saida[escrita++] = entrada[lida++];
+        }
+        if (codigo != 0xFF && lida < tamanho)
+            saida[escrita++] = 0;
+    }
+    return escrita;
+}
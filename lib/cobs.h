@@ -0,0 +1,17 @@
+#ifndef COBS_H
+#define COBS_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+// Consistent Overhead Byte Stuffing: remove todos os zeros do quadro para
+// que 0x00 sirva de delimitador. O overhead e de 1 byte a cada 254.
+#define COBS_TAMANHO_MAX(n) ((n) + (n) / 254 + 1)
+
+// Retorna o tamanho codificado (sem o delimitador).
+size_t cobs_codificar(const uint8_t *entrada, size_t tamanho, uint8_t *saida);
+
+// Retorna o tamanho decodificado, ou 0 se o quadro for invalido.
+size_t cobs_decodificar(const uint8_t *entrada, size_t tamanho, uint8_t *saida);
+
+#endif
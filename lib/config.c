@@ -0,0 +1,102 @@
+#include <stddef.h>
+#include <string.h>
+#include "config.h"
+#include "FreeRTOS.h"
+#include "task.h"
+#include "semphr.h"
+
+static config_estacao_t ativa;
+static SemaphoreHandle_t escritores;
+
+#define PARAM(nome, tipo, campo, min, max) \
+    { #nome, tipo, offsetof(config_estacao_t, campo), sizeof(((config_estacao_t *)0)->campo), min, max }
+
+const param_config_t config_params[] = {
+    PARAM(limiar_agua,         PARAM_CENTESIMOS, limiar_agua,         0, 10000),
+    PARAM(limiar_chuva,        PARAM_CENTESIMOS, limiar_chuva,        0, 10000),
+    PARAM(periodo_amostra_ms,  PARAM_INTEIRO,    periodo_amostra_ms,  10, 10000),
+    PARAM(periodo_display_ms,  PARAM_INTEIRO,    periodo_display_ms,  50, 10000),
+    PARAM(buzzer_ligado_ms,    PARAM_INTEIRO,    buzzer_ligado_ms,    0, 5000),
+    PARAM(buzzer_desligado_ms, PARAM_INTEIRO,    buzzer_desligado_ms, 10, 5000),
+    PARAM(cor_alerta,          PARAM_HEX,        cor_alerta,          0, 0xFFFFFF00u),
+    PARAM(cor_normal,          PARAM_HEX,        cor_normal,          0, 0xFFFFFF00u),
+    PARAM(mqtt_lote,           PARAM_INTEIRO,    mqtt_lote,           1, 1000),
+    PARAM(mqtt_drenagem,       PARAM_INTEIRO,    mqtt_drenagem,       1, 100),
+};
+
+const uint8_t config_num_params = sizeof(config_params) / sizeof(config_params[0]);
+
+void config_padrao(config_estacao_t *c) {
+    *c = (config_estacao_t){
+        .limiar_agua = CONFIG_PADRAO_LIMIAR_AGUA,
+        .limiar_chuva = CONFIG_PADRAO_LIMIAR_CHUVA,
+        .periodo_amostra_ms = CONFIG_PADRAO_PERIODO_AMOSTRA_MS,
+        .periodo_display_ms = CONFIG_PADRAO_PERIODO_DISPLAY_MS,
+        .buzzer_ligado_ms = CONFIG_PADRAO_BUZZER_LIGADO_MS,
+        .buzzer_desligado_ms = CONFIG_PADRAO_BUZZER_DESLIGADO_MS,
+        .cor_alerta = CONFIG_PADRAO_COR_ALERTA,
+        .cor_normal = CONFIG_PADRAO_COR_NORMAL,
+        .calibracao = {{ .pontos = 0 }, { .pontos = 0 }},
+        .mqtt_lote = CONFIG_PADRAO_MQTT_LOTE,
+        .mqtt_drenagem = CONFIG_PADRAO_MQTT_DRENAGEM
+    };
+}
+
+void config_init(void) {
+    config_padrao(&ativa);
+    escritores = xSemaphoreCreateMutex();
+}
+
+// A copia leva poucas dezenas de ciclos; a secao critica garante que
+// nenhuma tarefa veja metade de uma atualizacao.
+void config_obter(config_estacao_t *destino) {
+    taskENTER_CRITICAL();
+    *destino = ativa;
+    taskEXIT_CRITICAL();
+}
+
+void config_aplicar(const config_estacao_t *nova) {
+    taskENTER_CRITICAL();
+    ativa = *nova;
+    taskEXIT_CRITICAL();
+}
+
+// Mutex com heranca de prioridade: o Modbus (prioridade 2) nao fica atras
+// de uma tarefa media enquanto o shell (idle) segura a configuracao.
+void config_travar(void) {
+    xSemaphoreTake(escritores, portMAX_DELAY);
+}
+
+void config_liberar(void) {
+    xSemaphoreGive(escritores);
+}
+
+const param_config_t *config_param(const char *nome) {
+    for (uint8_t i = 0; i < config_num_params; i++) {
+        if (strcmp(config_params[i].nome, nome) == 0)
+            return &config_params[i];
+    }
+    return NULL;
+}
+
+uint32_t config_ler_param(const config_estacao_t *c, const param_config_t *p) {
+    const uint8_t *base = (const uint8_t *)c + p->offset;
+    if (p->tamanho == sizeof(uint16_t)) {
+        uint16_t v;
+        memcpy(&v, base, sizeof(v));
+        return v;
+    }
+    uint32_t v;
+    memcpy(&v, base, sizeof(v));
+    return v;
+}
+
+void config_escrever_param(config_estacao_t *c, const param_config_t *p, uint32_t valor) {
+    uint8_t *base = (uint8_t *)c + p->offset;
+    if (p->tamanho == sizeof(uint16_t)) {
+        uint16_t v = (uint16_t)valor;
+        memcpy(base, &v, sizeof(v));
+    } else {
+        memcpy(base, &valor, sizeof(valor));
+    }
+}
@@ -0,0 +1,93 @@
+#ifndef CONFIG_H
+#define CONFIG_H
+
+#include "pico/stdlib.h"
+
+// -------------------- Configuracao da estacao --------------------
+// Parametros ajustaveis em tempo de execucao (shell USB). As tarefas leem
+// uma copia completa a cada ciclo com config_obter, entao uma alteracao
+// feita por config_aplicar e vista inteira ou nao e vista: nunca meio
+// aplicada.
+
+// Valores padrao (antes eram #defines e literais nas tarefas)
+#define CONFIG_PADRAO_LIMIAR_AGUA   7000 // centesimos de %
+#define CONFIG_PADRAO_LIMIAR_CHUVA  8000
+#define CONFIG_PADRAO_PERIODO_AMOSTRA_MS 100
+#define CONFIG_PADRAO_PERIODO_DISPLAY_MS 500
+#define CONFIG_PADRAO_BUZZER_LIGADO_MS    200
+#define CONFIG_PADRAO_BUZZER_DESLIGADO_MS 300
+#define CONFIG_PADRAO_COR_ALERTA 0x00FF0000u // GRB da matriz WS2812: vermelho
+#define CONFIG_PADRAO_COR_NORMAL 0xFF000000u // verde
+#define CONFIG_PADRAO_MQTT_LOTE      50 // amostras por mensagem (5 s a 100 ms)
+#define CONFIG_PADRAO_MQTT_DRENAGEM  5  // lotes atrasados por segundo (mqtt.h)
+
+// Curva de calibracao de um canal do ADC: pares (contagem bruta, valor em
+// centesimos de %) ordenados pela contagem. Com menos de 2 pontos vale o
+// mapeamento ideal 0..4095 -> 0..100%. Ver calibracao.h.
+#define CONFIG_CALIBRACAO_PONTOS 8
+#define CONFIG_CANAIS 2 // 0 = nivel, 1 = chuva
+
+typedef struct {
+    uint8_t pontos;
+    uint8_t reservado;
+    uint16_t bruto[CONFIG_CALIBRACAO_PONTOS];
+    uint16_t valor[CONFIG_CALIBRACAO_PONTOS];
+} calibracao_canal_t;
+
+// Campos novos so no fim: config_flash.c aproveita registros mais curtos.
+typedef struct {
+    uint16_t limiar_agua;  // centesimos de %
+    uint16_t limiar_chuva; // centesimos de %
+    uint16_t periodo_amostra_ms;
+    uint16_t periodo_display_ms;
+    uint16_t buzzer_ligado_ms;
+    uint16_t buzzer_desligado_ms;
+    uint32_t cor_alerta;
+    uint32_t cor_normal;
+    calibracao_canal_t calibracao[CONFIG_CANAIS];
+    uint16_t mqtt_lote;
+    uint16_t mqtt_drenagem;
+} config_estacao_t;
+
+void config_init(void);
+
+// Preenche c com os valores de compilacao.
+void config_padrao(config_estacao_t *c);
+
+// Copia consistente da configuracao ativa.
+void config_obter(config_estacao_t *destino);
+
+// Substitui a configuracao ativa de uma vez.
+void config_aplicar(const config_estacao_t *nova);
+
+// Quem altera a configuracao (shell, Modbus) faz config_obter, muda a copia
+// e config_aplicar entre config_travar e config_liberar: dois escritores
+// nunca desfazem a alteracao um do outro. Os leitores nao travam.
+void config_travar(void);
+void config_liberar(void);
+
+// -------------------- Tabela de parametros --------------------
+// Usada pelo shell para get/set por nome, com validacao de faixa.
+typedef enum {
+    PARAM_CENTESIMOS, // mostrado como decimal com 2 casas
+    PARAM_INTEIRO,
+    PARAM_HEX
+} tipo_param_t;
+
+typedef struct {
+    const char *nome;
+    tipo_param_t tipo;
+    uint8_t offset;
+    uint8_t tamanho; // 2 ou 4 bytes
+    uint32_t minimo;
+    uint32_t maximo;
+} param_config_t;
+
+extern const param_config_t config_params[];
+extern const uint8_t config_num_params;
+
+const param_config_t *config_param(const char *nome);
+uint32_t config_ler_param(const config_estacao_t *c, const param_config_t *p);
+void config_escrever_param(config_estacao_t *c, const param_config_t *p, uint32_t valor);
+
+#endif
@@ -0,0 +1,100 @@
+#include <stddef.h>
+#include <string.h>
+#include "config_flash.h"
+#include "crc16.h"
+#include "flash_hw.h"
+#include "tlog.h"
+
+// Novos campos so podem ser acrescentados ao fim de config_estacao_t: um
+// registro mais curto (gravado por firmware anterior) ainda e aproveitado,
+// com os campos que faltam ficando no valor padrao.
+typedef struct {
+    uint32_t magia;
+    uint16_t versao;
+    uint16_t tamanho; // sizeof(config_estacao_t) de quem gravou
+    uint32_t geracao;
+    uint16_t crc;     // cobre o cabecalho ate aqui (sem o crc) e a config
+    uint16_t reservado;
+} cabecalho_config_t;
+
+typedef struct {
+    cabecalho_config_t cabecalho;
+    config_estacao_t config;
+} registro_config_t;
+
+_Static_assert(sizeof(registro_config_t) <= FLASH_PAGE_SIZE, "registro de configuracao maior que uma pagina");
+
+static int8_t setor_atual = -1; // setor com a copia valida mais recente
+static uint32_t geracao_atual;
+
+static uint32_t offset_setor(uint8_t setor) {
+    return FLASH_HW_CONFIG_OFFSET + setor * FLASH_SECTOR_SIZE;
+}
+
+static uint16_t crc_registro(const cabecalho_config_t *c, const void *config, uint16_t tamanho) {
+    uint16_t crc = crc16(c, offsetof(cabecalho_config_t, crc));
+    return crc16_atualizar(crc, config, tamanho);
+}
+
+static const cabecalho_config_t *registro_valido(uint8_t setor) {
+    const cabecalho_config_t *c = (const cabecalho_config_t *)flash_hw_ler(offset_setor(setor));
+    if (c->magia != CONFIG_FLASH_MAGIA || c->versao != CONFIG_FLASH_VERSAO)
+        return NULL;
+    if (c->tamanho == 0 || c->tamanho > FLASH_PAGE_SIZE - sizeof(*c))
+        return NULL;
+    if (crc_registro(c, c + 1, c->tamanho) != c->crc)
+        return NULL;
+    return c;
+}
+
+bool config_flash_carregar(void) {
+    const cabecalho_config_t *regs[FLASH_HW_CONFIG_SETORES];
+    setor_atual = -1;
+    for (uint8_t s = 0; s < FLASH_HW_CONFIG_SETORES; s++) {
+        regs[s] = registro_valido(s);
+        // Comparacao com sinal: a geracao pode dar a volta
+        if (regs[s] && (setor_atual < 0 || (int32_t)(regs[s]->geracao - geracao_atual) > 0)) {
+            setor_atual = (int8_t)s;
+            geracao_atual = regs[s]->geracao;
+        }
+    }
+    if (setor_atual < 0)
+        return false;
+
+    const cabecalho_config_t *c = regs[setor_atual];
+    config_estacao_t config;
+    config_padrao(&config);
+    memcpy(&config, c + 1, c->tamanho < sizeof(config) ? c->tamanho : sizeof(config));
+    config_aplicar(&config);
+
+    TLOG("config: geracao %u carregada do setor %u", geracao_atual, (uint32_t)setor_atual);
+    return true;
+}
+
+bool config_flash_salvar(void) {
+    static uint8_t pagina[FLASH_PAGE_SIZE]; // so a tarefa do shell grava
+    registro_config_t *r = (registro_config_t *)pagina;
+    uint8_t destino = setor_atual == 0 ? 1 : 0;
+
+    memset(pagina, 0xFF, sizeof(pagina));
+    r->cabecalho.magia = CONFIG_FLASH_MAGIA;
+    r->cabecalho.versao = CONFIG_FLASH_VERSAO;
+    r->cabecalho.tamanho = sizeof(config_estacao_t);
+    r->cabecalho.geracao = setor_atual < 0 ? 1 : geracao_atual + 1;
+    r->cabecalho.reservado = 0xFFFF;
+    config_obter(&r->config);
+    r->cabecalho.crc = crc_registro(&r->cabecalho, &r->config, sizeof(r->config));
+
+    flash_hw_apagar_setor(offset_setor(destino));
+    flash_hw_programar_pagina(offset_setor(destino), pagina);
+
+    // Confere a gravacao pela XIP antes de trocar de setor
+    if (!registro_valido(destino) || memcmp(flash_hw_ler(offset_setor(destino)), pagina, sizeof(registro_config_t)) != 0) {
+        TLOG("config: falha ao gravar o setor %u", (uint32_t)destino);
+        return false;
+    }
+    setor_atual = (int8_t)destino;
+    geracao_atual = r->cabecalho.geracao;
+    TLOG("config: geracao %u gravada no setor %u", geracao_atual, (uint32_t)destino);
+    return true;
+}
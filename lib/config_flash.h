@@ -0,0 +1,28 @@
+#ifndef CONFIG_FLASH_H
+#define CONFIG_FLASH_H
+
+#include "pico/stdlib.h"
+#include "config.h"
+
+// -------------------- Configuracao persistente --------------------
+// A configuracao fica gravada em dois setores alternados. Cada gravacao vai
+// para o setor que NAO tem a copia valida mais recente, com uma geracao
+// maior; a copia anterior so deixa de valer quando a nova esta completa e
+// com CRC correto. Uma queda de energia no meio da gravacao apenas mantem
+// a configuracao anterior.
+//
+// No boot o registro e validado e copiado direto da janela XIP, sem
+// nenhuma interpretacao: a estrutura gravada e a propria config_estacao_t.
+
+#define CONFIG_FLASH_MAGIA  0x47464346u // "FCFG"
+#define CONFIG_FLASH_VERSAO 1
+
+// Carrega a copia valida mais recente, se houver, sobre os valores padrao.
+// Chamar depois de config_init e antes de iniciar o escalonador.
+bool config_flash_carregar(void);
+
+// Grava a configuracao ativa. Apaga um setor (dezenas de ms com as
+// interrupcoes desabilitadas), entao so deve ser chamada sob demanda.
+bool config_flash_salvar(void);
+
+#endif
@@ -0,0 +1,18 @@
+#include "crc16.h"
+
+// Implementacao por nibble: tabela de 16 entradas (32 bytes) em vez de 512,
+// bom compromisso entre tamanho e velocidade no Cortex-M0+.
+static const uint16_t tabela_nibble[16] = {
+    0x0000, 0x1021, 0x2042, 0x3063, 0x4084, 0x50A5, 0x60C6, 0x70E7,
+    0x8108, 0x9129, 0xA14A, 0xB16B, 0xC18C, 0xD1AD, 0xE1CE, 0xF1EF
+};
+
+uint16_t crc16_atualizar(uint16_t crc, const void *dados, size_t tamanho) {
+    const uint8_t *p = (const uint8_t *)dados;
+    while (tamanho--) {
+        crc = (uint16_t)((crc << 4) ^ tabela_nibble[(crc >> 12) ^ (*p >> 4)]);
+        crc = (uint16_t)((crc << 4) ^ tabela_nibble[(crc >> 12) ^ (*p & 0x0F)]);
+        p++;
+    }
+    return crc;
+}
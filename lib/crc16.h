@@ -0,0 +1,17 @@
+#ifndef CRC16_H
+#define CRC16_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+// CRC-16/CCITT-FALSE (polinomio 0x1021, valor inicial 0xFFFF).
+// Usado para validar paginas do log em flash e quadros de telemetria.
+#define CRC16_INICIAL 0xFFFF
+
+uint16_t crc16_atualizar(uint16_t crc, const void *dados, size_t tamanho);
+
+static inline uint16_t crc16(const void *dados, size_t tamanho) {
+    return crc16_atualizar(CRC16_INICIAL, dados, tamanho);
+}
+
+#endif
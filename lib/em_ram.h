@@ -0,0 +1,24 @@
+#ifndef EM_RAM_H
+#define EM_RAM_H
+
+#include "pico/stdlib.h"
+
+// -------------------- Codigo na SRAM --------------------
+// Todo o codigo executa da flash QSPI pela cache da XIP. Uma falta de cache
+// (por exemplo depois que o desenho do display expulsou as linhas) para a
+// CPU enquanto a linha e buscada na flash. Com ESTACAO_CODIGO_EM_RAM (opcao
+// do CMake, ligada por padrao), as funcoes marcadas com EM_RAM sao copiadas
+// para a SRAM no boot: a ISR do DMA, a leitura e avaliacao do alerta e os
+// drivers da matriz WS2812 e do buzzer.
+
+#ifndef ESTACAO_CODIGO_EM_RAM
+#define ESTACAO_CODIGO_EM_RAM 0
+#endif
+
+#if ESTACAO_CODIGO_EM_RAM
+#define EM_RAM(funcao) __not_in_flash_func(funcao)
+#else
+#define EM_RAM(funcao) funcao
+#endif
+
+#endif
@@ -0,0 +1,25 @@
+#include "flash_hw.h"
+#include "hardware/sync.h"
+
+// As rotinas ficam em SRAM: entre desabilitar as interrupcoes e chamar o
+// SDK nao pode haver nenhuma busca de instrucao pela XIP.
+void __no_inline_not_in_flash_func(flash_hw_apagar_setor)(uint32_t offset) {
+    uint32_t ints = save_and_disable_interrupts();
+    flash_range_erase(offset, FLASH_SECTOR_SIZE);
+    restore_interrupts(ints);
+}
+
+void __no_inline_not_in_flash_func(flash_hw_programar_pagina)(uint32_t offset, const uint8_t *dados) {
+    uint32_t ints = save_and_disable_interrupts();
+    flash_range_program(offset, dados, FLASH_PAGE_SIZE);
+    restore_interrupts(ints);
+}
+
+bool flash_hw_apagado(uint32_t offset, size_t tamanho) {
+    const uint32_t *p = (const uint32_t *)flash_hw_ler(offset);
+    for (size_t i = 0; i < tamanho / sizeof(uint32_t); i++) {
+        if (p[i] != 0xFFFFFFFFu)
+            return false;
+    }
+    return true;
+}
@@ -0,0 +1,31 @@
+#ifndef FLASH_HW_H
+#define FLASH_HW_H
+
+#include "pico/stdlib.h"
+#include "hardware/flash.h"
+
+// -------------------- Mapa da flash --------------------
+// O firmware ocupa o inicio da flash QSPI; o ultimo 1 MB fica reservado
+// para o log circular de amostras e eventos e, logo antes dele, dois
+// setores guardam a configuracao persistente (config_flash.c).
+#define FLASH_HW_LOG_TAMANHO   (1024u * 1024u)
+#define FLASH_HW_LOG_OFFSET    (PICO_FLASH_SIZE_BYTES - FLASH_HW_LOG_TAMANHO)
+#define FLASH_HW_CONFIG_SETORES 2
+#define FLASH_HW_CONFIG_OFFSET (FLASH_HW_LOG_OFFSET - FLASH_HW_CONFIG_SETORES * FLASH_SECTOR_SIZE)
+
+// Acesso de leitura direto pela janela XIP (sem copia).
+static inline const uint8_t *flash_hw_ler(uint32_t offset) {
+    return (const uint8_t *)(XIP_BASE + offset);
+}
+
+// Apaga um setor de 4 KB. Interrupcoes ficam desabilitadas durante a
+// operacao, pois nenhum codigo pode executar da flash enquanto ela apaga.
+void flash_hw_apagar_setor(uint32_t offset);
+
+// Grava uma pagina de 256 bytes a partir de um buffer em RAM.
+void flash_hw_programar_pagina(uint32_t offset, const uint8_t *dados);
+
+// Retorna true se a regiao esta completamente apagada (0xFF).
+bool flash_hw_apagado(uint32_t offset, size_t tamanho);
+
+#endif
@@ -0,0 +1,312 @@
+#include <string.h>
+#include "flash_log.h"
+#include "crc16.h"
+#include "tlog.h"
+#include "FreeRTOS.h"
+#include "task.h"
+
+#define PAGINA_NENHUMA 0xFFFFFFFFu
+
+#define FLASH_LOG_BUFFERS 3
+
+typedef struct {
+    cabecalho_pagina_t cabecalho;
+    union {
+        registro_log_t registros[REGISTRO_LOG_POR_PAGINA];
+        uint8_t dados[REGISTRO_LOG_TAMANHO_DADOS];
+    };
+} pagina_log_t;
+
+_Static_assert(sizeof(pagina_log_t) == FLASH_PAGE_SIZE, "pagina do log deve ter 256 bytes");
+_Static_assert(REGISTRO_LOG_TAMANHO_PAGINA == FLASH_PAGE_SIZE, "formato do log assume paginas de 256 bytes");
+
+typedef enum {
+    BUFFER_LIVRE,
+    BUFFER_EVENTOS,   // recebendo registros de flash_log_registrar
+    BUFFER_RESERVADO, // sendo copiado por flash_log_registrar_serie
+    BUFFER_PENDENTE   // aguardando gravacao pela tarefa
+} estado_buffer_t;
+
+// Paginas em RAM: uma acumula eventos, as outras recebem blocos
+// comprimidos prontos ou aguardam gravacao.
+static pagina_log_t buffers[FLASH_LOG_BUFFERS];
+static volatile uint8_t estado[FLASH_LOG_BUFFERS];
+static int8_t buffer_eventos = -1;
+static TickType_t primeiro_evento; // quando o buffer de eventos recebeu o primeiro registro
+
+static uint32_t cabeca = PAGINA_NENHUMA; // ultima pagina gravada
+static uint32_t cauda = PAGINA_NENHUMA;  // pagina mais antiga
+static uint32_t sequencia;
+static uint32_t descartados;
+static TaskHandle_t tarefa_log;
+
+// -------------------- Leitura da flash --------------------
+static inline const cabecalho_pagina_t *cabecalho(uint32_t pagina) {
+    return (const cabecalho_pagina_t *)flash_hw_ler(FLASH_HW_LOG_OFFSET + pagina * FLASH_PAGE_SIZE);
+}
+
+static inline bool pagina_valida(uint32_t pagina) {
+    uint32_t magia = cabecalho(pagina)->magia;
+    return magia == REGISTRO_LOG_MAGIA || magia == REGISTRO_LOG_MAGIA_SERIE ||
+           magia == REGISTRO_LOG_MAGIA_CAPTURA;
+}
+
+static inline uint32_t circular(uint32_t pagina) {
+    return pagina % FLASH_LOG_NUM_PAGINAS;
+}
+
+// -------------------- Recuperacao no boot --------------------
+// Partindo de qualquer pagina valida (pivo) e andando para frente, as paginas
+// sao validas e crescentes ate a cabeca; depois vem o trecho apagado e as
+// paginas mais antigas que o pivo. O predicado "valida e sequencia >= pivo"
+// e portanto verdadeiro num prefixo, e a cabeca e achada por busca binaria.
+static uint32_t buscar_cabeca(uint32_t pivo) {
+    uint32_t seq_pivo = cabecalho(pivo)->sequencia;
+    uint32_t lo = 0, hi = FLASH_LOG_NUM_PAGINAS - 1;
+    while (lo < hi) {
+        uint32_t meio = lo + (hi - lo + 1) / 2;
+        uint32_t p = circular(pivo + meio);
+        if (pagina_valida(p) && cabecalho(p)->sequencia >= seq_pivo)
+            lo = meio;
+        else
+            hi = meio - 1;
+    }
+    return circular(pivo + lo);
+}
+
+// Depois da cabeca so ha paginas invalidas ate a mais antiga; dali em diante
+// todas sao validas. Busca binaria pela primeira valida.
+static uint32_t buscar_cauda(uint32_t cab) {
+    uint32_t lo = 1, hi = FLASH_LOG_NUM_PAGINAS; // hi volta a propria cabeca
+    while (lo < hi) {
+        uint32_t meio = lo + (hi - lo) / 2;
+        if (pagina_valida(circular(cab + meio)))
+            hi = meio;
+        else
+            lo = meio + 1;
+    }
+    return circular(cab + lo);
+}
+
+static void apagar_setor(uint32_t setor) {
+    setor %= FLASH_LOG_NUM_SETORES;
+    uint32_t offset = FLASH_HW_LOG_OFFSET + setor * FLASH_SECTOR_SIZE;
+    if (!flash_hw_apagado(offset, FLASH_SECTOR_SIZE)) {
+        flash_hw_apagar_setor(offset);
+        TLOG("flash_log: setor %u apagado", setor);
+    }
+
+    // Se a cauda estava nesse setor, os registros mais antigos foram perdidos
+    if (cauda != PAGINA_NENHUMA && cauda / FLASH_LOG_PAGINAS_POR_SETOR == setor)
+        cauda = circular((setor + 1) * FLASH_LOG_PAGINAS_POR_SETOR);
+}
+
+static void liberar(pagina_log_t *pagina) {
+    memset(pagina, 0xFF, sizeof(*pagina));
+    pagina->cabecalho.quantidade = 0;
+}
+
+void flash_log_init(void) {
+    for (uint8_t i = 0; i < FLASH_LOG_BUFFERS; i++) {
+        liberar(&buffers[i]);
+        estado[i] = BUFFER_LIVRE;
+    }
+    buffer_eventos = -1;
+
+    // Todo setor em uso comeca com uma pagina valida, entao basta olhar o
+    // inicio de cada setor para achar um pivo.
+    uint32_t pivo = PAGINA_NENHUMA;
+    for (uint32_t s = 0; s < FLASH_LOG_NUM_SETORES; s++) {
+        if (pagina_valida(s * FLASH_LOG_PAGINAS_POR_SETOR)) {
+            pivo = s * FLASH_LOG_PAGINAS_POR_SETOR;
+            break;
+        }
+    }
+
+    if (pivo == PAGINA_NENHUMA) {
+        // Log vazio: prepara os dois primeiros setores
+        cabeca = cauda = PAGINA_NENHUMA;
+        sequencia = 0;
+        apagar_setor(0);
+        apagar_setor(1);
+        return;
+    }
+
+    cabeca = buscar_cabeca(pivo);
+    cauda = buscar_cauda(cabeca);
+    sequencia = cabecalho(cabeca)->sequencia;
+
+    // Uma queda de energia pode ter deixado paginas meio gravadas depois da
+    // cabeca; pula ate a proxima pagina realmente apagada do setor.
+    uint32_t proxima = circular(cabeca + 1);
+    while (proxima % FLASH_LOG_PAGINAS_POR_SETOR != 0 &&
+           !flash_hw_apagado(FLASH_HW_LOG_OFFSET + proxima * FLASH_PAGE_SIZE, FLASH_PAGE_SIZE)) {
+        cabeca = proxima;
+        proxima = circular(proxima + 1);
+    }
+    // Garante o invariante "setor a frente apagado" (normalmente ja vale e a
+    // verificacao nao apaga nada); no inicio de setor, gravar_pagina cuida disso.
+    if (proxima % FLASH_LOG_PAGINAS_POR_SETOR == 0)
+        apagar_setor(proxima / FLASH_LOG_PAGINAS_POR_SETOR);
+    else
+        apagar_setor(proxima / FLASH_LOG_PAGINAS_POR_SETOR + 1);
+}
+
+// -------------------- Escrita --------------------
+// Chamar com a secao critica ativa.
+static int8_t reservar_buffer(estado_buffer_t novo) {
+    for (int8_t i = 0; i < FLASH_LOG_BUFFERS; i++) {
+        if (estado[i] == BUFFER_LIVRE) {
+            estado[i] = novo;
+            return i;
+        }
+    }
+    return -1;
+}
+
+bool flash_log_registrar(const registro_log_t *registro) {
+    bool aceito = false;
+    bool cheio = false;
+
+    taskENTER_CRITICAL();
+    if (buffer_eventos < 0) {
+        buffer_eventos = reservar_buffer(BUFFER_EVENTOS);
+        if (buffer_eventos >= 0)
+            buffers[buffer_eventos].cabecalho.magia = REGISTRO_LOG_MAGIA;
+    }
+    if (buffer_eventos >= 0) {
+        pagina_log_t *pagina = &buffers[buffer_eventos];
+        if (pagina->cabecalho.quantidade == 0)
+            primeiro_evento = xTaskGetTickCount();
+        pagina->registros[pagina->cabecalho.quantidade++] = *registro;
+        aceito = true;
+        if (pagina->cabecalho.quantidade == REGISTRO_LOG_POR_PAGINA) {
+            estado[buffer_eventos] = BUFFER_PENDENTE;
+            buffer_eventos = -1;
+            cheio = true;
+        }
+    } else {
+        descartados++;
+    }
+    taskEXIT_CRITICAL();
+
+    if (cheio && tarefa_log != NULL)
+        xTaskNotifyGive(tarefa_log);
+    return aceito;
+}
+
+// Recusar nao e perder: a captura oferece o mesmo bloco de novo. So quem
+// desiste do bloco conta o descarte (flash_log_registrar_serie).
+bool flash_log_registrar_bloco(uint32_t magia, const void *dados, size_t tamanho, uint16_t quantidade) {
+    taskENTER_CRITICAL();
+    int8_t i = reservar_buffer(BUFFER_RESERVADO);
+    taskEXIT_CRITICAL();
+    if (i < 0)
+        return false;
+
+    // A copia acontece fora da secao critica: o buffer reservado nao e
+    // tocado por mais ninguem ate ser marcado como pendente.
+    pagina_log_t *pagina = &buffers[i];
+    memcpy(pagina->dados, dados, tamanho);
+    pagina->cabecalho.magia = magia;
+    pagina->cabecalho.quantidade = quantidade;
+    estado[i] = BUFFER_PENDENTE;
+
+    if (tarefa_log != NULL)
+        xTaskNotifyGive(tarefa_log);
+    return true;
+}
+
+// A serie reinicia o bloco logo depois, entao uma recusa perde as amostras
+bool flash_log_registrar_serie(const serie_comp_t *serie) {
+    if (flash_log_registrar_bloco(REGISTRO_LOG_MAGIA_SERIE, serie->bloco, serie_comp_bytes(serie), serie->amostras))
+        return true;
+    taskENTER_CRITICAL();
+    descartados += serie->amostras;
+    taskEXIT_CRITICAL();
+    return false;
+}
+
+static void gravar_pagina(pagina_log_t *pagina) {
+    uint32_t proxima = (cabeca == PAGINA_NENHUMA) ? 0 : circular(cabeca + 1);
+
+    // Ao entrar num setor novo, apaga o seguinte: a escrita nunca espera
+    // por um apagamento no setor em que esta gravando.
+    if (proxima % FLASH_LOG_PAGINAS_POR_SETOR == 0)
+        apagar_setor(proxima / FLASH_LOG_PAGINAS_POR_SETOR + 1);
+
+    pagina->cabecalho.sequencia = ++sequencia;
+    pagina->cabecalho.crc = crc16(pagina->dados, sizeof(pagina->dados));
+    flash_hw_programar_pagina(FLASH_HW_LOG_OFFSET + proxima * FLASH_PAGE_SIZE, (const uint8_t *)pagina);
+
+    TLOG("flash_log: pagina %u seq %u formato %x", proxima, sequencia, pagina->cabecalho.magia);
+    cabeca = proxima;
+    if (cauda == PAGINA_NENHUMA)
+        cauda = proxima;
+}
+
+void vFlashLogTask(void *params) {
+    tarefa_log = xTaskGetCurrentTaskHandle();
+
+    TickType_t espera = pdMS_TO_TICKS(FLASH_LOG_DESCARGA_MS);
+
+    while (true) {
+        ulTaskNotifyTake(pdTRUE, espera);
+
+        // Eventos com FLASH_LOG_DESCARGA_MS em RAM vao para a flash mesmo
+        // sem encher a pagina, para limitar a perda numa queda de energia.
+        // A idade e conferida a cada despertar: as paginas da serie e da
+        // captura acordam a tarefa bem antes de o prazo vencer sozinho.
+        espera = pdMS_TO_TICKS(FLASH_LOG_DESCARGA_MS);
+        taskENTER_CRITICAL();
+        if (buffer_eventos >= 0 && buffers[buffer_eventos].cabecalho.quantidade > 0) {
+            TickType_t idade = xTaskGetTickCount() - primeiro_evento;
+            if (idade >= pdMS_TO_TICKS(FLASH_LOG_DESCARGA_MS)) {
+                estado[buffer_eventos] = BUFFER_PENDENTE;
+                buffer_eventos = -1;
+            } else {
+                espera = pdMS_TO_TICKS(FLASH_LOG_DESCARGA_MS) - idade;
+            }
+        }
+        taskEXIT_CRITICAL();
+
+        for (uint8_t i = 0; i < FLASH_LOG_BUFFERS; i++) {
+            if (estado[i] == BUFFER_PENDENTE) {
+                gravar_pagina(&buffers[i]);
+                liberar(&buffers[i]);
+                estado[i] = BUFFER_LIVRE;
+            }
+        }
+    }
+}
+
+// -------------------- Leitura --------------------
+uint32_t flash_log_paginas(void) {
+    if (cabeca == PAGINA_NENHUMA)
+        return 0;
+    return circular(cabeca + FLASH_LOG_NUM_PAGINAS - cauda) + 1;
+}
+
+const void *flash_log_pagina(uint32_t indice, formato_pagina_t *formato, uint16_t *quantidade) {
+    if (indice >= flash_log_paginas())
+        return NULL;
+    const cabecalho_pagina_t *c = cabecalho(circular(cauda + indice));
+    const uint8_t *dados = (const uint8_t *)(c + 1);
+    if (crc16(dados, REGISTRO_LOG_TAMANHO_DADOS) != c->crc)
+        return NULL;
+
+    if (c->magia == REGISTRO_LOG_MAGIA && c->quantidade <= REGISTRO_LOG_POR_PAGINA)
+        *formato = PAGINA_REGISTROS;
+    else if (c->magia == REGISTRO_LOG_MAGIA_SERIE)
+        *formato = PAGINA_SERIE;
+    else if (c->magia == REGISTRO_LOG_MAGIA_CAPTURA)
+        *formato = PAGINA_CAPTURA;
+    else
+        return NULL;
+    *quantidade = c->quantidade;
+    return dados;
+}
+
+uint32_t flash_log_descartados(void) {
+    return descartados;
+}
@@ -0,0 +1,60 @@
+#ifndef FLASH_LOG_H
+#define FLASH_LOG_H
+
+#include "pico/stdlib.h"
+#include "flash_hw.h"
+#include "registro_log.h"
+#include "serie_comp.h"
+
+// -------------------- Log circular em flash --------------------
+// Os registros sao acumulados em RAM e gravados em paginas inteiras de 256
+// bytes. O setor seguinte ao ponteiro de escrita e sempre apagado com
+// antecedencia, entao a regiao fica dividida em: [mais novos][apagado][mais
+// antigos]. Cada pagina carrega um numero de sequencia crescente, o que
+// permite achar cabeca e cauda por busca binaria no boot.
+
+#define FLASH_LOG_PAGINAS_POR_SETOR (FLASH_SECTOR_SIZE / FLASH_PAGE_SIZE)
+#define FLASH_LOG_NUM_PAGINAS       (FLASH_HW_LOG_TAMANHO / FLASH_PAGE_SIZE)
+#define FLASH_LOG_NUM_SETORES       (FLASH_HW_LOG_TAMANHO / FLASH_SECTOR_SIZE)
+
+// Tempo maximo que registros podem ficar em RAM antes de uma gravacao parcial
+#define FLASH_LOG_DESCARGA_MS       60000
+
+typedef enum {
+    PAGINA_REGISTROS, // registro_log_t crus (eventos)
+    PAGINA_SERIE,     // bloco de amostras comprimido com serie_comp
+    PAGINA_CAPTURA    // trecho de uma janela de captura (captura.c)
+} formato_pagina_t;
+
+// Recupera cabeca e cauda a partir do conteudo da flash. Chamar uma vez,
+// antes de iniciar o escalonador.
+void flash_log_init(void);
+
+// Copia o registro para o buffer em RAM. Nunca bloqueia: se os dois buffers
+// estiverem ocupados o registro e descartado e contabilizado.
+bool flash_log_registrar(const registro_log_t *registro);
+
+// Entrega um bloco comprimido completo (ate REGISTRO_LOG_TAMANHO_DADOS
+// bytes) para gravacao em pagina propria. Tambem nao bloqueia; sem buffer,
+// as amostras do bloco sao descartadas e contadas.
+bool flash_log_registrar_serie(const serie_comp_t *serie);
+
+// Grava uma pagina com conteudo pronto (ate REGISTRO_LOG_TAMANHO_DADOS bytes)
+// identificada pela magia. Retorna false, sem bloquear, se nao houver buffer;
+// nada e contado como descarte, porque quem chama pode oferecer de novo.
+bool flash_log_registrar_bloco(uint32_t magia, const void *dados, size_t tamanho, uint16_t quantidade);
+
+// Tarefa que grava as paginas cheias e apaga setores a frente da escrita.
+void vFlashLogTask(void *params);
+
+// Paginas gravadas, da mais antiga (0) para a mais nova.
+uint32_t flash_log_paginas(void);
+
+// Retorna a area de dados da pagina indicada (NULL se invalida ou
+// corrompida). Para PAGINA_SERIE e PAGINA_CAPTURA, quantidade e o numero
+// de amostras.
+const void *flash_log_pagina(uint32_t indice, formato_pagina_t *formato, uint16_t *quantidade);
+
+uint32_t flash_log_descartados(void);
+
+#endif
@@ -0,0 +1,48 @@
+#include "formatar.h"
+
+void formatar_percentual(char *destino, uint16_t decimos) {
+    char digitos[5];
+    uint8_t n = 0;
+    uint16_t inteiro = decimos / 10;
+
+    do {
+        digitos[n++] = (char)('0' + inteiro % 10);
+        inteiro /= 10;
+    } while (inteiro);
+
+    while (n)
+        *destino++ = digitos[--n];
+    *destino++ = '.';
+    *destino++ = (char)('0' + decimos % 10);
+    *destino++ = '%';
+    *destino = '\0';
+}
+
+uint8_t formatar_decimal(char *destino, uint32_t valor, uint8_t casas) {
+    char digitos[10];
+    uint8_t n = 0;
+
+    do {
+        digitos[n++] = (char)('0' + valor % 10);
+        valor /= 10;
+    } while (valor || n <= casas);
+
+    uint8_t escritos = 0;
+    while (n) {
+        if (n == casas)
+            destino[escritos++] = '.';
+        destino[escritos++] = digitos[--n];
+    }
+    destino[escritos] = '\0';
+    return escritos;
+}
+
+uint8_t formatar_hex(char *destino, uint32_t valor) {
+    static const char hex[] = "0123456789ABCDEF";
+    destino[0] = '0';
+    destino[1] = 'x';
+    for (uint8_t i = 0; i < 8; i++)
+        destino[2 + i] = hex[(valor >> (28 - 4 * i)) & 0xF];
+    destino[10] = '\0';
+    return 10;
+}
@@ -0,0 +1,23 @@
+#ifndef FORMATAR_H
+#define FORMATAR_H
+
+#include <stdint.h>
+
+// Formatacao de numeros sem printf: nada de ponto flutuante nem das
+// centenas de bytes de pilha que o vfprintf da newlib usa.
+
+#define FORMATAR_PERCENTUAL_MAX 8 // "6553.5%" + terminador
+
+// Escreve decimos de % como "NN.N%" (equivale a "%.1f%%").
+void formatar_percentual(char *destino, uint16_t decimos);
+
+#define FORMATAR_NUMERO_MAX 12 // "4294967295" ou "0xFFFFFFFF" + terminador
+
+// Escreve valor com casas decimais fixas (casas = 2: 7050 -> "70.50").
+// Retorna o numero de caracteres escritos, sem o terminador.
+uint8_t formatar_decimal(char *destino, uint32_t valor, uint8_t casas);
+
+// Escreve valor como "0xXXXXXXXX".
+uint8_t formatar_hex(char *destino, uint32_t valor);
+
+#endif
@@ -0,0 +1,472 @@
+#include <string.h>
+#include "http.h"
+#include "mqtt.h"
+#include "formatar.h"
+#include "tlog.h"
+#include "pico/cyw43_arch.h"
+#include "lwip/tcp.h"
+#include "FreeRTOS.h"
+#include "task.h"
+
+// Cabecalho HTTP e JSON ficam colados no mesmo buffer: o JSON comeca em
+// CABECALHO_MAX e o cabecalho e escrito logo antes dele, alinhado a direita.
+#define CABECALHO_MAX 160
+#define PEDIDO_MAX    32 // inicio da linha do pedido ("GET /eventos HTTP/1.1")
+#define SEM_RETRATO   0xFF
+
+_Static_assert(HTTP_RETRATO_MAX > CABECALHO_MAX + 300, "JSON nao cabe no retrato");
+
+typedef struct {
+    char dados[HTTP_RETRATO_MAX];
+    uint16_t inicio;   // resposta HTTP: dados[inicio..fim)
+    uint16_t json;     // JSON: dados[json..fim), seguido de "\n\n" para o SSE
+    uint16_t fim;
+} retrato_t;
+
+typedef enum {
+    ROTA_NENHUMA,
+    ROTA_RETRATO,
+    ROTA_EVENTOS,
+    ROTA_NAO_ACHADA,
+    ROTA_METODO
+} rota_t;
+
+typedef struct {
+    struct tcp_pcb *pcb; // NULL: vaga livre
+    bool sse;
+    bool meio_evento;    // SSE: o "data: " foi escrito, falta o JSON
+    bool fechar;         // fecha depois do ultimo ACK
+    bool cabecalho;      // ja passou da linha do pedido
+    uint8_t pendente;    // rota_t que esperava espaco no TCP
+    uint8_t n_linha;
+    uint8_t coluna;      // caracteres da linha atual do cabecalho
+    char linha[PEDIDO_MAX];
+    uint32_t no_ar;      // bytes escritos ainda sem ACK
+    uint32_t versao;     // SSE: ultima versao enviada
+    uint32_t ultimo_ms;  // ultimo envio ou ACK
+} conexao_t;
+
+static const char SSE_CABECALHO[] =
+    "HTTP/1.1 200 OK\r\nContent-Type: text/event-stream\r\nCache-Control: no-store\r\n"
+    "Access-Control-Allow-Origin: *\r\n\r\n";
+static const char SSE_DADOS[] = "data: ";
+static const char SSE_PING[] = ": ping\n\n";
+static const char NAO_ACHADA[] = "HTTP/1.1 404 Not Found\r\nContent-Length: 0\r\nConnection: close\r\n\r\n";
+static const char METODO[] =
+    "HTTP/1.1 405 Method Not Allowed\r\nAllow: GET\r\nContent-Length: 0\r\nConnection: close\r\n\r\n";
+
+// Retratos e conexoes: so com o nucleo do lwIP travado (callbacks ou
+// cyw43_arch_lwip_begin). A excecao e montar o retrato que nao e o atual.
+static retrato_t retratos[HTTP_RETRATOS];
+static uint8_t atual = SEM_RETRATO;
+static uint32_t versao; // do retrato atual
+static conexao_t conexoes[HTTP_CONEXOES];
+static struct tcp_pcb *escuta;
+
+// Estado vindo da vJoystickTask
+static http_estado_t entrada;
+static bool mudou;
+static TaskHandle_t tarefa;
+
+static http_estatistica_t estatistica;
+
+static uint32_t agora_ms(void) {
+    return to_ms_since_boot(get_absolute_time());
+}
+
+// -------------------- Estado --------------------
+static bool mesmo_estado(const http_estado_t *a, const http_estado_t *b) {
+    return a->nivel_c == b->nivel_c && a->chuva_c == b->chuva_c && a->alerta == b->alerta &&
+           a->alertas == b->alertas && a->telemetria_descartados == b->telemetria_descartados &&
+           a->log_descartados == b->log_descartados && a->capturas_perdidas == b->capturas_perdidas &&
+           a->tlog_descartados == b->tlog_descartados && a->mqtt_conectado == b->mqtt_conectado &&
+           a->mqtt_publicadas == b->mqtt_publicadas && a->mqtt_pendentes == b->mqtt_pendentes &&
+           a->mqtt_descartadas == b->mqtt_descartadas;
+}
+
+void http_init(void) {
+    memset(&entrada, 0, sizeof(entrada));
+    memset(&estatistica, 0, sizeof(estatistica));
+    mudou = true;
+}
+
+void http_atualizar(const http_estado_t *estado) {
+    taskENTER_CRITICAL();
+    bool diferente = !mesmo_estado(&entrada, estado);
+    if (diferente) {
+        entrada = *estado;
+        mudou = true;
+    }
+    taskEXIT_CRITICAL();
+    if (diferente && tarefa != NULL)
+        xTaskNotifyGive(tarefa);
+}
+
+void http_obter(http_estatistica_t *destino) {
+    taskENTER_CRITICAL();
+    *destino = estatistica;
+    taskEXIT_CRITICAL();
+}
+
+// -------------------- Retrato --------------------
+static char *escrever(char *p, const char *texto) {
+    size_t n = strlen(texto);
+    memcpy(p, texto, n);
+    return p + n;
+}
+
+static char *campo(char *p, const char *chave, uint32_t valor, uint8_t casas) {
+    p = escrever(p, chave);
+    return p + formatar_decimal(p, valor, casas);
+}
+
+static void montar(retrato_t *r, const http_estado_t *e, uint32_t tempo_ms) {
+    char *json = &r->dados[CABECALHO_MAX];
+    char *p = campo(json, "{\"t\":", tempo_ms, 0);
+    p = campo(p, ",\"nivel\":", e->nivel_c, 2);
+    p = campo(p, ",\"chuva\":", e->chuva_c, 2);
+    p = campo(p, ",\"alerta\":", e->alerta, 0);
+    p = campo(p, ",\"alertas\":", e->alertas, 0);
+    p = campo(p, ",\"descartes\":{\"telemetria\":", e->telemetria_descartados, 0);
+    p = campo(p, ",\"log\":", e->log_descartados, 0);
+    p = campo(p, ",\"captura\":", e->capturas_perdidas, 0);
+    p = campo(p, ",\"tlog\":", e->tlog_descartados, 0);
+    p = campo(p, "},\"mqtt\":{\"conectado\":", e->mqtt_conectado, 0);
+    p = campo(p, ",\"publicadas\":", e->mqtt_publicadas, 0);
+    p = campo(p, ",\"pendentes\":", e->mqtt_pendentes, 0);
+    p = campo(p, ",\"descartadas\":", e->mqtt_descartadas, 0);
+    p = escrever(p, "}}");
+    r->json = CABECALHO_MAX;
+    r->fim = (uint16_t)(p - r->dados);
+    memcpy(p, "\n\n", 2);
+
+    char cabecalho[CABECALHO_MAX];
+    char *c = escrever(cabecalho,
+                       "HTTP/1.1 200 OK\r\nContent-Type: application/json\r\nCache-Control: no-store\r\n"
+                       "Access-Control-Allow-Origin: *\r\nContent-Length: ");
+    c = campo(c, "", (uint32_t)(r->fim - r->json), 0);
+    c = escrever(c, "\r\n\r\n");
+    size_t n = (size_t)(c - cabecalho);
+    r->inicio = (uint16_t)(CABECALHO_MAX - n);
+    memcpy(&r->dados[r->inicio], cabecalho, n);
+}
+
+// -------------------- Conexoes --------------------
+static bool cabe(const conexao_t *c, size_t bytes) {
+    return tcp_sndbuf(c->pcb) >= bytes;
+}
+
+// O lwIP copia os bytes para os seus segmentos. Mesmo com espaco no buffer
+// de envio o tcp_write pode faltar segmento ou pbuf (ERR_MEM): quem chamou
+// nao conta nada e tenta de novo no proximo ACK ou na manutencao.
+static bool escrever_tcp(conexao_t *c, const void *dados, size_t n, u8_t flags) {
+    if (tcp_write(c->pcb, dados, (u16_t)n, TCP_WRITE_FLAG_COPY | flags) != ERR_OK)
+        return false;
+    c->no_ar += (uint32_t)n;
+    c->ultimo_ms = agora_ms();
+    return true;
+}
+
+static void soltar(conexao_t *c) {
+    estatistica.clientes--;
+    estatistica.clientes_sse -= c->sse;
+    c->pcb = NULL;
+}
+
+static void sem_callbacks(struct tcp_pcb *pcb) {
+    tcp_arg(pcb, NULL);
+    tcp_recv(pcb, NULL);
+    tcp_sent(pcb, NULL);
+    tcp_err(pcb, NULL);
+}
+
+static err_t abortar(conexao_t *c) {
+    sem_callbacks(c->pcb);
+    tcp_abort(c->pcb);
+    soltar(c);
+    return ERR_ABRT;
+}
+
+// So com todos os envios confirmados; retorna ERR_ABRT se precisou abortar
+static err_t fechar(conexao_t *c) {
+    sem_callbacks(c->pcb);
+    if (tcp_close(c->pcb) != ERR_OK) {
+        tcp_abort(c->pcb);
+        soltar(c);
+        return ERR_ABRT;
+    }
+    soltar(c);
+    return ERR_OK;
+}
+
+// Proximo evento SSE: so depois do ACK do anterior, e sempre o mais novo.
+// Se o JSON nao entrou depois do "data: ", a proxima tentativa manda o
+// retrato atual; versao e contadores so andam com o evento inteiro.
+static void enviar_evento(conexao_t *c) {
+    if (!c->sse || atual == SEM_RETRATO)
+        return;
+    const retrato_t *r = &retratos[atual];
+    size_t n = (size_t)(r->fim - r->json) + 2;
+    if (!c->meio_evento) {
+        if (c->no_ar > 0 || c->versao == versao || !cabe(c, sizeof(SSE_DADOS) - 1 + n) ||
+            !escrever_tcp(c, SSE_DADOS, sizeof(SSE_DADOS) - 1, TCP_WRITE_FLAG_MORE))
+            return;
+        c->meio_evento = true;
+    }
+    if (!escrever_tcp(c, &r->dados[r->json], n, 0))
+        return;
+    c->meio_evento = false;
+    estatistica.saltados += versao - c->versao - 1;
+    estatistica.eventos++;
+    c->versao = versao;
+}
+
+// false se nao entrou agora; tenta de novo no proximo ACK ou na manutencao
+static bool responder(conexao_t *c, rota_t rota) {
+    switch (rota) {
+    case ROTA_RETRATO: {
+        if (atual == SEM_RETRATO)
+            return false;
+        const retrato_t *r = &retratos[atual];
+        size_t n = (size_t)(r->fim - r->inicio);
+        if (!cabe(c, n) || !escrever_tcp(c, &r->dados[r->inicio], n, 0))
+            return false;
+        estatistica.requisicoes++;
+        break;
+    }
+    case ROTA_EVENTOS:
+        if (!cabe(c, sizeof(SSE_CABECALHO) - 1) ||
+            !escrever_tcp(c, SSE_CABECALHO, sizeof(SSE_CABECALHO) - 1, 0))
+            return false;
+        c->sse = true;
+        c->versao = versao - 1; // o retrato atual sai no primeiro ACK
+        estatistica.clientes_sse++;
+        break;
+    case ROTA_NAO_ACHADA:
+    case ROTA_METODO: {
+        const char *texto = rota == ROTA_METODO ? METODO : NAO_ACHADA;
+        size_t n = strlen(texto);
+        if (!cabe(c, n) || !escrever_tcp(c, texto, n, 0))
+            return false;
+        c->fechar = true;
+        break;
+    }
+    case ROTA_NENHUMA:
+        break;
+    }
+    return true;
+}
+
+// Caminho seguido de espaco ou de uma query que ignoramos
+static bool caminho(const char *linha, const char *esperado) {
+    size_t n = strlen(esperado);
+    return strncmp(linha, esperado, n) == 0 && (linha[n] == ' ' || linha[n] == '?');
+}
+
+static rota_t rota_de(const char *linha) {
+    if (strncmp(linha, "GET ", 4) != 0)
+        return ROTA_METODO;
+    if (caminho(linha + 4, "/") || caminho(linha + 4, "/estado"))
+        return ROTA_RETRATO;
+    if (caminho(linha + 4, "/eventos"))
+        return ROTA_EVENTOS;
+    return ROTA_NAO_ACHADA;
+}
+
+// Guarda a linha do pedido e acha o fim do cabecalho (linha vazia). Com um
+// pedido ainda esperando espaco, o seguinte fecha a conexao.
+static void ler_pedido(conexao_t *c, const uint8_t *bytes, u16_t n) {
+    for (u16_t i = 0; i < n && !c->sse && !c->fechar; i++) {
+        char ch = (char)bytes[i];
+        if (ch == '\r')
+            continue;
+        if (ch != '\n') {
+            if (!c->cabecalho && c->n_linha < PEDIDO_MAX - 1)
+                c->linha[c->n_linha++] = ch;
+            if (c->coluna < UINT8_MAX)
+                c->coluna++;
+            continue;
+        }
+        if (c->coluna > 0 || !c->cabecalho) {
+            c->linha[c->n_linha] = '\0';
+            c->cabecalho = true;
+            c->coluna = 0;
+            continue;
+        }
+        rota_t rota = rota_de(c->linha);
+        if (c->pendente != ROTA_NENHUMA)
+            c->fechar = true;
+        else if (!responder(c, rota))
+            c->pendente = (uint8_t)rota;
+        c->cabecalho = false;
+        c->n_linha = 0;
+    }
+}
+
+// -------------------- TCP (callbacks do lwIP) --------------------
+static err_t ao_receber(void *arg, struct tcp_pcb *tpcb, struct pbuf *p, err_t err) {
+    conexao_t *c = arg;
+    (void)err;
+    if (p == NULL) {
+        // O cliente fechou; o que ainda esta no ar precisa do ACK antes
+        if (c->no_ar == 0)
+            return fechar(c);
+        c->fechar = true;
+        return ERR_OK;
+    }
+    for (struct pbuf *q = p; q != NULL; q = q->next)
+        ler_pedido(c, q->payload, q->len);
+    tcp_recved(tpcb, p->tot_len);
+    pbuf_free(p);
+    if (c->fechar && c->no_ar == 0)
+        return fechar(c);
+    tcp_output(tpcb);
+    return ERR_OK;
+}
+
+static err_t ao_enviar(void *arg, struct tcp_pcb *tpcb, u16_t tamanho) {
+    conexao_t *c = arg;
+    c->no_ar -= tamanho < c->no_ar ? tamanho : c->no_ar;
+    c->ultimo_ms = agora_ms();
+
+    if (c->pendente != ROTA_NENHUMA && responder(c, (rota_t)c->pendente))
+        c->pendente = ROTA_NENHUMA;
+    enviar_evento(c);
+    if (c->fechar && c->no_ar == 0)
+        return fechar(c);
+    tcp_output(tpcb);
+    return ERR_OK;
+}
+
+// O pcb ja foi liberado pelo lwIP, e com ele os segmentos
+static void ao_erro(void *arg, err_t err) {
+    conexao_t *c = arg;
+    TLOG("http: conexao perdida (erro %d)", err);
+    soltar(c);
+}
+
+// Sem vaga, ERR_MEM faz o lwIP abortar a conexao nova
+static err_t ao_aceitar(void *arg, struct tcp_pcb *novo, err_t err) {
+    (void)arg;
+    if (err != ERR_OK || novo == NULL)
+        return ERR_VAL;
+    conexao_t *c = NULL;
+    for (int i = 0; i < HTTP_CONEXOES && c == NULL; i++) {
+        if (conexoes[i].pcb == NULL)
+            c = &conexoes[i];
+    }
+    if (c == NULL) {
+        estatistica.recusadas++;
+        return ERR_MEM;
+    }
+
+    memset(c, 0, sizeof(*c));
+    c->pcb = novo;
+    c->ultimo_ms = agora_ms();
+    tcp_arg(novo, c);
+    tcp_recv(novo, ao_receber);
+    tcp_sent(novo, ao_enviar);
+    tcp_err(novo, ao_erro);
+    tcp_nagle_disable(novo); // cada resposta ja sai num tcp_write so
+    estatistica.clientes++;
+    return ERR_OK;
+}
+
+// -------------------- Tarefa --------------------
+static bool escutar(void) {
+    cyw43_arch_lwip_begin();
+    struct tcp_pcb *pcb = tcp_new_ip_type(IPADDR_TYPE_ANY);
+    if (pcb != NULL && tcp_bind(pcb, IP_ANY_TYPE, HTTP_PORTA) == ERR_OK)
+        escuta = tcp_listen_with_backlog(pcb, HTTP_CONEXOES);
+    if (escuta != NULL)
+        tcp_accept(escuta, ao_aceitar);
+    else if (pcb != NULL)
+        tcp_abort(pcb);
+    cyw43_arch_lwip_end();
+    if (escuta != NULL)
+        TLOG("http: escutando na porta %u", HTTP_PORTA);
+    else
+        TLOG("http: sem pcb para escutar");
+    return escuta != NULL;
+}
+
+// Monta o retrato no buffer que nao e o atual e o torna o atual. Os
+// callbacks so leem o atual, e o lwIP ja copiou o que foi escrito dele.
+// Antes do Wi-Fi nao ha conexoes nem nucleo do lwIP para travar.
+static bool publicar(uint32_t agora) {
+    taskENTER_CRITICAL();
+    bool pedido = mudou;
+    http_estado_t e = entrada;
+    mudou = false;
+    taskEXIT_CRITICAL();
+    if (!pedido)
+        return false;
+
+    uint8_t livre = atual == 0 ? 1 : 0; // so esta tarefa muda 'atual'
+    montar(&retratos[livre], &e, agora);
+
+    if (escuta != NULL)
+        cyw43_arch_lwip_begin();
+    atual = livre;
+    versao++;
+    estatistica.retratos++;
+    for (int i = 0; i < HTTP_CONEXOES; i++) {
+        if (conexoes[i].pcb != NULL && conexoes[i].sse) {
+            enviar_evento(&conexoes[i]);
+            tcp_output(conexoes[i].pcb);
+        }
+    }
+    if (escuta != NULL)
+        cyw43_arch_lwip_end();
+    return true;
+}
+
+// Keep-alive ocioso, cliente que nao confirma, escrita recusada sem nada
+// no ar (nenhum ACK vai chamar ao_enviar) e ping do SSE
+static void manter(uint32_t agora) {
+    cyw43_arch_lwip_begin();
+    for (int i = 0; i < HTTP_CONEXOES; i++) {
+        conexao_t *c = &conexoes[i];
+        if (c->pcb == NULL)
+            continue;
+        uint32_t parado = agora - c->ultimo_ms;
+        if (c->no_ar > 0 && parado > HTTP_ACK_MS) {
+            TLOG("http: cliente sem ACK, abortando");
+            abortar(c);
+            continue;
+        }
+        if (!c->sse && c->no_ar == 0 && parado > HTTP_OCIOSA_MS) {
+            fechar(c);
+            continue;
+        }
+        if (c->pendente != ROTA_NENHUMA && responder(c, (rota_t)c->pendente))
+            c->pendente = ROTA_NENHUMA;
+        enviar_evento(c);
+        if (c->sse && c->no_ar == 0 && !c->meio_evento && parado > HTTP_SSE_PING_MS &&
+            cabe(c, sizeof(SSE_PING) - 1))
+            escrever_tcp(c, SSE_PING, sizeof(SSE_PING) - 1, 0);
+        tcp_output(c->pcb);
+    }
+    cyw43_arch_lwip_end();
+}
+
+void vHttpTask(void *params) {
+    (void)params;
+    tarefa = xTaskGetCurrentTaskHandle();
+    uint32_t ultimo_retrato_ms = agora_ms() - HTTP_PERIODO_MS;
+
+    while (true) {
+        ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(HTTP_PERIODO_MS));
+        uint32_t agora = agora_ms();
+
+        // A associacao e da vMqttTask; o pcb de escuta sobrevive a quedas
+        if (escuta == NULL && mqtt_wifi_associado() && !escutar()) {
+            vTaskDelay(pdMS_TO_TICKS(HTTP_OCIOSA_MS));
+            continue;
+        }
+        if (agora - ultimo_retrato_ms >= HTTP_PERIODO_MS && publicar(agora))
+            ultimo_retrato_ms = agora;
+        if (escuta != NULL)
+            manter(agora);
+    }
+}
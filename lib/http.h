@@ -0,0 +1,75 @@
+#ifndef HTTP_H
+#define HTTP_H
+
+#include "pico/stdlib.h"
+
+// -------------------- Servidor HTTP de estado (Wi-Fi do Pico W) --------------------
+// Para o tecnico em campo, com o celular na mesma rede:
+//   GET /         retrato JSON do estado atual (tambem /estado)
+//   GET /eventos  o mesmo JSON a cada mudanca, como Server-Sent Events
+//
+// Nada e formatado por requisicao. Quando o estado muda, a tarefa monta a
+// resposta inteira (cabecalho HTTP e JSON) no buffer estatico que nao e o
+// atual e troca os dois. Um GET vira um unico tcp_write do retrato atual,
+// que o lwIP copia para os seus segmentos (com LWIP_NETIF_TX_SINGLE_PBUF ele
+// copiaria de qualquer jeito): nenhum cliente ve o retrato mudar no meio do
+// envio, por mais lento que seja. Um tcp_write recusado (ERR_MEM) nao conta
+// como resposta; a conexao tenta de novo no proximo ACK ou em
+// HTTP_PERIODO_MS.
+//
+// No SSE cada cliente recebe o retrato mais novo quando termina o anterior:
+// um cliente lento pula versoes (saltados) em vez de acumular atraso.
+//
+// Carga (valores em %, t em ms desde o boot, da ultima mudanca):
+//   {"t":..,"nivel":..,"chuva":..,"alerta":0|1,"alertas":..,
+//    "descartes":{"telemetria":..,"log":..,"captura":..,"tlog":..},
+//    "mqtt":{"conectado":0|1,"publicadas":..,"pendentes":..,"descartadas":..}}
+
+#ifndef HTTP_PORTA
+#define HTTP_PORTA 80
+#endif
+
+#define HTTP_CONEXOES     4     // clientes ao mesmo tempo, SSE incluidos
+#define HTTP_RETRATOS     2     // o atual e o que a tarefa monta
+#define HTTP_RETRATO_MAX  512
+#define HTTP_PERIODO_MS   100   // intervalo minimo entre retratos
+#define HTTP_SSE_PING_MS  15000 // comentario SSE para o navegador nao desistir
+#define HTTP_OCIOSA_MS    10000 // keep-alive sem pedido: fecha e libera a vaga
+#define HTTP_ACK_MS       30000 // bytes sem ACK nesse tempo: aborta a conexao
+
+// Estado mostrado; vJoystickTask preenche a cada leitura
+typedef struct {
+    uint16_t nivel_c; // centesimos de %
+    uint16_t chuva_c;
+    bool alerta;
+    uint32_t alertas; // entradas em alerta desde o boot
+    uint32_t telemetria_descartados;
+    uint32_t log_descartados;
+    uint32_t capturas_perdidas;
+    uint32_t tlog_descartados;
+    bool mqtt_conectado;
+    uint32_t mqtt_publicadas;
+    uint16_t mqtt_pendentes;
+    uint32_t mqtt_descartadas;
+} http_estado_t;
+
+typedef struct {
+    uint8_t clientes;     // conexoes abertas agora
+    uint8_t clientes_sse;
+    uint32_t requisicoes; // GETs respondidos com o retrato
+    uint32_t eventos;     // retratos enviados por SSE
+    uint32_t saltados;    // versoes puladas por clientes SSE lentos
+    uint32_t retratos;    // respostas montadas
+    uint32_t recusadas;   // conexoes sem vaga
+} http_estatistica_t;
+
+void http_init(void);
+
+// Copia o estado; a tarefa so remonta o retrato se algo mudou.
+void http_atualizar(const http_estado_t *estado);
+
+void http_obter(http_estatistica_t *destino);
+
+void vHttpTask(void *params);
+
+#endif
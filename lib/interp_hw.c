@@ -0,0 +1,173 @@
+#include "interp_hw.h"
+#include "em_ram.h"
+
+#if INTERP_HW_DISPONIVEL
+#include "hardware/interp.h"
+#include "hardware/clocks.h"
+#include "ssd1306.h"
+#include "FreeRTOS.h"
+#include "task.h"
+
+volatile bool interp_hw_ativo = true;
+#else
+volatile bool interp_hw_ativo = false;
+#endif
+
+#define AMOSTRA_MASCARA 0x0FFF // bit 15 indica erro de conversao
+
+// -------------------- Caminho portavel --------------------
+static uint32_t EM_RAM(somar_portavel)(const uint16_t *anel, uint bits, uint32_t inicio, int32_t passo, uint32_t n) {
+    uint32_t mascara = (1u << (bits - 1)) - 1; // em amostras
+    uint32_t soma = 0;
+    for (uint32_t i = 0; i < n; i++) {
+        soma += anel[inicio & mascara] & AMOSTRA_MASCARA;
+        inicio += (uint32_t)passo;
+    }
+    return soma;
+}
+
+static void copiar_portavel(uint16_t *destino, const uint16_t *anel, uint bits, uint32_t inicio, uint32_t n) {
+    uint32_t mascara = (1u << (bits - 1)) - 1;
+    for (uint32_t i = 0; i < n; i++)
+        destino[i] = anel[(inicio + i) & mascara] & AMOSTRA_MASCARA;
+}
+
+// -------------------- Caminho com interp0 --------------------
+#if INTERP_HW_DISPONIVEL
+// Lane 0 guarda o deslocamento em bytes e, a cada POP, soma o passo ao
+// deslocamento ja mascarado: a volta do anel sai de graca. O resultado
+// completo e BASE2 (inicio do anel) + deslocamento mascarado, ou seja, o
+// endereco da amostra. Lane 1 fica zerada.
+// Equivalentes locais de interp_save/interp_restore, que ficam na flash:
+// inline, acompanham a funcao que os chama para a SRAM.
+static inline void salvar(interp_hw_save_t *salvo) {
+    salvo->accum[0] = interp0->accum[0];
+    salvo->accum[1] = interp0->accum[1];
+    salvo->base[0] = interp0->base[0];
+    salvo->base[1] = interp0->base[1];
+    salvo->base[2] = interp0->base[2];
+    salvo->ctrl[0] = interp0->ctrl[0];
+    salvo->ctrl[1] = interp0->ctrl[1];
+}
+
+static inline void restaurar(const interp_hw_save_t *salvo) {
+    interp0->ctrl[0] = salvo->ctrl[0];
+    interp0->ctrl[1] = salvo->ctrl[1];
+    interp0->accum[0] = salvo->accum[0];
+    interp0->accum[1] = salvo->accum[1];
+    interp0->base[0] = salvo->base[0];
+    interp0->base[1] = salvo->base[1];
+    interp0->base[2] = salvo->base[2];
+}
+
+static inline void configurar_anel(const uint16_t *anel, uint bits, uint32_t inicio, int32_t passo) {
+    interp_config c = interp_default_config();
+    interp_config_set_mask(&c, 1, bits - 1);
+    interp_set_config(interp0, 0, &c);
+    interp_config nulo = interp_default_config();
+    interp_set_config(interp0, 1, &nulo);
+
+    interp0->accum[0] = inicio * sizeof(uint16_t);
+    interp0->base[0] = (uint32_t)(passo * (int32_t)sizeof(uint16_t));
+    interp0->accum[1] = 0;
+    interp0->base[1] = 0;
+    interp0->base[2] = (uintptr_t)anel;
+}
+
+static uint32_t EM_RAM(somar_interp)(const uint16_t *anel, uint bits, uint32_t inicio, int32_t passo, uint32_t n) {
+    interp_hw_save_t salvo;
+    salvar(&salvo);
+    configurar_anel(anel, bits, inicio, passo);
+
+    uint32_t soma = 0;
+    while (n--)
+        soma += *(const uint16_t *)interp0->pop[2] & AMOSTRA_MASCARA;
+
+    restaurar(&salvo);
+    return soma;
+}
+
+static void copiar_interp(uint16_t *destino, const uint16_t *anel, uint bits, uint32_t inicio, uint32_t n) {
+    interp_hw_save_t salvo;
+    salvar(&salvo);
+    configurar_anel(anel, bits, inicio, 1);
+
+    while (n--)
+        *destino++ = *(const uint16_t *)interp0->pop[2] & AMOSTRA_MASCARA;
+
+    restaurar(&salvo);
+}
+#endif
+
+uint32_t EM_RAM(interp_hw_anel_somar)(const uint16_t *anel, uint bits, uint32_t inicio, int32_t passo, uint32_t n) {
+#if INTERP_HW_DISPONIVEL
+    if (interp_hw_ativo)
+        return somar_interp(anel, bits, inicio, passo, n);
+#endif
+    return somar_portavel(anel, bits, inicio, passo, n);
+}
+
+void interp_hw_anel_copiar(uint16_t *destino, const uint16_t *anel, uint bits, uint32_t inicio, uint32_t n) {
+#if INTERP_HW_DISPONIVEL
+    if (interp_hw_ativo) {
+        copiar_interp(destino, anel, bits, inicio, n);
+        return;
+    }
+#endif
+    copiar_portavel(destino, anel, bits, inicio, n);
+}
+
+// -------------------- Comparacao de ciclos --------------------
+#if INTERP_HW_DISPONIVEL
+#define COMPARACAO_ANEL_BITS  11 // 1024 amostras
+#define COMPARACAO_REPETICOES 64
+#define COMPARACAO_TEXTO      "EMERGENCIA 99.9%"
+
+static uint16_t anel_teste[(1u << COMPARACAO_ANEL_BITS) / sizeof(uint16_t)];
+static uint8_t framebuffer_teste[WIDTH * HEIGHT / 8 + 1];
+
+// O M0+ nao tem contador de ciclos; o timer de 1 us, multiplicado pelo
+// clock do sistema, tem resolucao suficiente para lotes de milissegundos.
+static uint32_t decimos_de_ciclo(uint32_t us, uint32_t operacoes) {
+    uint64_t ciclos = (uint64_t)us * (clock_get_hz(clk_sys) / 1000000u);
+    return (uint32_t)(ciclos * 10 / operacoes);
+}
+
+static uint32_t medir_anel(void) {
+    volatile uint32_t soma = 0; // impede que o laco seja descartado
+    uint32_t n = sizeof(anel_teste) / sizeof(anel_teste[0]);
+    uint32_t t0 = time_us_32();
+    for (uint32_t r = 0; r < COMPARACAO_REPETICOES; r++)
+        soma += interp_hw_anel_somar(anel_teste, COMPARACAO_ANEL_BITS, r, -2, n);
+    (void)soma;
+    return decimos_de_ciclo(time_us_32() - t0, COMPARACAO_REPETICOES * n);
+}
+
+static uint32_t medir_texto(ssd1306_t *ssd) {
+    uint32_t caracteres = sizeof(COMPARACAO_TEXTO) - 1;
+    uint32_t t0 = time_us_32();
+    for (uint32_t r = 0; r < COMPARACAO_REPETICOES; r++)
+        ssd1306_draw_string(ssd, COMPARACAO_TEXTO, 0, (uint8_t)((r & 3) * 8));
+    return decimos_de_ciclo(time_us_32() - t0, COMPARACAO_REPETICOES * caracteres);
+}
+
+void interp_hw_comparar(interp_hw_comparacao_t *c) {
+    // Framebuffer proprio: o desenho nao passa pelo I2C nem pelo display real
+    ssd1306_t ssd = {
+        .width = WIDTH, .height = HEIGHT, .pages = HEIGHT / 8,
+        .ram_buffer = framebuffer_teste, .bufsize = sizeof(framebuffer_teste)
+    };
+    for (uint32_t i = 0; i < sizeof(anel_teste) / sizeof(anel_teste[0]); i++)
+        anel_teste[i] = (uint16_t)(i * 37);
+
+    // Com o escalonador suspenso a vDisplayTask nao disputa o interp1
+    vTaskSuspendAll();
+    interp_hw_ativo = false;
+    c->anel_portavel = medir_anel();
+    c->texto_portavel = medir_texto(&ssd);
+    interp_hw_ativo = true;
+    c->anel_interp = medir_anel();
+    c->texto_interp = medir_texto(&ssd);
+    xTaskResumeAll();
+}
+#endif
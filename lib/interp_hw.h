@@ -0,0 +1,44 @@
+#ifndef INTERP_HW_H
+#define INTERP_HW_H
+
+#include "pico/stdlib.h"
+
+// -------------------- Interpoladores do SIO --------------------
+// Cada nucleo do RP2040 tem dois interpoladores que fazem shift, mascara e
+// soma num unico acesso. Aqui eles geram enderecos para:
+//  - interp0: percorrer anéis de amostras (media e copia da captura);
+//  - interp1: percorrer o framebuffer do SSD1306 (ssd1306.c).
+// O FreeRTOS nao salva os interpoladores na troca de contexto, entao quem
+// usa interp0 salva e restaura o estado em volta do lote. interp1 e usado
+// apenas pelas primitivas de desenho.
+//
+// Fora do RP2040 (build do host) valem as versoes portaveis.
+
+#ifndef INTERP_HW_DISPONIVEL
+#define INTERP_HW_DISPONIVEL PICO_ON_DEVICE
+#endif
+
+// Escolhe o caminho em tempo de execucao; desligado so para a comparacao.
+extern volatile bool interp_hw_ativo;
+
+// Soma os 12 bits de n amostras de um anel de 2^bits bytes, a partir do
+// indice inicio, andando passo amostras (negativo volta no tempo).
+uint32_t interp_hw_anel_somar(const uint16_t *anel, uint bits, uint32_t inicio, int32_t passo, uint32_t n);
+
+// Copia n amostras consecutivas do anel (12 bits) para destino.
+void interp_hw_anel_copiar(uint16_t *destino, const uint16_t *anel, uint bits, uint32_t inicio, uint32_t n);
+
+#if INTERP_HW_DISPONIVEL
+// Ciclos de CPU por operacao, em decimos, nos dois caminhos.
+typedef struct {
+    uint32_t anel_portavel; // por amostra somada
+    uint32_t anel_interp;
+    uint32_t texto_portavel; // por caractere desenhado
+    uint32_t texto_interp;
+} interp_hw_comparacao_t;
+
+// Mede os dois caminhos com o escalonador suspenso (~15 ms).
+void interp_hw_comparar(interp_hw_comparacao_t *c);
+#endif
+
+#endif
@@ -0,0 +1,65 @@
+#ifndef LWIPOPTS_H
+#define LWIPOPTS_H
+
+// -------------------- lwIP do Pico W (pico_cyw43_arch_lwip_sys_freertos) --------------------
+// Pilha com FreeRTOS: o lwIP roda na sua tarefa (tcpip) e as tarefas da
+// estacao usam a API raw entre cyw43_arch_lwip_begin/end. So TCP sobre
+// IPv4 com DHCP; sem sockets nem netconn, que pediriam pilha e heap.
+
+#define NO_SYS                      0
+#define LWIP_SOCKET                 0
+#define LWIP_NETCONN                0
+#define LWIP_TCPIP_CORE_LOCKING     1
+#define LWIP_TCPIP_CORE_LOCKING_INPUT 1
+#define TCPIP_THREAD_STACKSIZE      1024
+#define TCPIP_THREAD_PRIO           2
+#define TCPIP_MBOX_SIZE             8
+#define DEFAULT_THREAD_STACKSIZE    512
+#define DEFAULT_RAW_RECVMBOX_SIZE   8
+#define DEFAULT_TCP_RECVMBOX_SIZE   8
+#define DEFAULT_ACCEPTMBOX_SIZE     8
+#define LWIP_TIMEVAL_PRIVATE        0
+
+// Memoria: pool proprio, sem malloc da libc
+#define MEM_LIBC_MALLOC             0
+#define MEM_ALIGNMENT               4
+#define MEM_SIZE                    8000
+#define MEMP_NUM_TCP_SEG            32
+#define MEMP_NUM_ARP_QUEUE          10
+#define PBUF_POOL_SIZE              16
+
+// TCP: o buffer de envio cabe uma janela inteira de PUBLISH (mqtt.h)
+#define LWIP_TCP                    1
+#define TCP_MSS                     1460
+#define TCP_WND                     (4 * TCP_MSS)
+#define TCP_SND_BUF                 (4 * TCP_MSS)
+#define TCP_SND_QUEUELEN            ((4 * (TCP_SND_BUF) + (TCP_MSS - 1)) / (TCP_MSS))
+#define MEMP_NUM_TCP_PCB            8  // broker MQTT + HTTP_CONEXOES + MODBUS_CONEXOES + folga
+#define MEMP_NUM_TCP_PCB_LISTEN     3  // HTTP, Modbus e folga
+#define LWIP_TCP_KEEPALIVE          1
+
+#define LWIP_IPV4                   1
+#define LWIP_IPV6                   0
+#define LWIP_ARP                    1
+#define LWIP_ETHERNET               1
+#define LWIP_ICMP                   1
+#define LWIP_RAW                    1
+#define LWIP_UDP                    1
+#define LWIP_DHCP                   1
+#define LWIP_DNS                    0
+#define DHCP_DOES_ARP_CHECK         0
+#define LWIP_DHCP_DOES_ACD_CHECK    0
+#define LWIP_NETIF_STATUS_CALLBACK  1
+#define LWIP_NETIF_LINK_CALLBACK    1
+#define LWIP_NETIF_HOSTNAME         1
+#define LWIP_NETIF_TX_SINGLE_PBUF   1 // cada segmento num pbuf so: tcp_write sempre copia
+#define LWIP_CHKSUM_ALGORITHM       3
+
+#define MEM_STATS                   0
+#define SYS_STATS                   0
+#define MEMP_STATS                  0
+#define LINK_STATS                  0
+#define LWIP_STATS                  0
+#define LWIP_DEBUG                  0
+
+#endif
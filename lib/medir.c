@@ -0,0 +1,67 @@
+#include "medir.h"
+
+#if ESTACAO_MEDIR_LATENCIA
+#include <string.h>
+#include "hardware/structs/xip_ctrl.h"
+#include "em_ram.h"
+#include "FreeRTOS.h"
+#include "task.h"
+
+static estatistica_t medidas[MEDIDA_NUM];
+static volatile bool frio;
+
+static const char *const nomes[MEDIDA_NUM] = {
+    [MEDIDA_DESPERTAR] = "despertar",
+    [MEDIDA_LEITURA] = "leitura",
+    [MEDIDA_MATRIZ] = "matriz"
+};
+
+// O SysTick conta para baixo e recarrega com RVR; cada medida e escrita
+// por uma unica tarefa, entao nao precisa de exclusao.
+static void EM_RAM(registrar)(medida_t medida, uint32_t ciclos) {
+    estatistica_t *e = &medidas[medida];
+
+    if (e->n == 0 || ciclos < e->minimo)
+        e->minimo = ciclos;
+    if (ciclos > e->maximo)
+        e->maximo = ciclos;
+    e->soma += ciclos;
+    e->n++;
+}
+
+void EM_RAM(medir_fim)(medida_t medida, uint32_t inicio) {
+    uint32_t fim = systick_hw->cvr;
+    registrar(medida, inicio >= fim ? inicio - fim : inicio + systick_hw->rvr + 1 - fim);
+}
+
+void EM_RAM(medir_desde_tick)(medida_t medida) {
+    registrar(medida, systick_hw->rvr - systick_hw->cvr);
+}
+
+void medir_preparar(void) {
+    if (!frio)
+        return;
+    xip_ctrl_hw->flush = 1;
+    (void)xip_ctrl_hw->flush; // a leitura espera o fim da limpeza
+}
+
+void medir_modo_frio(bool ligado) {
+    frio = ligado;
+}
+
+void medir_zerar(void) {
+    taskENTER_CRITICAL();
+    memset(medidas, 0, sizeof(medidas));
+    taskEXIT_CRITICAL();
+}
+
+void medir_obter(medida_t medida, estatistica_t *destino) {
+    taskENTER_CRITICAL();
+    *destino = medidas[medida];
+    taskEXIT_CRITICAL();
+}
+
+const char *medir_nome(medida_t medida) {
+    return nomes[medida];
+}
+#endif
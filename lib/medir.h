@@ -0,0 +1,60 @@
+#ifndef MEDIR_H
+#define MEDIR_H
+
+#include "pico/stdlib.h"
+
+// -------------------- Medicao de latencia --------------------
+// Com ESTACAO_MEDIR_LATENCIA (opcao do CMake), os caminhos quentes contam
+// ciclos pelo SysTick (contador de 24 bits do proprio nucleo, recarregado a
+// cada tick do FreeRTOS) e acumulam minimo, maximo e media. max - min e o
+// jitter. No modo "frio" a cache da XIP e esvaziada antes de cada leitura,
+// reproduzindo o pior caso de codigo expulso da cache.
+// Sem a opcao, as chamadas somem na compilacao.
+
+#ifndef ESTACAO_MEDIR_LATENCIA
+#define ESTACAO_MEDIR_LATENCIA 0
+#endif
+
+typedef enum {
+    MEDIDA_DESPERTAR, // do tick do SysTick ate a vJoystickTask voltar a rodar
+    MEDIDA_LEITURA,  // media dos canais, calibracao e avaliacao do alerta
+    MEDIDA_MATRIZ,   // envio das 25 cores para a matriz WS2812
+    MEDIDA_NUM
+} medida_t;
+
+typedef struct {
+    uint32_t n;
+    uint32_t minimo;
+    uint32_t maximo;
+    uint64_t soma;
+} estatistica_t;
+
+#if ESTACAO_MEDIR_LATENCIA
+#include "hardware/structs/systick.h"
+
+static inline uint32_t medir_inicio(void) {
+    return systick_hw->cvr;
+}
+
+// Registra os ciclos desde medir_inicio (intervalos menores que um tick).
+void medir_fim(medida_t medida, uint32_t inicio);
+
+// Registra os ciclos desde o ultimo tick. Chamada logo apos acordar de um
+// vTaskDelay, mede a latencia do escalonador ate a tarefa.
+void medir_desde_tick(medida_t medida);
+
+// Esvazia a cache da XIP se o modo frio estiver ligado.
+void medir_preparar(void);
+
+void medir_modo_frio(bool frio);
+void medir_zerar(void);
+void medir_obter(medida_t medida, estatistica_t *destino);
+const char *medir_nome(medida_t medida);
+#else
+static inline uint32_t medir_inicio(void) { return 0; }
+static inline void medir_fim(medida_t medida, uint32_t inicio) { (void)medida; (void)inicio; }
+static inline void medir_desde_tick(medida_t medida) { (void)medida; }
+static inline void medir_preparar(void) {}
+#endif
+
+#endif
@@ -0,0 +1,515 @@
+#include <string.h>
+#include "modbus.h"
+#include "mqtt.h"
+#include "config.h"
+#include "relogio.h"
+#include "em_ram.h"
+#include "tlog.h"
+#include "hardware/gpio.h"
+#include "hardware/irq.h"
+#include "hardware/sync.h"
+#include "pico/cyw43_arch.h"
+#include "lwip/tcp.h"
+#include "FreeRTOS.h"
+#include "task.h"
+
+// Codigos de funcao e de excecao (Modbus Application Protocol 1.1b3)
+#define FUNCAO_LER_RETENCAO   0x03
+#define FUNCAO_LER_ENTRADAS   0x04
+#define FUNCAO_ESCREVER_UM    0x06
+#define FUNCAO_ESCREVER_VARIOS 0x10
+
+#define EXCECAO_FUNCAO   0x01
+#define EXCECAO_ENDERECO 0x02
+#define EXCECAO_VALOR    0x03
+
+#define LER_MAX        125 // registradores por leitura
+#define ESCREVER_MAX   123
+#define RETENCAO_MAX   32
+#define METADE_ALTA    0x80 // no mapa: registrador com os 16 bits altos
+#define RTU_QUADRO_MAX 256
+#define MBAP           7    // cabecalho do Modbus TCP: transacao, protocolo, tamanho, unidade
+
+_Static_assert((MODBUS_RX_ANEL & (MODBUS_RX_ANEL - 1)) == 0, "anel deve ser potencia de 2");
+
+// -------------------- Imagem dupla --------------------
+// Sequencia par: a frente e a imagem 0; impar: a 1. O escritor preenche a
+// outra e incrementa; logo depois de publicar, a de tras passa a ser a que
+// era a frente. O leitor so confia na copia se a sequencia nao mudou
+// enquanto copiava; se mudou, o escritor pode ja estar sobrescrevendo a
+// imagem copiada, e a copia e refeita. Nao depende das prioridades.
+static uint16_t imagens[2][MODBUS_ENTRADAS];
+static volatile uint32_t sequencia;
+
+// Holding register -> indice em config_params (e METADE_ALTA)
+static uint8_t mapa_retencao[RETENCAO_MAX];
+static uint8_t num_retencao;
+
+// Contadores atualizados pela vModbusTask (RTU) e pela thread do lwIP (TCP):
+// sempre numa secao critica (contar)
+static modbus_estatistica_t estatistica;
+
+// Conexoes TCP: so com o nucleo do lwIP travado
+typedef struct {
+    struct tcp_pcb *pcb; // NULL: vaga livre
+    uint16_t n;
+    uint8_t entrada[MBAP + MODBUS_PDU_MAX];
+    uint32_t ultimo_ms;
+} conexao_modbus_t;
+
+static conexao_modbus_t conexoes[MODBUS_CONEXOES];
+static struct tcp_pcb *escuta;
+
+// Bytes da UART: o handler escreve na cabeca, a tarefa le da cauda
+static uint8_t rx_bytes[MODBUS_RX_ANEL];
+static uint32_t rx_chegada_us[MODBUS_RX_ANEL];
+static volatile uint32_t rx_cabeca;
+static volatile uint32_t rx_cauda;
+static TaskHandle_t tarefa;
+
+void modbus_init(void) {
+    memset(imagens, 0, sizeof(imagens));
+    memset(&estatistica, 0, sizeof(estatistica));
+    sequencia = 0;
+
+    num_retencao = 0;
+    for (uint8_t i = 0; i < config_num_params; i++) {
+        if (config_params[i].tamanho == sizeof(uint32_t) && num_retencao < RETENCAO_MAX)
+            mapa_retencao[num_retencao++] = i | METADE_ALTA;
+        if (num_retencao < RETENCAO_MAX)
+            mapa_retencao[num_retencao++] = i;
+    }
+}
+
+uint16_t *modbus_imagem_escrever(void) {
+    return imagens[(sequencia + 1) & 1];
+}
+
+void modbus_imagem_publicar(void) {
+    __dmb(); // a imagem inteira antes da sequencia
+    sequencia = sequencia + 1;
+}
+
+static void contar(uint32_t *contador) {
+    taskENTER_CRITICAL();
+    (*contador)++;
+    taskEXIT_CRITICAL();
+}
+
+static void copiar_entradas(uint16_t inicio, uint16_t n, uint16_t *destino) {
+    while (true) {
+        uint32_t antes = sequencia;
+        __dmb();
+        memcpy(destino, &imagens[antes & 1][inicio], n * sizeof(uint16_t));
+        __dmb();
+        if (sequencia == antes)
+            return;
+        contar(&estatistica.repeticoes);
+    }
+}
+
+// -------------------- PDU --------------------
+static uint16_t ler16(const uint8_t *p) {
+    return (uint16_t)(p[0] << 8 | p[1]);
+}
+
+static uint8_t *escrever16(uint8_t *p, uint16_t valor) {
+    p[0] = (uint8_t)(valor >> 8);
+    p[1] = (uint8_t)valor;
+    return p + 2;
+}
+
+static size_t excecao(const uint8_t *pdu, uint8_t codigo, uint8_t *resposta) {
+    contar(&estatistica.excecoes);
+    resposta[0] = pdu[0] | 0x80;
+    resposta[1] = codigo;
+    return 2;
+}
+
+static uint16_t registrador_retencao(const config_estacao_t *c, uint16_t indice) {
+    const param_config_t *p = &config_params[mapa_retencao[indice] & ~METADE_ALTA];
+    uint32_t valor = config_ler_param(c, p);
+    return (uint16_t)(mapa_retencao[indice] & METADE_ALTA ? valor >> 16 : valor);
+}
+
+// Aplica os valores na copia c; false se algum parametro sair da faixa
+static bool escrever_retencao(config_estacao_t *c, uint16_t inicio, uint16_t n, const uint8_t *valores) {
+    for (uint16_t i = 0; i < n; i++) {
+        uint8_t m = mapa_retencao[inicio + i];
+        const param_config_t *p = &config_params[m & ~METADE_ALTA];
+        uint32_t atual = config_ler_param(c, p);
+        uint32_t v = ler16(&valores[2 * i]);
+        if (p->tamanho == sizeof(uint32_t))
+            v = m & METADE_ALTA ? (atual & 0xFFFFu) | (v << 16) : (atual & 0xFFFF0000u) | v;
+        config_escrever_param(c, p, v);
+    }
+    // So no fim: as duas metades de um parametro de 32 bits chegam juntas
+    for (uint16_t i = 0; i < n; i++) {
+        const param_config_t *p = &config_params[mapa_retencao[inicio + i] & ~METADE_ALTA];
+        uint32_t v = config_ler_param(c, p);
+        if (v < p->minimo || v > p->maximo)
+            return false;
+    }
+    return true;
+}
+
+size_t modbus_processar(const uint8_t *pdu, size_t tamanho, uint8_t *resposta) {
+    if (tamanho < 1)
+        return 0;
+    uint8_t funcao = pdu[0];
+    uint16_t inicio = tamanho >= 3 ? ler16(&pdu[1]) : 0;
+    uint16_t n = tamanho >= 5 ? ler16(&pdu[3]) : 0;
+    uint8_t *p = resposta;
+    *p++ = funcao;
+
+    switch (funcao) {
+    case FUNCAO_LER_ENTRADAS:
+    case FUNCAO_LER_RETENCAO: {
+        uint16_t limite = funcao == FUNCAO_LER_ENTRADAS ? MODBUS_ENTRADAS : num_retencao;
+        if (tamanho != 5 || n < 1 || n > LER_MAX)
+            return excecao(pdu, EXCECAO_VALOR, resposta);
+        if ((uint32_t)inicio + n > limite)
+            return excecao(pdu, EXCECAO_ENDERECO, resposta);
+        *p++ = (uint8_t)(2 * n);
+        uint16_t valores[LER_MAX];
+        if (funcao == FUNCAO_LER_ENTRADAS) {
+            copiar_entradas(inicio, n, valores);
+        } else {
+            config_estacao_t c;
+            config_obter(&c);
+            for (uint16_t i = 0; i < n; i++)
+                valores[i] = registrador_retencao(&c, inicio + i);
+        }
+        for (uint16_t i = 0; i < n; i++)
+            p = escrever16(p, valores[i]);
+        return (size_t)(p - resposta);
+    }
+    case FUNCAO_ESCREVER_UM:
+    case FUNCAO_ESCREVER_VARIOS: {
+        const uint8_t *valores = &pdu[3];
+        if (funcao == FUNCAO_ESCREVER_UM) {
+            n = 1;
+            if (tamanho != 5)
+                return excecao(pdu, EXCECAO_VALOR, resposta);
+        } else if (tamanho < 6 || n < 1 || n > ESCREVER_MAX || pdu[5] != 2 * n || tamanho != 6u + 2u * n) {
+            return excecao(pdu, EXCECAO_VALOR, resposta);
+        } else {
+            valores = &pdu[6];
+        }
+        if ((uint32_t)inicio + n > num_retencao)
+            return excecao(pdu, EXCECAO_ENDERECO, resposta);
+
+        // Ler-alterar-aplicar com a trava dos escritores: um 'set' do shell
+        // ao mesmo tempo nao se perde
+        config_estacao_t c;
+        config_travar();
+        config_obter(&c);
+        bool ok = escrever_retencao(&c, inicio, n, valores);
+        if (ok)
+            config_aplicar(&c);
+        config_liberar();
+        if (!ok)
+            return excecao(pdu, EXCECAO_VALOR, resposta);
+        contar(&estatistica.escritas);
+
+        // Eco: endereco e valor (06) ou endereco e quantidade (16)
+        memcpy(p, &pdu[1], 4);
+        return 5;
+    }
+    default:
+        return excecao(pdu, EXCECAO_FUNCAO, resposta);
+    }
+}
+
+uint16_t modbus_crc(const uint8_t *dados, size_t tamanho) {
+    uint16_t crc = 0xFFFF;
+    for (size_t i = 0; i < tamanho; i++) {
+        crc ^= dados[i];
+        for (int b = 0; b < 8; b++)
+            crc = crc & 1 ? (uint16_t)((crc >> 1) ^ 0xA001) : (uint16_t)(crc >> 1);
+    }
+    return crc;
+}
+
+void modbus_obter(modbus_estatistica_t *destino) {
+    taskENTER_CRITICAL();
+    *destino = estatistica;
+    taskEXIT_CRITICAL();
+}
+
+static void medir_resposta(uint64_t inicio_us) {
+    uint32_t us = (uint32_t)(time_us_64() - inicio_us);
+    taskENTER_CRITICAL();
+    if (us > estatistica.resposta_max_us)
+        estatistica.resposta_max_us = us;
+    taskEXIT_CRITICAL();
+}
+
+// -------------------- RTU --------------------
+// Tamanho do pedido pelo codigo da funcao; 0 se ainda nao da para saber
+// (o quadro entao termina pelo silencio de 3,5 caracteres).
+static size_t tamanho_rtu(const uint8_t *quadro, size_t n) {
+    if (n < 2)
+        return 0;
+    switch (quadro[1]) {
+    case FUNCAO_LER_RETENCAO:
+    case FUNCAO_LER_ENTRADAS:
+    case FUNCAO_ESCREVER_UM:
+        return 8;
+    case FUNCAO_ESCREVER_VARIOS:
+        return n >= 7 ? 9u + quadro[6] : 0;
+    default:
+        return 0;
+    }
+}
+
+static void atender_rtu(const uint8_t *quadro, size_t n) {
+    uint64_t inicio_us = time_us_64();
+    if (n < 4 || modbus_crc(quadro, n - 2) != (uint16_t)(quadro[n - 2] | quadro[n - 1] << 8)) {
+        contar(&estatistica.rtu_erros);
+        return;
+    }
+    uint8_t endereco = quadro[0];
+    if (endereco != MODBUS_ENDERECO && endereco != 0)
+        return; // outro escravo
+    contar(&estatistica.rtu_quadros);
+
+    uint8_t resposta[1 + MODBUS_PDU_MAX + 2];
+    size_t r = modbus_processar(&quadro[1], n - 3, &resposta[1]);
+    if (endereco == 0 || r == 0)
+        return; // difusao: executa e nao responde
+    resposta[0] = MODBUS_ENDERECO;
+    uint16_t crc = modbus_crc(resposta, r + 1);
+    resposta[r + 1] = (uint8_t)crc;
+    resposta[r + 2] = (uint8_t)(crc >> 8);
+    medir_resposta(inicio_us);
+
+    // O divisor da UART nao pode mudar no meio da resposta
+    relogio_bloquear();
+    gpio_put(MODBUS_PINO_DE, 1);
+    uart_write_blocking(MODBUS_UART, resposta, r + 3);
+    uart_tx_wait_blocking(MODBUS_UART);
+    gpio_put(MODBUS_PINO_DE, 0);
+    relogio_liberar();
+}
+
+// O set_sys_clock_khz leva o clk_peri junto com o clk_sys: sem refazer o
+// divisor, a UART sairia de 19200 a cada troca de perfil
+static void ajustar_uart(uint32_t hz) {
+    (void)hz;
+    uart_set_baudrate(MODBUS_UART, MODBUS_BAUD);
+}
+
+// Com a FIFO desligada a UART interrompe a cada byte, e o instante guardado
+// e o da chegada: o silencio de 3,5 caracteres nao depende de quando a
+// tarefa acorda. Anel cheio perde o byte, e o CRC do quadro acusa.
+static void EM_RAM(uart_rx_handler)(void) {
+    BaseType_t acordou = pdFALSE;
+    while (uart_is_readable(MODBUS_UART)) {
+        uint8_t byte = (uint8_t)uart_getc(MODBUS_UART);
+        uint32_t i = rx_cabeca;
+        if (i - rx_cauda < MODBUS_RX_ANEL) {
+            rx_bytes[i & (MODBUS_RX_ANEL - 1)] = byte;
+            rx_chegada_us[i & (MODBUS_RX_ANEL - 1)] = (uint32_t)time_us_64();
+            __dmb();
+            rx_cabeca = i + 1;
+        }
+    }
+    vTaskNotifyGiveFromISR(tarefa, &acordou);
+    portYIELD_FROM_ISR(acordou);
+}
+
+static void iniciar_rtu(void) {
+    uart_init(MODBUS_UART, MODBUS_BAUD);
+    uart_set_format(MODBUS_UART, 8, 1, UART_PARITY_EVEN);
+    uart_set_fifo_enabled(MODBUS_UART, false);
+    relogio_registrar(ajustar_uart);
+    gpio_set_function(MODBUS_PINO_TX, GPIO_FUNC_UART);
+    gpio_set_function(MODBUS_PINO_RX, GPIO_FUNC_UART);
+    gpio_init(MODBUS_PINO_DE);
+    gpio_set_dir(MODBUS_PINO_DE, GPIO_OUT);
+    gpio_put(MODBUS_PINO_DE, 0); // transceptor recebendo
+
+    irq_set_exclusive_handler(MODBUS_UART_IRQ, uart_rx_handler);
+    irq_set_enabled(MODBUS_UART_IRQ, true);
+    uart_set_irq_enables(MODBUS_UART, true, false);
+}
+
+// -------------------- TCP (callbacks do lwIP) --------------------
+static void soltar(conexao_modbus_t *c) {
+    c->pcb = NULL;
+    taskENTER_CRITICAL();
+    estatistica.clientes_tcp--;
+    taskEXIT_CRITICAL();
+}
+
+static err_t fechar(conexao_modbus_t *c, bool abortar) {
+    tcp_arg(c->pcb, NULL);
+    tcp_recv(c->pcb, NULL);
+    tcp_err(c->pcb, NULL);
+    err_t err = ERR_OK;
+    if (abortar || tcp_close(c->pcb) != ERR_OK) {
+        tcp_abort(c->pcb);
+        err = ERR_ABRT;
+    }
+    soltar(c);
+    return err;
+}
+
+// Responde cada ADU completo; false se o mestre mandou lixo ou nao cabe
+// resposta (um mestre espera a resposta antes do proximo pedido)
+static bool atender_tcp(conexao_modbus_t *c) {
+    while (c->n >= MBAP) {
+        uint16_t tamanho = ler16(&c->entrada[4]);
+        if (ler16(&c->entrada[2]) != 0 || tamanho < 2 || tamanho > MODBUS_PDU_MAX + 1)
+            return false;
+        size_t total = 6u + tamanho;
+        if (c->n < total)
+            return true;
+
+        uint64_t inicio_us = time_us_64();
+        uint8_t resposta[MBAP + MODBUS_PDU_MAX];
+        size_t r = modbus_processar(&c->entrada[MBAP], tamanho - 1u, &resposta[MBAP]);
+        memcpy(resposta, c->entrada, 4); // transacao e protocolo
+        escrever16(&resposta[4], (uint16_t)(r + 1));
+        resposta[6] = c->entrada[6];     // unidade, como veio
+        medir_resposta(inicio_us);
+        contar(&estatistica.tcp_pedidos);
+        if (tcp_sndbuf(c->pcb) < MBAP + r ||
+            tcp_write(c->pcb, resposta, (u16_t)(MBAP + r), TCP_WRITE_FLAG_COPY) != ERR_OK)
+            return false;
+
+        c->n = (uint16_t)(c->n - total);
+        memmove(c->entrada, &c->entrada[total], c->n);
+    }
+    return true;
+}
+
+static err_t ao_receber(void *arg, struct tcp_pcb *tpcb, struct pbuf *p, err_t err) {
+    conexao_modbus_t *c = arg;
+    (void)err;
+    if (p == NULL)
+        return fechar(c, false);
+
+    bool ok = true;
+    for (struct pbuf *q = p; q != NULL && ok; q = q->next) {
+        const uint8_t *bytes = q->payload;
+        for (u16_t i = 0; i < q->len && ok; i++) {
+            c->entrada[c->n++] = bytes[i]; // um ADU tem no maximo sizeof(entrada)
+            ok = atender_tcp(c);
+        }
+    }
+    tcp_recved(tpcb, p->tot_len);
+    pbuf_free(p);
+    c->ultimo_ms = to_ms_since_boot(get_absolute_time());
+    if (!ok) {
+        TLOG("modbus: pedido TCP invalido, fechando");
+        return fechar(c, true);
+    }
+    tcp_output(tpcb);
+    return ERR_OK;
+}
+
+// O pcb ja foi liberado pelo lwIP
+static void ao_erro(void *arg, err_t err) {
+    (void)err;
+    soltar(arg);
+}
+
+static err_t ao_aceitar(void *arg, struct tcp_pcb *novo, err_t err) {
+    (void)arg;
+    if (err != ERR_OK || novo == NULL)
+        return ERR_VAL;
+    for (int i = 0; i < MODBUS_CONEXOES; i++) {
+        conexao_modbus_t *c = &conexoes[i];
+        if (c->pcb != NULL)
+            continue;
+        c->pcb = novo;
+        c->n = 0;
+        c->ultimo_ms = to_ms_since_boot(get_absolute_time());
+        tcp_arg(novo, c);
+        tcp_recv(novo, ao_receber);
+        tcp_err(novo, ao_erro);
+        tcp_nagle_disable(novo); // respostas pequenas, uma por pedido
+        taskENTER_CRITICAL();
+        estatistica.clientes_tcp++;
+        taskEXIT_CRITICAL();
+        return ERR_OK;
+    }
+    return ERR_MEM; // sem vaga: o lwIP aborta a conexao
+}
+
+static bool escutar(void) {
+    cyw43_arch_lwip_begin();
+    struct tcp_pcb *pcb = tcp_new_ip_type(IPADDR_TYPE_ANY);
+    if (pcb != NULL && tcp_bind(pcb, IP_ANY_TYPE, MODBUS_PORTA) == ERR_OK)
+        escuta = tcp_listen_with_backlog(pcb, MODBUS_CONEXOES);
+    if (escuta != NULL)
+        tcp_accept(escuta, ao_aceitar);
+    else if (pcb != NULL)
+        tcp_abort(pcb);
+    cyw43_arch_lwip_end();
+    return escuta != NULL;
+}
+
+static void fechar_ociosas(uint32_t agora) {
+    cyw43_arch_lwip_begin();
+    for (int i = 0; i < MODBUS_CONEXOES; i++) {
+        if (conexoes[i].pcb != NULL && agora - conexoes[i].ultimo_ms > MODBUS_OCIOSA_MS)
+            fechar(&conexoes[i], false);
+    }
+    cyw43_arch_lwip_end();
+}
+
+// -------------------- Tarefa --------------------
+void vModbusTask(void *params) {
+    (void)params;
+    tarefa = xTaskGetCurrentTaskHandle();
+    iniciar_rtu();
+
+    uint8_t quadro[RTU_QUADRO_MAX];
+    size_t n = 0;
+    uint32_t ultimo_byte_us = 0;
+    uint32_t ultima_manutencao_ms = 0;
+
+    while (true) {
+        // Dorme ate chegar byte; com um quadro pela metade, so ate dar o
+        // silencio que o termina
+        ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(n > 0 ? MODBUS_SILENCIO_MS : MODBUS_MANUTENCAO_MS));
+
+        uint32_t fim = rx_cabeca;
+        __dmb();
+        for (uint32_t i = rx_cauda; i != fim; i++) {
+            uint8_t byte = rx_bytes[i & (MODBUS_RX_ANEL - 1)];
+            uint32_t chegada_us = rx_chegada_us[i & (MODBUS_RX_ANEL - 1)];
+            __dmb();
+            rx_cauda = i + 1;
+            if (n > 0 && chegada_us - ultimo_byte_us > MODBUS_SILENCIO_US)
+                n = 0; // sobra de um quadro interrompido
+            if (n < sizeof(quadro))
+                quadro[n++] = byte;
+            ultimo_byte_us = chegada_us;
+
+            // Pedido completo pelo tamanho: responde sem esperar o silencio
+            size_t esperado = tamanho_rtu(quadro, n);
+            if (esperado != 0 && n >= esperado) {
+                atender_rtu(quadro, esperado);
+                n = 0;
+            }
+        }
+        if (n > 0 && (uint32_t)time_us_64() - ultimo_byte_us > MODBUS_SILENCIO_US) {
+            atender_rtu(quadro, n); // funcao desconhecida: responde a excecao
+            n = 0;
+        }
+
+        // A associacao e da vMqttTask; o pcb de escuta sobrevive a quedas
+        uint32_t agora = to_ms_since_boot(get_absolute_time());
+        if (agora - ultima_manutencao_ms >= MODBUS_MANUTENCAO_MS) {
+            ultima_manutencao_ms = agora;
+            if (escuta == NULL && mqtt_wifi_associado())
+                escutar();
+            else if (escuta != NULL)
+                fechar_ociosas(agora);
+        }
+    }
+}
@@ -0,0 +1,121 @@
+#ifndef MODBUS_H
+#define MODBUS_H
+
+#include "pico/stdlib.h"
+#include "hardware/uart.h"
+
+// -------------------- Escravo Modbus (RTU na UART, TCP no Wi-Fi) --------------------
+// O SCADA le as leituras como input registers (funcao 04) e le ou escreve a
+// configuracao como holding registers (03, 06 e 16). Os dois transportes
+// entregam o mesmo PDU a modbus_processar, que responde na hora.
+//
+// Imagem dupla: a vJoystickTask preenche a imagem de tras
+// (modbus_imagem_escrever) e a publica incrementando uma sequencia
+// (modbus_imagem_publicar). Um pedido copia a imagem da frente (paridade da
+// sequencia) e confere a sequencia de novo; se houve qualquer publicacao
+// durante a copia, ela e refeita. A aquisicao nunca espera por um pedido e
+// nenhum pedido mistura registradores de leituras diferentes, seja qual for
+// a prioridade de quem copia.
+//
+// Input registers (somente leitura; 32 bits em dois registradores, o alto
+// primeiro):
+//   0      nivel (centesimos de %)      1  chuva
+//   2      severidade: 0 normal, 1 um canal acima do limiar, 2 os dois
+//   3      bits: 0 alerta, 1 nivel acima, 2 chuva acima, 3 MQTT conectado
+//   4-5    leituras desde o boot (muda a cada imagem)
+//   6-7    tempo da leitura (ms desde o boot)
+//   8-9    alertas desde o boot
+//   10-11  descartes da telemetria     12-13  do log em flash
+//   14-15  capturas perdidas           16-17  descartes do log tokenizado
+//
+// Holding registers: os parametros de config_params, na ordem da tabela,
+// com 1 registrador (16 bits) ou 2 (32 bits, o alto primeiro):
+//   0 limiar_agua  1 limiar_chuva  2 periodo_amostra_ms  3 periodo_display_ms
+//   4 buzzer_ligado_ms  5 buzzer_desligado_ms  6-7 cor_alerta  8-9 cor_normal
+//   10 mqtt_lote  11 mqtt_drenagem
+// Uma escrita com valor fora da faixa do parametro responde a excecao 03 e
+// nao aplica nada; a configuracao muda inteira, como no shell, e com a
+// mesma trava (config_travar).
+
+#ifndef MODBUS_ENDERECO
+#define MODBUS_ENDERECO 1 // escravo no barramento RTU
+#endif
+#ifndef MODBUS_PORTA
+#define MODBUS_PORTA 502
+#endif
+
+// RTU: UART0 nos GPIO 0/1, 19200 8E1 (padrao do Modbus serial), com o
+// DE/RE do transceptor RS-485 no GPIO 8
+#define MODBUS_UART     uart0
+#define MODBUS_UART_IRQ UART0_IRQ
+#define MODBUS_PINO_TX  0
+#define MODBUS_PINO_RX  1
+#define MODBUS_PINO_DE  8
+#define MODBUS_BAUD     19200
+#define MODBUS_SILENCIO_US (35u * 11u * 1000000u / 10u / MODBUS_BAUD) // 3,5 caracteres
+#define MODBUS_SILENCIO_MS ((MODBUS_SILENCIO_US + 999u) / 1000u + 1u)   // em ticks, com o tick parcial
+#define MODBUS_RX_ANEL     128  // bytes recebidos com o instante de chegada
+#define MODBUS_MANUTENCAO_MS 1000
+
+#define MODBUS_CONEXOES  2     // mestres TCP ao mesmo tempo
+#define MODBUS_OCIOSA_MS 60000 // mestre TCP calado: fecha e libera a vaga
+
+// Input registers
+enum {
+    MODBUS_ENT_NIVEL = 0,
+    MODBUS_ENT_CHUVA = 1,
+    MODBUS_ENT_SEVERIDADE = 2,
+    MODBUS_ENT_BITS = 3,
+    MODBUS_ENT_LEITURAS = 4,
+    MODBUS_ENT_TEMPO_MS = 6,
+    MODBUS_ENT_ALERTAS = 8,
+    MODBUS_ENT_TELEMETRIA_DESCARTADOS = 10,
+    MODBUS_ENT_LOG_DESCARTADOS = 12,
+    MODBUS_ENT_CAPTURAS_PERDIDAS = 14,
+    MODBUS_ENT_TLOG_DESCARTADOS = 16,
+    MODBUS_ENTRADAS = 18
+};
+
+#define MODBUS_BIT_ALERTA         (1u << 0)
+#define MODBUS_BIT_NIVEL_ACIMA    (1u << 1)
+#define MODBUS_BIT_CHUVA_ACIMA    (1u << 2)
+#define MODBUS_BIT_MQTT_CONECTADO (1u << 3)
+
+#define MODBUS_PDU_MAX 253
+
+typedef struct {
+    uint32_t rtu_quadros;     // quadros RTU para este escravo
+    uint32_t rtu_erros;       // CRC errado ou quadro curto
+    uint32_t tcp_pedidos;
+    uint32_t excecoes;
+    uint32_t escritas;        // configuracoes aplicadas pelo mestre
+    uint32_t repeticoes;      // copias da imagem refeitas
+    uint32_t resposta_max_us; // do fim do pedido a resposta pronta
+    uint8_t clientes_tcp;
+} modbus_estatistica_t;
+
+void modbus_init(void);
+
+// Imagem de tras para a vJoystickTask preencher inteira e publicar. So
+// ela escreve; nada aqui bloqueia.
+uint16_t *modbus_imagem_escrever(void);
+void modbus_imagem_publicar(void);
+
+static inline void modbus_escrever32(uint16_t *imagem, uint registrador, uint32_t valor) {
+    imagem[registrador] = (uint16_t)(valor >> 16);
+    imagem[registrador + 1] = (uint16_t)valor;
+}
+
+// Atende um PDU (codigo da funcao + dados) e escreve o PDU de resposta,
+// normal ou de excecao. Retorna o tamanho da resposta.
+size_t modbus_processar(const uint8_t *pdu, size_t tamanho, uint8_t *resposta);
+
+// CRC-16/MODBUS (0xA001 refletido, inicial 0xFFFF), byte baixo primeiro no quadro
+uint16_t modbus_crc(const uint8_t *dados, size_t tamanho);
+
+void modbus_obter(modbus_estatistica_t *destino);
+
+// RTU pela interrupcao da UART; TCP na porta MODBUS_PORTA depois do Wi-Fi
+void vModbusTask(void *params);
+
+#endif
@@ -0,0 +1,479 @@
+#include <string.h>
+#include "mqtt.h"
+#include "mqtt_proto.h"
+#include "config.h"
+#include "formatar.h"
+#include "tlog.h"
+#include "pico/cyw43_arch.h"
+#include "lwip/tcp.h"
+#include "FreeRTOS.h"
+#include "task.h"
+
+#define CARGA_MAX  128
+#define PACOTE_MAX (CARGA_MAX + MQTT_PUBLISH_EXTRA(sizeof(MQTT_TOPICO "/alerta")))
+
+// Identificadores de pacote: lotes em 0x0001..0x4000, alertas em
+// 0x8000..0xBFFF, pela posicao no anel. Um PUBACK diz de qual anel veio.
+#define ID_MASCARA 0x3FFFu
+
+_Static_assert((MQTT_ANEL_LOTES & (MQTT_ANEL_LOTES - 1)) == 0, "anel deve ser potencia de 2");
+_Static_assert((MQTT_ANEL_ALERTAS & (MQTT_ANEL_ALERTAS - 1)) == 0, "anel deve ser potencia de 2");
+_Static_assert(MQTT_ANEL_LOTES <= ID_MASCARA + 1, "identificadores nao cobrem o anel");
+
+// Lote fechado ou transicao de alerta; a carga JSON so e montada na hora
+// de publicar. Alertas tem amostras = 0 e so usam o indice 0 dos canais.
+typedef struct {
+    uint32_t tempo_ms;
+    uint16_t amostras;
+    uint8_t alerta;
+    uint8_t reservado;
+    uint16_t nivel[3]; // minimo, media, maximo (centesimos de %)
+    uint16_t chuva[3];
+} mensagem_mqtt_t;
+
+// Indices livres (so crescem), mascarados no acesso: cauda <= enviada <=
+// cabeca. Entre cauda e enviada estao as mensagens sem PUBACK; antes de
+// reenviar, as que ja sairam numa conexao anterior (vao com DUP).
+typedef struct {
+    mensagem_mqtt_t *itens;
+    uint32_t mascara;
+    uint32_t cabeca;
+    uint32_t enviada;
+    uint32_t cauda;
+    uint32_t reenviar;
+    uint16_t base_id;
+    const char *topico;
+} fila_mqtt_t;
+
+typedef enum {
+    MQTT_DESCONECTADO,
+    MQTT_CONECTANDO, // TCP e CONNECT enviados, esperando o CONNACK
+    MQTT_CONECTADO
+} estado_mqtt_t;
+
+static mensagem_mqtt_t itens_lotes[MQTT_ANEL_LOTES];
+static mensagem_mqtt_t itens_alertas[MQTT_ANEL_ALERTAS];
+static fila_mqtt_t lotes = {
+    .itens = itens_lotes, .mascara = MQTT_ANEL_LOTES - 1, .base_id = 0x0001, .topico = MQTT_TOPICO "/lote"
+};
+static fila_mqtt_t alertas = {
+    .itens = itens_alertas, .mascara = MQTT_ANEL_ALERTAS - 1, .base_id = 0x8000, .topico = MQTT_TOPICO "/alerta"
+};
+
+// Lote em formacao (so a tarefa de leitura mexe)
+static mensagem_mqtt_t lote;
+static uint32_t soma_nivel;
+static uint32_t soma_chuva;
+
+// Conexao: a tarefa mexe com o nucleo do lwIP travado
+// (cyw43_arch_lwip_begin); os callbacks rodam com ele travado.
+static volatile estado_mqtt_t estado;
+static struct tcp_pcb *pcb;
+static mqtt_leitor_t leitor;
+static uint8_t pacote[PACOTE_MAX];
+static TaskHandle_t tarefa;
+static uint32_t ultimo_envio_ms;
+static uint32_t ultimo_recebido_ms;
+static uint32_t espera_puback_ms; // inicio da espera pela mensagem sem PUBACK mais antiga
+
+static mqtt_estatistica_t estatistica;
+static volatile bool wifi_associado; // CYW43 iniciado e link Wi-Fi de pe
+static bool radio_ativo;
+static uint64_t radio_desde_us;
+
+static uint32_t agora_ms(void) {
+    return to_ms_since_boot(get_absolute_time());
+}
+
+// -------------------- Aneis --------------------
+static uint16_t id_de(const fila_mqtt_t *f, uint32_t indice) {
+    return (uint16_t)(f->base_id + (indice & ID_MASCARA));
+}
+
+static void enfileirar(fila_mqtt_t *f, const mensagem_mqtt_t *m) {
+    taskENTER_CRITICAL();
+    if (f->cabeca - f->cauda > f->mascara) {
+        // Cheio: perde a mais antiga, mesmo que ja esteja no ar
+        f->cauda++;
+        if ((int32_t)(f->enviada - f->cauda) < 0)
+            f->enviada = f->cauda;
+        estatistica.descartadas++;
+    }
+    f->itens[f->cabeca++ & f->mascara] = *m;
+    taskEXIT_CRITICAL();
+}
+
+static uint32_t em_voo(void) {
+    return (lotes.enviada - lotes.cauda) + (alertas.enviada - alertas.cauda);
+}
+
+// O broker confirma em ordem (MQTT 3.1.1, 4.6): o PUBACK de uma mensagem
+// confirma tambem as anteriores do mesmo anel.
+static void confirmar(uint16_t id) {
+    fila_mqtt_t *f = id & 0x8000 ? &alertas : &lotes;
+    taskENTER_CRITICAL();
+    for (uint32_t i = f->cauda; i != f->enviada; i++) {
+        if (id_de(f, i) != id)
+            continue;
+        for (; f->cauda != i + 1; f->cauda++) {
+            estatistica.publicadas++;
+            estatistica.amostras += f->itens[f->cauda & f->mascara].amostras;
+        }
+        break;
+    }
+    taskEXIT_CRITICAL();
+    espera_puback_ms = agora_ms();
+}
+
+// Conexao perdida: o que estava sem PUBACK sai de novo, com DUP
+static void voltar(fila_mqtt_t *f) {
+    if ((int32_t)(f->enviada - f->reenviar) > 0)
+        f->reenviar = f->enviada;
+    f->enviada = f->cauda;
+}
+
+// -------------------- Produtores --------------------
+void mqtt_init(void) {
+    memset(&lote, 0, sizeof(lote));
+    memset(&estatistica, 0, sizeof(estatistica));
+    estado = MQTT_DESCONECTADO;
+}
+
+void mqtt_amostra(uint16_t nivel_c, uint16_t chuva_c, bool alerta, uint16_t tamanho_lote) {
+    if (lote.amostras == 0) {
+        lote.nivel[0] = lote.nivel[2] = nivel_c;
+        lote.chuva[0] = lote.chuva[2] = chuva_c;
+        lote.alerta = 0;
+        soma_nivel = soma_chuva = 0;
+    }
+    if (nivel_c < lote.nivel[0]) lote.nivel[0] = nivel_c;
+    if (nivel_c > lote.nivel[2]) lote.nivel[2] = nivel_c;
+    if (chuva_c < lote.chuva[0]) lote.chuva[0] = chuva_c;
+    if (chuva_c > lote.chuva[2]) lote.chuva[2] = chuva_c;
+    soma_nivel += nivel_c;
+    soma_chuva += chuva_c;
+    lote.alerta |= alerta;
+
+    if (++lote.amostras < tamanho_lote)
+        return;
+    lote.tempo_ms = agora_ms();
+    lote.nivel[1] = (uint16_t)((soma_nivel + lote.amostras / 2) / lote.amostras);
+    lote.chuva[1] = (uint16_t)((soma_chuva + lote.amostras / 2) / lote.amostras);
+    enfileirar(&lotes, &lote);
+    lote.amostras = 0;
+}
+
+void mqtt_alerta(uint16_t nivel_c, uint16_t chuva_c, bool alerta) {
+    mensagem_mqtt_t m = {
+        .tempo_ms = agora_ms(),
+        .alerta = alerta,
+        .nivel = { nivel_c },
+        .chuva = { chuva_c }
+    };
+    enfileirar(&alertas, &m);
+    if (tarefa != NULL)
+        xTaskNotifyGive(tarefa);
+}
+
+void mqtt_obter(mqtt_estatistica_t *destino) {
+    taskENTER_CRITICAL();
+    *destino = estatistica;
+    destino->pendentes = (uint16_t)((lotes.cabeca - lotes.cauda) + (alertas.cabeca - alertas.cauda));
+    taskEXIT_CRITICAL();
+    if (radio_ativo)
+        destino->radio_us += time_us_64() - radio_desde_us;
+}
+
+bool mqtt_wifi_associado(void) {
+    return wifi_associado;
+}
+
+// -------------------- Carga JSON --------------------
+static char *escrever(char *p, const char *texto) {
+    size_t n = strlen(texto);
+    memcpy(p, texto, n);
+    return p + n;
+}
+
+static char *escrever_canal(char *p, const char *chave, const uint16_t *valores, uint8_t n) {
+    p = escrever(p, chave);
+    for (uint8_t i = 0; i < n; i++) {
+        if (i)
+            *p++ = ',';
+        p += formatar_decimal(p, valores[i], 2);
+    }
+    return n > 1 ? escrever(p, "]") : p;
+}
+
+static size_t carga_json(const mensagem_mqtt_t *m, char *destino) {
+    char *p = escrever(destino, "{\"t\":");
+    p += formatar_decimal(p, m->tempo_ms, 0);
+    if (m->amostras == 0) {
+        p = escrever(p, ",\"alerta\":");
+        *p++ = (char)('0' + m->alerta);
+        p = escrever_canal(p, ",\"nivel\":", m->nivel, 1);
+        p = escrever_canal(p, ",\"chuva\":", m->chuva, 1);
+    } else {
+        p = escrever(p, ",\"n\":");
+        p += formatar_decimal(p, m->amostras, 0);
+        p = escrever_canal(p, ",\"nivel\":[", m->nivel, 3);
+        p = escrever_canal(p, ",\"chuva\":[", m->chuva, 3);
+        p = escrever(p, ",\"alerta\":");
+        *p++ = (char)('0' + m->alerta);
+    }
+    *p++ = '}';
+    return (size_t)(p - destino);
+}
+
+// -------------------- Radio --------------------
+// Desempenho so enquanto ha troca com o broker; o resto do tempo o CYW43
+// dorme entre beacons e acorda pelo DTIM para receber.
+static void radio(bool ativo) {
+    uint64_t agora = time_us_64();
+    if (radio_ativo)
+        estatistica.radio_us += agora - radio_desde_us;
+    radio_desde_us = agora;
+    if (ativo != radio_ativo) {
+        cyw43_wifi_pm(&cyw43_state, ativo ? CYW43_PERFORMANCE_PM : CYW43_AGGRESSIVE_PM);
+        radio_ativo = ativo;
+    }
+}
+
+// -------------------- TCP (callbacks do lwIP) --------------------
+static void desconectado(void) {
+    taskENTER_CRITICAL();
+    voltar(&lotes);
+    voltar(&alertas);
+    taskEXIT_CRITICAL();
+    estado = MQTT_DESCONECTADO;
+    estatistica.conectado = false;
+}
+
+// Retorna ERR_ABRT se precisou abortar (o callback deve repassar)
+static err_t fechar(void) {
+    err_t err = ERR_OK;
+    if (pcb != NULL) {
+        tcp_arg(pcb, NULL);
+        tcp_recv(pcb, NULL);
+        tcp_err(pcb, NULL);
+        if (tcp_close(pcb) != ERR_OK) {
+            tcp_abort(pcb);
+            err = ERR_ABRT;
+        }
+        pcb = NULL;
+    }
+    desconectado();
+    return err;
+}
+
+static bool enviar(const uint8_t *dados, size_t n) {
+    if (n == 0 || tcp_sndbuf(pcb) < n || tcp_write(pcb, dados, (u16_t)n, TCP_WRITE_FLAG_COPY) != ERR_OK)
+        return false;
+    ultimo_envio_ms = agora_ms();
+    return true;
+}
+
+static err_t ao_conectar(void *arg, struct tcp_pcb *tpcb, err_t err) {
+    (void)arg;
+    (void)tpcb;
+    (void)err; // sempre ERR_OK; falhas chegam por ao_erro
+    if (!enviar(pacote, mqtt_connect(pacote, sizeof(pacote), MQTT_CLIENTE, MQTT_KEEPALIVE_S)))
+        return fechar();
+    tcp_output(pcb);
+    return ERR_OK;
+}
+
+static err_t ao_receber(void *arg, struct tcp_pcb *tpcb, struct pbuf *p, err_t err) {
+    (void)arg;
+    (void)err;
+    if (p == NULL) {
+        TLOG("mqtt: broker fechou a conexao");
+        err_t r = fechar();
+        xTaskNotifyGive(tarefa);
+        return r;
+    }
+
+    bool recusado = false;
+    mqtt_pacote_t recebido;
+    for (struct pbuf *q = p; q != NULL; q = q->next) {
+        const uint8_t *bytes = q->payload;
+        for (u16_t i = 0; i < q->len; i++) {
+            if (!mqtt_leitor_byte(&leitor, bytes[i], &recebido))
+                continue;
+            if (recebido.tipo == MQTT_CONNACK && recebido.codigo != 0) {
+                TLOG("mqtt: CONNACK recusado (%u)", recebido.codigo);
+                recusado = true;
+            } else if (recebido.tipo == MQTT_CONNACK) {
+                estado = MQTT_CONECTADO;
+                estatistica.conectado = true;
+                estatistica.conexoes++;
+            } else if (recebido.tipo == MQTT_PUBACK) {
+                confirmar(recebido.id);
+            }
+        }
+    }
+    tcp_recved(tpcb, p->tot_len);
+    pbuf_free(p);
+    ultimo_recebido_ms = agora_ms();
+    xTaskNotifyGive(tarefa);
+    return recusado ? fechar() : ERR_OK;
+}
+
+// O pcb ja foi liberado pelo lwIP
+static void ao_erro(void *arg, err_t err) {
+    (void)arg;
+    TLOG("mqtt: conexao perdida (erro %d)", err);
+    pcb = NULL;
+    desconectado();
+    xTaskNotifyGive(tarefa);
+}
+
+// -------------------- Tarefa --------------------
+static bool conectar(void) {
+    ip_addr_t broker;
+    if (!ipaddr_aton(MQTT_BROKER, &broker))
+        return false;
+
+    radio(true);
+    if (cyw43_tcpip_link_status(&cyw43_state, CYW43_ITF_STA) != CYW43_LINK_UP &&
+        cyw43_arch_wifi_connect_timeout_ms(WIFI_SSID, WIFI_SENHA, CYW43_AUTH_WPA2_AES_PSK, MQTT_ASSOCIACAO_MS) != 0) {
+        TLOG("mqtt: sem rede Wi-Fi");
+        wifi_associado = false;
+        return false;
+    }
+    wifi_associado = true;
+
+    cyw43_arch_lwip_begin();
+    pcb = tcp_new_ip_type(IPADDR_TYPE_V4);
+    if (pcb != NULL) {
+        tcp_recv(pcb, ao_receber);
+        tcp_err(pcb, ao_erro);
+        tcp_nagle_disable(pcb); // as rajadas ja saem juntas por tcp_output
+        mqtt_leitor_iniciar(&leitor);
+        estado = MQTT_CONECTANDO;
+        if (tcp_connect(pcb, &broker, MQTT_PORTA, ao_conectar) != ERR_OK) {
+            tcp_abort(pcb);
+            pcb = NULL;
+            estado = MQTT_DESCONECTADO;
+        }
+    }
+    cyw43_arch_lwip_end();
+    return pcb != NULL;
+}
+
+// Publica da fila enquanto houver janela, credito e espaco no TCP.
+// Chamar com o nucleo do lwIP travado.
+static uint32_t publicar(fila_mqtt_t *f, uint32_t maximo) {
+    char carga[CARGA_MAX];
+    uint32_t n = 0;
+
+    while (n < maximo && em_voo() < MQTT_JANELA) {
+        taskENTER_CRITICAL();
+        uint32_t indice = f->enviada;
+        bool vazia = indice == f->cabeca;
+        mensagem_mqtt_t m = f->itens[indice & f->mascara];
+        bool dup = (int32_t)(f->reenviar - indice) > 0;
+        taskEXIT_CRITICAL();
+        if (vazia)
+            break;
+
+        size_t tamanho = carga_json(&m, carga);
+        if (!enviar(pacote, mqtt_publish(pacote, sizeof(pacote), f->topico, carga, tamanho, id_de(f, indice), dup)))
+            break;
+        if (em_voo() == 0)
+            espera_puback_ms = ultimo_envio_ms;
+
+        taskENTER_CRITICAL();
+        if (f->enviada == indice) // senao, descartada pelo produtor enquanto saia
+            f->enviada++;
+        taskEXIT_CRITICAL();
+        estatistica.reenvios += dup;
+        n++;
+    }
+    return n;
+}
+
+void vMqttTask(void *params) {
+    (void)params;
+    tarefa = xTaskGetCurrentTaskHandle();
+    if (cyw43_arch_init() != 0) {
+        TLOG("mqtt: CYW43 nao iniciou");
+        vTaskDelete(NULL);
+    }
+    cyw43_arch_enable_sta_mode();
+    radio(false);
+    cyw43_wifi_pm(&cyw43_state, CYW43_AGGRESSIVE_PM);
+
+    config_estacao_t config;
+    uint32_t espera_ms = MQTT_ESPERA_MIN_MS;
+    uint32_t proxima_tentativa_ms = 0;
+    uint32_t inicio_conexao_ms = 0;
+    uint32_t credito = 0; // milesimos de mensagem de lote
+    uint32_t anterior_ms = agora_ms();
+
+    while (true) {
+        ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(MQTT_PERIODO_MS));
+        config_obter(&config);
+        uint32_t agora = agora_ms();
+
+        // Os lotes drenam a config.mqtt_drenagem por segundo; o balde
+        // guarda no maximo uma janela, para a rajada nao passar disso
+        credito += (agora - anterior_ms) * config.mqtt_drenagem;
+        if (credito > MQTT_JANELA * 1000u)
+            credito = MQTT_JANELA * 1000u;
+        anterior_ms = agora;
+
+        // O ao_erro (thread do lwIP, prioridade maior) pode zerar o pcb a
+        // qualquer momento fora da trava: os estados com pcb sao conferidos
+        // de novo depois do cyw43_arch_lwip_begin
+        switch (estado) {
+        case MQTT_DESCONECTADO:
+            if ((int32_t)(agora - proxima_tentativa_ms) < 0)
+                break;
+            // A proxima tentativa ja fica marcada aqui: a recusa do TCP e a
+            // falta de CONNACK chegam depois, pelo ao_erro ou pelo prazo
+            if (conectar())
+                inicio_conexao_ms = agora;
+            proxima_tentativa_ms = agora_ms() + espera_ms;
+            espera_ms = espera_ms * 2 > MQTT_ESPERA_MAX_MS ? MQTT_ESPERA_MAX_MS : espera_ms * 2;
+            break;
+
+        case MQTT_CONECTANDO:
+            if (agora - inicio_conexao_ms > MQTT_CONEXAO_MS) {
+                cyw43_arch_lwip_begin();
+                if (estado == MQTT_CONECTANDO && pcb != NULL) {
+                    TLOG("mqtt: broker nao respondeu");
+                    fechar();
+                }
+                cyw43_arch_lwip_end();
+            }
+            break;
+
+        case MQTT_CONECTADO:
+            espera_ms = MQTT_ESPERA_MIN_MS;
+            cyw43_arch_lwip_begin();
+            if (estado != MQTT_CONECTADO || pcb == NULL) {
+                // caiu entre o switch e a trava
+            } else if (em_voo() > 0 && agora - espera_puback_ms > MQTT_PUBACK_MS) {
+                TLOG("mqtt: sem PUBACK, reconectando");
+                fechar();
+            } else if (agora - ultimo_recebido_ms > MQTT_KEEPALIVE_S * 1500u) {
+                TLOG("mqtt: broker mudo, reconectando");
+                fechar();
+            } else {
+                // Alertas primeiro e sem limite de taxa; uma rajada, um tcp_output
+                uint32_t n = publicar(&alertas, MQTT_JANELA);
+                uint32_t n_lotes = publicar(&lotes, credito / 1000u);
+                credito -= n_lotes * 1000u;
+                if (n + n_lotes == 0 && agora - ultimo_envio_ms >= MQTT_KEEPALIVE_S * 500u)
+                    n = enviar(pacote, mqtt_pingreq(pacote, sizeof(pacote)));
+                if (n + n_lotes > 0)
+                    tcp_output(pcb);
+            }
+            cyw43_arch_lwip_end();
+            break;
+        }
+
+        radio(estado == MQTT_CONECTANDO || (estado == MQTT_CONECTADO && em_voo() > 0));
+    }
+}
@@ -0,0 +1,87 @@
+#ifndef MQTT_H
+#define MQTT_H
+
+#include "pico/stdlib.h"
+
+// -------------------- Publicador MQTT (Wi-Fi do Pico W) --------------------
+// As leituras viram lotes. A cada config.mqtt_lote amostras sai uma mensagem
+// com minimo, media e maximo de cada canal. As transicoes de alerta saem na
+// hora, por uma fila propria que passa na frente dos lotes. Tudo vai com
+// QoS 1: a mensagem so sai do anel quando o broker confirma (PUBACK).
+//
+// Sem broker (Wi-Fi fora do ar, TCP recusado) os lotes se acumulam no anel.
+// Com o anel cheio, o mais antigo e descartado e contado. Quando a conexao
+// volta, o atraso e drenado a config.mqtt_drenagem mensagens/s, para nao
+// disputar o radio e a CPU com as tarefas de alerta. O que ja tinha saido
+// sem confirmacao e reenviado com DUP.
+//
+// Radio: fora das rajadas o CYW43 fica em economia agressiva e dorme entre
+// os beacons. So durante a conexao e enquanto houver mensagem sem PUBACK ele
+// vai para desempenho. O custo de radio de cada amostra entregue e o tempo
+// em desempenho dividido pelas amostras confirmadas (mqtt_obter).
+//
+// Topicos e cargas (JSON, valores em %, t em ms desde o boot):
+//   MQTT_TOPICO/lote    {"t":..,"n":50,"nivel":[min,media,max],"chuva":[...],"alerta":0|1}
+//   MQTT_TOPICO/alerta  {"t":..,"alerta":0|1,"nivel":..,"chuva":..}
+// No lote, "alerta" e 1 se alguma amostra do lote estava em alerta.
+
+// Rede e broker vem do CMake (-DWIFI_SSID=... -DMQTT_BROKER=...)
+#ifndef WIFI_SSID
+#define WIFI_SSID ""
+#endif
+#ifndef WIFI_SENHA
+#define WIFI_SENHA ""
+#endif
+#ifndef MQTT_BROKER
+#define MQTT_BROKER "127.0.0.1" // IPv4; sem DNS
+#endif
+#ifndef MQTT_PORTA
+#define MQTT_PORTA 1883
+#endif
+#ifndef MQTT_CLIENTE
+#define MQTT_CLIENTE "estacao-cheias"
+#endif
+#ifndef MQTT_TOPICO
+#define MQTT_TOPICO "estacao/cheias"
+#endif
+
+#define MQTT_ANEL_LOTES    128  // ~10 min sem broker com lotes de 5 s
+#define MQTT_ANEL_ALERTAS  16
+#define MQTT_JANELA        8    // mensagens sem PUBACK ao mesmo tempo
+#define MQTT_PERIODO_MS    20
+#define MQTT_KEEPALIVE_S   60
+#define MQTT_ASSOCIACAO_MS 10000 // tentativa de entrar na rede Wi-Fi
+#define MQTT_CONEXAO_MS    5000  // TCP + CONNACK
+#define MQTT_PUBACK_MS     10000 // sem PUBACK nesse tempo, reconecta e reenvia
+#define MQTT_ESPERA_MIN_MS 1000  // espera entre tentativas, dobra a cada falha
+#define MQTT_ESPERA_MAX_MS 60000
+
+typedef struct {
+    bool conectado;
+    uint32_t conexoes;
+    uint32_t publicadas;  // confirmadas pelo broker
+    uint32_t amostras;    // amostras dentro dos lotes confirmados
+    uint32_t descartadas; // perdidas com o anel cheio
+    uint32_t reenvios;    // PUBLISH repetidos com DUP depois de reconectar
+    uint16_t pendentes;   // lotes e alertas no anel, ainda sem PUBACK
+    uint64_t radio_us;    // tempo do radio em desempenho
+} mqtt_estatistica_t;
+
+void mqtt_init(void);
+
+// Soma uma leitura ao lote atual (centesimos de %); o lote fecha com lote
+// amostras. So a tarefa de leitura chama.
+void mqtt_amostra(uint16_t nivel_c, uint16_t chuva_c, bool alerta, uint16_t lote);
+
+// Transicao de alerta: vai para a fila de alertas e acorda a tarefa.
+void mqtt_alerta(uint16_t nivel_c, uint16_t chuva_c, bool alerta);
+
+void mqtt_obter(mqtt_estatistica_t *destino);
+
+// A vMqttTask e dona do CYW43: inicia o chip e entra na rede. Outros
+// servicos sobre o lwIP (http.h) so usam a pilha depois que isto vale true.
+bool mqtt_wifi_associado(void);
+
+void vMqttTask(void *params);
+
+#endif
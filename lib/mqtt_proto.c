@@ -0,0 +1,124 @@
+#include <string.h>
+#include "mqtt_proto.h"
+
+enum { LER_CABECALHO, LER_TAMANHO, LER_CORPO };
+
+// -------------------- Codificacao --------------------
+// Tamanho restante em base 128, 7 bits por byte (ate 4 bytes)
+static size_t escrever_tamanho(uint8_t *destino, uint32_t tamanho) {
+    size_t n = 0;
+    do {
+        uint8_t byte = tamanho & 0x7F;
+        tamanho >>= 7;
+        destino[n++] = tamanho ? (uint8_t)(byte | 0x80) : byte;
+    } while (tamanho);
+    return n;
+}
+
+static size_t tamanho_do_tamanho(uint32_t tamanho) {
+    return tamanho < 128 ? 1 : tamanho < 16384 ? 2 : tamanho < 2097152 ? 3 : 4;
+}
+
+static size_t escrever_texto(uint8_t *destino, const char *texto, size_t n) {
+    destino[0] = (uint8_t)(n >> 8);
+    destino[1] = (uint8_t)n;
+    memcpy(&destino[2], texto, n);
+    return 2 + n;
+}
+
+size_t mqtt_connect(uint8_t *destino, size_t max, const char *cliente, uint16_t keepalive_s) {
+    static const uint8_t protocolo[] = { 0, 4, 'M', 'Q', 'T', 'T', 4 };
+    size_t n_cliente = strlen(cliente);
+    uint32_t restante = sizeof(protocolo) + 1 + 2 + 2 + (uint32_t)n_cliente;
+    if (1 + tamanho_do_tamanho(restante) + restante > max)
+        return 0;
+
+    size_t n = 0;
+    destino[n++] = MQTT_CONNECT;
+    n += escrever_tamanho(&destino[n], restante);
+    memcpy(&destino[n], protocolo, sizeof(protocolo));
+    n += sizeof(protocolo);
+    destino[n++] = 0x02; // clean session: o broker nao guarda nada nosso
+    destino[n++] = (uint8_t)(keepalive_s >> 8);
+    destino[n++] = (uint8_t)keepalive_s;
+    n += escrever_texto(&destino[n], cliente, n_cliente);
+    return n;
+}
+
+size_t mqtt_publish(uint8_t *destino, size_t max, const char *topico, const void *carga, size_t tamanho,
+                    uint16_t id, bool dup) {
+    size_t n_topico = strlen(topico);
+    uint32_t restante = 2 + (uint32_t)n_topico + 2 + (uint32_t)tamanho;
+    if (1 + tamanho_do_tamanho(restante) + restante > max)
+        return 0;
+
+    size_t n = 0;
+    destino[n++] = MQTT_PUBLISH | MQTT_PUBLISH_QOS1 | (dup ? MQTT_PUBLISH_DUP : 0);
+    n += escrever_tamanho(&destino[n], restante);
+    n += escrever_texto(&destino[n], topico, n_topico);
+    destino[n++] = (uint8_t)(id >> 8);
+    destino[n++] = (uint8_t)id;
+    memcpy(&destino[n], carga, tamanho);
+    return n + tamanho;
+}
+
+static size_t pacote_vazio(uint8_t *destino, size_t max, uint8_t tipo) {
+    if (max < 2)
+        return 0;
+    destino[0] = tipo;
+    destino[1] = 0;
+    return 2;
+}
+
+size_t mqtt_pingreq(uint8_t *destino, size_t max) {
+    return pacote_vazio(destino, max, MQTT_PINGREQ);
+}
+
+size_t mqtt_disconnect(uint8_t *destino, size_t max) {
+    return pacote_vazio(destino, max, MQTT_DISCONNECT);
+}
+
+// -------------------- Leitura --------------------
+void mqtt_leitor_iniciar(mqtt_leitor_t *l) {
+    memset(l, 0, sizeof(*l));
+}
+
+static bool terminar(mqtt_leitor_t *l, mqtt_pacote_t *pacote) {
+    pacote->tipo = l->tipo & 0xF0;
+    pacote->codigo = l->lidos >= 2 ? l->corpo[1] : 0;
+    pacote->id = l->lidos >= 2 ? (uint16_t)(l->corpo[0] << 8 | l->corpo[1]) : 0;
+    l->estado = LER_CABECALHO;
+    return true;
+}
+
+bool mqtt_leitor_byte(mqtt_leitor_t *l, uint8_t byte, mqtt_pacote_t *pacote) {
+    switch (l->estado) {
+    case LER_CABECALHO:
+        l->tipo = byte;
+        l->restante = 0;
+        l->deslocamento = 0;
+        l->lidos = 0;
+        l->estado = LER_TAMANHO;
+        return false;
+
+    case LER_TAMANHO:
+        l->restante |= (uint32_t)(byte & 0x7F) << l->deslocamento;
+        l->deslocamento += 7;
+        if (byte & 0x80) {
+            if (l->deslocamento >= 28)
+                l->estado = LER_CABECALHO; // tamanho invalido: recomeca
+            return false;
+        }
+        if (l->restante == 0)
+            return terminar(l, pacote);
+        l->estado = LER_CORPO;
+        return false;
+
+    default:
+        if (l->lidos < sizeof(l->corpo))
+            l->corpo[l->lidos++] = byte;
+        if (--l->restante == 0)
+            return terminar(l, pacote);
+        return false;
+    }
+}
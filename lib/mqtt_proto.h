@@ -0,0 +1,57 @@
+#ifndef MQTT_PROTO_H
+#define MQTT_PROTO_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// -------------------- MQTT 3.1.1 (so o que o publicador usa) --------------------
+// Codifica CONNECT, PUBLISH com QoS 1, PINGREQ e DISCONNECT direto num
+// buffer do chamador e le as respostas do broker byte a byte, sem alocar.
+// Pacotes que o publicador nao espera (PUBLISH de volta, SUBACK...) sao
+// pulados inteiros pelo leitor.
+
+#define MQTT_CONNECT    0x10
+#define MQTT_CONNACK    0x20
+#define MQTT_PUBLISH    0x30
+#define MQTT_PUBACK     0x40
+#define MQTT_PINGREQ    0xC0
+#define MQTT_PINGRESP   0xD0
+#define MQTT_DISCONNECT 0xE0
+
+#define MQTT_PUBLISH_QOS1 0x02
+#define MQTT_PUBLISH_DUP  0x08
+
+// Cabecalho fixo (1 byte + ate 4 de tamanho) mais o identificador do pacote
+#define MQTT_PUBLISH_EXTRA(topico) (5 + 2 + (topico) + 2)
+
+// Cada funcao retorna o tamanho do pacote, ou 0 se nao couber em max.
+size_t mqtt_connect(uint8_t *destino, size_t max, const char *cliente, uint16_t keepalive_s);
+size_t mqtt_publish(uint8_t *destino, size_t max, const char *topico, const void *carga, size_t tamanho,
+                    uint16_t id, bool dup);
+size_t mqtt_pingreq(uint8_t *destino, size_t max);
+size_t mqtt_disconnect(uint8_t *destino, size_t max);
+
+// Pacote recebido: tipo (nibble alto, MQTT_CONNACK...), codigo de retorno do
+// CONNACK e identificador do PUBACK.
+typedef struct {
+    uint8_t tipo;
+    uint8_t codigo;
+    uint16_t id;
+} mqtt_pacote_t;
+
+typedef struct {
+    uint8_t estado;
+    uint8_t tipo;
+    uint8_t deslocamento; // bits ja lidos do tamanho
+    uint32_t restante;
+    uint8_t corpo[2];     // os dois primeiros bytes bastam para CONNACK e PUBACK
+    uint8_t lidos;
+} mqtt_leitor_t;
+
+void mqtt_leitor_iniciar(mqtt_leitor_t *l);
+
+// Consome um byte; true quando um pacote terminou (em *pacote).
+bool mqtt_leitor_byte(mqtt_leitor_t *l, uint8_t byte, mqtt_pacote_t *pacote);
+
+#endif
@@ -0,0 +1,31 @@
+#include "painel.h"
+#include "formatar.h"
+
+void painel_desenhar(ssd1306_t *display, uint16_t nivel_decimos, uint16_t chuva_decimos, bool alerta) {
+    char buffer[FORMATAR_PERCENTUAL_MAX]; // Buffer para armazenar a string
+    const bool cor = true;
+
+    ssd1306_fill(display, !cor);                          // Limpa o display
+    ssd1306_rect(display, 3, 3, 122, 60, cor, !cor);      // Desenha um retângulo
+    ssd1306_line(display, 3, 25, 123, 25, cor);           // Desenha uma linha
+    ssd1306_line(display, 3, 37, 123, 37, cor);           // Desenha uma linha
+    ssd1306_line(display, 63, 41, 63, 60, cor);           // Linha vertical entre "Nivel" e "Chuva"
+
+    // Exibe mensagem de alerta ou modo normal
+    if (alerta) {
+        ssd1306_draw_string(display, "Enchente Lida", 12, 6);
+        ssd1306_draw_string(display, "Evacuar agora", 12, 16);
+        ssd1306_draw_string(display, "  EMERGENCIA", 10, 28);
+    } else {
+        ssd1306_draw_string(display, "CEPEDI   TIC37", 8, 6);
+        ssd1306_draw_string(display, "EMBARCATECH", 20, 16);
+        ssd1306_draw_string(display, "   FreeRTOS", 10, 28);
+    }
+
+    ssd1306_draw_string(display, "Nivel", 10, 41);
+    ssd1306_draw_string(display, "Chuva", 78, 41);
+    formatar_percentual(buffer, nivel_decimos);
+    ssd1306_draw_string(display, buffer, 10, 52);
+    formatar_percentual(buffer, chuva_decimos);
+    ssd1306_draw_string(display, buffer, 80, 52);
+}
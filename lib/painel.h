@@ -0,0 +1,15 @@
+#ifndef PAINEL_H
+#define PAINEL_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "ssd1306.h"
+
+// -------------------- Painel do display --------------------
+// Desenha o quadro da estacao no framebuffer, sem enviar ao display: a
+// vDisplayTask chama ssd1306_send_data depois, e as ferramentas do host
+// (sim/quadros.c) usam o mesmo desenho para as imagens de referencia.
+// Nivel e chuva em decimos de %.
+void painel_desenhar(ssd1306_t *display, uint16_t nivel_decimos, uint16_t chuva_decimos, bool alerta);
+
+#endif
@@ -0,0 +1,52 @@
+#ifndef REGISTRO_LOG_H
+#define REGISTRO_LOG_H
+
+#include <stdint.h>
+
+// -------------------- Formato das paginas do log em flash --------------------
+// Sem dependencias do SDK: tambem e usado pelas ferramentas do host que
+// decodificam uma copia da regiao do log.
+
+#define REGISTRO_LOG_TAMANHO_PAGINA 256u
+#define REGISTRO_LOG_MAGIA          0x474F4C46u // "FLOG": registros crus
+#define REGISTRO_LOG_MAGIA_SERIE    0x5A474C46u // "FLGZ": serie comprimida
+#define REGISTRO_LOG_MAGIA_CAPTURA  0x50414346u // "FCAP": janela de captura do ADC
+
+typedef enum {
+    REGISTRO_AMOSTRA = 1, // leitura periodica dos sensores
+    REGISTRO_ALERTA  = 2  // transicao do estado de alerta
+} tipo_registro_t;
+
+// Registro de 12 bytes. Valores em centesimos de % (0 a 10000).
+typedef struct {
+    uint32_t tempo_ms;
+    uint16_t nivel_agua;
+    uint16_t volume_chuva;
+    uint8_t tipo;
+    uint8_t alerta;
+    uint16_t reservado;
+} registro_log_t;
+
+typedef struct {
+    uint32_t magia;
+    uint32_t sequencia;  // cresce a cada pagina gravada
+    uint16_t quantidade; // registros (ou amostras comprimidas) na pagina
+    uint16_t crc;        // CRC-16 de toda a area de dados
+} cabecalho_pagina_t;
+
+#define REGISTRO_LOG_TAMANHO_DADOS (REGISTRO_LOG_TAMANHO_PAGINA - sizeof(cabecalho_pagina_t))
+#define REGISTRO_LOG_POR_PAGINA    (REGISTRO_LOG_TAMANHO_DADOS / sizeof(registro_log_t))
+
+// Pagina de captura: cabecalho seguido de amostras cruas de 12 bits,
+// intercaladas (nivel, chuva, nivel, chuva...).
+typedef struct {
+    uint32_t tempo_disparo_ms;
+    uint32_t taxa_hz;     // amostras/s somando os dois canais
+    uint16_t inicio;      // indice da primeira amostra desta pagina na janela
+    uint16_t pre_disparo; // amostras da janela antes do disparo
+} cabecalho_captura_t;
+
+#define REGISTRO_LOG_CAPTURA_POR_PAGINA \
+    ((REGISTRO_LOG_TAMANHO_DADOS - sizeof(cabecalho_captura_t)) / sizeof(uint16_t))
+
+#endif
@@ -0,0 +1,174 @@
+#include <string.h>
+#include "relogio.h"
+#include "em_ram.h"
+#include "tlog.h"
+#include "hardware/clocks.h"
+#include "hardware/sync.h"
+#include "hardware/structs/systick.h"
+#include "FreeRTOS.h"
+#include "task.h"
+#include "semphr.h"
+
+static const uint32_t khz_perfil[RELOGIO_NUM_PERFIS] = {
+    [RELOGIO_ECONOMIA] = RELOGIO_ECONOMIA_KHZ,
+    [RELOGIO_DESEMPENHO] = RELOGIO_DESEMPENHO_KHZ
+};
+
+static const uint32_t ma_perfil[RELOGIO_NUM_PERFIS] = {
+    [RELOGIO_ECONOMIA] = RELOGIO_ECONOMIA_MA,
+    [RELOGIO_DESEMPENHO] = RELOGIO_DESEMPENHO_MA
+};
+
+static const char *const nomes[RELOGIO_NUM_PERFIS] = {
+    [RELOGIO_ECONOMIA] = "economia",
+    [RELOGIO_DESEMPENHO] = "desempenho"
+};
+
+static relogio_ajuste_t ajustes[RELOGIO_AJUSTES_MAX];
+static uint8_t num_ajustes;
+
+static SemaphoreHandle_t bloqueio;
+static TaskHandle_t tarefa;
+static volatile uint32_t motivos;
+static volatile perfil_relogio_t fixo = RELOGIO_NUM_PERFIS; // automatico
+static volatile perfil_relogio_t atual = RELOGIO_NUM_PERFIS;
+static volatile uint32_t hz_atual;
+static uint64_t inicio_perfil_us;
+static estatistica_relogio_t estatisticas[RELOGIO_NUM_PERFIS];
+
+// -------------------- Troca --------------------
+// O SysTick conta ciclos do clk_sys: a recarga do tick do FreeRTOS muda
+// junto com o clock, dentro da mesma secao sem interrupcoes.
+static void aplicar_perfil(perfil_relogio_t perfil) {
+    uint64_t agora = time_us_64();
+    if (atual < RELOGIO_NUM_PERFIS)
+        estatisticas[atual].tempo_us += agora - inicio_perfil_us;
+
+    uint32_t ints = save_and_disable_interrupts();
+    set_sys_clock_khz(khz_perfil[perfil], true);
+    hz_atual = clock_get_hz(clk_sys);
+    systick_hw->rvr = hz_atual / configTICK_RATE_HZ - 1;
+    systick_hw->cvr = 0;
+    restore_interrupts(ints);
+
+    for (uint8_t i = 0; i < num_ajustes; i++)
+        ajustes[i](hz_atual);
+
+    atual = perfil;
+    inicio_perfil_us = agora;
+    estatisticas[perfil].entradas++;
+}
+
+void relogio_init(void) {
+    for (perfil_relogio_t p = 0; p < RELOGIO_NUM_PERFIS; p++) {
+        estatisticas[p] = (estatistica_relogio_t){ .khz = khz_perfil[p], .corrente_ma = ma_perfil[p] };
+    }
+    bloqueio = xSemaphoreCreateMutex();
+    // Antes do escalonador o SysTick ainda nao foi programado; o port o
+    // configura a partir de clock_get_hz(clk_sys) ao iniciar.
+    set_sys_clock_khz(RELOGIO_ECONOMIA_KHZ, true);
+    hz_atual = clock_get_hz(clk_sys);
+    atual = RELOGIO_ECONOMIA;
+    inicio_perfil_us = time_us_64();
+    estatisticas[RELOGIO_ECONOMIA].entradas = 1;
+}
+
+// Antes do escalonador nao ha troca possivel, entao nao ha o que bloquear.
+void relogio_registrar(relogio_ajuste_t ajuste) {
+    bool rodando = xTaskGetSchedulerState() == taskSCHEDULER_RUNNING;
+    if (rodando)
+        relogio_bloquear();
+    if (num_ajustes < RELOGIO_AJUSTES_MAX) {
+        ajustes[num_ajustes++] = ajuste;
+        ajuste(hz_atual);
+    }
+    if (rodando)
+        relogio_liberar();
+}
+
+// -------------------- Pedidos --------------------
+void relogio_pedir(motivo_relogio_t motivo, bool ativo) {
+    taskENTER_CRITICAL();
+    uint32_t anteriores = motivos;
+    motivos = ativo ? anteriores | motivo : anteriores & ~(uint32_t)motivo;
+    bool mudou = motivos != anteriores;
+    taskEXIT_CRITICAL();
+
+    if (mudou && tarefa)
+        xTaskNotifyGive(tarefa);
+}
+
+void relogio_fixar(perfil_relogio_t perfil) {
+    fixo = perfil;
+    if (tarefa)
+        xTaskNotifyGive(tarefa);
+}
+
+void relogio_bloquear(void) {
+    xSemaphoreTake(bloqueio, portMAX_DELAY);
+}
+
+void relogio_liberar(void) {
+    xSemaphoreGive(bloqueio);
+}
+
+// -------------------- Estatisticas --------------------
+void EM_RAM(relogio_amostrar_latencia)(void) {
+    uint32_t ciclos = systick_hw->rvr - systick_hw->cvr;
+    uint32_t us = ciclos / (hz_atual / 1000000u);
+    estatistica_relogio_t *e = &estatisticas[atual];
+    if (us > e->latencia_max_us)
+        e->latencia_max_us = us;
+}
+
+void relogio_obter(perfil_relogio_t perfil, estatistica_relogio_t *destino) {
+    taskENTER_CRITICAL();
+    *destino = estatisticas[perfil];
+    if (perfil == atual)
+        destino->tempo_us += time_us_64() - inicio_perfil_us;
+    taskEXIT_CRITICAL();
+}
+
+perfil_relogio_t relogio_perfil(void) {
+    return atual;
+}
+
+const char *relogio_nome(perfil_relogio_t perfil) {
+    return nomes[perfil];
+}
+
+// -------------------- Tarefa --------------------
+static perfil_relogio_t perfil_desejado(void) {
+    if (fixo < RELOGIO_NUM_PERFIS)
+        return fixo;
+    return motivos ? RELOGIO_DESEMPENHO : RELOGIO_ECONOMIA;
+}
+
+void vRelogioTask(void *params) {
+    tarefa = xTaskGetCurrentTaskHandle();
+    TickType_t sem_motivos_desde = xTaskGetTickCount();
+
+    while (true) {
+        ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(RELOGIO_RETORNO_MS / 4));
+
+        perfil_relogio_t desejado = perfil_desejado();
+        if (desejado == RELOGIO_DESEMPENHO || fixo < RELOGIO_NUM_PERFIS)
+            sem_motivos_desde = xTaskGetTickCount();
+        // Subir e imediato; descer so depois de um tempo sem motivos
+        else if (atual == RELOGIO_DESEMPENHO &&
+                 xTaskGetTickCount() - sem_motivos_desde < pdMS_TO_TICKS(RELOGIO_RETORNO_MS))
+            continue;
+        if (desejado == atual)
+            continue;
+
+        uint64_t pedido_us = time_us_64();
+        relogio_bloquear();
+        aplicar_perfil(desejado);
+        relogio_liberar();
+
+        uint32_t troca_us = (uint32_t)(time_us_64() - pedido_us);
+        if (troca_us > estatisticas[desejado].troca_max_us)
+            estatisticas[desejado].troca_max_us = troca_us;
+        TLOG("relogio: %u kHz (motivos 0x%x, troca em %u us)", khz_perfil[desejado], motivos, troca_us);
+    }
+}
@@ -0,0 +1,80 @@
+#ifndef RELOGIO_H
+#define RELOGIO_H
+
+#include "pico/stdlib.h"
+
+// -------------------- Gerenciador de clock --------------------
+// O nucleo roda em RELOGIO_ECONOMIA no modo normal e sobe para
+// RELOGIO_DESEMPENHO enquanto houver algum motivo ativo (alerta, captura
+// sendo descarregada). A volta para economia espera RELOGIO_RETORNO_MS
+// sem motivos, para nao oscilar.
+//
+// Tudo que deriva do clk_sys e reajustado a cada troca pelas funcoes
+// registradas com relogio_registrar (divisores de PIO, PWM, I2C e, como o
+// set_sys_clock_khz leva o clk_peri junto, da UART do Modbus) e pelo
+// proprio gerenciador (recarga do SysTick do FreeRTOS). ADC e USB usam o
+// PLL da USB (48 MHz) e o timer usa o clk_ref, entao nao mudam.
+//
+// Transferencias que nao podem ser cortadas no meio (quadro I2C do
+// display, cores da matriz, resposta RTU) ficam entre
+// relogio_bloquear/relogio_liberar.
+
+#define RELOGIO_ECONOMIA_KHZ   64000
+#define RELOGIO_DESEMPENHO_KHZ 133000
+#define RELOGIO_RETORNO_MS     2000
+#define RELOGIO_AJUSTES_MAX    6
+
+// Corrente estimada da placa em cada perfil (mA). Valores de partida a
+// partir das curvas do datasheet do RP2040; medir na placa e ajustar.
+#define RELOGIO_ECONOMIA_MA    18
+#define RELOGIO_DESEMPENHO_MA  28
+
+typedef enum {
+    RELOGIO_ECONOMIA,
+    RELOGIO_DESEMPENHO,
+    RELOGIO_NUM_PERFIS
+} perfil_relogio_t;
+
+typedef enum {
+    RELOGIO_MOTIVO_ALERTA  = 1u << 0,
+    RELOGIO_MOTIVO_CAPTURA = 1u << 1
+} motivo_relogio_t;
+
+typedef struct {
+    uint32_t khz;
+    uint32_t entradas;
+    uint64_t tempo_us;        // tempo total no perfil
+    uint32_t latencia_max_us; // pior atraso do tick ate a tarefa amostrada
+    uint32_t troca_max_us;    // pior tempo de troca (espera do bloqueio + PLL)
+    uint32_t corrente_ma;
+} estatistica_relogio_t;
+
+// Recebe o novo clk_sys em Hz e reajusta um periferico.
+typedef void (*relogio_ajuste_t)(uint32_t hz);
+
+// Coloca o sistema em economia. Chamar antes de iniciar o escalonador.
+void relogio_init(void);
+
+// Registra um ajuste e o aplica imediatamente com o clock atual.
+void relogio_registrar(relogio_ajuste_t ajuste);
+
+// Liga ou desliga um motivo para o perfil de desempenho. Nao bloqueia.
+void relogio_pedir(motivo_relogio_t motivo, bool ativo);
+
+// Forca um perfil (ou volta ao automatico com RELOGIO_NUM_PERFIS).
+void relogio_fixar(perfil_relogio_t perfil);
+
+void relogio_bloquear(void);
+void relogio_liberar(void);
+
+// Chamar logo apos acordar de um vTaskDelay: registra quanto tempo passou
+// desde o tick no perfil atual.
+void relogio_amostrar_latencia(void);
+
+void relogio_obter(perfil_relogio_t perfil, estatistica_relogio_t *destino);
+perfil_relogio_t relogio_perfil(void);
+const char *relogio_nome(perfil_relogio_t perfil);
+
+void vRelogioTask(void *params);
+
+#endif
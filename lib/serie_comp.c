@@ -0,0 +1,188 @@
+#include <string.h>
+#include "serie_comp.h"
+
+// -------------------- Fluxo de bits (MSB primeiro) --------------------
+static void escrever_bits(serie_comp_t *c, uint32_t valor, unsigned n) {
+    while (n) {
+        unsigned livre = 8 - (c->bits & 7);
+        unsigned k = n < livre ? n : livre;
+        uint8_t parte = (uint8_t)((valor >> (n - k)) & ((1u << k) - 1));
+        c->bloco[c->bits >> 3] |= (uint8_t)(parte << (livre - k));
+        c->bits += k;
+        n -= k;
+    }
+}
+
+static uint32_t ler_bits(serie_decomp_t *d, unsigned n) {
+    uint32_t valor = 0;
+    while (n) {
+        unsigned restam = 8 - (d->bits & 7);
+        unsigned k = n < restam ? n : restam;
+        // Leitura alem do fim (bloco corrompido) devolve zeros e e
+        // detectada depois pela contagem de bits.
+        uint8_t byte = d->bits < d->capacidade_bits ? d->bloco[d->bits >> 3] : 0;
+        valor = (valor << k) | ((byte >> (restam - k)) & ((1u << k) - 1));
+        d->bits += k;
+        n -= k;
+    }
+    return valor;
+}
+
+static inline uint32_t zigzag(int32_t v) {
+    return ((uint32_t)v << 1) ^ (uint32_t)(v >> 31);
+}
+
+static inline int32_t unzigzag(uint32_t v) {
+    return (int32_t)(v >> 1) ^ -(int32_t)(v & 1);
+}
+
+static inline int32_t estender_sinal(uint32_t v, unsigned bits) {
+    uint32_t m = 1u << (bits - 1);
+    return (int32_t)((v ^ m) - m);
+}
+
+// -------------------- Tabelas de prefixo --------------------
+// Tempo (delta-of-delta, com sinal): '0' | '10'+4 | '110'+9 | '1110'+12 | '1111'+32
+// O bucket de 4 bits cobre o jitter tipico de vTaskDelay (poucos ms).
+static unsigned custo_tempo(int32_t dod) {
+    if (dod == 0) return 1;
+    if (dod >= -8 && dod < 8) return 2 + 4;
+    if (dod >= -256 && dod < 256) return 3 + 9;
+    if (dod >= -2048 && dod < 2048) return 4 + 12;
+    return 4 + 32;
+}
+
+static void codificar_tempo(serie_comp_t *c, int32_t dod) {
+    if (dod == 0) {
+        escrever_bits(c, 0x0, 1);
+    } else if (dod >= -8 && dod < 8) {
+        escrever_bits(c, 0x2, 2);
+        escrever_bits(c, (uint32_t)dod & 0xF, 4);
+    } else if (dod >= -256 && dod < 256) {
+        escrever_bits(c, 0x6, 3);
+        escrever_bits(c, (uint32_t)dod & 0x1FF, 9);
+    } else if (dod >= -2048 && dod < 2048) {
+        escrever_bits(c, 0xE, 4);
+        escrever_bits(c, (uint32_t)dod & 0xFFF, 12);
+    } else {
+        escrever_bits(c, 0xF, 4);
+        escrever_bits(c, (uint32_t)dod, 32);
+    }
+}
+
+static int32_t decodificar_tempo(serie_decomp_t *d) {
+    if (!ler_bits(d, 1)) return 0;
+    if (!ler_bits(d, 1)) return estender_sinal(ler_bits(d, 4), 4);
+    if (!ler_bits(d, 1)) return estender_sinal(ler_bits(d, 9), 9);
+    if (!ler_bits(d, 1)) return estender_sinal(ler_bits(d, 12), 12);
+    return (int32_t)ler_bits(d, 32);
+}
+
+// Valores (delta em zig-zag): '0' | '10'+3 | '110'+5 | '1110'+9 | '1111'+17
+// Uma contagem do ADC vale ~2,4 centesimos, entao o ruido de +-2 contagens
+// cai nos dois primeiros buckets.
+static unsigned custo_valor(uint32_t zz) {
+    if (zz == 0) return 1;
+    if (zz < 8) return 2 + 3;
+    if (zz < 32) return 3 + 5;
+    if (zz < 512) return 4 + 9;
+    return 4 + 17;
+}
+
+static void codificar_valor(serie_comp_t *c, uint32_t zz) {
+    if (zz == 0) {
+        escrever_bits(c, 0x0, 1);
+    } else if (zz < 8) {
+        escrever_bits(c, 0x2, 2);
+        escrever_bits(c, zz, 3);
+    } else if (zz < 32) {
+        escrever_bits(c, 0x6, 3);
+        escrever_bits(c, zz, 5);
+    } else if (zz < 512) {
+        escrever_bits(c, 0xE, 4);
+        escrever_bits(c, zz, 9);
+    } else {
+        escrever_bits(c, 0xF, 4);
+        escrever_bits(c, zz, 17);
+    }
+}
+
+static uint32_t decodificar_valor(serie_decomp_t *d) {
+    if (!ler_bits(d, 1)) return 0;
+    if (!ler_bits(d, 1)) return ler_bits(d, 3);
+    if (!ler_bits(d, 1)) return ler_bits(d, 5);
+    if (!ler_bits(d, 1)) return ler_bits(d, 9);
+    return ler_bits(d, 17);
+}
+
+// -------------------- Codificador --------------------
+void serie_comp_iniciar(serie_comp_t *c, uint8_t *bloco, size_t tamanho) {
+    memset(bloco, 0, tamanho);
+    c->bloco = bloco;
+    c->capacidade_bits = tamanho * 8;
+    c->bits = 0;
+    c->amostras = 0;
+    c->delta_tempo = 0;
+}
+
+bool serie_comp_adicionar(serie_comp_t *c, const amostra_comp_t *amostra) {
+    if (c->amostras == 0) {
+        if (c->capacidade_bits < 64)
+            return false;
+        escrever_bits(c, amostra->tempo_ms, 32);
+        escrever_bits(c, amostra->nivel_agua, 16);
+        escrever_bits(c, amostra->volume_chuva, 16);
+    } else {
+        int32_t delta = (int32_t)(amostra->tempo_ms - c->anterior.tempo_ms);
+        int32_t dod = delta - c->delta_tempo;
+        uint32_t zz_nivel = zigzag((int32_t)amostra->nivel_agua - c->anterior.nivel_agua);
+        uint32_t zz_chuva = zigzag((int32_t)amostra->volume_chuva - c->anterior.volume_chuva);
+
+        size_t custo = custo_tempo(dod) + custo_valor(zz_nivel) + custo_valor(zz_chuva);
+        if (c->bits + custo > c->capacidade_bits)
+            return false;
+
+        codificar_tempo(c, dod);
+        codificar_valor(c, zz_nivel);
+        codificar_valor(c, zz_chuva);
+        c->delta_tempo = delta;
+    }
+    c->anterior = *amostra;
+    c->amostras++;
+    return true;
+}
+
+// -------------------- Decodificador --------------------
+void serie_decomp_iniciar(serie_decomp_t *d, const uint8_t *bloco, size_t tamanho, uint16_t amostras) {
+    d->bloco = bloco;
+    d->capacidade_bits = tamanho * 8;
+    d->bits = 0;
+    d->restantes = amostras;
+    d->primeira = true;
+    d->delta_tempo = 0;
+}
+
+bool serie_decomp_proxima(serie_decomp_t *d, amostra_comp_t *amostra) {
+    if (d->restantes == 0)
+        return false;
+
+    if (d->primeira) {
+        d->anterior.tempo_ms = ler_bits(d, 32);
+        d->anterior.nivel_agua = (uint16_t)ler_bits(d, 16);
+        d->anterior.volume_chuva = (uint16_t)ler_bits(d, 16);
+        d->primeira = false;
+    } else {
+        d->delta_tempo += decodificar_tempo(d);
+        d->anterior.tempo_ms += (uint32_t)d->delta_tempo;
+        d->anterior.nivel_agua = (uint16_t)(d->anterior.nivel_agua + unzigzag(decodificar_valor(d)));
+        d->anterior.volume_chuva = (uint16_t)(d->anterior.volume_chuva + unzigzag(decodificar_valor(d)));
+    }
+    if (d->bits > d->capacidade_bits) {
+        d->restantes = 0;
+        return false;
+    }
+
+    *amostra = d->anterior;
+    d->restantes--;
+    return true;
+}
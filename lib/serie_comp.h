@@ -0,0 +1,57 @@
+#ifndef SERIE_COMP_H
+#define SERIE_COMP_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+// -------------------- Compressao da serie de amostras --------------------
+// Codificacao incremental no estilo Gorilla, por bloco de tamanho fixo:
+//  - tempo: delta-of-delta com prefixos de tamanho variavel;
+//  - nivel/chuva (centesimos de %): delta em zig-zag com prefixos.
+// A primeira amostra de cada bloco vai crua, entao cada bloco e
+// decodificado de forma independente. Custo por amostra e constante
+// (no maximo SERIE_COMP_MAX_BITS bits e algumas operacoes de shift).
+
+#define SERIE_COMP_MAX_BITS (4 + 32 + 2 * (4 + 17))
+
+typedef struct {
+    uint32_t tempo_ms;
+    uint16_t nivel_agua;   // centesimos de %
+    uint16_t volume_chuva; // centesimos de %
+} amostra_comp_t;
+
+typedef struct {
+    uint8_t *bloco;
+    size_t capacidade_bits;
+    size_t bits;
+    uint16_t amostras;
+    amostra_comp_t anterior;
+    int32_t delta_tempo;
+} serie_comp_t;
+
+typedef struct {
+    const uint8_t *bloco;
+    size_t capacidade_bits;
+    size_t bits;
+    uint16_t restantes;
+    bool primeira;
+    amostra_comp_t anterior;
+    int32_t delta_tempo;
+} serie_decomp_t;
+
+// O bloco deve vir zerado ou apagado; serie_comp_iniciar o zera.
+void serie_comp_iniciar(serie_comp_t *c, uint8_t *bloco, size_t tamanho);
+
+// Retorna false (sem alterar o bloco) quando a amostra nao cabe mais.
+bool serie_comp_adicionar(serie_comp_t *c, const amostra_comp_t *amostra);
+
+// Bytes efetivamente usados pelo bloco.
+static inline size_t serie_comp_bytes(const serie_comp_t *c) {
+    return (c->bits + 7) / 8;
+}
+
+void serie_decomp_iniciar(serie_decomp_t *d, const uint8_t *bloco, size_t tamanho, uint16_t amostras);
+bool serie_decomp_proxima(serie_decomp_t *d, amostra_comp_t *amostra);
+
+#endif
@@ -0,0 +1,505 @@
+#include <stdlib.h>
+#include <string.h>
+#include "shell.h"
+#include "config.h"
+#include "config_flash.h"
+#include "calibracao.h"
+#include "interp_hw.h"
+#include "medir.h"
+#include "relogio.h"
+#include "formatar.h"
+#include "telemetria.h"
+#include "tlog.h"
+#include "mqtt.h"
+#include "http.h"
+#include "modbus.h"
+#include "pico/stdio_usb.h"
+#include "FreeRTOS.h"
+#include "task.h"
+
+// -------------------- Respostas --------------------
+static void responder(const char *texto) {
+    size_t n = strlen(texto);
+    if (n > TELEMETRIA_CARGA_MAX)
+        n = TELEMETRIA_CARGA_MAX;
+    telemetria_enviar(TELEMETRIA_RESPOSTA, texto, n);
+}
+
+// Resposta montada aos pedacos, com limite: o que passar de
+// TELEMETRIA_CARGA_MAX e cortado, nunca escrito alem do buffer.
+typedef struct {
+    char texto[TELEMETRIA_CARGA_MAX + 1];
+    size_t n;
+} resposta_t;
+
+static void resposta_texto(resposta_t *r, const char *texto) {
+    size_t k = strlen(texto);
+    if (k > TELEMETRIA_CARGA_MAX - r->n)
+        k = TELEMETRIA_CARGA_MAX - r->n;
+    memcpy(&r->texto[r->n], texto, k);
+    r->n += k;
+    r->texto[r->n] = '\0';
+}
+
+static void resposta_numero(resposta_t *r, uint32_t valor, uint8_t casas) {
+    char numero[FORMATAR_NUMERO_MAX];
+    numero[formatar_decimal(numero, valor, casas)] = '\0';
+    resposta_texto(r, numero);
+}
+
+// rotulo seguido de um numero inteiro
+static void anexar(resposta_t *r, const char *rotulo, uint32_t valor) {
+    resposta_texto(r, rotulo);
+    resposta_numero(r, valor, 0);
+}
+
+static void resposta_enviar(resposta_t *r) {
+    telemetria_enviar(TELEMETRIA_RESPOSTA, r->texto, r->n);
+    r->n = 0;
+    r->texto[0] = '\0';
+}
+
+static void responder_param(const config_estacao_t *c, const param_config_t *p) {
+    char texto[TELEMETRIA_CARGA_MAX + 1];
+    size_t n = strlen(p->nome);
+    uint32_t valor = config_ler_param(c, p);
+
+    memcpy(texto, p->nome, n);
+    texto[n++] = '=';
+    if (p->tipo == PARAM_HEX)
+        formatar_hex(&texto[n], valor);
+    else
+        formatar_decimal(&texto[n], valor, p->tipo == PARAM_CENTESIMOS ? 2 : 0);
+    responder(texto);
+}
+
+// -------------------- Valores --------------------
+// Centesimos aceitam "70", "70.5" ou "70.25"; sem ponto flutuante.
+static bool ler_centesimos(const char *texto, uint32_t *valor) {
+    uint32_t v = 0;
+    int casas = -1;
+    bool algum_digito = false;
+
+    for (; *texto; texto++) {
+        if (*texto == '.' && casas < 0) {
+            casas = 0;
+            continue;
+        }
+        if (*texto < '0' || *texto > '9' || casas == 2 || v > 10000000u)
+            return false;
+        v = v * 10 + (uint32_t)(*texto - '0');
+        algum_digito = true;
+        if (casas >= 0)
+            casas++;
+    }
+    if (!algum_digito)
+        return false;
+    for (casas = casas < 0 ? 0 : casas; casas < 2; casas++)
+        v *= 10;
+    *valor = v;
+    return true;
+}
+
+static bool ler_valor(const param_config_t *p, const char *texto, uint32_t *valor) {
+    if (p->tipo == PARAM_CENTESIMOS)
+        return ler_centesimos(texto, valor);
+
+    char *fim;
+    unsigned long v = strtoul(texto, &fim, p->tipo == PARAM_HEX ? 16 : 10);
+    if (fim == texto || *fim)
+        return false;
+    *valor = (uint32_t)v;
+    return true;
+}
+
+// -------------------- Comandos --------------------
+static void comando_get(const char *nome, const char *arg2) {
+    (void)arg2;
+    config_estacao_t c;
+    config_obter(&c);
+
+    if (!nome) {
+        for (uint8_t i = 0; i < config_num_params; i++)
+            responder_param(&c, &config_params[i]);
+        return;
+    }
+    const param_config_t *p = config_param(nome);
+    if (p)
+        responder_param(&c, p);
+    else
+        responder("erro: parametro desconhecido");
+}
+
+static void comando_set(const char *nome, const char *texto) {
+    const param_config_t *p = nome ? config_param(nome) : NULL;
+    uint32_t valor;
+
+    if (!p || !texto) {
+        responder("erro: uso set <nome> <valor>");
+        return;
+    }
+    if (!ler_valor(p, texto, &valor) || valor < p->minimo || valor > p->maximo) {
+        responder("erro: valor invalido ou fora da faixa");
+        return;
+    }
+
+    // Le, altera e aplica a estrutura inteira: as tarefas veem o valor novo
+    // no proximo ciclo, nunca uma configuracao pela metade.
+    // A tabela da calibracao e refeita fora da trava (config_travar).
+    config_estacao_t c;
+    config_travar();
+    config_obter(&c);
+    config_escrever_param(&c, p, valor);
+    config_aplicar(&c);
+    config_liberar();
+    calibracao_atualizar(&c);
+
+    TLOG("shell: parametro %u = %u", (uint32_t)(p - config_params), valor);
+    responder_param(&c, p);
+}
+
+// cal <canal>                lista os pontos da curva
+// cal <canal> <valor|min|max> mede a contagem atual como esse valor (%)
+// cal <canal> limpar         volta ao mapeamento ideal
+static void comando_cal(const char *texto_canal, const char *arg) {
+    config_estacao_t c;
+    char texto[TELEMETRIA_CARGA_MAX + 1];
+
+    if (!texto_canal || texto_canal[1] != '\0' || texto_canal[0] < '0' ||
+        texto_canal[0] >= '0' + CONFIG_CANAIS) {
+        responder("erro: uso cal <0|1> [valor|min|max|limpar]");
+        return;
+    }
+    uint canal = (uint)(texto_canal[0] - '0');
+    config_obter(&c);
+    calibracao_canal_t *curva = &c.calibracao[canal];
+
+    if (!arg) {
+        if (curva->pontos < 2)
+            responder("ideal 0..4095 -> 0..100");
+        for (uint8_t i = 0; i < curva->pontos; i++) {
+            uint8_t n = formatar_decimal(texto, curva->bruto[i], 0);
+            texto[n++] = '=';
+            formatar_decimal(&texto[n], curva->valor[i], 2);
+            responder(texto);
+        }
+        return;
+    }
+
+    // A medida leva alguns ms: a curva nova e montada fora da trava e so
+    // ela entra na configuracao do momento
+    uint32_t valor;
+    if (strcmp(arg, "limpar") == 0) {
+        curva->pontos = 0;
+    } else {
+        if (strcmp(arg, "min") == 0)
+            valor = 0;
+        else if (strcmp(arg, "max") == 0)
+            valor = 10000;
+        else if (!ler_centesimos(arg, &valor) || valor > 10000) {
+            responder("erro: valor invalido ou fora da faixa");
+            return;
+        }
+        if (!calibracao_medir_ponto(curva, canal, (uint16_t)valor)) {
+            responder("erro: curva cheia, use limpar");
+            return;
+        }
+    }
+    calibracao_canal_t nova = *curva;
+    config_travar();
+    config_obter(&c);
+    c.calibracao[canal] = nova;
+    config_aplicar(&c);
+    config_liberar();
+    calibracao_atualizar(&c);
+    TLOG("shell: calibracao do canal %u com %u pontos", canal, curva->pontos);
+    responder(curva->pontos == 1 ? "ok (falta 1 ponto; ate la vale o ideal)" : "ok");
+}
+
+#if INTERP_HW_DISPONIVEL
+// interp: ciclos por operacao sem e com os interpoladores
+static void responder_comparacao(const char *rotulo, uint32_t portavel, uint32_t interp, const char *unidade) {
+    char texto[TELEMETRIA_CARGA_MAX + 1];
+    size_t n = strlen(rotulo);
+    memcpy(texto, rotulo, n);
+    n += formatar_decimal(&texto[n], portavel, 1);
+    memcpy(&texto[n], " -> ", 4);
+    n += 4;
+    n += formatar_decimal(&texto[n], interp, 1);
+    strcpy(&texto[n], unidade);
+    responder(texto);
+}
+
+static void comando_interp(const char *arg1, const char *arg2) {
+    (void)arg1;
+    (void)arg2;
+    interp_hw_comparacao_t c;
+    interp_hw_comparar(&c);
+    responder_comparacao("anel: ", c.anel_portavel, c.anel_interp, " ciclos/amostra");
+    responder_comparacao("texto: ", c.texto_portavel, c.texto_interp, " ciclos/caractere");
+}
+#endif
+
+#if ESTACAO_MEDIR_LATENCIA
+// latencia [zerar|frio|quente]: ciclos por caminho quente (medir.h)
+static void comando_latencia(const char *arg, const char *arg2) {
+    (void)arg2;
+    if (arg) {
+        if (strcmp(arg, "zerar") == 0)
+            medir_zerar();
+        else if (strcmp(arg, "frio") == 0 || strcmp(arg, "quente") == 0)
+            medir_modo_frio(arg[0] == 'f');
+        else {
+            responder("erro: uso latencia [zerar|frio|quente]");
+            return;
+        }
+        responder("ok");
+        return;
+    }
+
+    resposta_t r = { .n = 0 };
+    for (medida_t m = 0; m < MEDIDA_NUM; m++) {
+        estatistica_t e;
+        medir_obter(m, &e);
+        resposta_texto(&r, medir_nome(m));
+        anexar(&r, " n=", e.n);
+        anexar(&r, " min=", e.minimo);
+        anexar(&r, " med=", e.n ? (uint32_t)(e.soma / e.n) : 0);
+        anexar(&r, " max=", e.maximo);
+        resposta_enviar(&r);
+    }
+}
+#endif
+
+// relogio [economia|desempenho|auto]: perfis de clock e seus numeros
+static void comando_relogio(const char *arg, const char *arg2) {
+    (void)arg2;
+    if (arg) {
+        perfil_relogio_t p = RELOGIO_NUM_PERFIS;
+        for (perfil_relogio_t i = 0; i < RELOGIO_NUM_PERFIS; i++) {
+            if (strcmp(arg, relogio_nome(i)) == 0)
+                p = i;
+        }
+        if (p == RELOGIO_NUM_PERFIS && strcmp(arg, "auto") != 0) {
+            responder("erro: uso relogio [economia|desempenho|auto]");
+            return;
+        }
+        relogio_fixar(p);
+        responder("ok");
+        return;
+    }
+
+    // Duas respostas por perfil: com os campos no maximo, uma so passaria
+    // de TELEMETRIA_CARGA_MAX
+    resposta_t r = { .n = 0 };
+    for (perfil_relogio_t p = 0; p < RELOGIO_NUM_PERFIS; p++) {
+        estatistica_relogio_t e;
+        relogio_obter(p, &e);
+        resposta_texto(&r, relogio_nome(p));
+        anexar(&r, p == relogio_perfil() ? "*" : " ", e.khz / 1000);
+        anexar(&r, "MHz t=", (uint32_t)(e.tempo_us / 1000000u));
+        anexar(&r, "s n=", e.entradas);
+        anexar(&r, " ~", e.corrente_ma);
+        resposta_texto(&r, "mA");
+        resposta_enviar(&r);
+
+        resposta_texto(&r, relogio_nome(p));
+        anexar(&r, " lat=", e.latencia_max_us);
+        anexar(&r, "us tr=", e.troca_max_us);
+        resposta_texto(&r, "us");
+        resposta_enviar(&r);
+    }
+}
+
+// mqtt: conexao, entregas e custo de radio por amostra entregue
+static void comando_mqtt(const char *arg1, const char *arg2) {
+    (void)arg1;
+    (void)arg2;
+    mqtt_estatistica_t e;
+    mqtt_obter(&e);
+
+    resposta_t r = { .n = 0 };
+    anexar(&r, e.conectado ? "conectado n=" : "desconectado n=", e.conexoes);
+    anexar(&r, " pub=", e.publicadas);
+    anexar(&r, " pend=", e.pendentes);
+    anexar(&r, " desc=", e.descartadas);
+    anexar(&r, " dup=", e.reenvios);
+    resposta_enviar(&r);
+
+    anexar(&r, "radio ", (uint32_t)(e.radio_us / 1000u));
+    anexar(&r, "ms amostras=", e.amostras);
+    anexar(&r, " ", e.amostras ? (uint32_t)(e.radio_us / e.amostras) : 0);
+    resposta_texto(&r, "us/amostra");
+    resposta_enviar(&r);
+}
+
+// http: clientes, respostas e retratos do servidor de estado
+static void comando_http(const char *arg1, const char *arg2) {
+    (void)arg1;
+    (void)arg2;
+    http_estatistica_t e;
+    http_obter(&e);
+
+    resposta_t r = { .n = 0 };
+    anexar(&r, "clientes=", e.clientes);
+    anexar(&r, " sse=", e.clientes_sse);
+    anexar(&r, " req=", e.requisicoes);
+    anexar(&r, " ev=", e.eventos);
+    anexar(&r, " salto=", e.saltados);
+    resposta_enviar(&r);
+
+    anexar(&r, "retratos=", e.retratos);
+    anexar(&r, " recusadas=", e.recusadas);
+    resposta_enviar(&r);
+}
+
+// modbus: pedidos por transporte, excecoes e pior tempo de resposta
+static void comando_modbus(const char *arg1, const char *arg2) {
+    (void)arg1;
+    (void)arg2;
+    modbus_estatistica_t e;
+    modbus_obter(&e);
+
+    resposta_t r = { .n = 0 };
+    anexar(&r, "rtu=", e.rtu_quadros);
+    anexar(&r, " erros=", e.rtu_erros);
+    anexar(&r, " tcp=", e.tcp_pedidos);
+    anexar(&r, " clientes=", e.clientes_tcp);
+    resposta_enviar(&r);
+
+    anexar(&r, "excecoes=", e.excecoes);
+    anexar(&r, " escritas=", e.escritas);
+    anexar(&r, " repeticoes=", e.repeticoes);
+    anexar(&r, " max=", e.resposta_max_us);
+    resposta_texto(&r, "us");
+    resposta_enviar(&r);
+}
+
+// padrao: volta todos os parametros ao valor de fabrica (sem gravar)
+static void comando_padrao(const char *arg1, const char *arg2) {
+    (void)arg1;
+    (void)arg2;
+    config_estacao_t c;
+    config_padrao(&c);
+    config_travar();
+    config_aplicar(&c);
+    config_liberar();
+    calibracao_atualizar(&c);
+    responder("ok");
+}
+
+static void comando_salvar(const char *arg1, const char *arg2) {
+    (void)arg1;
+    (void)arg2;
+    responder(config_flash_salvar() ? "ok" : "erro: falha ao gravar a flash");
+}
+
+// -------------------- Interpretador --------------------
+typedef struct {
+    const char *nome;
+    void (*executar)(const char *arg1, const char *arg2);
+} comando_t;
+
+// A mensagem de comando desconhecido e montada desta tabela.
+static const comando_t comandos[] = {
+    { "get", comando_get },
+    { "set", comando_set },
+    { "cal", comando_cal },
+    { "padrao", comando_padrao },
+    { "salvar", comando_salvar },
+    { "relogio", comando_relogio },
+    { "mqtt", comando_mqtt },
+    { "http", comando_http },
+    { "modbus", comando_modbus },
+#if ESTACAO_MEDIR_LATENCIA
+    { "latencia", comando_latencia },
+#endif
+#if INTERP_HW_DISPONIVEL
+    { "interp", comando_interp },
+#endif
+};
+
+// Continua em outra resposta quando o proximo nome nao cabe no quadro.
+static void responder_comandos(void) {
+    resposta_t r = { .n = 0 };
+    resposta_texto(&r, "erro: comandos");
+    for (size_t i = 0; i < count_of(comandos); i++) {
+        const char *separador = i > 0 ? ", " : " ";
+        if (r.n + strlen(separador) + strlen(comandos[i].nome) + 1 > TELEMETRIA_CARGA_MAX) {
+            resposta_texto(&r, ",");
+            resposta_enviar(&r);
+            separador = "";
+        }
+        resposta_texto(&r, separador);
+        resposta_texto(&r, comandos[i].nome);
+    }
+    resposta_enviar(&r);
+}
+
+// Separa a proxima palavra da linha, terminando-a no lugar.
+static char *proxima_palavra(char **cursor) {
+    char *p = *cursor;
+    while (*p == ' ' || *p == '\t')
+        p++;
+    if (!*p)
+        return NULL;
+    char *inicio = p;
+    while (*p && *p != ' ' && *p != '\t')
+        p++;
+    if (*p)
+        *p++ = '\0';
+    *cursor = p;
+    return inicio;
+}
+
+static void executar(char *linha) {
+    char *cursor = linha;
+    char *comando = proxima_palavra(&cursor);
+    char *arg1 = comando ? proxima_palavra(&cursor) : NULL;
+    char *arg2 = arg1 ? proxima_palavra(&cursor) : NULL;
+
+    if (!comando)
+        return;
+    for (size_t i = 0; i < count_of(comandos); i++) {
+        if (strcmp(comando, comandos[i].nome) == 0) {
+            comandos[i].executar(arg1, arg2);
+            return;
+        }
+    }
+    responder_comandos();
+}
+
+// -------------------- Tarefa --------------------
+void vShellTask(void *params) {
+    char linha[SHELL_LINHA_MAX];
+    char recebidos[16];
+    uint8_t tamanho = 0;
+    bool estourou = false;
+
+    while (true) {
+        vTaskDelay(pdMS_TO_TICKS(SHELL_PERIODO_MS));
+        if (!stdio_usb_connected())
+            continue;
+
+        // Nao bloqueia: PICO_ERROR_NO_DATA (negativo) quando nao ha nada
+        int n;
+        while ((n = stdio_usb.in_chars(recebidos, sizeof(recebidos))) > 0) {
+            for (int i = 0; i < n; i++) {
+                char ch = recebidos[i];
+                if (ch == '\r' || ch == '\n') {
+                    linha[tamanho] = '\0';
+                    if (estourou)
+                        responder("erro: linha longa demais");
+                    else
+                        executar(linha);
+                    tamanho = 0;
+                    estourou = false;
+                } else if (tamanho < SHELL_LINHA_MAX - 1) {
+                    linha[tamanho++] = ch;
+                } else {
+                    estourou = true;
+                }
+            }
+        }
+    }
+}
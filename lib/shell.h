@@ -0,0 +1,32 @@
+#ifndef SHELL_H
+#define SHELL_H
+
+#include "pico/stdlib.h"
+
+// -------------------- Shell de comandos (USB CDC) --------------------
+// Comandos em texto chegam pelo sentido host->placa do CDC, uma linha por
+// comando. O sentido placa->host ja carrega a telemetria binaria, entao as
+// respostas saem como quadros TELEMETRIA_RESPOSTA e nao quebram o fluxo.
+//
+//   get                 lista todos os parametros
+//   get <nome>          mostra um parametro
+//   set <nome> <valor>  altera um parametro (aplicado na hora)
+//   cal <canal> [...]   curva de calibracao do canal (calibracao.h)
+//   padrao              volta aos valores de compilacao
+//   interp              compara ciclos com e sem os interpoladores (interp_hw.h)
+//   latencia [...]      ciclos dos caminhos quentes, se medidos (medir.h)
+//   relogio [...]       perfis de clock: tempo, corrente, latencia (relogio.h)
+//   mqtt                entregas ao broker e radio por amostra (mqtt.h)
+//   http                clientes, respostas e retratos do servidor (http.h)
+//   modbus              pedidos RTU e TCP, excecoes e resposta (modbus.h)
+//   salvar              grava a configuracao ativa na flash (config_flash.h)
+//
+// A tarefa roda na prioridade do idle e so le o que ja chegou; a
+// aquisicao nunca espera por ela.
+
+#define SHELL_LINHA_MAX  64
+#define SHELL_PERIODO_MS 20
+
+void vShellTask(void *params);
+
+#endif
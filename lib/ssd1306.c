@@ -1,5 +1,11 @@
+#include <string.h>
 #include "ssd1306.h"
 #include "font.h"
+#include "interp_hw.h"
+
+#if INTERP_HW_DISPONIVEL
+#include "hardware/interp.h"
+#endif
 
 void ssd1306_init(ssd1306_t *ssd, uint8_t width, uint8_t height, bool external_vcc, uint8_t address, i2c_inst_t *i2c) {
   ssd->width = width;
@@ -41,31 +47,35 @@ void ssd1306_config(ssd1306_t *ssd) {
   ssd1306_command(ssd, SET_DISP | 0x01);
 }
 
-void ssd1306_command(ssd1306_t *ssd, uint8_t command) {
+bool ssd1306_command(ssd1306_t *ssd, uint8_t command) {
   ssd->port_buffer[1] = command;
-  i2c_write_blocking(
+  return i2c_write_timeout_us(
     ssd->i2c_port,
     ssd->address,
     ssd->port_buffer,
     2,
-    false
-  );
-}
-
-void ssd1306_send_data(ssd1306_t *ssd) {
-  ssd1306_command(ssd, SET_COL_ADDR);
-  ssd1306_command(ssd, 0);
-  ssd1306_command(ssd, ssd->width - 1);
-  ssd1306_command(ssd, SET_PAGE_ADDR);
-  ssd1306_command(ssd, 0);
-  ssd1306_command(ssd, ssd->pages - 1);
-  i2c_write_blocking(
-    ssd->i2c_port,
-    ssd->address,
-    ssd->ram_buffer,
-    ssd->bufsize,
-    false
-  );
+    false,
+    SSD1306_TIMEOUT_US(2)
+  ) == 2;
+}
+
+// Para na primeira transacao que falha: com o barramento preso, o quadro
+// custa um timeout, nao sete.
+bool ssd1306_send_data(ssd1306_t *ssd) {
+  return ssd1306_command(ssd, SET_COL_ADDR) &&
+         ssd1306_command(ssd, 0) &&
+         ssd1306_command(ssd, ssd->width - 1) &&
+         ssd1306_command(ssd, SET_PAGE_ADDR) &&
+         ssd1306_command(ssd, 0) &&
+         ssd1306_command(ssd, ssd->pages - 1) &&
+         i2c_write_timeout_us(
+           ssd->i2c_port,
+           ssd->address,
+           ssd->ram_buffer,
+           ssd->bufsize,
+           false,
+           SSD1306_TIMEOUT_US(ssd->bufsize)
+         ) == (int)ssd->bufsize;
 }
 
 void ssd1306_pixel(ssd1306_t *ssd, uint8_t x, uint8_t y, bool value) {
@@ -77,40 +87,95 @@ void ssd1306_pixel(ssd1306_t *ssd, uint8_t x, uint8_t y, bool value) {
     ssd->ram_buffer[index] &= ~(1 << pixel);
 }
 
-/*
-void ssd1306_fill(ssd1306_t *ssd, bool value) {
-  uint8_t byte = value ? 0xFF : 0x00;
-  for (uint8_t i = 1; i < ssd->bufsize; ++i)
-    ssd->ram_buffer[i] = byte;
-}*/
+// Percorre n pixels a partir de (x, y) com passo (dx, dy). Com padrao, o
+// bit k de bits da o valor do k-esimo pixel (n <= 32); sem, todos recebem
+// bits != 0. As coordenadas dao a volta em 8 bits, como em ssd1306_pixel.
+#if INTERP_HW_DISPONIVEL
+// interp1, lane 0: acumula y (passo dy) e contribui y >> 3 (pagina).
+// Lane 1: acumula x * 8 (passo dx * 8) e contribui a coluna. O resultado
+// completo, BASE2 + pagina + coluna, ja e o endereco do byte; cada POP
+// avanca os dois acumuladores.
+static void interp_fb_configurar(ssd1306_t *ssd) {
+  interp_config c0 = interp_default_config();
+  interp_config_set_add_raw(&c0, true);
+  interp_config_set_shift(&c0, 3);
+  interp_config_set_mask(&c0, 0, 4);
+  interp_set_config(interp1, 0, &c0);
 
-void ssd1306_fill(ssd1306_t *ssd, bool value) {
-    // Itera por todas as posições do display
-    for (uint8_t y = 0; y < ssd->height; ++y) {
-        for (uint8_t x = 0; x < ssd->width; ++x) {
-            ssd1306_pixel(ssd, x, y, value);
-        }
-    }
+  interp_config c1 = interp_default_config();
+  interp_config_set_add_raw(&c1, true);
+  interp_config_set_mask(&c1, 3, 10);
+  interp_set_config(interp1, 1, &c1);
+
+  interp1->base[2] = (uintptr_t)(ssd->ram_buffer + 1);
 }
 
+static void interp_fb_tracar(uint8_t x, uint8_t y, int8_t dx, int8_t dy, uint16_t n, uint32_t bits, bool padrao) {
+  interp1->accum[0] = y;
+  interp1->base[0] = (uint32_t)(int32_t)dy;
+  interp1->accum[1] = (uint32_t)x << 3;
+  interp1->base[1] = (uint32_t)(int32_t)(dx * 8);
 
+  for (uint16_t k = 0; k < n; ++k) {
+    uint8_t bit = (uint8_t)(1u << (interp1->accum[0] & 7));
+    uint8_t *byte = (uint8_t *)interp1->pop[2];
+    bool value = padrao ? (bits >> k) & 1 : bits != 0;
+    if (value)
+      *byte |= bit;
+    else
+      *byte &= (uint8_t)~bit;
+  }
+}
+#endif
 
-void ssd1306_rect(ssd1306_t *ssd, uint8_t top, uint8_t left, uint8_t width, uint8_t height, bool value, bool fill) {
-  for (uint8_t x = left; x < left + width; ++x) {
-    ssd1306_pixel(ssd, x, top, value);
-    ssd1306_pixel(ssd, x, top + height - 1, value);
+static void tracar_portavel(ssd1306_t *ssd, uint8_t x, uint8_t y, int8_t dx, int8_t dy, uint16_t n, uint32_t bits, bool padrao) {
+  for (uint16_t k = 0; k < n; ++k) {
+    ssd1306_pixel(ssd, x, y, padrao ? (bits >> k) & 1 : bits != 0);
+    x += dx;
+    y += dy;
+  }
+}
+
+// Inicio de uma primitiva: configura o interp1 uma vez para todos os
+// tracos dela.
+static bool tracos_iniciar(ssd1306_t *ssd) {
+#if INTERP_HW_DISPONIVEL
+  if (interp_hw_ativo) {
+    interp_fb_configurar(ssd);
+    return true;
   }
-  for (uint8_t y = top; y < top + height; ++y) {
-    ssd1306_pixel(ssd, left, y, value);
-    ssd1306_pixel(ssd, left + width - 1, y, value);
+#endif
+  return false;
+}
+
+static void tracar(ssd1306_t *ssd, bool interp, uint8_t x, uint8_t y, int8_t dx, int8_t dy, uint16_t n, uint32_t bits, bool padrao) {
+#if INTERP_HW_DISPONIVEL
+  if (interp) {
+    interp_fb_tracar(x, y, dx, dy, n, bits, padrao);
+    return;
   }
+#endif
+  tracar_portavel(ssd, x, y, dx, dy, n, bits, padrao);
+}
 
-  if (fill) {
-    for (uint8_t x = left + 1; x < left + width - 1; ++x) {
-      for (uint8_t y = top + 1; y < top + height - 1; ++y) {
-        ssd1306_pixel(ssd, x, y, value);
-      }
-    }
+// Cada bit do framebuffer e um pixel: preencher e escrever bytes inteiros.
+void ssd1306_fill(ssd1306_t *ssd, bool value) {
+  memset(ssd->ram_buffer + 1, value ? 0xFF : 0x00, ssd->bufsize - 1);
+}
+
+
+
+void ssd1306_rect(ssd1306_t *ssd, uint8_t top, uint8_t left, uint8_t width, uint8_t height, bool value, bool fill) {
+  bool interp = tracos_iniciar(ssd);
+
+  tracar(ssd, interp, left, top, 1, 0, width, value, false);
+  tracar(ssd, interp, left, top + height - 1, 1, 0, width, value, false);
+  tracar(ssd, interp, left, top, 0, 1, height, value, false);
+  tracar(ssd, interp, left + width - 1, top, 0, 1, height, value, false);
+
+  if (fill && width > 2 && height > 2) {
+    for (uint8_t x = left + 1; x < left + width - 1; ++x)
+      tracar(ssd, interp, x, top + 1, 0, 1, height - 2, value, false);
   }
 }
 
@@ -144,13 +209,13 @@ void ssd1306_line(ssd1306_t *ssd, uint8_t x0, uint8_t y0, uint8_t x1, uint8_t y1
 
 
 void ssd1306_hline(ssd1306_t *ssd, uint8_t x0, uint8_t x1, uint8_t y, bool value) {
-  for (uint8_t x = x0; x <= x1; ++x)
-    ssd1306_pixel(ssd, x, y, value);
+  if (x1 >= x0)
+    tracar(ssd, tracos_iniciar(ssd), x0, y, 1, 0, x1 - x0 + 1, value, false);
 }
 
 void ssd1306_vline(ssd1306_t *ssd, uint8_t x, uint8_t y0, uint8_t y1, bool value) {
-  for (uint8_t y = y0; y <= y1; ++y)
-    ssd1306_pixel(ssd, x, y, value);
+  if (y1 >= y0)
+    tracar(ssd, tracos_iniciar(ssd), x, y0, 0, 1, y1 - y0 + 1, value, false);
 }
 
 // Função para desenhar um caractere
@@ -169,14 +234,13 @@ void ssd1306_draw_char(ssd1306_t *ssd, char c, uint8_t x, uint8_t y)
     index = 0; // Índice 0 corresponde ao caractere "nada" (espaço)
   }
 
-  // Desenha o caractere na tela
+  // Desenha o caractere na tela: cada byte da fonte e uma coluna de 8
+  // pixels, o bit j sendo a linha j
+  bool interp = tracos_iniciar(ssd);
   for (uint8_t i = 0; i < 8; ++i)
   {
     uint8_t line = font[index + i]; // Acessa a linha correspondente do caractere na fonte
-    for (uint8_t j = 0; j < 8; ++j)
-    {
-      ssd1306_pixel(ssd, x + i, y + j, line & (1 << j)); // Desenha cada pixel do caractere
-    }
+    tracar(ssd, interp, x + i, y, 0, 1, 8, line, true);
   }
 }
 
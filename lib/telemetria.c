@@ -0,0 +1,110 @@
+#include <string.h>
+#include "telemetria.h"
+#include "cobs.h"
+#include "crc16.h"
+#include "tlog.h"
+#include "pico/stdio_usb.h"
+#include "tusb.h"
+#include "FreeRTOS.h"
+#include "task.h"
+
+#define QUADRO_MAX   (sizeof(telemetria_cabecalho_t) + TELEMETRIA_CARGA_MAX + sizeof(uint16_t))
+#define CODIFICADO_MAX (COBS_TAMANHO_MAX(QUADRO_MAX) + 1)
+
+_Static_assert((TELEMETRIA_ANEL & (TELEMETRIA_ANEL - 1)) == 0, "anel deve ser potencia de 2");
+
+static uint8_t anel[TELEMETRIA_ANEL];
+static uint32_t cabeca; // indices livres (so crescem), mascarados no acesso
+static uint32_t cauda;
+static uint8_t sequencia;
+static uint32_t descartados;
+
+void telemetria_init(void) {
+    cabeca = cauda = 0;
+    sequencia = 0;
+    descartados = 0;
+}
+
+// Descarta o quadro mais antigo: avanca a cauda ate depois do proximo 0x00.
+// Chamar com a secao critica ativa.
+static void descartar_mais_antigo(void) {
+    while (cauda != cabeca) {
+        if (anel[cauda++ & (TELEMETRIA_ANEL - 1)] == 0)
+            break;
+    }
+    descartados++;
+}
+
+void telemetria_enviar(tipo_telemetria_t tipo, const void *carga, size_t tamanho) {
+    uint8_t quadro[QUADRO_MAX];
+    uint8_t codificado[CODIFICADO_MAX];
+
+    if (tamanho > TELEMETRIA_CARGA_MAX)
+        return;
+
+    quadro[0] = (uint8_t)tipo;
+    memcpy(&quadro[2], carga, tamanho);
+
+    // A sequencia entra no CRC e no COBS, entao o quadro e fechado na mesma
+    // secao critica que o poe no anel: um produtor preemptado (o shell roda
+    // em idle) nao enfileira depois um quadro com sequencia mais antiga. Sao
+    // no maximo TELEMETRIA_CARGA_MAX + 4 bytes.
+    taskENTER_CRITICAL();
+    quadro[1] = sequencia++;
+    uint16_t crc = crc16(quadro, 2 + tamanho);
+    quadro[2 + tamanho] = (uint8_t)(crc & 0xFF);
+    quadro[3 + tamanho] = (uint8_t)(crc >> 8);
+    size_t n = cobs_codificar(quadro, 4 + tamanho, codificado);
+    codificado[n++] = 0x00;
+    while (TELEMETRIA_ANEL - (cabeca - cauda) < n)
+        descartar_mais_antigo();
+    for (size_t i = 0; i < n; i++)
+        anel[cabeca++ & (TELEMETRIA_ANEL - 1)] = codificado[i];
+    taskEXIT_CRITICAL();
+}
+
+uint32_t telemetria_descartados(void) {
+    return descartados;
+}
+
+void vTelemetriaTask(void *params) {
+    uint8_t pedaco[64];
+    uint32_t entrada[TLOG_ENTRADA_MAX];
+
+    while (true) {
+        vTaskDelay(pdMS_TO_TICKS(TELEMETRIA_PERIODO_MS));
+
+        for (uint32_t i = 0; i < TELEMETRIA_LOG_POR_CICLO; i++) {
+            uint32_t n = tlog_ler(entrada);
+            if (n == 0)
+                break;
+            telemetria_enviar(TELEMETRIA_LOG, entrada, n * sizeof(uint32_t));
+        }
+
+        // Sem host conectado os quadros ficam no anel e os mais antigos
+        // vao sendo descartados pelos produtores.
+        if (!stdio_usb_connected())
+            continue;
+
+        while (true) {
+            uint32_t livre_usb = tud_cdc_write_available();
+            if (livre_usb == 0)
+                break;
+
+            uint32_t n = 0;
+            taskENTER_CRITICAL();
+            uint32_t ocupado = cabeca - cauda;
+            n = ocupado < sizeof(pedaco) ? ocupado : sizeof(pedaco);
+            if (n > livre_usb)
+                n = livre_usb;
+            for (uint32_t i = 0; i < n; i++)
+                pedaco[i] = anel[cauda++ & (TELEMETRIA_ANEL - 1)];
+            taskEXIT_CRITICAL();
+
+            if (n == 0)
+                break;
+            // Cabe no buffer do CDC, entao a escrita nao espera
+            stdio_usb.out_chars((const char *)pedaco, (int)n);
+        }
+    }
+}
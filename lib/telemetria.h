@@ -0,0 +1,27 @@
+#ifndef TELEMETRIA_H
+#define TELEMETRIA_H
+
+#include "pico/stdlib.h"
+#include "telemetria_proto.h"
+
+// -------------------- Telemetria por USB CDC --------------------
+// Os quadros sao codificados na hora e guardados num anel de bytes. Quem
+// produz nunca espera: sem espaco, os quadros mais antigos sao descartados
+// (e contados). A tarefa de telemetria esvazia o anel para a USB apenas na
+// quantidade que o buffer do CDC aceita no momento. Ela tambem repassa as
+// entradas do log tokenizado (tlog.h) como quadros TELEMETRIA_LOG.
+
+#define TELEMETRIA_ANEL      2048 // bytes
+#define TELEMETRIA_PERIODO_MS 5
+#define TELEMETRIA_LOG_POR_CICLO 8 // entradas do tlog repassadas por ciclo
+
+void telemetria_init(void);
+
+// Enfileira um quadro. Seguro para chamar de qualquer tarefa.
+void telemetria_enviar(tipo_telemetria_t tipo, const void *carga, size_t tamanho);
+
+void vTelemetriaTask(void *params);
+
+uint32_t telemetria_descartados(void);
+
+#endif
@@ -0,0 +1,57 @@
+#ifndef TELEMETRIA_PROTO_H
+#define TELEMETRIA_PROTO_H
+
+#include <stdint.h>
+
+// -------------------- Protocolo de telemetria binaria --------------------
+// Cada quadro e [tipo][sequencia][carga][crc16 LE], codificado em COBS e
+// terminado por 0x00. O CRC (CRC-16/CCITT-FALSE) cobre tipo, sequencia e
+// carga. A sequencia cresce a cada quadro, na ordem em que entram no anel,
+// entao lacunas no host indicam quadros descartados pela estacao. Inteiros
+// em little-endian.
+
+#define TELEMETRIA_CARGA_MAX 64
+#define TELEMETRIA_ATRASO_MAX 16 // passo para tras que ainda e atraso, nao volta do contador
+
+typedef enum {
+    TELEMETRIA_AMOSTRA    = 1,
+    TELEMETRIA_ALERTA     = 2,
+    TELEMETRIA_CONTADORES = 3,
+    TELEMETRIA_LOG        = 4, // entrada do log tokenizado (palavras de tlog.h)
+    TELEMETRIA_RESPOSTA   = 5  // texto de resposta do shell (shell.h), sem terminador
+} tipo_telemetria_t;
+
+typedef struct __attribute__((packed)) {
+    uint8_t tipo;
+    uint8_t sequencia;
+} telemetria_cabecalho_t;
+
+// Quadros perdidos entre a sequencia esperada e a recebida. Ate
+// TELEMETRIA_ATRASO_MAX para tras e um quadro atrasado ou repetido (UDP
+// reordena; firmwares antigos tambem): devolve -1, nao conta perda e quem
+// chama nao recua a esperada.
+static inline int telemetria_lacuna(uint8_t esperada, uint8_t recebida) {
+    uint8_t atras = (uint8_t)(esperada - recebida);
+    if (atras != 0 && atras <= TELEMETRIA_ATRASO_MAX)
+        return -1;
+    return (uint8_t)(recebida - esperada);
+}
+
+typedef struct __attribute__((packed)) {
+    uint32_t tempo_ms;
+    uint16_t nivel_agua;   // centesimos de %
+    uint16_t volume_chuva; // centesimos de %
+    uint8_t alerta;
+} telemetria_amostra_t;
+
+typedef telemetria_amostra_t telemetria_alerta_t; // valores no instante da transicao
+
+typedef struct __attribute__((packed)) {
+    uint32_t tempo_ms;
+    uint32_t telemetria_descartados; // quadros perdidos por falta de leitura no host
+    uint32_t log_descartados;        // registros perdidos pelo log em flash
+    uint32_t capturas_perdidas;
+    uint32_t tlog_descartados;       // entradas perdidas pelo log tokenizado
+} telemetria_contadores_t;
+
+#endif
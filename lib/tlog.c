@@ -0,0 +1,50 @@
+#include "tlog.h"
+#include "hardware/sync.h"
+#include "hardware/timer.h"
+
+_Static_assert((TLOG_PALAVRAS & (TLOG_PALAVRAS - 1)) == 0, "anel deve ser potencia de 2");
+
+// Simbolos gerados pelo linker para a secao orfa "tlog_fmt"
+extern const char __start_tlog_fmt[];
+
+static uint32_t anel[TLOG_PALAVRAS];
+static volatile uint32_t cabeca; // indices livres (so crescem)
+static volatile uint32_t cauda;
+static uint32_t descartados;
+
+// O M0+ nao tem LDREX/STREX; a reserva de espaco e feita com as interrupcoes
+// mascaradas por poucas instrucoes, sem mutex nem troca de contexto.
+void __not_in_flash_func(tlog_escrever)(const char *fmt, const uint32_t *args, uint32_t n) {
+    uint32_t id = (uint32_t)(fmt - __start_tlog_fmt);
+    uint32_t ints = save_and_disable_interrupts();
+
+    uint32_t c = cabeca;
+    if (TLOG_PALAVRAS - (c - cauda) < 2 + n) {
+        descartados++;
+        restore_interrupts(ints);
+        return;
+    }
+    anel[c++ & (TLOG_PALAVRAS - 1)] = TLOG_CABECALHO(id, n);
+    anel[c++ & (TLOG_PALAVRAS - 1)] = time_us_32();
+    for (uint32_t i = 0; i < n; i++)
+        anel[c++ & (TLOG_PALAVRAS - 1)] = args[i];
+    cabeca = c;
+
+    restore_interrupts(ints);
+}
+
+uint32_t tlog_ler(uint32_t *destino) {
+    uint32_t t = cauda;
+    if (t == cabeca)
+        return 0;
+
+    uint32_t n = 2 + TLOG_ARGS(anel[t & (TLOG_PALAVRAS - 1)]);
+    for (uint32_t i = 0; i < n; i++)
+        destino[i] = anel[(t + i) & (TLOG_PALAVRAS - 1)];
+    cauda = t + n;
+    return n;
+}
+
+uint32_t tlog_descartados(void) {
+    return descartados;
+}
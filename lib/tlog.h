@@ -0,0 +1,46 @@
+#ifndef TLOG_H
+#define TLOG_H
+
+#include "pico/stdlib.h"
+#include "tlog_proto.h"
+
+// -------------------- Log tokenizado --------------------
+// O ponto de log grava apenas o identificador da string de formato (seu
+// deslocamento na secao "tlog_fmt") e os argumentos crus, em palavras de 32
+// bits, num anel em RAM. Nada e formatado no RP2040: o host recebe as
+// entradas pela telemetria e formata com a tabela extraida do ELF
+// (PiscaLed.tlog, gerada no build por objcopy).
+//
+// Argumentos sao convertidos para uint32_t; floats devem ser passados com
+// TLOG_FLOAT() para preservar os bits. Strings (%s) nao sao suportadas.
+//
+//   TLOG("nivel %u.%02u%%", c / 100, c % 100);
+//   TLOG("tensao %.3f", TLOG_FLOAT(v));
+
+#define TLOG_PALAVRAS  1024 // tamanho do anel (potencia de 2)
+
+#define TLOG(fmt, ...) do {                                                          \
+        static const char tlog_fmt_[] __attribute__((section("tlog_fmt"), used)) = fmt; \
+        const uint32_t tlog_args_[] = { 0, ##__VA_ARGS__ };                          \
+        _Static_assert(sizeof(tlog_args_) / sizeof(uint32_t) - 1 <= TLOG_ARGS_MAX,   \
+                       "TLOG aceita no maximo TLOG_ARGS_MAX argumentos");            \
+        tlog_escrever(tlog_fmt_, tlog_args_ + 1,                                     \
+                      sizeof(tlog_args_) / sizeof(uint32_t) - 1);                    \
+    } while (0)
+
+static inline uint32_t TLOG_FLOAT(float valor) {
+    union { float f; uint32_t u; } conversao = { .f = valor };
+    return conversao.u;
+}
+
+// Pode ser chamada de tarefas e de interrupcoes. Sem espaco, a entrada e
+// descartada e contada.
+void tlog_escrever(const char *fmt, const uint32_t *args, uint32_t n);
+
+// Copia a entrada mais antiga (ate TLOG_ENTRADA_MAX palavras) e retorna o
+// numero de palavras, ou 0 se o anel estiver vazio. Um unico consumidor.
+uint32_t tlog_ler(uint32_t *destino);
+
+uint32_t tlog_descartados(void);
+
+#endif
@@ -0,0 +1,17 @@
+#ifndef TLOG_PROTO_H
+#define TLOG_PROTO_H
+
+#include <stdint.h>
+
+// Formato das entradas do log tokenizado, compartilhado com o host.
+// Cada entrada: [cabecalho][tempo_us][argumentos...], em palavras de 32 bits.
+
+#define TLOG_ARGS_MAX    6
+#define TLOG_ENTRADA_MAX (2 + TLOG_ARGS_MAX)
+
+// Cabecalho: id (16 bits) | quantidade de argumentos (8 bits)
+#define TLOG_CABECALHO(id, n) (((uint32_t)(id) << 16) | ((uint32_t)(n) & 0xFF))
+#define TLOG_ID(cabecalho)    ((cabecalho) >> 16)
+#define TLOG_ARGS(cabecalho)  ((cabecalho) & 0xFF)
+
+#endif
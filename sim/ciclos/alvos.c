@@ -0,0 +1,128 @@
+// Alvos do estacao_ciclos: cada ciclos_* e uma chamada medida no emulador
+// do Cortex-M0+, sem argumentos e com o estado em variaveis estaticas
+// (memoria e cache persistem entre as chamadas, como no firmware).
+// Compilado com arm-none-eabi-gcc junto dos modulos de lib/ (sim/CMakeLists.txt).
+#include <string.h>
+#include "ssd1306.h"
+#include "painel.h"
+#include "formatar.h"
+#include "crc16.h"
+#include "cobs.h"
+#include "serie_comp.h"
+#include "interp_hw.h"
+#include "config.h"
+
+#define ANEL_BITS 9 // 256 amostras intercaladas, como o anel da captura
+#define AMOSTRAS_MEDIA 64
+
+static uint8_t framebuffer[1 + WIDTH * HEIGHT / 8] = { 0x40 };
+static ssd1306_t display = {
+    .width = WIDTH, .height = HEIGHT, .pages = HEIGHT / 8, .address = 0x3C,
+    .ram_buffer = framebuffer, .bufsize = sizeof(framebuffer),
+};
+
+static uint32_t iteracao;
+static volatile uint32_t resultado; // o compilador nao descarta o que e medido
+static char texto[FORMATAR_NUMERO_MAX];
+static uint16_t anel[1u << (ANEL_BITS - 1)];
+static uint8_t bloco[64];
+static uint8_t codificado[COBS_TAMANHO_MAX(sizeof(bloco))];
+static uint8_t bloco_serie[256];
+static serie_comp_t serie;
+static amostra_comp_t amostra;
+
+// O quadro nao e enviado aqui: o custo do I2C e medido pelo
+// estacao_desempenho.
+int i2c_write_timeout_us(i2c_inst_t *i2c, uint8_t endereco, const uint8_t *dados, size_t tamanho, bool sem_stop,
+                         uint timeout_us) {
+    (void)i2c;
+    (void)endereco;
+    (void)dados;
+    (void)sem_stop;
+    (void)timeout_us;
+    return (int)tamanho;
+}
+
+// Referencia: o custo de chamar um alvo, descontado dos outros
+void ciclos_vazio(void) {
+}
+
+// -------------------- Desenho --------------------
+void ciclos_pixel(void) {
+    ssd1306_pixel(&display, (uint8_t)(iteracao & 127), (uint8_t)((iteracao >> 7) & 63), true);
+    iteracao++;
+}
+
+void ciclos_fill(void) {
+    ssd1306_fill(&display, false);
+}
+
+void ciclos_rect(void) {
+    ssd1306_rect(&display, 3, 3, 122, 60, true, false);
+}
+
+void ciclos_line(void) {
+    ssd1306_line(&display, 0, 0, 127, 63, true);
+}
+
+void ciclos_draw_char(void) {
+    ssd1306_draw_char(&display, 'A', 60, 28);
+}
+
+void ciclos_draw_string(void) {
+    ssd1306_draw_string(&display, "EMBARCATECH", 20, 16);
+}
+
+void ciclos_painel(void) {
+    painel_desenhar(&display, 453, 120, false);
+}
+
+// -------------------- Formatacao --------------------
+void ciclos_formatar_percentual(void) {
+    formatar_percentual(texto, 1234);
+}
+
+void ciclos_formatar_decimal(void) {
+    resultado = formatar_decimal(texto, 705012u, 2);
+}
+
+// -------------------- Leitura e alerta --------------------
+// Media da captura (captura_media) sobre um anel intercalado de dois canais.
+void ciclos_media(void) {
+    uint32_t soma = interp_hw_anel_somar(anel, ANEL_BITS, iteracao++ & 0xFF, -2, AMOSTRAS_MEDIA);
+    resultado = soma / AMOSTRAS_MEDIA;
+}
+
+// O resto da leitura na vJoystickTask: comparacao com os limiares em
+// centesimos e a conversao para float enviada na fila (telemetria e log ja
+// levam os centesimos). Sem FPU, em software.
+void ciclos_alerta(void) {
+    uint16_t nivel_c = (uint16_t)(iteracao++ % 10001u);
+    uint16_t chuva_c = 3050;
+    bool alerta = nivel_c >= CONFIG_PADRAO_LIMIAR_AGUA || chuva_c >= CONFIG_PADRAO_LIMIAR_CHUVA;
+
+    float valores[2] = { nivel_c / 100.0f, chuva_c / 100.0f };
+    uint32_t bits[2];
+    memcpy(bits, valores, sizeof(bits));
+    resultado = bits[0] ^ bits[1] ^ alerta;
+}
+
+// -------------------- Telemetria e log --------------------
+void ciclos_crc16(void) {
+    resultado = crc16(bloco, sizeof(bloco));
+}
+
+void ciclos_cobs(void) {
+    resultado = (uint32_t)cobs_codificar(bloco, sizeof(bloco), codificado);
+}
+
+// Uma amostra no bloco comprimido; bloco cheio recomeca
+void ciclos_serie_comp(void) {
+    if (serie.bloco == NULL || serie.amostras >= 40)
+        serie_comp_iniciar(&serie, bloco_serie, sizeof(bloco_serie));
+    amostra.tempo_ms += 1000 + (iteracao & 3);
+    amostra.nivel_agua = (uint16_t)(4000 + (iteracao * 37) % 200);
+    amostra.volume_chuva = (uint16_t)(2000 + (iteracao * 11) % 50);
+    iteracao++;
+    resultado = serie_comp_adicionar(&serie, &amostra);
+}
@@ -0,0 +1,353 @@
+// Conta instrucoes e ciclos do Cortex-M0+ por chamada das funcoes
+// ciclos_* de alvos.elf (sim/ciclos/alvos.c compilado com
+// arm-none-eabi-gcc), executadas no emulador de m0plus.c. Sem placa: o
+// custo no alvo (sem FPU, float e divisao em software, esperas da XIP)
+// vira um numero que pode ser acompanhado e limitado.
+//
+//   estacao_ciclos alvos.elf [--json] [--chamadas N] [--falta-xip N]
+//                  [--sem-divisor] [--gravar arq]
+//                  [--orcamentos arq [--tolerancia P]] [alvo...]
+//
+// Cada alvo roda uma vez com a cache da XIP vazia (frio) e depois
+// --chamadas vezes seguidas (quente, media). Do resultado sai o custo de
+// chamar ciclos_vazio, para sobrar so o da funcao medida. Com --gravar,
+// os ciclos quentes vao para um CSV (alvo,ciclos); com --orcamentos, cada
+// alvo que passar do seu orcamento mais a tolerancia (5% por padrao) faz
+// o programa terminar com codigo 1.
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "m0plus.h"
+
+#define ALVOS_MAX 64
+#define PREFIXO "ciclos_"
+#define LIMITE_INSTRUCOES 50000000u
+
+// Divisao inteira pelo SDK: o divisor do SIO responde em 8 ciclos; com a
+// chamada, o salvamento do estado do divisor e o retorno, ~20.
+#define CICLOS_DIVISAO_SDK 20
+
+typedef struct {
+    char nome[64];
+    uint32_t endereco;
+    uint64_t ciclos, frio, instrucoes, faltas_xip;
+    int64_t orcamento; // -1 = sem orcamento
+} alvo_t;
+
+static alvo_t alvos[ALVOS_MAX];
+static uint8_t num_alvos;
+
+// -------------------- ELF --------------------
+static uint32_t le32(const uint8_t *p) {
+    return (uint32_t)p[0] | (uint32_t)p[1] << 8 | (uint32_t)p[2] << 16 | (uint32_t)p[3] << 24;
+}
+
+static uint16_t le16(const uint8_t *p) {
+    return (uint16_t)(p[0] | p[1] << 8);
+}
+
+static int comparar_alvos(const void *a, const void *b) {
+    uint32_t x = ((const alvo_t *)a)->endereco, y = ((const alvo_t *)b)->endereco;
+    return (x > y) - (x < y);
+}
+
+typedef struct {
+    const char *nome;
+    uint32_t (*funcao)(uint32_t *r);
+} divisao_t;
+
+static uint32_t udiv(uint32_t *r) {
+    uint32_t n = r[0], d = r[1];
+    // Divisao por zero no SIO: quociente 0xFFFFFFFF, resto = dividendo
+    r[0] = d ? n / d : 0xFFFFFFFFu;
+    r[1] = d ? n % d : n;
+    return CICLOS_DIVISAO_SDK;
+}
+
+static uint32_t sdiv(uint32_t *r) {
+    int32_t n = (int32_t)r[0], d = (int32_t)r[1];
+    if (d == 0) {
+        r[0] = n < 0 ? 1u : 0xFFFFFFFFu;
+        r[1] = (uint32_t)n;
+    } else if (n == INT32_MIN && d == -1) {
+        r[0] = (uint32_t)n;
+        r[1] = 0;
+    } else {
+        r[0] = (uint32_t)(n / d);
+        r[1] = (uint32_t)(n % d);
+    }
+    return CICLOS_DIVISAO_SDK;
+}
+
+static const divisao_t divisoes[] = {
+    { "__aeabi_uidiv", udiv },
+    { "__aeabi_uidivmod", udiv },
+    { "__aeabi_idiv", sdiv },
+    { "__aeabi_idivmod", sdiv },
+};
+
+static bool carregar_elf(m0_t *m, const char *arquivo, bool divisor) {
+    FILE *f = fopen(arquivo, "rb");
+    if (f == NULL) {
+        perror(arquivo);
+        return false;
+    }
+    fseek(f, 0, SEEK_END);
+    long tamanho = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    uint8_t *elf = malloc((size_t)tamanho);
+    bool ok = elf != NULL && fread(elf, 1, (size_t)tamanho, f) == (size_t)tamanho;
+    fclose(f);
+
+    // ELF32, little-endian, ARM
+    ok = ok && tamanho >= 52 && memcmp(elf, "\x7F" "ELF", 4) == 0 &&
+         elf[4] == 1 && elf[5] == 1 && le16(elf + 18) == 40;
+    if (!ok) {
+        fprintf(stderr, "%s: nao e um ELF32 ARM\n", arquivo);
+        free(elf);
+        return false;
+    }
+
+    uint32_t phoff = le32(elf + 28), shoff = le32(elf + 32);
+    uint16_t phentsize = le16(elf + 42), phnum = le16(elf + 44);
+    uint16_t shentsize = le16(elf + 46), shnum = le16(elf + 48);
+
+    // Segmentos carregaveis vao direto para o endereco de execucao: .data e
+    // o codigo da SRAM ja ficam no lugar, sem o crt0 copiar da flash
+    for (uint16_t k = 0; ok && k < phnum; k++) {
+        const uint8_t *ph = elf + phoff + (size_t)k * phentsize;
+        if (le32(ph) != 1 || le32(ph + 16) == 0) // PT_LOAD com dados
+            continue;
+        ok = le32(ph + 4) + le32(ph + 16) <= (uint32_t)tamanho &&
+             m0_carregar(m, le32(ph + 8), elf + le32(ph + 4), le32(ph + 16));
+        if (!ok)
+            fprintf(stderr, "%s: segmento fora da memoria (0x%08x)\n", arquivo, le32(ph + 8));
+    }
+
+    // Tabela de simbolos: alvos e rotinas de divisao
+    for (uint16_t k = 0; ok && k < shnum; k++) {
+        const uint8_t *sh = elf + shoff + (size_t)k * shentsize;
+        if (le32(sh + 4) != 2) // SHT_SYMTAB
+            continue;
+        const uint8_t *strtab_sh = elf + shoff + (size_t)le32(sh + 24) * shentsize;
+        const char *nomes = (const char *)elf + le32(strtab_sh + 16);
+        const uint8_t *simbolos = elf + le32(sh + 16);
+        uint32_t quantos = le32(sh + 20) / 16;
+
+        for (uint32_t s = 0; s < quantos; s++) {
+            const uint8_t *sim = simbolos + s * 16;
+            if ((sim[12] & 0xF) != 2) // STT_FUNC
+                continue;
+            const char *nome = nomes + le32(sim);
+            uint32_t valor = le32(sim + 4);
+
+            if (strncmp(nome, PREFIXO, strlen(PREFIXO)) == 0 && num_alvos < ALVOS_MAX) {
+                alvo_t *a = &alvos[num_alvos++];
+                snprintf(a->nome, sizeof(a->nome), "%s", nome + strlen(PREFIXO));
+                a->endereco = valor;
+                a->orcamento = -1;
+            }
+            for (size_t d = 0; divisor && d < sizeof(divisoes) / sizeof(divisoes[0]); d++) {
+                if (strcmp(nome, divisoes[d].nome) == 0)
+                    m0_interceptar(m, valor, divisoes[d].funcao);
+            }
+        }
+    }
+    free(elf);
+    qsort(alvos, num_alvos, sizeof(alvos[0]), comparar_alvos);
+    return ok;
+}
+
+static alvo_t *procurar(const char *nome) {
+    for (uint8_t k = 0; k < num_alvos; k++) {
+        if (strcmp(alvos[k].nome, nome) == 0)
+            return &alvos[k];
+    }
+    return NULL;
+}
+
+// -------------------- Medicao --------------------
+static bool medir(m0_t *m, alvo_t *a, uint32_t chamadas) {
+    m0_esvaziar_cache(m);
+    uint64_t c0 = m->ciclos, f0 = m->faltas_xip;
+    if (!m0_chamar(m, a->endereco, NULL, 0, LIMITE_INSTRUCOES))
+        return false;
+    a->frio = m->ciclos - c0;
+    a->faltas_xip = m->faltas_xip - f0;
+
+    c0 = m->ciclos;
+    uint64_t i0 = m->instrucoes;
+    for (uint32_t k = 0; k < chamadas; k++) {
+        if (!m0_chamar(m, a->endereco, NULL, 0, LIMITE_INSTRUCOES))
+            return false;
+    }
+    a->ciclos = (m->ciclos - c0 + chamadas / 2) / chamadas;
+    a->instrucoes = (m->instrucoes - i0 + chamadas / 2) / chamadas;
+    return true;
+}
+
+static uint64_t descontar(uint64_t valor, uint64_t base) {
+    return valor > base ? valor - base : 0;
+}
+
+// -------------------- Orcamentos --------------------
+static bool ler_orcamentos(const char *arquivo) {
+    FILE *f = fopen(arquivo, "r");
+    if (f == NULL) {
+        perror(arquivo);
+        return false;
+    }
+    char linha[128];
+    while (fgets(linha, sizeof(linha), f) != NULL) {
+        char nome[64];
+        long long ciclos;
+        if (linha[0] == '#' || sscanf(linha, "%63[^,],%lld", nome, &ciclos) != 2)
+            continue;
+        alvo_t *a = procurar(nome);
+        if (a != NULL)
+            a->orcamento = ciclos;
+        else
+            fprintf(stderr, "aviso: orcamento de %s, que nao esta no ELF\n", nome);
+    }
+    fclose(f);
+    return true;
+}
+
+static bool gravar_orcamentos(const char *arquivo, const bool *selecionados) {
+    FILE *f = fopen(arquivo, "w");
+    if (f == NULL) {
+        perror(arquivo);
+        return false;
+    }
+    fprintf(f, "# alvo,ciclos (quentes, sem o custo da chamada)\n");
+    for (uint8_t k = 0; k < num_alvos; k++) {
+        if (selecionados[k])
+            fprintf(f, "%s,%llu\n", alvos[k].nome, (unsigned long long)alvos[k].ciclos);
+    }
+    return fclose(f) == 0;
+}
+
+static void uso(const char *programa) {
+    fprintf(stderr, "uso: %s alvos.elf [--json] [--chamadas N] [--falta-xip N] [--sem-divisor]\n"
+                    "       [--gravar arq] [--orcamentos arq [--tolerancia P]] [alvo...]\n", programa);
+}
+
+int main(int argc, char **argv) {
+    const char *elf = NULL, *gravar = NULL, *orcamentos = NULL;
+    bool json = false, divisor = true;
+    uint32_t chamadas = 8, falta_xip = M0_FALTA_XIP_PADRAO, tolerancia = 5;
+    const char *filtro[ALVOS_MAX];
+    int num_filtro = 0;
+
+    for (int k = 1; k < argc; k++) {
+        const char *a = argv[k];
+        bool tem_valor = k + 1 < argc;
+        if (strcmp(a, "--json") == 0) {
+            json = true;
+        } else if (strcmp(a, "--sem-divisor") == 0) {
+            divisor = false;
+        } else if (strcmp(a, "--chamadas") == 0 && tem_valor) {
+            chamadas = (uint32_t)strtoul(argv[++k], NULL, 10);
+        } else if (strcmp(a, "--falta-xip") == 0 && tem_valor) {
+            falta_xip = (uint32_t)strtoul(argv[++k], NULL, 10);
+        } else if (strcmp(a, "--tolerancia") == 0 && tem_valor) {
+            tolerancia = (uint32_t)strtoul(argv[++k], NULL, 10);
+        } else if (strcmp(a, "--gravar") == 0 && tem_valor) {
+            gravar = argv[++k];
+        } else if (strcmp(a, "--orcamentos") == 0 && tem_valor) {
+            orcamentos = argv[++k];
+        } else if (a[0] == '-') {
+            uso(argv[0]);
+            return 2;
+        } else if (elf == NULL) {
+            elf = a;
+        } else if (num_filtro < ALVOS_MAX) {
+            filtro[num_filtro++] = a;
+        }
+    }
+    if (elf == NULL || chamadas == 0) {
+        uso(argv[0]);
+        return 2;
+    }
+
+    static m0_t m;
+    if (!m0_iniciar(&m)) {
+        fprintf(stderr, "sem memoria para o emulador\n");
+        return 1;
+    }
+    m.falta_xip = falta_xip;
+    if (!carregar_elf(&m, elf, divisor))
+        return 1;
+
+    alvo_t *vazio = procurar("vazio");
+    if (vazio == NULL) {
+        fprintf(stderr, "%s: sem " PREFIXO "vazio\n", elf);
+        return 1;
+    }
+    if (orcamentos != NULL && !ler_orcamentos(orcamentos))
+        return 1;
+
+    bool selecionados[ALVOS_MAX];
+    for (uint8_t k = 0; k < num_alvos; k++) {
+        selecionados[k] = num_filtro == 0 && &alvos[k] != vazio;
+        for (int j = 0; j < num_filtro; j++)
+            selecionados[k] |= strcmp(alvos[k].nome, filtro[j]) == 0;
+    }
+
+    if (!medir(&m, vazio, chamadas)) {
+        fprintf(stderr, "vazio: %s\n", m.erro);
+        return 1;
+    }
+    uint64_t base_ciclos = vazio->ciclos, base_frio = vazio->frio, base_instrucoes = vazio->instrucoes;
+
+    int acima = 0;
+    bool primeiro = true;
+    if (json)
+        printf("{\n  \"falta_xip\": %u,\n  \"alvos\": [", falta_xip);
+    else
+        printf("%-20s %10s %10s %10s %8s %12s\n", "alvo", "instrucoes", "ciclos", "frio", "faltas", "orcamento");
+
+    for (uint8_t k = 0; k < num_alvos; k++) {
+        alvo_t *a = &alvos[k];
+        if (!selecionados[k])
+            continue;
+        if (!medir(&m, a, chamadas)) {
+            fprintf(stderr, "%s: %s\n", a->nome, m.erro);
+            return 1;
+        }
+        a->ciclos = descontar(a->ciclos, base_ciclos);
+        a->frio = descontar(a->frio, base_frio);
+        a->instrucoes = descontar(a->instrucoes, base_instrucoes);
+
+        bool estourou = a->orcamento >= 0 && a->ciclos * 100 > (uint64_t)a->orcamento * (100 + tolerancia);
+        acima += estourou;
+
+        if (json) {
+            printf("%s\n    {\"nome\": \"%s\", \"instrucoes\": %llu, \"ciclos\": %llu, \"ciclos_frio\": %llu, \"faltas_xip\": %llu",
+                   primeiro ? "" : ",", a->nome, (unsigned long long)a->instrucoes, (unsigned long long)a->ciclos,
+                   (unsigned long long)a->frio, (unsigned long long)a->faltas_xip);
+            if (a->orcamento >= 0)
+                printf(", \"orcamento\": %lld, \"acima\": %s", (long long)a->orcamento, estourou ? "true" : "false");
+            printf("}");
+        } else {
+            char orcamento[32] = "-";
+            if (a->orcamento >= 0)
+                snprintf(orcamento, sizeof(orcamento), "%lld%s", (long long)a->orcamento, estourou ? " ACIMA" : "");
+            printf("%-20s %10llu %10llu %10llu %8llu %12s\n", a->nome, (unsigned long long)a->instrucoes,
+                   (unsigned long long)a->ciclos, (unsigned long long)a->frio,
+                   (unsigned long long)a->faltas_xip, orcamento);
+        }
+        primeiro = false;
+    }
+    if (json)
+        printf("\n  ]\n}\n");
+
+    if (gravar != NULL && !gravar_orcamentos(gravar, selecionados))
+        return 1;
+    if (acima) {
+        fprintf(stderr, "%d alvo(s) acima do orcamento (tolerancia %u%%)\n", acima, tolerancia);
+        return 1;
+    }
+    m0_liberar(&m);
+    return 0;
+}
@@ -0,0 +1,597 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "m0plus.h"
+
+#define SP 13
+#define LR 14
+#define PC 15
+
+bool m0_iniciar(m0_t *m) {
+    memset(m, 0, sizeof(*m));
+    m->flash = malloc(M0_FLASH_TAMANHO);
+    m->sram = calloc(1, M0_SRAM_TAMANHO);
+    if (m->flash == NULL || m->sram == NULL) {
+        m0_liberar(m);
+        return false;
+    }
+    memset(m->flash, 0xFF, M0_FLASH_TAMANHO);
+    m->falta_xip = M0_FALTA_XIP_PADRAO;
+    return true;
+}
+
+void m0_liberar(m0_t *m) {
+    free(m->flash);
+    free(m->sram);
+    m->flash = m->sram = NULL;
+}
+
+void m0_esvaziar_cache(m0_t *m) {
+    memset(m->xip_tag, 0, sizeof(m->xip_tag));
+    memset(m->xip_recente, 0, sizeof(m->xip_recente));
+}
+
+bool m0_interceptar(m0_t *m, uint32_t endereco, m0_intercepto_t funcao) {
+    if (m->num_interceptos >= M0_INTERCEPTOS_MAX)
+        return false;
+    m->interceptos[m->num_interceptos].endereco = endereco & ~1u;
+    m->interceptos[m->num_interceptos].funcao = funcao;
+    m->num_interceptos++;
+    return true;
+}
+
+// -------------------- Memoria --------------------
+static bool na_flash(uint32_t endereco, uint32_t tamanho) {
+    return endereco >= M0_FLASH_BASE && endereco - M0_FLASH_BASE <= M0_FLASH_TAMANHO - tamanho;
+}
+
+static bool na_sram(uint32_t endereco, uint32_t tamanho) {
+    return endereco >= M0_SRAM_BASE && endereco - M0_SRAM_BASE <= M0_SRAM_TAMANHO - tamanho;
+}
+
+bool m0_carregar(m0_t *m, uint32_t endereco, const void *dados, size_t tamanho) {
+    if (tamanho == 0)
+        return true;
+    if (tamanho > M0_FLASH_TAMANHO)
+        return false;
+    if (na_flash(endereco, (uint32_t)tamanho))
+        memcpy(m->flash + (endereco - M0_FLASH_BASE), dados, tamanho);
+    else if (na_sram(endereco, (uint32_t)tamanho))
+        memcpy(m->sram + (endereco - M0_SRAM_BASE), dados, tamanho);
+    else
+        return false;
+    return true;
+}
+
+// Cache da XIP: 2 vias com substituicao da via menos recente. A tag guarda
+// a linha + 1 para que zero signifique vazia.
+static void xip_acessar(m0_t *m, uint32_t endereco) {
+    uint32_t linha = (endereco - M0_FLASH_BASE) / M0_XIP_LINHA;
+    uint32_t conjunto = linha % M0_XIP_CONJUNTOS;
+    uint32_t tag = linha / M0_XIP_CONJUNTOS + 1;
+
+    for (uint8_t via = 0; via < M0_XIP_VIAS; via++) {
+        if (m->xip_tag[conjunto][via] == tag) {
+            m->xip_recente[conjunto] = via;
+            return;
+        }
+    }
+    uint8_t via = (uint8_t)(m->xip_recente[conjunto] ^ 1);
+    m->xip_tag[conjunto][via] = tag;
+    m->xip_recente[conjunto] = via;
+    m->ciclos += m->falta_xip;
+    m->faltas_xip++;
+}
+
+static bool falhar(m0_t *m, const char *motivo, uint32_t valor) {
+    snprintf(m->erro, sizeof(m->erro), "%s 0x%08x (pc 0x%08x)", motivo, valor, m->pc_instrucao);
+    return false;
+}
+
+static bool ler(m0_t *m, uint32_t endereco, uint32_t tamanho, uint32_t *valor) {
+    if (endereco & (tamanho - 1))
+        return falhar(m, "leitura desalinhada em", endereco);
+
+    const uint8_t *p;
+    if (na_sram(endereco, tamanho)) {
+        p = m->sram + (endereco - M0_SRAM_BASE);
+    } else if (na_flash(endereco, tamanho)) {
+        xip_acessar(m, endereco);
+        p = m->flash + (endereco - M0_FLASH_BASE);
+    } else {
+        return falhar(m, "leitura fora da memoria em", endereco);
+    }
+
+    *valor = p[0];
+    if (tamanho > 1)
+        *valor |= (uint32_t)p[1] << 8;
+    if (tamanho > 2)
+        *valor |= (uint32_t)p[2] << 16 | (uint32_t)p[3] << 24;
+    return true;
+}
+
+static bool escrever(m0_t *m, uint32_t endereco, uint32_t tamanho, uint32_t valor) {
+    if (endereco & (tamanho - 1))
+        return falhar(m, "escrita desalinhada em", endereco);
+    if (!na_sram(endereco, tamanho))
+        return falhar(m, "escrita fora da SRAM em", endereco);
+
+    uint8_t *p = m->sram + (endereco - M0_SRAM_BASE);
+    for (uint32_t i = 0; i < tamanho; i++)
+        p[i] = (uint8_t)(valor >> (8 * i));
+    return true;
+}
+
+static bool buscar(m0_t *m, uint32_t endereco, uint16_t *instrucao) {
+    uint32_t valor;
+    if (endereco & 1)
+        return falhar(m, "busca desalinhada em", endereco);
+    if (na_sram(endereco, 2)) {
+        const uint8_t *p = m->sram + (endereco - M0_SRAM_BASE);
+        *instrucao = (uint16_t)(p[0] | p[1] << 8);
+        return true;
+    }
+    if (!ler(m, endereco, 2, &valor))
+        return falhar(m, "busca fora da memoria em", endereco);
+    *instrucao = (uint16_t)valor;
+    return true;
+}
+
+// -------------------- ULA --------------------
+static void flags_nz(m0_t *m, uint32_t r) {
+    m->n = r >> 31;
+    m->z = r == 0;
+}
+
+static uint32_t somar(m0_t *m, uint32_t a, uint32_t b, uint32_t carry) {
+    uint64_t u = (uint64_t)a + b + carry;
+    int64_t s = (int64_t)(int32_t)a + (int32_t)b + carry;
+    uint32_t r = (uint32_t)u;
+    flags_nz(m, r);
+    m->c = u >> 32;
+    m->v = (int64_t)(int32_t)r != s;
+    return r;
+}
+
+static uint32_t deslocar(m0_t *m, uint8_t tipo, uint32_t valor, uint32_t n) {
+    // tipo: 0 LSL, 1 LSR, 2 ASR, 3 ROR; n ja resolvido (0 = sem mudanca)
+    if (n == 0)
+        return valor;
+    switch (tipo) {
+    case 0:
+        if (n < 32) {
+            m->c = (valor >> (32 - n)) & 1;
+            return valor << n;
+        }
+        m->c = n == 32 ? valor & 1 : 0;
+        return 0;
+    case 1:
+        if (n < 32) {
+            m->c = (valor >> (n - 1)) & 1;
+            return valor >> n;
+        }
+        m->c = n == 32 ? valor >> 31 : 0;
+        return 0;
+    case 2:
+        if (n < 32) {
+            m->c = (valor >> (n - 1)) & 1;
+            return (uint32_t)((int32_t)valor >> n);
+        }
+        m->c = valor >> 31;
+        return m->c ? 0xFFFFFFFFu : 0;
+    default:
+        n &= 31;
+        if (n == 0) {
+            m->c = valor >> 31;
+            return valor;
+        }
+        valor = (valor >> n) | (valor << (32 - n));
+        m->c = valor >> 31;
+        return valor;
+    }
+}
+
+static bool condicao(const m0_t *m, uint8_t cond) {
+    switch (cond) {
+    case 0x0: return m->z;
+    case 0x1: return !m->z;
+    case 0x2: return m->c;
+    case 0x3: return !m->c;
+    case 0x4: return m->n;
+    case 0x5: return !m->n;
+    case 0x6: return m->v;
+    case 0x7: return !m->v;
+    case 0x8: return m->c && !m->z;
+    case 0x9: return !m->c || m->z;
+    case 0xA: return m->n == m->v;
+    case 0xB: return m->n != m->v;
+    case 0xC: return !m->z && m->n == m->v;
+    case 0xD: return m->z || m->n != m->v;
+    default: return true;
+    }
+}
+
+static uint32_t estender(uint32_t valor, uint8_t bits) {
+    uint32_t sinal = 1u << (bits - 1);
+    return (valor ^ sinal) - sinal;
+}
+
+// -------------------- Execucao --------------------
+// Desvio para um endereco Thumb (bit 0 em 1, descartado).
+static bool desviar_bx(m0_t *m, uint32_t destino) {
+    if (!(destino & 1))
+        return falhar(m, "desvio para estado ARM em", destino);
+    m->r[PC] = destino & ~1u;
+    return true;
+}
+
+static bool empilhar(m0_t *m, uint32_t lista) {
+    uint32_t sp = m->r[SP] - 4u * (uint32_t)__builtin_popcount(lista);
+    uint32_t endereco = sp;
+    for (uint8_t i = 0; i < 16; i++) {
+        if (lista & (1u << i)) {
+            if (!escrever(m, endereco, 4, m->r[i]))
+                return false;
+            endereco += 4;
+        }
+    }
+    m->r[SP] = sp;
+    return true;
+}
+
+// Executa uma instrucao; *ciclos recebe o custo base (as faltas da XIP
+// somam direto em m->ciclos).
+static bool passo(m0_t *m, uint32_t *ciclos) {
+    uint32_t pc = m->r[PC];
+    uint16_t i;
+    m->pc_instrucao = pc;
+    if (!buscar(m, pc, &i))
+        return false;
+
+    uint32_t *r = m->r;
+    uint32_t lido = pc + 4; // valor de PC visto pela instrucao
+    r[PC] = pc + 2;
+    *ciclos = 1;
+
+    uint8_t rd = i & 7;
+    uint8_t rn = (i >> 3) & 7;
+
+    switch (i >> 11) {
+    case 0x00: case 0x01: case 0x02: { // LSLS/LSRS/ASRS imediato
+        uint8_t tipo = (uint8_t)(i >> 11);
+        uint32_t n = (i >> 6) & 31;
+        if (n == 0 && tipo != 0)
+            n = 32;
+        r[rd] = deslocar(m, tipo, r[rn], n);
+        flags_nz(m, r[rd]);
+        return true;
+    }
+    case 0x03: { // ADDS/SUBS registrador ou imediato de 3 bits
+        uint32_t op = (i & 0x0400) ? (i >> 6) & 7 : r[(i >> 6) & 7];
+        r[rd] = (i & 0x0200) ? somar(m, r[rn], ~op, 1) : somar(m, r[rn], op, 0);
+        return true;
+    }
+    case 0x04: // MOVS imediato
+        r[(i >> 8) & 7] = i & 0xFF;
+        flags_nz(m, i & 0xFF);
+        return true;
+    case 0x05: // CMP imediato
+        somar(m, r[(i >> 8) & 7], ~(uint32_t)(i & 0xFF), 1);
+        return true;
+    case 0x06: { // ADDS imediato
+        uint8_t d = (i >> 8) & 7;
+        r[d] = somar(m, r[d], i & 0xFF, 0);
+        return true;
+    }
+    case 0x07: { // SUBS imediato
+        uint8_t d = (i >> 8) & 7;
+        r[d] = somar(m, r[d], ~(uint32_t)(i & 0xFF), 1);
+        return true;
+    }
+    case 0x08:
+        if (!(i & 0x0400)) { // processamento de dados
+            uint32_t a = r[rd], b = r[rn];
+            switch ((i >> 6) & 15) {
+            case 0x0: r[rd] = a & b; flags_nz(m, r[rd]); break;                       // ANDS
+            case 0x1: r[rd] = a ^ b; flags_nz(m, r[rd]); break;                       // EORS
+            case 0x2: r[rd] = deslocar(m, 0, a, b & 0xFF); flags_nz(m, r[rd]); break; // LSLS
+            case 0x3: r[rd] = deslocar(m, 1, a, b & 0xFF); flags_nz(m, r[rd]); break; // LSRS
+            case 0x4: r[rd] = deslocar(m, 2, a, b & 0xFF); flags_nz(m, r[rd]); break; // ASRS
+            case 0x5: r[rd] = somar(m, a, b, m->c); break;                            // ADCS
+            case 0x6: r[rd] = somar(m, a, ~b, m->c); break;                           // SBCS
+            case 0x7: r[rd] = deslocar(m, 3, a, b & 0xFF); flags_nz(m, r[rd]); break; // RORS
+            case 0x8: flags_nz(m, a & b); break;                                      // TST
+            case 0x9: r[rd] = somar(m, 0, ~b, 1); break;                              // RSBS (NEG)
+            case 0xA: somar(m, a, ~b, 1); break;                                      // CMP
+            case 0xB: somar(m, a, b, 0); break;                                       // CMN
+            case 0xC: r[rd] = a | b; flags_nz(m, r[rd]); break;                       // ORRS
+            case 0xD: r[rd] = a * b; flags_nz(m, r[rd]); break;                       // MULS (1 ciclo)
+            case 0xE: r[rd] = a & ~b; flags_nz(m, r[rd]); break;                      // BICS
+            default:  r[rd] = ~b; flags_nz(m, r[rd]); break;                          // MVNS
+            }
+            return true;
+        } else { // registradores altos e BX/BLX
+            uint8_t d = (uint8_t)((i & 7) | ((i >> 4) & 8));
+            uint8_t s = (i >> 3) & 15;
+            uint32_t valor = s == PC ? lido : r[s];
+            switch ((i >> 8) & 3) {
+            case 0: // ADD
+                if (d == PC) {
+                    *ciclos = 2;
+                    r[PC] = (lido + valor) & ~1u;
+                } else {
+                    r[d] += valor;
+                }
+                return true;
+            case 1: // CMP
+                somar(m, d == PC ? lido : r[d], ~valor, 1);
+                return true;
+            case 2: // MOV
+                if (d == PC) {
+                    *ciclos = 2;
+                    r[PC] = valor & ~1u;
+                } else {
+                    r[d] = valor;
+                }
+                return true;
+            default: // BX / BLX
+                *ciclos = 2;
+                if (i & 0x80)
+                    r[LR] = (pc + 2) | 1u;
+                return desviar_bx(m, valor);
+            }
+        }
+    case 0x09: { // LDR literal
+        uint32_t valor;
+        *ciclos = 2;
+        if (!ler(m, (lido & ~3u) + (i & 0xFFu) * 4u, 4, &valor))
+            return false;
+        r[(i >> 8) & 7] = valor;
+        return true;
+    }
+    case 0x0A: case 0x0B: { // load/store com registrador de deslocamento
+        uint32_t endereco = r[rn] + r[(i >> 6) & 7];
+        uint32_t valor;
+        *ciclos = 2;
+        switch ((i >> 9) & 7) {
+        case 0: return escrever(m, endereco, 4, r[rd]);       // STR
+        case 1: return escrever(m, endereco, 2, r[rd]);       // STRH
+        case 2: return escrever(m, endereco, 1, r[rd]);       // STRB
+        case 3:                                               // LDRSB
+            if (!ler(m, endereco, 1, &valor))
+                return false;
+            r[rd] = estender(valor, 8);
+            return true;
+        case 4: return ler(m, endereco, 4, &r[rd]);           // LDR
+        case 5: return ler(m, endereco, 2, &r[rd]);           // LDRH
+        case 6: return ler(m, endereco, 1, &r[rd]);           // LDRB
+        default:                                              // LDRSH
+            if (!ler(m, endereco, 2, &valor))
+                return false;
+            r[rd] = estender(valor, 16);
+            return true;
+        }
+    }
+    case 0x0C: case 0x0D: case 0x0E: case 0x0F: case 0x10: case 0x11: {
+        // STR/LDR (palavra, byte, meia palavra) com imediato de 5 bits
+        static const uint8_t tamanhos[] = { 4, 4, 1, 1, 2, 2 };
+        uint8_t tipo = (uint8_t)((i >> 11) - 0x0C);
+        uint32_t tamanho = tamanhos[tipo];
+        uint32_t endereco = r[rn] + ((i >> 6) & 31) * tamanho;
+        *ciclos = 2;
+        if (tipo & 1)
+            return ler(m, endereco, tamanho, &r[rd]);
+        return escrever(m, endereco, tamanho, r[rd]);
+    }
+    case 0x12: // STR relativo ao SP
+        *ciclos = 2;
+        return escrever(m, r[SP] + (i & 0xFFu) * 4u, 4, r[(i >> 8) & 7]);
+    case 0x13: // LDR relativo ao SP
+        *ciclos = 2;
+        return ler(m, r[SP] + (i & 0xFFu) * 4u, 4, &r[(i >> 8) & 7]);
+    case 0x14: // ADR
+        r[(i >> 8) & 7] = (lido & ~3u) + (i & 0xFFu) * 4u;
+        return true;
+    case 0x15: // ADD Rd, SP, #imm
+        r[(i >> 8) & 7] = r[SP] + (i & 0xFFu) * 4u;
+        return true;
+    case 0x16: case 0x17: // diversas
+        if ((i & 0xFF00) == 0xB000) {
+            uint32_t imediato = (i & 0x7Fu) * 4u;
+            r[SP] = (i & 0x80) ? r[SP] - imediato : r[SP] + imediato;
+            return true;
+        }
+        if ((i & 0xFF00) == 0xB200) {
+            uint32_t v = r[rn];
+            switch ((i >> 6) & 3) {
+            case 0: r[rd] = estender(v & 0xFFFF, 16); break; // SXTH
+            case 1: r[rd] = estender(v & 0xFF, 8); break;    // SXTB
+            case 2: r[rd] = v & 0xFFFF; break;               // UXTH
+            default: r[rd] = v & 0xFF; break;                // UXTB
+            }
+            return true;
+        }
+        if ((i & 0xFE00) == 0xB400) { // PUSH
+            uint32_t lista = (i & 0xFFu) | ((i & 0x100u) ? 1u << LR : 0);
+            *ciclos = 1 + (uint32_t)__builtin_popcount(lista);
+            return empilhar(m, lista);
+        }
+        if ((i & 0xFFEF) == 0xB662) { // CPSIE/CPSID i
+            m->primask = i & 0x10;
+            return true;
+        }
+        if ((i & 0xFF00) == 0xBA00 && ((i >> 6) & 3) != 2) {
+            uint32_t v = r[rn];
+            switch ((i >> 6) & 3) {
+            case 0: r[rd] = __builtin_bswap32(v); break;                               // REV
+            case 1: r[rd] = ((v & 0x00FF00FFu) << 8) | ((v >> 8) & 0x00FF00FFu); break; // REV16
+            default: r[rd] = estender(((v & 0xFF) << 8) | ((v >> 8) & 0xFF), 16); break; // REVSH
+            }
+            return true;
+        }
+        if ((i & 0xFE00) == 0xBC00) { // POP
+            uint32_t lista = (i & 0xFFu) | ((i & 0x100u) ? 1u << PC : 0);
+            uint32_t endereco = r[SP];
+            uint32_t destino = 0;
+            *ciclos = 1 + (uint32_t)__builtin_popcount(lista);
+            for (uint8_t k = 0; k < 16; k++) {
+                if (!(lista & (1u << k)))
+                    continue;
+                uint32_t valor;
+                if (!ler(m, endereco, 4, &valor))
+                    return false;
+                if (k == PC)
+                    destino = valor;
+                else
+                    r[k] = valor;
+                endereco += 4;
+            }
+            r[SP] = endereco;
+            if (lista & (1u << PC)) {
+                *ciclos += 2;
+                return desviar_bx(m, destino);
+            }
+            return true;
+        }
+        if ((i & 0xFF00) == 0xBE00)
+            return falhar(m, "BKPT em", pc);
+        if ((i & 0xFF0F) == 0xBF00 && (i & 0xF0) <= 0x40) // NOP, YIELD, WFE, WFI, SEV
+            return true;
+        return falhar(m, "instrucao invalida em", pc);
+    case 0x18: case 0x19: { // STMIA / LDMIA
+        uint8_t base = (i >> 8) & 7;
+        uint32_t lista = i & 0xFFu;
+        uint32_t endereco = r[base];
+        bool carga = i & 0x0800;
+        *ciclos = 1 + (uint32_t)__builtin_popcount(lista);
+        for (uint8_t k = 0; k < 8; k++) {
+            if (!(lista & (1u << k)))
+                continue;
+            if (carga ? !ler(m, endereco, 4, &r[k]) : !escrever(m, endereco, 4, r[k]))
+                return false;
+            endereco += 4;
+        }
+        if (!carga || !(lista & (1u << base)))
+            r[base] = endereco;
+        return true;
+    }
+    case 0x1A: case 0x1B: { // B condicional, UDF, SVC
+        uint8_t cond = (i >> 8) & 15;
+        if (cond == 0xE)
+            return falhar(m, "UDF em", pc);
+        if (cond == 0xF)
+            return falhar(m, "SVC em", pc);
+        if (condicao(m, cond)) {
+            *ciclos = 2;
+            r[PC] = lido + (estender(i & 0xFFu, 8) << 1);
+        }
+        return true;
+    }
+    case 0x1C: // B
+        *ciclos = 2;
+        r[PC] = lido + (estender(i & 0x7FFu, 11) << 1);
+        return true;
+    case 0x1E: case 0x1F: { // instrucoes de 32 bits
+        uint16_t i2;
+        if (!buscar(m, pc + 2, &i2))
+            return false;
+        r[PC] = pc + 4;
+
+        if ((i & 0xF800) == 0xF000 && (i2 & 0xD000) == 0xD000) { // BL
+            uint32_t s = (i >> 10) & 1;
+            uint32_t i1 = !(((i2 >> 13) & 1) ^ s);
+            uint32_t j2 = !(((i2 >> 11) & 1) ^ s);
+            uint32_t deslocamento = (s << 24) | (i1 << 23) | (j2 << 22) |
+                                    ((i & 0x3FFu) << 12) | ((i2 & 0x7FFu) << 1);
+            *ciclos = 3;
+            r[LR] = (pc + 4) | 1u;
+            r[PC] = pc + 4 + estender(deslocamento, 25);
+            return true;
+        }
+        if ((i & 0xFFF0) == 0xF380 && (i2 & 0xFF00) == 0x8800) { // MSR
+            uint32_t valor = r[i & 15];
+            *ciclos = 3;
+            switch (i2 & 0xFF) {
+            case 0x00: // APSR
+                m->n = valor >> 31;
+                m->z = (valor >> 30) & 1;
+                m->c = (valor >> 29) & 1;
+                m->v = (valor >> 28) & 1;
+                break;
+            case 0x08:
+                r[SP] = valor & ~3u;
+                break;
+            case 0x10:
+                m->primask = valor & 1;
+                break;
+            default:
+                break;
+            }
+            return true;
+        }
+        if (i == 0xF3EF && (i2 & 0xF000) == 0x8000) { // MRS
+            uint8_t d = (i2 >> 8) & 15;
+            *ciclos = 3;
+            switch (i2 & 0xFF) {
+            case 0x00: case 0x03:
+                r[d] = (uint32_t)m->n << 31 | (uint32_t)m->z << 30 | (uint32_t)m->c << 29 | (uint32_t)m->v << 28;
+                break;
+            case 0x08: case 0x09:
+                r[d] = r[SP];
+                break;
+            case 0x10:
+                r[d] = m->primask;
+                break;
+            default:
+                r[d] = 0;
+                break;
+            }
+            return true;
+        }
+        if (i == 0xF3BF && (i2 & 0xFF00) == 0x8F00) { // DSB, DMB, ISB
+            *ciclos = 3;
+            return true;
+        }
+        return falhar(m, "instrucao de 32 bits invalida em", pc);
+    }
+    default:
+        return falhar(m, "instrucao invalida em", pc);
+    }
+}
+
+bool m0_chamar(m0_t *m, uint32_t endereco, const uint32_t *argumentos, uint8_t num_argumentos, uint64_t limite) {
+    memset(m->r, 0, sizeof(m->r));
+    for (uint8_t k = 0; k < num_argumentos && k < 4; k++)
+        m->r[k] = argumentos[k];
+    m->r[SP] = M0_PILHA_TOPO;
+    m->r[LR] = M0_RETORNO | 1u;
+    m->r[PC] = endereco & ~1u;
+    m->erro[0] = '\0';
+
+    uint64_t fim = m->instrucoes + limite;
+    while (m->r[PC] != M0_RETORNO) {
+        if (m->instrucoes >= fim)
+            return falhar(m, "limite de instrucoes excedido; ultimo destino", m->r[PC]);
+
+        bool interceptado = false;
+        for (uint8_t k = 0; k < m->num_interceptos; k++) {
+            if (m->interceptos[k].endereco == m->r[PC]) {
+                m->ciclos += m->interceptos[k].funcao(m->r);
+                m->instrucoes++;
+                if (!desviar_bx(m, m->r[LR]))
+                    return false;
+                interceptado = true;
+                break;
+            }
+        }
+        if (interceptado)
+            continue;
+
+        uint32_t ciclos;
+        if (!passo(m, &ciclos))
+            return false;
+        m->ciclos += ciclos;
+        m->instrucoes++;
+    }
+    return true;
+}
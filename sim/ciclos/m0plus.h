@@ -0,0 +1,84 @@
+#ifndef M0PLUS_H
+#define M0PLUS_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// -------------------- Emulador do Cortex-M0+ --------------------
+// Interpretador do conjunto ARMv6-M (Thumb de 16 bits, mais BL, MSR, MRS e
+// barreiras) com a contagem de ciclos do Cortex-M0+ do RP2040:
+//  - dados e desvios pela tabela de tempos do TRM (multiplicador de um
+//    ciclo, configuracao do RP2040);
+//  - busca de instrucoes e leituras na flash passam por um modelo da cache
+//    da XIP (16 KB, 2 vias, linhas de 8 bytes); cada falta soma
+//    falta_xip ciclos. A SRAM responde sem espera.
+// Chamadas a enderecos interceptados (por exemplo as rotinas de divisao do
+// SDK, que usam o divisor do SIO) sao resolvidas no hospedeiro com um
+// custo fixo.
+
+#define M0_FLASH_BASE    0x10000000u
+#define M0_FLASH_TAMANHO (2u * 1024u * 1024u)
+#define M0_SRAM_BASE     0x20000000u
+#define M0_SRAM_TAMANHO  (264u * 1024u)
+#define M0_PILHA_TOPO    (M0_SRAM_BASE + M0_SRAM_TAMANHO)
+
+// Endereco de retorno das chamadas do hospedeiro (regiao da ROM): quando o
+// alvo retorna para ele, m0_chamar termina.
+#define M0_RETORNO 0x00000100u
+
+#define M0_XIP_LINHA      8
+#define M0_XIP_VIAS       2
+#define M0_XIP_CONJUNTOS  (16u * 1024u / M0_XIP_LINHA / M0_XIP_VIAS)
+#define M0_FALTA_XIP_PADRAO 50 // ciclos por linha buscada na flash QSPI
+
+#define M0_INTERCEPTOS_MAX 8
+
+// Executa a funcao interceptada: le os argumentos de r[0..3], escreve o
+// resultado em r[0] (e r[1]) e retorna os ciclos que ela custaria.
+typedef uint32_t (*m0_intercepto_t)(uint32_t *r);
+
+typedef struct {
+    uint32_t r[16];
+    bool n, z, c, v;
+    bool primask;
+
+    uint8_t *flash;
+    uint8_t *sram;
+
+    uint32_t xip_tag[M0_XIP_CONJUNTOS][M0_XIP_VIAS]; // 0 = linha vazia
+    uint8_t xip_recente[M0_XIP_CONJUNTOS];           // via usada por ultimo
+    uint32_t falta_xip;
+
+    struct {
+        uint32_t endereco;
+        m0_intercepto_t funcao;
+    } interceptos[M0_INTERCEPTOS_MAX];
+    uint8_t num_interceptos;
+
+    uint64_t ciclos;
+    uint64_t instrucoes;
+    uint64_t faltas_xip;
+
+    uint32_t pc_instrucao; // instrucao em execucao, para as mensagens de erro
+    char erro[128];        // preenchido quando m0_chamar falha
+} m0_t;
+
+bool m0_iniciar(m0_t *m);
+void m0_liberar(m0_t *m);
+
+// Copia dados para a flash ou a SRAM (carga do ELF).
+bool m0_carregar(m0_t *m, uint32_t endereco, const void *dados, size_t tamanho);
+
+// Esvazia a cache da XIP: a proxima chamada comeca fria.
+void m0_esvaziar_cache(m0_t *m);
+
+bool m0_interceptar(m0_t *m, uint32_t endereco, m0_intercepto_t funcao);
+
+// Chama a funcao Thumb em endereco com ate quatro argumentos e executa ate
+// ela retornar. ciclos, instrucoes e faltas_xip acumulam. Falha (com
+// m->erro) em instrucao invalida, acesso fora da memoria ou desalinhado,
+// BKPT/SVC ou mais de limite instrucoes.
+bool m0_chamar(m0_t *m, uint32_t endereco, const uint32_t *argumentos, uint8_t num_argumentos, uint64_t limite);
+
+#endif
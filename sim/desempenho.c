@@ -0,0 +1,212 @@
+// Microbenchmarks das primitivas de desenho (lib/ssd1306.c) e do quadro
+// completo da vDisplayTask (lib/painel.c), no host. Cada caso roda em
+// lotes ate somar --tempo-ms; vale a mediana de 5 rodadas, em ns por
+// operacao e ns por pixel escrito. O quadro tambem passa por um transporte
+// I2C falso que conta o que iria para o display.
+//
+//   estacao_desempenho [--json] [--tempo-ms N] [caso...]
+//
+// Os tempos sao do host: servem para comparar versoes das primitivas entre
+// si, nao para estimar o custo no RP2040.
+#define _POSIX_C_SOURCE 200809L
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include "ssd1306.h"
+#include "painel.h"
+
+#define RODADAS 5
+
+// -------------------- Transporte --------------------
+static uint32_t transacoes, bytes_enviados;
+
+int i2c_write_timeout_us(i2c_inst_t *i2c, uint8_t endereco, const uint8_t *dados, size_t tamanho, bool sem_stop,
+                         uint timeout_us) {
+    (void)i2c;
+    (void)endereco;
+    (void)dados;
+    (void)sem_stop;
+    (void)timeout_us;
+    transacoes++;
+    bytes_enviados += (uint32_t)tamanho;
+    return (int)tamanho;
+}
+
+// -------------------- Casos --------------------
+static ssd1306_t display;
+static uint32_t iteracao;
+
+static void caso_fill(void) {
+    ssd1306_fill(&display, iteracao & 1);
+}
+
+static void caso_rect_contorno(void) {
+    ssd1306_rect(&display, 3, 3, 122, 60, true, false);
+}
+
+static void caso_rect_cheio(void) {
+    ssd1306_rect(&display, 10, 20, 40, 24, true, true);
+}
+
+static void caso_line_horizontal(void) {
+    ssd1306_line(&display, 3, 25, 123, 25, true);
+}
+
+static void caso_line_vertical(void) {
+    ssd1306_line(&display, 63, 41, 63, 60, true);
+}
+
+static void caso_line_diagonal(void) {
+    ssd1306_line(&display, 0, 0, 127, 63, true);
+}
+
+static void caso_hline(void) {
+    ssd1306_hline(&display, 3, 123, 25, true);
+}
+
+static void caso_vline(void) {
+    ssd1306_vline(&display, 63, 0, 63, true);
+}
+
+static void caso_draw_char(void) {
+    ssd1306_draw_char(&display, (char)('A' + iteracao % 26), 60, 28);
+}
+
+static void caso_draw_string(void) {
+    ssd1306_draw_string(&display, "EMBARCATECH", 20, 16);
+}
+
+// Como na vDisplayTask: desenho + envio, alternando normal e alerta
+static void caso_painel(void) {
+    bool alerta = iteracao & 1;
+    painel_desenhar(&display, (uint16_t)(iteracao % 1000), 305, alerta);
+    ssd1306_send_data(&display);
+}
+
+typedef struct {
+    const char *nome;
+    void (*executar)(void);
+    uint32_t pixels; // pixels escritos por operacao
+} caso_t;
+
+static const caso_t casos[] = {
+    { "fill", caso_fill, WIDTH * HEIGHT },
+    { "rect_contorno", caso_rect_contorno, 2 * 122 + 2 * 60 },
+    { "rect_cheio", caso_rect_cheio, 2 * 40 + 2 * 24 + 38 * 22 },
+    { "line_horizontal", caso_line_horizontal, 121 },
+    { "line_vertical", caso_line_vertical, 20 },
+    { "line_diagonal", caso_line_diagonal, 128 },
+    { "hline", caso_hline, 121 },
+    { "vline", caso_vline, 64 },
+    { "draw_char", caso_draw_char, 64 },
+    { "draw_string", caso_draw_string, 11 * 64 },
+    { "painel", caso_painel, WIDTH * HEIGHT }, // o fill ja escreve todos
+};
+
+static uint64_t agora_ns(void) {
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return (uint64_t)t.tv_sec * 1000000000u + (uint64_t)t.tv_nsec;
+}
+
+static uint64_t executar_lote(const caso_t *caso, uint32_t n) {
+    uint64_t inicio = agora_ns();
+    for (uint32_t i = 0; i < n; i++, iteracao++)
+        caso->executar();
+    return agora_ns() - inicio;
+}
+
+static int comparar_double(const void *a, const void *b) {
+    double x = *(const double *)a, y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+// ns por operacao: dobra o lote ate ocupar a fatia de uma rodada e fica
+// com a mediana das rodadas.
+static double medir(const caso_t *caso, uint32_t tempo_ms) {
+    uint64_t fatia_ns = (uint64_t)tempo_ms * 1000000u / RODADAS;
+    uint32_t n = 1;
+    while (executar_lote(caso, n) < fatia_ns / 8 && n < (1u << 30))
+        n *= 2;
+    n = n * 8;
+
+    double rodadas[RODADAS];
+    for (int r = 0; r < RODADAS; r++)
+        rodadas[r] = (double)executar_lote(caso, n) / n;
+    qsort(rodadas, RODADAS, sizeof(rodadas[0]), comparar_double);
+    return rodadas[RODADAS / 2];
+}
+
+static bool selecionado(const char *nome, int argc, char **argv, int primeiro) {
+    if (primeiro >= argc)
+        return true;
+    for (int i = primeiro; i < argc; i++) {
+        if (strcmp(argv[i], nome) == 0)
+            return true;
+    }
+    return false;
+}
+
+int main(int argc, char **argv) {
+    bool json = false;
+    uint32_t tempo_ms = 200;
+    int arg = 1;
+    for (; arg < argc && argv[arg][0] == '-'; arg++) {
+        if (strcmp(argv[arg], "--json") == 0) {
+            json = true;
+        } else if (strcmp(argv[arg], "--tempo-ms") == 0 && arg + 1 < argc) {
+            tempo_ms = (uint32_t)strtoul(argv[++arg], NULL, 10);
+        } else {
+            fprintf(stderr, "uso: %s [--json] [--tempo-ms N] [caso...]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    ssd1306_init(&display, WIDTH, HEIGHT, false, 0x3C, NULL);
+
+    // Um quadro do painel pelo transporte: o que a vDisplayTask envia a
+    // cada periodo_display_ms
+    transacoes = bytes_enviados = 0;
+    painel_desenhar(&display, 453, 120, false);
+    ssd1306_send_data(&display);
+    uint32_t quadro_transacoes = transacoes, quadro_bytes = bytes_enviados;
+    uint32_t painel_pixels = 0;
+    for (size_t i = 1; i < display.bufsize; i++)
+        painel_pixels += (uint32_t)__builtin_popcount(display.ram_buffer[i]);
+
+    // A 400 kHz: 9 bits por byte (com o ACK), mais start, endereco e stop
+    // (11 bits) por transacao
+    double quadro_us = (quadro_bytes * 9.0 + quadro_transacoes * 11.0) / 400e3 * 1e6;
+
+    if (json)
+        printf("{\n  \"casos\": [");
+    else
+        printf("%-16s %12s %10s %10s\n", "caso", "ns/op", "pixels/op", "ns/pixel");
+
+    bool primeiro = true;
+    for (size_t i = 0; i < count_of(casos); i++) {
+        const caso_t *caso = &casos[i];
+        if (!selecionado(caso->nome, argc, argv, arg))
+            continue;
+
+        uint32_t pixels = caso->pixels;
+        double ns = medir(caso, tempo_ms);
+        if (json) {
+            printf("%s\n    {\"nome\": \"%s\", \"ns_op\": %.1f, \"pixels_op\": %u, \"ns_pixel\": %.3f}",
+                   primeiro ? "" : ",", caso->nome, ns, pixels, ns / pixels);
+        } else {
+            printf("%-16s %12.1f %10u %10.3f\n", caso->nome, ns, pixels, ns / pixels);
+        }
+        primeiro = false;
+    }
+
+    if (json) {
+        printf("\n  ],\n  \"quadro\": {\"bytes\": %u, \"transacoes\": %u, \"pixels_acesos\": %u, \"us_i2c_400k\": %.0f}\n}\n",
+               quadro_bytes, quadro_transacoes, painel_pixels, quadro_us);
+    } else {
+        printf("\nquadro: %u bytes em %u transacoes (%u pixels acesos), ~%.0f us no I2C a 400 kHz\n",
+               quadro_bytes, quadro_transacoes, painel_pixels, quadro_us);
+    }
+    free(display.ram_buffer);
+    return 0;
+}
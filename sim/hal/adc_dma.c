@@ -0,0 +1,308 @@
+#include <string.h>
+#include "hal_sim.h"
+#include "falhas.h"
+#include "hardware/adc.h"
+#include "hardware/dma.h"
+#include "hardware/irq.h"
+#include "hardware/clocks.h"
+
+adc_hw_t hal_sim_adc_hw;
+dma_hw_t hal_sim_dma_hw;
+
+// -------------------- ADC --------------------
+// Conversao de 96 ciclos do clk_adc; com divisor, uma a cada (1 + div)
+// ciclos. Em round-robin a entrada avanca para o proximo bit da mascara
+// depois de cada conversao, como no RP2040.
+#define ADC_CICLOS_MIN 96u
+
+static hal_sim_fonte_adc_t fonte = hal_sim_fonte_padrao;
+static uint entrada;
+static uint mascara_rr;
+static float divisor;
+static bool rodando;
+static bool fifo_habilitado;
+static uint64_t resto; // conversoes fracionarias entre ticks, em Hz * us
+
+void hal_sim_definir_fonte_adc(hal_sim_fonte_adc_t nova) {
+    fonte = nova;
+}
+
+// xorshift32: ruido reprodutivel de uma execucao para outra
+static uint32_t semente_ruido = 2463534242u;
+
+static int32_t ruido(int32_t amplitude) {
+    semente_ruido ^= semente_ruido << 13;
+    semente_ruido ^= semente_ruido >> 17;
+    semente_ruido ^= semente_ruido << 5;
+    return (int32_t)(semente_ruido % (uint32_t)(2 * amplitude + 1)) - amplitude;
+}
+
+uint16_t hal_sim_fonte_padrao(uint canal, uint64_t tempo_us) {
+    const uint64_t periodo_us = 40000000u;
+    int32_t valor;
+    if (canal == 0) {
+        uint64_t fase = tempo_us % periodo_us;
+        uint64_t tri = fase < periodo_us / 2 ? fase : periodo_us - fase; // 0 .. periodo/2
+        valor = (int32_t)(4095u * 20u / 100u + tri * (4095u * 70u / 100u) / (periodo_us / 2));
+    } else {
+        valor = 4095 * 30 / 100;
+    }
+    valor += ruido(3);
+    if (valor < 0)
+        valor = 0;
+    if (valor > 4095)
+        valor = 4095;
+    return (uint16_t)valor;
+}
+
+void adc_init(void) {
+    memset(&hal_sim_adc_hw, 0, sizeof(hal_sim_adc_hw));
+    entrada = 0;
+    mascara_rr = 0;
+    divisor = 0.0f;
+    rodando = false;
+    fifo_habilitado = false;
+    hal_sim_registrar("adc", "init", 0, 0);
+}
+
+void adc_gpio_init(uint gpio) {
+    gpio_set_function(gpio, GPIO_FUNC_NULL);
+    hal_sim_registrar("adc", "gpio", gpio, gpio - 26);
+}
+
+void adc_select_input(uint nova) {
+    entrada = nova;
+}
+
+uint adc_get_selected_input(void) {
+    return entrada;
+}
+
+void adc_set_round_robin(uint mascara) {
+    mascara_rr = mascara & 0x1Fu;
+    hal_sim_registrar("adc", "round_robin", mascara_rr, 0);
+}
+
+void adc_fifo_setup(bool habilitar, bool dreq, uint limiar, bool erro, bool byte) {
+    (void)dreq;
+    (void)limiar;
+    (void)erro;
+    (void)byte;
+    fifo_habilitado = habilitar;
+}
+
+void adc_set_clkdiv(float novo) {
+    divisor = novo;
+    hal_sim_adc_hw.div = (uint32_t)(novo * 256.0f);
+    hal_sim_registrar("adc", "clkdiv", (uint32_t)novo, hal_sim_adc_hw.div & 0xFFu);
+}
+
+void adc_run(bool rodar) {
+    rodando = rodar;
+    hal_sim_registrar("adc", "run", rodar, 0);
+}
+
+void adc_fifo_drain(void) {
+}
+
+static uint16_t converter(uint64_t tempo_us) {
+    uint16_t valor = falhas_adc(entrada, tempo_us, fonte(entrada, tempo_us) & 0xFFFu);
+    if (mascara_rr) {
+        do {
+            entrada = (entrada + 1) % 5;
+        } while (!(mascara_rr & (1u << entrada)));
+    }
+    hal_sim_adc_hw.result = valor;
+    hal_sim_contadores.adc_amostras++;
+    return valor;
+}
+
+uint16_t adc_read(void) {
+    return converter(time_us_64());
+}
+
+static uint32_t taxa_hz(void) {
+    uint32_t ciclos = (uint32_t)(1.0f + divisor);
+    if (ciclos < ADC_CICLOS_MIN)
+        ciclos = ADC_CICLOS_MIN;
+    return clock_get_hz(clk_adc) / ciclos;
+}
+
+// -------------------- DMA --------------------
+static uint32_t canais_usados;
+static dma_channel_config configs[NUM_DMA_CHANNELS];
+static uint32_t ocupados;
+static irq_handler_t handlers[NUM_IRQS];
+static uint32_t irqs_habilitadas;
+
+int dma_claim_unused_channel(bool obrigatorio) {
+    for (uint canal = 0; canal < NUM_DMA_CHANNELS; canal++) {
+        if (!(canais_usados & (1u << canal))) {
+            canais_usados |= 1u << canal;
+            return (int)canal;
+        }
+    }
+    if (obrigatorio) {
+        fprintf(stderr, "hal_sim: nenhum canal de DMA livre\n");
+        abort();
+    }
+    return -1;
+}
+
+void dma_channel_unclaim(uint canal) {
+    canais_usados &= ~(1u << canal);
+}
+
+dma_channel_config dma_channel_get_default_config(uint canal) {
+    dma_channel_config c = {
+        .tamanho = DMA_SIZE_32,
+        .incrementa_leitura = true,
+        .incrementa_escrita = false,
+        .dreq = DREQ_FORCE,
+        .encadear = (uint8_t)canal
+    };
+    return c;
+}
+
+void channel_config_set_transfer_data_size(dma_channel_config *c, enum dma_channel_transfer_size tamanho) {
+    c->tamanho = (uint8_t)tamanho;
+}
+
+void channel_config_set_read_increment(dma_channel_config *c, bool incrementa) {
+    c->incrementa_leitura = incrementa;
+}
+
+void channel_config_set_write_increment(dma_channel_config *c, bool incrementa) {
+    c->incrementa_escrita = incrementa;
+}
+
+void channel_config_set_ring(dma_channel_config *c, bool escrita, uint bits) {
+    c->anel_na_escrita = escrita;
+    c->anel_bits = (uint8_t)bits;
+}
+
+void channel_config_set_dreq(dma_channel_config *c, uint dreq) {
+    c->dreq = (uint8_t)dreq;
+}
+
+void channel_config_set_chain_to(dma_channel_config *c, uint canal) {
+    c->encadear = (uint8_t)canal;
+}
+
+void dma_channel_configure(uint canal, const dma_channel_config *c, volatile void *escrita,
+                           const volatile void *leitura, uint32_t contagem, bool iniciar) {
+    configs[canal] = *c;
+    hal_sim_dma_hw.ch[canal].write_addr = (uintptr_t)escrita;
+    hal_sim_dma_hw.ch[canal].read_addr = (uintptr_t)leitura;
+    dma_channel_set_trans_count(canal, contagem, iniciar);
+    hal_sim_registrar("dma", "configure", canal, c->dreq);
+}
+
+void dma_channel_set_trans_count(uint canal, uint32_t contagem, bool iniciar) {
+    hal_sim_dma_hw.ch[canal].transfer_count = contagem;
+    if (iniciar && contagem)
+        ocupados |= 1u << canal;
+}
+
+void dma_channel_set_irq0_enabled(uint canal, bool habilitar) {
+    if (habilitar)
+        hal_sim_dma_hw.inte0 |= 1u << canal;
+    else
+        hal_sim_dma_hw.inte0 &= ~(1u << canal);
+}
+
+bool dma_channel_is_busy(uint canal) {
+    return (ocupados & (1u << canal)) != 0;
+}
+
+void dma_channel_abort(uint canal) {
+    ocupados &= ~(1u << canal);
+}
+
+void irq_set_exclusive_handler(uint num, irq_handler_t handler) {
+    handlers[num] = handler;
+}
+
+void irq_set_enabled(uint num, bool habilitar) {
+    if (habilitar)
+        irqs_habilitadas |= 1u << num;
+    else
+        irqs_habilitadas &= ~(1u << num);
+}
+
+void hal_sim_irq(uint num) {
+    if ((irqs_habilitadas & (1u << num)) && handlers[num])
+        handlers[num]();
+}
+
+static uintptr_t avancar(uintptr_t endereco, const dma_channel_config *c, bool incrementa, bool anel) {
+    if (!incrementa)
+        return endereco;
+    uintptr_t proximo = endereco + (1u << c->tamanho);
+    if (anel && c->anel_bits) {
+        uintptr_t m = ((uintptr_t)1 << c->anel_bits) - 1;
+        proximo = (endereco & ~m) | (proximo & m);
+    }
+    return proximo;
+}
+
+static void escrever(uintptr_t endereco, uint32_t valor, uint8_t tamanho) {
+    switch (tamanho) {
+    case DMA_SIZE_8:
+        *(volatile uint8_t *)endereco = (uint8_t)valor;
+        break;
+    case DMA_SIZE_16:
+        *(volatile uint16_t *)endereco = (uint16_t)valor;
+        break;
+    default:
+        *(volatile uint32_t *)endereco = valor;
+        break;
+    }
+}
+
+// Uma conversao com DREQ_ADC: cada canal ocupado que le o FIFO do ADC
+// transfere uma amostra. Sem canal ocupado a amostra fica no FIFO.
+static void transferir_adc(uint16_t valor) {
+    hal_sim_adc_hw.fifo = valor;
+    for (uint canal = 0; canal < NUM_DMA_CHANNELS; canal++) {
+        const dma_channel_config *c = &configs[canal];
+        dma_channel_hw_t *ch = &hal_sim_dma_hw.ch[canal];
+        if (!(ocupados & (1u << canal)) || c->dreq != DREQ_ADC)
+            continue;
+
+        escrever(ch->write_addr, valor, c->tamanho);
+        ch->write_addr = avancar(ch->write_addr, c, c->incrementa_escrita, c->anel_na_escrita);
+        ch->read_addr = avancar(ch->read_addr, c, c->incrementa_leitura, !c->anel_na_escrita);
+        hal_sim_contadores.dma_transferencias++;
+
+        if (--ch->transfer_count == 0) {
+            ocupados &= ~(1u << canal);
+            hal_sim_dma_hw.intr |= 1u << canal;
+            if (hal_sim_dma_hw.inte0 & (1u << canal)) {
+                hal_sim_dma_hw.ints0 |= 1u << canal;
+                hal_sim_contadores.dma_irqs++;
+                if ((irqs_habilitadas & (1u << DMA_IRQ_0)) && handlers[DMA_IRQ_0])
+                    handlers[DMA_IRQ_0]();
+            }
+        }
+    }
+}
+
+// Chamada a cada tick com o intervalo que passou. Roda no contexto do tick,
+// entao nao registra eventos (so conta).
+void hal_sim_adc_dma_avancar(uint64_t tempo_us, uint32_t intervalo_us) {
+    if (!rodando)
+        return;
+
+    uint32_t taxa = taxa_hz();
+    resto += (uint64_t)taxa * intervalo_us;
+    uint64_t n = resto / 1000000u;
+    resto %= 1000000u;
+
+    uint64_t inicio = tempo_us - intervalo_us;
+    for (uint64_t i = 0; i < n; i++) {
+        uint16_t valor = converter(inicio + i * 1000000u / taxa);
+        if (fifo_habilitado)
+            transferir_adc(valor);
+    }
+}
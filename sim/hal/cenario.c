@@ -0,0 +1,760 @@
+#include <string.h>
+#include "cenario.h"
+#include "hal_sim.h"
+#include "falhas.h"
+#include "hardware/pwm.h"
+#include "config.h"
+#include "FreeRTOS.h"
+#include "task.h"
+#if ESTACAO_SIM_VIRTUAL
+#include "virtual.h"
+#endif
+
+#define CENARIO_GPIO_VERMELHO 13 // LED_R em DispFilaTasks.c
+#define CENARIO_GPIO_VERDE    11 // LED_G
+#define CENARIO_GPIO_BUZZER   21 // BUZZER
+
+#define NOME_MAX    24
+#define TEXTO_MAX   48
+#define PALAVRAS_MAX 8
+#define ORDEM_MAX   8
+
+typedef enum {
+    PASSO_ENTRADA,
+    PASSO_FALHA,     // inicio da falha
+    PASSO_FIM_FALHA
+} tipo_passo_t;
+
+typedef struct {
+    uint32_t tempo_ms;
+    tipo_passo_t tipo;
+    uint8_t canal;       // entrada: 0 nivel, 1 chuva
+    uint16_t centesimos;
+    int falha;           // indice em falhas.h
+    unsigned linha;      // desempata passos no mesmo instante
+    char nome[NOME_MAX]; // marca do instante, se houver
+} passo_t;
+
+typedef struct {
+    uint32_t tempo_ms;
+    char texto[TEXTO_MAX];
+} evento_t;
+
+typedef struct {
+    char nome[NOME_MAX];
+    uint32_t tempo_ms;
+    size_t ordem; // posicao do evento marcado + 1; 0 e o inicio
+} marca_t;
+
+typedef enum {
+    VERIFICAR_ESPERAR,
+    VERIFICAR_NUNCA,
+    VERIFICAR_CONTAR,
+    VERIFICAR_ORDEM
+} tipo_verificacao_t;
+
+typedef struct {
+    tipo_verificacao_t tipo;
+    unsigned linha;
+    char evento[TEXTO_MAX];
+    char apos[NOME_MAX];
+    char como[NOME_MAX];
+    char operador[3];  // "<=", "==", ">=" ou vazio
+    uint32_t limite;   // ms (esperar) ou quantidade (contar)
+    uint32_t por_ms;   // janela de nunca/contar; 0: ate o fim
+    char ordem[ORDEM_MAX][NOME_MAX];
+    uint8_t num_ordem;
+
+    // Resultado
+    bool ok;
+    bool medido;
+    uint32_t tempo_ms; // evento encontrado (esperar) ou que violou (nunca)
+    uint32_t medida;   // latencia em ms (esperar, nunca) ou contagem (contar)
+} verificacao_t;
+
+static passo_t *passos;
+static size_t num_passos;
+static verificacao_t *verificacoes;
+static size_t num_verificacoes;
+static evento_t *eventos;
+static size_t num_eventos;
+static marca_t *marcas;
+static size_t num_marcas;
+static uint32_t duracao_ms;
+static unsigned linha_falha[FALHAS_MAX];
+static const char *arquivo_json;
+
+// Estado das saidas, para derivar so as mudancas
+static bool vermelho, verde, buzzer;
+static uint32_t ultima_cor = UINT32_MAX;
+
+static void *crescer(void *vetor, size_t n, size_t *capacidade, size_t tamanho) {
+    if (n < *capacidade)
+        return vetor;
+    *capacidade = *capacidade ? *capacidade * 2 : 64;
+    vetor = realloc(vetor, *capacidade * tamanho);
+    if (vetor == NULL) {
+        fprintf(stderr, "cenario: sem memoria\n");
+        exit(1);
+    }
+    return vetor;
+}
+
+// -------------------- Entrada --------------------
+// Entrada limpa (sem as falhas do ADC) no instante, em centesimos de %
+static uint16_t entrada_em(uint canal, uint64_t tempo_us) {
+    uint16_t centesimos = 0;
+    for (size_t i = 0; i < num_passos && (uint64_t)passos[i].tempo_ms * 1000u <= tempo_us; i++) {
+        if (passos[i].tipo == PASSO_ENTRADA && passos[i].canal == canal)
+            centesimos = passos[i].centesimos;
+    }
+    return centesimos;
+}
+
+static uint16_t fonte_cenario(uint canal, uint64_t tempo_us) {
+    return (uint16_t)((entrada_em(canal, tempo_us) * 4095u + 5000u) / 10000u);
+}
+
+static void definir_marca(const char *nome, uint32_t tempo_ms, size_t ordem) {
+    static size_t capacidade;
+    marcas = crescer(marcas, num_marcas, &capacidade, sizeof(marca_t));
+    marca_t *m = &marcas[num_marcas++];
+    snprintf(m->nome, sizeof(m->nome), "%s", nome);
+    m->tempo_ms = tempo_ms;
+    m->ordem = ordem;
+}
+
+static const marca_t *buscar_marca(const char *nome) {
+    for (size_t i = num_marcas; i-- > 0;) {
+        if (strcmp(marcas[i].nome, nome) == 0)
+            return &marcas[i];
+    }
+    return NULL;
+}
+
+// Acima das tarefas do firmware: o degrau e registrado antes da reacao
+static void vCenarioTask(void *params) {
+    (void)params;
+    for (size_t i = 0; i < num_passos; i++) {
+        const passo_t *p = &passos[i];
+        int32_t falta = (int32_t)(p->tempo_ms - xTaskGetTickCount());
+        if (falta > 0)
+            vTaskDelay((TickType_t)falta);
+        if (p->tipo == PASSO_ENTRADA) {
+            hal_sim_registrar("entrada", p->canal == 0 ? "nivel" : "chuva", p->centesimos, 0);
+        } else {
+            const falha_t *f = falhas_obter(p->falha);
+            hal_sim_registrar("falha", falhas_nome(f->tipo), p->tipo == PASSO_FALHA, f->parametro);
+        }
+        if (p->nome[0] != '\0')
+            definir_marca(p->nome, p->tempo_ms, num_eventos);
+    }
+    vTaskDelete(NULL);
+}
+
+// -------------------- Eventos --------------------
+static void anotar(const char *texto) {
+    static size_t capacidade;
+    eventos = crescer(eventos, num_eventos, &capacidade, sizeof(evento_t));
+    evento_t *e = &eventos[num_eventos++];
+    e->tempo_ms = (uint32_t)(time_us_64() / 1000u);
+    snprintf(e->texto, sizeof(e->texto), "%s", texto);
+}
+
+static void mostrar(const char *texto) {
+    printf("%u,%s\n", (uint32_t)(time_us_64() / 1000u), texto);
+}
+
+static void derivar(const char *texto) {
+    anotar(texto);
+    mostrar(texto);
+}
+
+static uint32_t canal_pwm(uint gpio) {
+    return pwm_gpio_to_slice_num(gpio) * 2 + pwm_gpio_to_channel(gpio);
+}
+
+static void observar(const char *periferico, const char *evento, uint32_t a, uint32_t b) {
+    char texto[TEXTO_MAX];
+    snprintf(texto, sizeof(texto), "%s %s %u %u", periferico, evento, a, b);
+    anotar(texto);
+
+    if (strcmp(periferico, "entrada") == 0 || strcmp(periferico, "falha") == 0 || strcmp(periferico, "fila") == 0) {
+        mostrar(texto);
+    } else if (strcmp(periferico, "pwm") == 0 && strcmp(evento, "nivel") == 0) {
+        if (a == canal_pwm(CENARIO_GPIO_VERMELHO) && (b > 0) != vermelho) {
+            vermelho = b > 0;
+            if (vermelho)
+                derivar("led vermelho");
+        } else if (a == canal_pwm(CENARIO_GPIO_VERDE) && (b > 0) != verde) {
+            verde = b > 0;
+            if (verde)
+                derivar("led verde");
+        } else if (a == canal_pwm(CENARIO_GPIO_BUZZER) && (b > 0) != buzzer) {
+            buzzer = b > 0;
+            derivar(buzzer ? "buzzer liga" : "buzzer desliga");
+        }
+    } else if (strcmp(periferico, "pio") == 0 && strcmp(evento, "palavra") == 0 && b != ultima_cor) {
+        config_estacao_t config;
+        config_obter(&config);
+        ultima_cor = b;
+        if (b == config.cor_alerta)
+            derivar("matriz alerta");
+        else if (b == config.cor_normal)
+            derivar("matriz normal");
+        else {
+            snprintf(texto, sizeof(texto), "matriz 0x%08X", b);
+            derivar(texto);
+        }
+    }
+}
+
+// Compara palavra a palavra; "*" casa com qualquer uma e o padrao pode
+// parar antes do texto.
+static bool casa(const char *padrao, const char *texto) {
+    while (true) {
+        padrao += strspn(padrao, " ");
+        texto += strspn(texto, " ");
+        if (*padrao == '\0')
+            return true;
+        if (*texto == '\0')
+            return false;
+        size_t np = strcspn(padrao, " ");
+        size_t nt = strcspn(texto, " ");
+        if (!(np == 1 && padrao[0] == '*') && (np != nt || strncmp(padrao, texto, np) != 0))
+            return false;
+        padrao += np;
+        texto += nt;
+    }
+}
+
+// -------------------- Verificacao --------------------
+static bool comparar(const char *operador, uint32_t valor, uint32_t limite) {
+    if (strcmp(operador, "<=") == 0)
+        return valor <= limite;
+    if (strcmp(operador, "==") == 0)
+        return valor == limite;
+    if (strcmp(operador, ">=") == 0)
+        return valor >= limite;
+    return true;
+}
+
+static const marca_t *referencia(const verificacao_t *v, bool *ok) {
+    static const marca_t inicio = { .nome = "inicio" };
+    if (v->apos[0] == '\0' || strcmp(v->apos, inicio.nome) == 0)
+        return &inicio;
+    const marca_t *m = buscar_marca(v->apos);
+    if (m == NULL) {
+        fprintf(stderr, "FALHA linha %u: a marca %s nao aconteceu\n", v->linha, v->apos);
+        *ok = false;
+    }
+    return m;
+}
+
+static bool na_janela(const verificacao_t *v, const marca_t *m, const evento_t *e) {
+    return v->por_ms == 0 || e->tempo_ms <= m->tempo_ms + v->por_ms;
+}
+
+static bool verificar(verificacao_t *v) {
+    bool ok = true;
+    const marca_t *m = NULL;
+    if (v->tipo != VERIFICAR_ORDEM) {
+        m = referencia(v, &ok);
+        if (m == NULL)
+            return false;
+    }
+
+    switch (v->tipo) {
+    case VERIFICAR_ESPERAR:
+        for (size_t i = m->ordem; i < num_eventos; i++) {
+            const evento_t *e = &eventos[i];
+            if (!casa(v->evento, e->texto))
+                continue;
+            v->medido = true;
+            v->tempo_ms = e->tempo_ms;
+            v->medida = e->tempo_ms - m->tempo_ms;
+            ok = comparar(v->operador, v->medida, v->limite);
+            fprintf(stderr, "%s linha %u: %s apos %s em %u ms (+%u ms", ok ? "ok" : "FALHA", v->linha,
+                    v->evento, m->nome, v->tempo_ms, v->medida);
+            if (v->operador[0] != '\0')
+                fprintf(stderr, ", esperado %s %u ms", v->operador, v->limite);
+            fprintf(stderr, ")\n");
+            if (v->como[0] != '\0')
+                definir_marca(v->como, e->tempo_ms, i + 1);
+            return ok;
+        }
+        fprintf(stderr, "FALHA linha %u: %s nao aconteceu apos %s\n", v->linha, v->evento, m->nome);
+        return false;
+
+    case VERIFICAR_NUNCA:
+        for (size_t i = m->ordem; i < num_eventos && na_janela(v, m, &eventos[i]); i++) {
+            if (casa(v->evento, eventos[i].texto)) {
+                v->medido = true;
+                v->tempo_ms = eventos[i].tempo_ms;
+                v->medida = eventos[i].tempo_ms - m->tempo_ms;
+                fprintf(stderr, "FALHA linha %u: %s em %u ms (+%u ms apos %s)\n", v->linha,
+                        eventos[i].texto, v->tempo_ms, v->medida, m->nome);
+                return false;
+            }
+        }
+        fprintf(stderr, "ok linha %u: nenhum %s apos %s\n", v->linha, v->evento, m->nome);
+        return true;
+
+    case VERIFICAR_CONTAR:
+        v->medido = true;
+        for (size_t i = m->ordem; i < num_eventos && na_janela(v, m, &eventos[i]); i++)
+            v->medida += casa(v->evento, eventos[i].texto);
+        ok = comparar(v->operador, v->medida, v->limite);
+        fprintf(stderr, "%s linha %u: %u x %s apos %s (esperado %s %u)\n", ok ? "ok" : "FALHA", v->linha,
+                v->medida, v->evento, m->nome, v->operador, v->limite);
+        return ok;
+
+    case VERIFICAR_ORDEM:
+        for (uint8_t i = 0; i < v->num_ordem; i++) {
+            const marca_t *atual = buscar_marca(v->ordem[i]);
+            if (atual == NULL) {
+                fprintf(stderr, "FALHA linha %u: a marca %s nao aconteceu\n", v->linha, v->ordem[i]);
+                return false;
+            }
+            if (m != NULL && atual->ordem <= m->ordem) {
+                fprintf(stderr, "FALHA linha %u: %s (%u ms) nao veio depois de %s (%u ms)\n", v->linha,
+                        atual->nome, atual->tempo_ms, m->nome, m->tempo_ms);
+                return false;
+            }
+            m = atual;
+        }
+        fprintf(stderr, "ok linha %u: ordem", v->linha);
+        for (uint8_t i = 0; i < v->num_ordem; i++)
+            fprintf(stderr, " %s", v->ordem[i]);
+        fprintf(stderr, "\n");
+        return true;
+    }
+    return false;
+}
+
+// -------------------- Recuperacao --------------------
+// Primeiro evento a partir do instante
+static size_t primeiro_evento(uint32_t tempo_ms) {
+    size_t i = 0;
+    while (i < num_eventos && eventos[i].tempo_ms < tempo_ms)
+        i++;
+    return i;
+}
+
+// Quanto depois de t a saida passou a mostrar o estado desejado: 0 se ja
+// mostrava; -1 se nao chegou la ate o fim.
+static int64_t ate_estado(const char *ligado, const char *desligado, bool desejado, uint32_t tempo_ms) {
+    size_t inicio = primeiro_evento(tempo_ms);
+    int estado = -1;
+    for (size_t i = 0; i < inicio; i++) {
+        if (casa(ligado, eventos[i].texto))
+            estado = 1;
+        else if (casa(desligado, eventos[i].texto))
+            estado = 0;
+    }
+    if (estado == desejado)
+        return 0;
+    for (size_t i = inicio; i < num_eventos; i++) {
+        if (casa(desejado ? ligado : desligado, eventos[i].texto))
+            return eventos[i].tempo_ms - tempo_ms;
+    }
+    return -1;
+}
+
+// Tempo do fim da falha ate o periferico voltar a fazer o seu papel: o
+// OLED receber um quadro inteiro (I2C), o LED mostrar o alerta que a
+// entrada limpa pede (ADC), a matriz mostrar a cor certa (PIO) ou uma
+// conexao TCP se completar (rede).
+static int64_t recuperacao(const falha_t *f) {
+    config_estacao_t config;
+    config_obter(&config);
+    uint64_t fim_us = (uint64_t)f->fim_ms * 1000u;
+    bool alerta = entrada_em(0, fim_us) >= config.limiar_agua || entrada_em(1, fim_us) >= config.limiar_chuva;
+
+    switch (f->tipo) {
+    case FALHA_I2C_NAK:
+    case FALHA_I2C_TRAVA:
+        for (size_t i = primeiro_evento(f->fim_ms); i < num_eventos; i++) {
+            if (casa("oled quadro", eventos[i].texto))
+                return eventos[i].tempo_ms - f->fim_ms;
+        }
+        return -1;
+    case FALHA_ADC_PRESO:
+    case FALHA_ADC_RUIDO:
+        return ate_estado("led vermelho", "led verde", alerta, f->fim_ms);
+    case FALHA_PIO_FILA:
+        return ate_estado("matriz alerta", "matriz normal", alerta, f->fim_ms);
+    case FALHA_REDE_QUEDA:
+        for (size_t i = primeiro_evento(f->fim_ms); i < num_eventos; i++) {
+            if (casa("rede conecta", eventos[i].texto))
+                return eventos[i].tempo_ms - f->fim_ms;
+        }
+        return -1;
+    }
+    return -1;
+}
+
+static void relatar_falhas(int64_t *recuperacoes) {
+    for (size_t i = 0; i < falhas_quantidade(); i++) {
+        const falha_t *f = falhas_obter((int)i);
+        recuperacoes[i] = f->fim_ms <= duracao_ms ? recuperacao(f) : -1;
+        fprintf(stderr, "falha linha %u: %s %u de %u a %u ms, %u operacoes afetadas, ", linha_falha[i],
+                falhas_nome(f->tipo), f->parametro, f->inicio_ms, f->fim_ms, f->afetadas);
+        if (recuperacoes[i] >= 0)
+            fprintf(stderr, "recuperada em +%lld ms\n", (long long)recuperacoes[i]);
+        else
+            fprintf(stderr, "sem recuperacao ate o fim\n");
+    }
+}
+
+// -------------------- JSON --------------------
+// Mesmo papel do --json do estacao_desempenho: guardar as latencias e as
+// recuperacoes de cada execucao para acompanhar a evolucao.
+static const char *const nomes_verificacao[] = {
+    [VERIFICAR_ESPERAR] = "esperar",
+    [VERIFICAR_NUNCA] = "nunca",
+    [VERIFICAR_CONTAR] = "contar",
+    [VERIFICAR_ORDEM] = "ordem",
+};
+
+static void gravar_json(const int64_t *recuperacoes) {
+    FILE *f = fopen(arquivo_json, "w");
+    if (f == NULL) {
+        perror(arquivo_json);
+        return;
+    }
+    fprintf(f, "{\n");
+#if ESTACAO_SIM_VIRTUAL
+    fprintf(f, "  \"semente\": %llu,\n  \"assinatura\": \"%016llx\",\n", (unsigned long long)virtual_semente(),
+            (unsigned long long)virtual_assinatura());
+#endif
+    fprintf(f, "  \"verificacoes\": [");
+    for (size_t i = 0; i < num_verificacoes; i++) {
+        const verificacao_t *v = &verificacoes[i];
+        fprintf(f, "%s\n    {\"linha\": %u, \"tipo\": \"%s\", \"evento\": \"%s\", \"apos\": \"%s\", \"ok\": %s",
+                i ? "," : "", v->linha, nomes_verificacao[v->tipo], v->evento,
+                v->apos[0] ? v->apos : "inicio", v->ok ? "true" : "false");
+        if (v->medido && v->tipo == VERIFICAR_CONTAR)
+            fprintf(f, ", \"contagem\": %u", v->medida);
+        else if (v->medido)
+            fprintf(f, ", \"tempo_ms\": %u, \"latencia_ms\": %u", v->tempo_ms, v->medida);
+        fprintf(f, "}");
+    }
+    fprintf(f, "\n  ],\n  \"falhas\": [");
+    for (size_t i = 0; i < falhas_quantidade(); i++) {
+        const falha_t *falha = falhas_obter((int)i);
+        fprintf(f, "%s\n    {\"linha\": %u, \"tipo\": \"%s\", \"parametro\": %u, \"inicio_ms\": %u, "
+                "\"fim_ms\": %u, \"afetadas\": %u, \"recuperacao_ms\": ", i ? "," : "", linha_falha[i],
+                falhas_nome(falha->tipo), falha->parametro, falha->inicio_ms, falha->fim_ms, falha->afetadas);
+        if (recuperacoes[i] >= 0)
+            fprintf(f, "%lld}", (long long)recuperacoes[i]);
+        else
+            fprintf(f, "null}");
+    }
+    fprintf(f, "\n  ]\n}\n");
+    fclose(f);
+}
+
+static void resultado(void) {
+    fflush(stdout);
+    uint32_t falhas = 0;
+    for (size_t i = 0; i < num_verificacoes; i++) {
+        verificacoes[i].ok = verificar(&verificacoes[i]);
+        falhas += !verificacoes[i].ok;
+    }
+    int64_t recuperacoes[FALHAS_MAX];
+    relatar_falhas(recuperacoes);
+    if (arquivo_json != NULL)
+        gravar_json(recuperacoes);
+    fprintf(stderr, "cenario: %zu verificacoes, %u falhas", num_verificacoes, falhas);
+#if ESTACAO_SIM_VIRTUAL
+    fprintf(stderr, " (semente %llu, assinatura %016llx)", (unsigned long long)virtual_semente(),
+            (unsigned long long)virtual_assinatura());
+#else
+    fprintf(stderr, " (port POSIX: tempos nao deterministicos)");
+#endif
+    fprintf(stderr, "\n");
+    if (falhas)
+        hal_sim_falhar();
+}
+
+// -------------------- Roteiro --------------------
+static void erro(const char *arquivo, unsigned linha, const char *mensagem, const char *palavra) {
+    fprintf(stderr, "%s:%u: %s%s%s\n", arquivo, linha, mensagem, palavra ? ": " : "", palavra ? palavra : "");
+    exit(1);
+}
+
+// Em ms por padrao; aceita os sufixos s, ms e us
+static bool ler_tempo_us(const char *texto, uint64_t *us) {
+    char *fim;
+    double valor = strtod(texto, &fim);
+    if (fim == texto || valor < 0)
+        return false;
+    if (strcmp(fim, "s") == 0)
+        valor *= 1e6;
+    else if (*fim == '\0' || strcmp(fim, "ms") == 0)
+        valor *= 1e3;
+    else if (strcmp(fim, "us") != 0)
+        return false;
+    *us = (uint64_t)(valor + 0.5);
+    return true;
+}
+
+static bool ler_tempo(const char *texto, uint32_t *ms) {
+    uint64_t us;
+    if (!ler_tempo_us(texto, &us) || us / 1000u > UINT32_MAX)
+        return false;
+    *ms = (uint32_t)((us + 500u) / 1000u);
+    return true;
+}
+
+static bool ler_percentual(const char *texto, uint16_t *centesimos) {
+    char *fim;
+    double pct = strtod(texto, &fim);
+    if (fim == texto || (*fim != '\0' && strcmp(fim, "%") != 0) || pct < 0.0 || pct > 100.0)
+        return false;
+    *centesimos = (uint16_t)(pct * 100.0 + 0.5);
+    return true;
+}
+
+static bool operador(const char *palavra) {
+    return strcmp(palavra, "<=") == 0 || strcmp(palavra, "==") == 0 || strcmp(palavra, ">=") == 0;
+}
+
+static bool reservada(const char *palavra) {
+    return operador(palavra) || strcmp(palavra, "apos") == 0 || strcmp(palavra, "como") == 0 ||
+           strcmp(palavra, "por") == 0;
+}
+
+static passo_t *novo_passo(tipo_passo_t tipo, unsigned linha, uint32_t tempo_ms) {
+    static size_t capacidade;
+    passos = crescer(passos, num_passos, &capacidade, sizeof(passo_t));
+    passo_t *passo = &passos[num_passos++];
+    memset(passo, 0, sizeof(*passo));
+    passo->tipo = tipo;
+    passo->tempo_ms = tempo_ms;
+    passo->linha = linha;
+    return passo;
+}
+
+static void adicionar_passo(const char *arquivo, unsigned linha, uint32_t tempo_ms, char **p, int n) {
+    if (n < 2 || (strcmp(p[0], "nivel") != 0 && strcmp(p[0], "chuva") != 0))
+        erro(arquivo, linha, "esperado nivel|chuva <pct>", NULL);
+    passo_t *passo = novo_passo(PASSO_ENTRADA, linha, tempo_ms);
+    passo->canal = strcmp(p[0], "chuva") == 0;
+    if (!ler_percentual(p[1], &passo->centesimos))
+        erro(arquivo, linha, "percentual invalido", p[1]);
+    if (n == 4 && strcmp(p[2], "como") == 0)
+        snprintf(passo->nome, sizeof(passo->nome), "%s", p[3]);
+    else if (n != 2)
+        erro(arquivo, linha, "sobrou", p[2]);
+}
+
+// falha i2c nak | i2c trava <tempo> | adc <canal> preso <contagem> |
+//       adc <canal> ruido <amplitude> | pio fila <tempo> | rede queda, e depois
+//       [por <tempo>] [como <nome>]
+static void adicionar_falha(const char *arquivo, unsigned linha, uint32_t tempo_ms, char **p, int n) {
+    tipo_falha_t tipo;
+    uint8_t canal = 0;
+    uint64_t parametro = 0;
+    int i;
+    if (n >= 2 && strcmp(p[0], "i2c") == 0 && strcmp(p[1], "nak") == 0) {
+        tipo = FALHA_I2C_NAK;
+        i = 2;
+    } else if (n >= 3 && strcmp(p[0], "i2c") == 0 && strcmp(p[1], "trava") == 0) {
+        tipo = FALHA_I2C_TRAVA;
+        if (!ler_tempo_us(p[2], &parametro) || parametro > UINT32_MAX)
+            erro(arquivo, linha, "tempo invalido", p[2]);
+        i = 3;
+    } else if (n >= 2 && strcmp(p[0], "rede") == 0 && strcmp(p[1], "queda") == 0) {
+        tipo = FALHA_REDE_QUEDA;
+        i = 2;
+    } else if (n >= 3 && strcmp(p[0], "pio") == 0 && strcmp(p[1], "fila") == 0) {
+        tipo = FALHA_PIO_FILA;
+        if (!ler_tempo_us(p[2], &parametro) || parametro > UINT32_MAX)
+            erro(arquivo, linha, "tempo invalido", p[2]);
+        i = 3;
+    } else if (n >= 4 && strcmp(p[0], "adc") == 0 &&
+               (strcmp(p[2], "preso") == 0 || strcmp(p[2], "ruido") == 0)) {
+        tipo = strcmp(p[2], "preso") == 0 ? FALHA_ADC_PRESO : FALHA_ADC_RUIDO;
+        char *fim;
+        canal = (uint8_t)strtoul(p[1], &fim, 10);
+        if (*fim != '\0' || canal > 4)
+            erro(arquivo, linha, "canal do ADC invalido", p[1]);
+        parametro = strtoul(p[3], &fim, 10);
+        if (*fim != '\0' || parametro > 4095)
+            erro(arquivo, linha, "contagem invalida", p[3]);
+        i = 4;
+    } else {
+        erro(arquivo, linha, "esperado i2c nak|i2c trava <t>|adc <canal> preso|ruido <n>|pio fila <t>|rede queda", NULL);
+        return;
+    }
+
+    uint32_t fim_ms = UINT32_MAX;
+    const char *nome = NULL;
+    for (; i + 1 < n; i += 2) {
+        if (strcmp(p[i], "por") == 0) {
+            uint32_t por_ms;
+            if (!ler_tempo(p[i + 1], &por_ms))
+                erro(arquivo, linha, "tempo invalido", p[i + 1]);
+            fim_ms = tempo_ms + por_ms;
+        } else if (strcmp(p[i], "como") == 0) {
+            nome = p[i + 1];
+        } else {
+            erro(arquivo, linha, "nao cabe aqui", p[i]);
+        }
+    }
+    if (i != n)
+        erro(arquivo, linha, "sobrou", p[i]);
+
+    int indice = falhas_agendar(tipo, canal, (uint32_t)parametro, tempo_ms, fim_ms);
+    if (indice < 0)
+        erro(arquivo, linha, "falhas demais", NULL);
+    linha_falha[indice] = linha;
+
+    passo_t *inicio = novo_passo(PASSO_FALHA, linha, tempo_ms);
+    inicio->falha = indice;
+    if (nome != NULL)
+        snprintf(inicio->nome, sizeof(inicio->nome), "%s", nome);
+    if (fim_ms != UINT32_MAX) {
+        passo_t *fim = novo_passo(PASSO_FIM_FALHA, linha, fim_ms);
+        fim->falha = indice;
+        if (nome != NULL)
+            snprintf(fim->nome, sizeof(fim->nome), "%.*s_fim", NOME_MAX - 5, nome);
+    }
+}
+
+static void adicionar_verificacao(const char *arquivo, unsigned linha, tipo_verificacao_t tipo, char **p, int n) {
+    static size_t capacidade;
+    verificacoes = crescer(verificacoes, num_verificacoes, &capacidade, sizeof(verificacao_t));
+    verificacao_t *v = &verificacoes[num_verificacoes];
+    memset(v, 0, sizeof(*v));
+    v->tipo = tipo;
+    v->linha = linha;
+
+    int i = 0;
+    if (tipo == VERIFICAR_ORDEM) {
+        if (n < 2 || n > ORDEM_MAX)
+            erro(arquivo, linha, "ordem pede de 2 a 8 marcas", NULL);
+        for (; i < n; i++)
+            snprintf(v->ordem[i], NOME_MAX, "%s", p[i]);
+        v->num_ordem = (uint8_t)n;
+        num_verificacoes++;
+        return;
+    }
+
+    // O evento vai ate a primeira palavra reservada
+    size_t usado = 0;
+    for (; i < n && !reservada(p[i]); i++)
+        usado += (size_t)snprintf(v->evento + usado, sizeof(v->evento) - usado, "%s%s", usado ? " " : "", p[i]);
+    if (usado == 0)
+        erro(arquivo, linha, "falta o evento", NULL);
+
+    while (i < n) {
+        const char *chave = p[i++];
+        if (i == n)
+            erro(arquivo, linha, "falta o valor de", chave);
+        const char *valor = p[i++];
+        if (strcmp(chave, "apos") == 0) {
+            snprintf(v->apos, sizeof(v->apos), "%s", valor);
+        } else if (strcmp(chave, "como") == 0 && tipo == VERIFICAR_ESPERAR) {
+            snprintf(v->como, sizeof(v->como), "%s", valor);
+        } else if (strcmp(chave, "por") == 0 && tipo != VERIFICAR_ESPERAR) {
+            if (!ler_tempo(valor, &v->por_ms))
+                erro(arquivo, linha, "tempo invalido", valor);
+        } else if (operador(chave) && tipo != VERIFICAR_NUNCA) {
+            snprintf(v->operador, sizeof(v->operador), "%s", chave);
+            bool lido;
+            if (tipo == VERIFICAR_CONTAR) {
+                char *fim;
+                v->limite = (uint32_t)strtoul(valor, &fim, 10);
+                lido = fim != valor && *fim == '\0';
+            } else {
+                lido = ler_tempo(valor, &v->limite);
+            }
+            if (!lido)
+                erro(arquivo, linha, "limite invalido", valor);
+        } else {
+            erro(arquivo, linha, "nao cabe aqui", chave);
+        }
+    }
+    if (tipo == VERIFICAR_CONTAR && v->operador[0] == '\0')
+        erro(arquivo, linha, "contar pede <=|==|>= <n>", NULL);
+    num_verificacoes++;
+}
+
+static int comparar_passos(const void *a, const void *b) {
+    const passo_t *pa = a, *pb = b;
+    if (pa->tempo_ms != pb->tempo_ms)
+        return pa->tempo_ms < pb->tempo_ms ? -1 : 1;
+    return (pa->linha > pb->linha) - (pa->linha < pb->linha); // qsort nao e estavel
+}
+
+static void carregar(const char *arquivo) {
+    FILE *f = fopen(arquivo, "r");
+    if (f == NULL) {
+        perror(arquivo);
+        exit(1);
+    }
+    char texto[256];
+    unsigned linha = 0;
+    bool duracao_fixa = false;
+    while (fgets(texto, sizeof(texto), f) != NULL) {
+        linha++;
+        texto[strcspn(texto, "#\r\n")] = '\0';
+        char *p[2 * PALAVRAS_MAX];
+        int n = 0;
+        for (char *palavra = strtok(texto, " \t"); palavra != NULL && n < 2 * PALAVRAS_MAX; palavra = strtok(NULL, " \t"))
+            p[n++] = palavra;
+        if (n == 0)
+            continue;
+
+        if (strcmp(p[0], "semente") == 0 && n == 2) {
+#if ESTACAO_SIM_VIRTUAL
+            virtual_definir_semente(strtoull(p[1], NULL, 0));
+#endif
+        } else if (strcmp(p[0], "duracao") == 0 && n == 2) {
+            if (!ler_tempo(p[1], &duracao_ms))
+                erro(arquivo, linha, "tempo invalido", p[1]);
+            duracao_fixa = true;
+        } else if (strcmp(p[0], "nivel") == 0 || strcmp(p[0], "chuva") == 0) {
+            adicionar_passo(arquivo, linha, 0, p, n);
+        } else if (strcmp(p[0], "em") == 0 && n >= 2) {
+            uint32_t tempo_ms;
+            if (!ler_tempo(p[1], &tempo_ms))
+                erro(arquivo, linha, "tempo invalido", p[1]);
+            if (n > 2 && strcmp(p[2], "falha") == 0)
+                adicionar_falha(arquivo, linha, tempo_ms, p + 3, n - 3);
+            else
+                adicionar_passo(arquivo, linha, tempo_ms, p + 2, n - 2);
+        } else if (strcmp(p[0], "esperar") == 0) {
+            adicionar_verificacao(arquivo, linha, VERIFICAR_ESPERAR, p + 1, n - 1);
+        } else if (strcmp(p[0], "nunca") == 0) {
+            adicionar_verificacao(arquivo, linha, VERIFICAR_NUNCA, p + 1, n - 1);
+        } else if (strcmp(p[0], "contar") == 0) {
+            adicionar_verificacao(arquivo, linha, VERIFICAR_CONTAR, p + 1, n - 1);
+        } else if (strcmp(p[0], "ordem") == 0) {
+            adicionar_verificacao(arquivo, linha, VERIFICAR_ORDEM, p + 1, n - 1);
+        } else {
+            erro(arquivo, linha, "instrucao desconhecida", p[0]);
+        }
+    }
+    fclose(f);
+
+    qsort(passos, num_passos, sizeof(passo_t), comparar_passos);
+    if (!duracao_fixa)
+        duracao_ms = (num_passos ? passos[num_passos - 1].tempo_ms : 0) + CENARIO_MARGEM_MS;
+}
+
+uint32_t cenario_iniciar(const char *arquivo, const char *json) {
+    arquivo_json = json;
+    carregar(arquivo);
+
+    hal_sim_definir_fonte_adc(fonte_cenario);
+    hal_sim_observar(observar);
+    hal_sim_ao_encerrar(resultado);
+    printf("tempo_ms,evento\n");
+
+    xTaskCreate(vCenarioTask, "Cenario", configMINIMAL_STACK_SIZE, NULL, configMAX_PRIORITIES - 2, NULL);
+    return duracao_ms;
+}
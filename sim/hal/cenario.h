@@ -0,0 +1,70 @@
+#ifndef CENARIO_H
+#define CENARIO_H
+
+#include "pico/stdlib.h"
+
+// -------------------- Cenarios com verificacao --------------------
+// Um roteiro em texto fixa a entrada do ADC em degraus, com instantes
+// exatos, e diz o que a estacao deve fazer depois. Com o kernel virtual
+// (estacao_virtual) a execucao e deterministica: a mesma semente da as
+// mesmas latencias, ao milissegundo, e a mesma ordem de eventos.
+//
+// Uma instrucao por linha; # comenta ate o fim da linha. Tempos em ms, ou
+// com sufixo s/ms (12.3s = 12300). Nivel e chuva em %, pela curva ideal.
+//
+//   semente 7                      intercalacao (ESTACAO_SIM_SEMENTE vale mais)
+//   duracao 20s                    tempo simulado (padrao: ultimo passo + 5 s)
+//   nivel 40                       entrada a partir de t=0
+//   chuva 10
+//   em 12.3s nivel 80 como subida  degrau da entrada; "como" da nome ao instante
+//   em 13s falha <falha> [por <tempo>] [como <marca>]
+//       falha injetada no HAL (falhas.h) ate o fim ou por <tempo>; o fim
+//       ganha a marca <marca>_fim. <falha> e uma de:
+//         i2c nak               toda transferencia volta sem ACK
+//         i2c trava <tempo>     cada transferencia segura a CPU mais <tempo>
+//         adc <canal> preso <n> o canal le sempre n (0..4095)
+//         adc <canal> ruido <n> soma ate +-n contagens a cada conversao
+//         pio fila <tempo>      cada palavra do PIO espera mais <tempo>
+//         rede queda            o Wi-Fi cai e nao volta ate o fim da falha
+//       Tempos das falhas aceitam tambem o sufixo us.
+//
+//   esperar <evento> [apos <marca>] [<=|==|>= <tempo>] [como <marca>]
+//       o primeiro <evento> depois da marca (padrao: inicio) deve ocorrer,
+//       com a latencia dentro do limite; "como" marca o instante dele
+//   nunca <evento> [apos <marca>] [por <tempo>]
+//       nenhum <evento> depois da marca (ate o fim ou por <tempo>)
+//   contar <evento> [apos <marca>] [por <tempo>] <=|==|>= <n>
+//   ordem <marca> <marca> [...]
+//       as marcas aconteceram nessa ordem (pela sequencia dos eventos, nao
+//       so pelo ms: dois eventos no mesmo tick ainda tem ordem)
+//
+// Eventos sao palavras comparadas com as do registro do HAL ("oled quadro",
+// "fila cheia 0", "pwm nivel 26 255"...) e com as que o cenario deriva:
+//
+//   entrada nivel|chuva <centesimos>   degrau aplicado
+//   led vermelho|verde                 canal do LED RGB que acendeu
+//   buzzer liga|desliga
+//   matriz alerta|normal|<cor>         cor nova da matriz
+//   falha <tipo> 1|0 <parametro>       inicio/fim de falha (i2c_nak, ...)
+//
+// "*" casa com qualquer palavra e palavras a menos casam com o resto.
+//
+// Os eventos derivados saem na saida padrao (tempo_ms,evento) e o
+// resultado de cada verificacao vai para stderr, antes do resumo. Se alguma
+// falhar, a simulacao termina com codigo 1.
+//
+// Para cada falha o relatorio da quantas operacoes ela atingiu e a
+// recuperacao: do fim da falha ate o periferico voltar a cumprir o seu
+// papel (I2C: proximo quadro do OLED; ADC: LED no estado que a entrada
+// limpa pede; PIO: matriz na cor certa; rede: proxima conexao TCP). Com
+// json != NULL as verificacoes, latencias e recuperacoes tambem vao para
+// esse arquivo.
+
+#define CENARIO_MARGEM_MS 5000
+
+// Carrega o roteiro, troca a fonte do ADC e cria a tarefa que aplica os
+// degraus e as falhas. Retorna a duracao da simulacao em ms. Chamar antes
+// do escalonador.
+uint32_t cenario_iniciar(const char *arquivo, const char *json);
+
+#endif
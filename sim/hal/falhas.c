@@ -0,0 +1,120 @@
+#include "falhas.h"
+
+static falha_t falhas[FALHAS_MAX];
+static size_t num_falhas;
+
+static const char *const nomes[] = {
+    [FALHA_I2C_NAK] = "i2c_nak",
+    [FALHA_I2C_TRAVA] = "i2c_trava",
+    [FALHA_ADC_PRESO] = "adc_preso",
+    [FALHA_ADC_RUIDO] = "adc_ruido",
+    [FALHA_PIO_FILA] = "pio_fila",
+    [FALHA_REDE_QUEDA] = "rede_queda",
+};
+
+int falhas_agendar(tipo_falha_t tipo, uint8_t canal, uint32_t parametro, uint32_t inicio_ms, uint32_t fim_ms) {
+    if (num_falhas == FALHAS_MAX)
+        return -1;
+    falhas[num_falhas] = (falha_t){
+        .tipo = tipo,
+        .canal = canal,
+        .parametro = parametro,
+        .inicio_ms = inicio_ms,
+        .fim_ms = fim_ms,
+    };
+    return (int)num_falhas++;
+}
+
+const falha_t *falhas_obter(int indice) {
+    return indice >= 0 && (size_t)indice < num_falhas ? &falhas[indice] : NULL;
+}
+
+size_t falhas_quantidade(void) {
+    return num_falhas;
+}
+
+const char *falhas_nome(tipo_falha_t tipo) {
+    return nomes[tipo];
+}
+
+static bool ativa(const falha_t *f, uint64_t tempo_us) {
+    return tempo_us >= (uint64_t)f->inicio_ms * 1000u && tempo_us < (uint64_t)f->fim_ms * 1000u;
+}
+
+// -------------------- Perifericos --------------------
+bool falhas_i2c(uint32_t *atraso_us) {
+    uint64_t agora = time_us_64();
+    bool nak = false;
+    *atraso_us = 0;
+    for (size_t i = 0; i < num_falhas; i++) {
+        falha_t *f = &falhas[i];
+        if (!ativa(f, agora))
+            continue;
+        if (f->tipo == FALHA_I2C_NAK) {
+            nak = true;
+            f->afetadas++;
+        } else if (f->tipo == FALHA_I2C_TRAVA) {
+            *atraso_us += f->parametro;
+            f->afetadas++;
+        }
+    }
+    return nak;
+}
+
+// Ruido em funcao do instante e do canal (splitmix64): a mesma amostra
+// recebe o mesmo ruido em qualquer execucao, independente da ordem das
+// leituras.
+static int32_t ruido(uint canal, uint64_t tempo_us, uint32_t amplitude) {
+    uint64_t z = tempo_us * 8u + canal + 0x9E3779B97F4A7C15ull;
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+    z ^= z >> 31;
+    return (int32_t)(z % (2u * amplitude + 1u)) - (int32_t)amplitude;
+}
+
+uint16_t falhas_adc(uint canal, uint64_t tempo_us, uint16_t valor) {
+    int32_t v = valor;
+    for (size_t i = 0; i < num_falhas; i++) {
+        falha_t *f = &falhas[i];
+        if (f->canal != canal || !ativa(f, tempo_us))
+            continue;
+        if (f->tipo == FALHA_ADC_PRESO) {
+            v = (int32_t)f->parametro;
+            f->afetadas++;
+        } else if (f->tipo == FALHA_ADC_RUIDO) {
+            v += ruido(canal, tempo_us, f->parametro);
+            f->afetadas++;
+        }
+    }
+    if (v < 0)
+        v = 0;
+    if (v > 4095)
+        v = 4095;
+    return (uint16_t)v;
+}
+
+uint32_t falhas_pio_us(void) {
+    uint64_t agora = time_us_64();
+    uint32_t atraso = 0;
+    for (size_t i = 0; i < num_falhas; i++) {
+        falha_t *f = &falhas[i];
+        if (f->tipo == FALHA_PIO_FILA && ativa(f, agora)) {
+            atraso += f->parametro;
+            f->afetadas++;
+        }
+    }
+    return atraso;
+}
+
+bool falhas_rede(void) {
+    uint64_t agora = time_us_64();
+    bool fora = false;
+    for (size_t i = 0; i < num_falhas; i++) {
+        falha_t *f = &falhas[i];
+        if (f->tipo == FALHA_REDE_QUEDA && ativa(f, agora)) {
+            fora = true;
+            f->afetadas++;
+        }
+    }
+    return fora;
+}
@@ -0,0 +1,69 @@
+#ifndef FALHAS_H
+#define FALHAS_H
+
+#include "pico/stdlib.h"
+
+// -------------------- Injecao de falhas --------------------
+// Falhas dos perifericos simulados, cada uma ativa numa janela de tempo
+// simulado [inicio_ms, fim_ms). O HAL as consulta a cada operacao, entao o
+// efeito comeca e termina no instante exato, com qualquer kernel:
+//
+//   FALHA_I2C_NAK    nenhum escravo responde: as escritas e leituras I2C
+//                    devolvem PICO_ERROR_GENERIC depois do endereco
+//   FALHA_I2C_TRAVA  o escravo estica o SCL: cada transacao prende a CPU
+//                    mais parametro us, ou ate o timeout de
+//                    i2c_write_timeout_us (PICO_ERROR_TIMEOUT)
+//   FALHA_ADC_PRESO  o canal le sempre a contagem parametro
+//   FALHA_ADC_RUIDO  o canal soma ruido uniforme de +-parametro contagens
+//   FALHA_PIO_FILA   o FIFO de TX nao esvazia: cada palavra espera mais
+//                    parametro us antes de entrar
+//   FALHA_REDE_QUEDA o Wi-Fi cai: as conexoes TCP abertas sao abortadas e
+//                    nem a associacao nem conexoes novas passam
+//
+// Os cenarios (cenario.h) agendam as falhas e marcam inicio e fim.
+
+typedef enum {
+    FALHA_I2C_NAK,
+    FALHA_I2C_TRAVA,
+    FALHA_ADC_PRESO,
+    FALHA_ADC_RUIDO,
+    FALHA_PIO_FILA,
+    FALHA_REDE_QUEDA
+} tipo_falha_t;
+
+typedef struct {
+    tipo_falha_t tipo;
+    uint8_t canal;       // so no ADC
+    uint32_t parametro;
+    uint32_t inicio_ms;
+    uint32_t fim_ms;
+    uint32_t afetadas;   // operacoes alteradas pela falha ate aqui
+} falha_t;
+
+#define FALHAS_MAX 16
+
+// Retorna o indice da falha, ou -1 se a tabela estiver cheia.
+int falhas_agendar(tipo_falha_t tipo, uint8_t canal, uint32_t parametro, uint32_t inicio_ms, uint32_t fim_ms);
+
+const falha_t *falhas_obter(int indice);
+size_t falhas_quantidade(void);
+
+// Nome curto (i2c_nak, adc_preso...), usado nos eventos e relatorios.
+const char *falhas_nome(tipo_falha_t tipo);
+
+// -------------------- Uso interno do HAL --------------------
+// true se a transacao deve falhar com NAK; em *atraso_us, o tempo extra de
+// clock stretching.
+bool falhas_i2c(uint32_t *atraso_us);
+
+// Leitura do canal depois das falhas ativas do ADC.
+uint16_t falhas_adc(uint canal, uint64_t tempo_us, uint16_t valor);
+
+// Espera extra antes de a palavra entrar no FIFO do PIO.
+uint32_t falhas_pio_us(void);
+
+// true se a rede esta fora; cada chamada com a rede fora conta uma operacao
+// afetada (conexao derrubada ou tentativa recusada).
+bool falhas_rede(void);
+
+#endif
@@ -0,0 +1,51 @@
+// Equivalente ao cabecalho que o pioasm gera a partir de final.pio; no
+// host nao ha pioasm, entao as instrucoes foram montadas a mao.
+
+#ifndef SIM_FINAL_PIO_H
+#define SIM_FINAL_PIO_H
+
+#include "hardware/pio.h"
+
+#define final_wrap_target 0
+#define final_wrap 6
+
+static const uint16_t final_program_instructions[] = {
+            //     .wrap_target
+    0x6021, //  0: out    x, 1
+    0x0024, //  1: jmp    !x, 4
+    0xe401, //  2: set    pins, 1                [4]
+    0x0006, //  3: jmp    6
+    0xe201, //  4: set    pins, 1                [2]
+    0xe200, //  5: set    pins, 0                [2]
+    0xe100, //  6: set    pins, 0                [1]
+            //     .wrap
+};
+
+static const struct pio_program final_program = {
+    .instructions = final_program_instructions,
+    .length = 7,
+    .origin = -1,
+};
+
+static inline pio_sm_config final_program_get_default_config(uint offset) {
+    pio_sm_config c = pio_get_default_sm_config();
+    sm_config_set_wrap(&c, offset + final_wrap_target, offset + final_wrap);
+    return c;
+}
+
+static inline void final_program_init(PIO pio, uint sm, uint offset, uint pin)
+{
+    pio_sm_config c = final_program_get_default_config(offset);
+    sm_config_set_set_pins(&c, pin, 1);
+    pio_gpio_init(pio, pin);
+    pio_sm_set_consecutive_pindirs(pio, sm, pin, 1, true);
+    float div = clock_get_hz(clk_sys) / 8000000.0;
+    sm_config_set_clkdiv(&c, div);
+    sm_config_set_fifo_join(&c, PIO_FIFO_JOIN_TX);
+    sm_config_set_out_shift(&c, false, true, 24);
+    sm_config_set_out_special(&c, true, false, false);
+    pio_sm_init(pio, sm, offset, &c);
+    pio_sm_set_enabled(pio, sm, true);
+}
+
+#endif
@@ -0,0 +1,67 @@
+#include <string.h>
+#include "hal_sim.h"
+#include "hardware/flash.h"
+
+// -------------------- Flash --------------------
+// A flash inteira fica em RAM, vista pelo firmware pela "janela XIP"
+// (XIP_BASE aponta para este vetor). Com ESTACAO_SIM_FLASH a imagem e
+// carregada no inicio e salva no fim, entao o log e a configuracao
+// sobrevivem de uma execucao para a outra como num reset.
+uint8_t hal_sim_flash[PICO_FLASH_SIZE_BYTES] __attribute__((aligned(FLASH_SECTOR_SIZE)));
+
+static const char *arquivo_imagem;
+
+void hal_sim_flash_iniciar(const char *arquivo) {
+    memset(hal_sim_flash, 0xFF, sizeof(hal_sim_flash));
+    arquivo_imagem = arquivo;
+    if (arquivo == NULL)
+        return;
+
+    FILE *f = fopen(arquivo, "rb");
+    if (f == NULL)
+        return; // primeira execucao: flash apagada
+    size_t lidos = fread(hal_sim_flash, 1, sizeof(hal_sim_flash), f);
+    fclose(f);
+    hal_sim_registrar("flash", "carregada", (uint32_t)lidos, 0);
+}
+
+void hal_sim_flash_salvar(void) {
+    if (arquivo_imagem == NULL)
+        return;
+    FILE *f = fopen(arquivo_imagem, "wb");
+    if (f == NULL || fwrite(hal_sim_flash, 1, sizeof(hal_sim_flash), f) != sizeof(hal_sim_flash))
+        perror(arquivo_imagem);
+    if (f != NULL)
+        fclose(f);
+}
+
+// Tempos tipicos do W25Q16JV do Pico: no tempo virtual, apagar e gravar
+// prendem a CPU (com as interrupcoes desligadas, como no firmware).
+#define FLASH_APAGAR_SETOR_US 45000
+#define FLASH_GRAVAR_PAGINA_US 400
+
+// Os mesmos requisitos de alinhamento do SDK; violacoes abortam, como um
+// erro de programacao que no RP2040 corromperia a flash.
+static void verificar(uint32_t offset, size_t tamanho, uint32_t alinhamento, const char *operacao) {
+    if (offset % alinhamento || tamanho % alinhamento || offset + tamanho > PICO_FLASH_SIZE_BYTES) {
+        fprintf(stderr, "hal_sim: %s invalido (offset 0x%x, %zu bytes)\n", operacao, offset, tamanho);
+        abort();
+    }
+}
+
+void flash_range_erase(uint32_t offset, size_t tamanho) {
+    verificar(offset, tamanho, FLASH_SECTOR_SIZE, "apagamento");
+    memset(&hal_sim_flash[offset], 0xFF, tamanho);
+    hal_sim_contadores.flash_apagamentos += (uint32_t)(tamanho / FLASH_SECTOR_SIZE);
+    hal_sim_registrar("flash", "apagar", offset, (uint32_t)tamanho);
+    hal_sim_ocupar_us((uint32_t)(tamanho / FLASH_SECTOR_SIZE) * FLASH_APAGAR_SETOR_US);
+}
+
+void flash_range_program(uint32_t offset, const uint8_t *dados, size_t tamanho) {
+    verificar(offset, tamanho, FLASH_PAGE_SIZE, "gravacao");
+    for (size_t i = 0; i < tamanho; i++)
+        hal_sim_flash[offset + i] &= dados[i];
+    hal_sim_contadores.flash_programacoes += (uint32_t)(tamanho / FLASH_PAGE_SIZE);
+    hal_sim_registrar("flash", "gravar", offset, (uint32_t)tamanho);
+    hal_sim_ocupar_us((uint32_t)(tamanho / FLASH_PAGE_SIZE) * FLASH_GRAVAR_PAGINA_US);
+}
@@ -0,0 +1,255 @@
+#define _POSIX_C_SOURCE 200809L
+#include <time.h>
+#include <string.h>
+#include "hal_sim.h"
+#include "hardware/clocks.h"
+#include "hardware/pwm.h"
+#include "hardware/sync.h"
+#include "hardware/structs/systick.h"
+#include "hardware/structs/xip_ctrl.h"
+#include "FreeRTOS.h"
+#include "task.h"
+#include "reproducao.h"
+#include "cenario.h"
+#if ESTACAO_SIM_VIRTUAL
+#include "virtual.h"
+#endif
+
+hal_sim_contadores_t hal_sim_contadores;
+systick_hw_t hal_sim_systick_hw;
+xip_ctrl_hw_t hal_sim_xip_ctrl_hw;
+
+static volatile uint64_t tempo_us;
+static uint32_t khz_sys = 125000;
+static uint32_t duracao_ms = HAL_SIM_DURACAO_PADRAO_MS;
+static FILE *trace;
+static struct timespec inicio_real;
+static hal_sim_observador_t observadores[HAL_SIM_OBSERVADORES_MAX];
+static uint8_t num_observadores;
+static void (*ao_encerrar)(void);
+static int codigo_saida;
+
+// -------------------- Tempo --------------------
+// O port do host marca o tick com configTICK_RATE_HZ reais, mas
+// pdMS_TO_TICKS conta um tick por milissegundo (sim/FreeRTOSConfig.h): cada
+// tick vale 1 ms simulado e a simulacao anda ESTACAO_SIM_ACELERACAO vezes
+// mais rapido que o relogio de parede. O kernel virtual chama o mesmo hook
+// a cada tick do seu contador.
+void vApplicationTickHook(void) {
+    tempo_us += 1000;
+    hal_sim_adc_dma_avancar(tempo_us, 1000);
+    hal_sim_uart_avancar();
+}
+
+uint64_t time_us_64(void) {
+    return tempo_us;
+}
+
+void sleep_ms(uint32_t ms) {
+    if (xTaskGetSchedulerState() == taskSCHEDULER_RUNNING)
+        vTaskDelay(pdMS_TO_TICKS(ms));
+    else
+        tempo_us += (uint64_t)ms * 1000u;
+}
+
+void sleep_us(uint64_t us) {
+    sleep_ms((uint32_t)((us + 999u) / 1000u));
+}
+
+void hal_sim_ocupar_us(uint32_t us) {
+#if ESTACAO_SIM_VIRTUAL
+    virtual_ocupar_us(us);
+#else
+    (void)us;
+#endif
+}
+
+// -------------------- Interrupcoes --------------------
+// As "interrupcoes" do HAL (handlers de DMA) rodam dentro do tick, entao a
+// secao critica do FreeRTOS as mascara tambem.
+uint32_t save_and_disable_interrupts(void) {
+    taskENTER_CRITICAL();
+    return 0;
+}
+
+void restore_interrupts(uint32_t estado) {
+    (void)estado;
+    taskEXIT_CRITICAL();
+}
+
+// -------------------- Clocks --------------------
+uint32_t clock_get_hz(enum clock_index relogio) {
+    switch (relogio) {
+    case clk_sys:
+    case clk_peri:
+        return khz_sys * 1000u;
+    case clk_usb:
+    case clk_adc:
+        return 48000000u;
+    case clk_ref:
+        return 12000000u;
+    default:
+        return 46875u;
+    }
+}
+
+bool set_sys_clock_khz(uint32_t khz, bool obrigatorio) {
+    (void)obrigatorio;
+    if (khz != khz_sys) {
+        hal_sim_contadores.trocas_clock++;
+        hal_sim_registrar("clock", "sys_khz", khz, khz_sys);
+    }
+    khz_sys = khz;
+    return true;
+}
+
+// -------------------- Registro --------------------
+// Nao e chamado do tick: fprintf nao pode interromper a si mesmo.
+void hal_sim_registrar(const char *periferico, const char *evento, uint32_t a, uint32_t b) {
+    if (trace != NULL)
+        fprintf(trace, "%llu,%s,%s,%u,%u\n", (unsigned long long)(tempo_us / 1000u), periferico, evento, a, b);
+    for (uint8_t i = 0; i < num_observadores; i++)
+        observadores[i](periferico, evento, a, b);
+}
+
+void hal_sim_observar(hal_sim_observador_t observador) {
+    if (num_observadores < HAL_SIM_OBSERVADORES_MAX)
+        observadores[num_observadores++] = observador;
+}
+
+void hal_sim_ao_encerrar(void (*funcao)(void)) {
+    ao_encerrar = funcao;
+}
+
+void hal_sim_falhar(void) {
+    codigo_saida = 1;
+}
+
+static double segundos_desde(const struct timespec *t0) {
+    struct timespec t1;
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    return (double)(t1.tv_sec - t0->tv_sec) + (double)(t1.tv_nsec - t0->tv_nsec) / 1e9;
+}
+
+void hal_sim_resumo(void) {
+    const hal_sim_contadores_t *c = &hal_sim_contadores;
+    double real = segundos_desde(&inicio_real);
+    double simulado = (double)tempo_us / 1e6;
+
+    fprintf(stderr, "simulacao: %.3f s simulados em %.3f s (%.1fx)\n",
+            simulado, real, real > 0 ? simulado / real : 0.0);
+#if ESTACAO_SIM_VIRTUAL
+    virtual_resumo(stderr);
+#endif
+    fprintf(stderr, "adc: %llu amostras; dma: %llu transferencias, %u irqs\n",
+            (unsigned long long)c->adc_amostras, (unsigned long long)c->dma_transferencias, c->dma_irqs);
+    fprintf(stderr, "i2c: %u transacoes, %llu bytes; oled: %u quadros\n",
+            c->i2c_transacoes, (unsigned long long)c->i2c_bytes, hal_sim_oled_quadros());
+    fprintf(stderr, "pio: %llu palavras; pwm: %u mudancas; gpio: %u eventos\n",
+            (unsigned long long)c->pio_palavras, c->pwm_mudancas, c->gpio_eventos);
+    fprintf(stderr, "flash: %u setores apagados, %u paginas gravadas\n",
+            c->flash_apagamentos, c->flash_programacoes);
+    fprintf(stderr, "usb: %llu bytes enviados, %llu recebidos; clock: %u trocas (%u kHz)\n",
+            (unsigned long long)c->usb_enviados, (unsigned long long)c->usb_recebidos,
+            c->trocas_clock, khz_sys);
+    fprintf(stderr, "rede: %u conexoes, %llu bytes enviados, %llu recebidos; radio: %.1f s em desempenho\n",
+            c->rede_conexoes, (unsigned long long)c->rede_enviados, (unsigned long long)c->rede_recebidos,
+            (double)c->radio_desempenho_us / 1e6);
+    fprintf(stderr, "uart: %llu bytes enviados, %llu recebidos\n",
+            (unsigned long long)c->uart_enviados, (unsigned long long)c->uart_recebidos);
+    for (uint gpio = 0; gpio < NUM_BANK0_GPIOS; gpio++) {
+        if (gpio_get_function(gpio) == GPIO_FUNC_PWM)
+            fprintf(stderr, "pwm gpio %u: nivel %u\n", gpio, hal_sim_pwm_nivel(gpio));
+    }
+}
+
+// -------------------- Inicio e fim --------------------
+static void vSimFimTask(void *params) {
+    (void)params;
+    vTaskDelay(pdMS_TO_TICKS(duracao_ms));
+
+    hal_sim_rede_encerrar();
+    if (ao_encerrar != NULL)
+        ao_encerrar();
+    hal_sim_resumo();
+    hal_sim_flash_salvar();
+    hal_sim_usb_encerrar();
+    hal_sim_uart_encerrar();
+    if (trace != NULL)
+        fclose(trace);
+    exit(codigo_saida);
+}
+
+static uint16_t fonte_fixa[2];
+
+static uint16_t fonte_fixa_adc(uint canal, uint64_t t) {
+    (void)t;
+    return canal < 2 ? fonte_fixa[canal] : 0;
+}
+
+bool stdio_init_all(void) {
+    clock_gettime(CLOCK_MONOTONIC, &inicio_real);
+
+    const char *valor = getenv("ESTACAO_SIM_DURACAO_MS");
+    if (valor != NULL)
+        duracao_ms = (uint32_t)strtoul(valor, NULL, 10);
+
+    valor = getenv("ESTACAO_SIM_TRACE");
+    if (valor != NULL) {
+        trace = fopen(valor, "w");
+        if (trace == NULL) {
+            perror(valor);
+            exit(1);
+        }
+        fputs("tempo_ms,periferico,evento,a,b\n", trace);
+    }
+
+    // O cenario fixa duracao, entrada e semente; as variaveis valem mais
+    valor = getenv("ESTACAO_SIM_CENARIO");
+    if (valor != NULL && getenv("ESTACAO_SIM_REPRODUCAO") != NULL) {
+        fprintf(stderr, "ESTACAO_SIM_CENARIO e ESTACAO_SIM_REPRODUCAO disputam o ADC: use uma so\n");
+        exit(1);
+    }
+    if (valor != NULL) {
+        uint32_t duracao = cenario_iniciar(valor, getenv("ESTACAO_SIM_CENARIO_JSON"));
+        if (getenv("ESTACAO_SIM_DURACAO_MS") == NULL)
+            duracao_ms = duracao;
+    }
+
+#if ESTACAO_SIM_VIRTUAL
+    valor = getenv("ESTACAO_SIM_SEMENTE");
+    if (valor != NULL)
+        virtual_definir_semente(strtoull(valor, NULL, 0));
+#endif
+
+    valor = getenv("ESTACAO_SIM_ADC");
+    if (valor != NULL) {
+        unsigned nivel, chuva;
+        if (sscanf(valor, "%u,%u", &nivel, &chuva) != 2) {
+            fprintf(stderr, "ESTACAO_SIM_ADC deve ser \"nivel,chuva\"\n");
+            exit(1);
+        }
+        fonte_fixa[0] = (uint16_t)(nivel & 0xFFF);
+        fonte_fixa[1] = (uint16_t)(chuva & 0xFFF);
+        hal_sim_definir_fonte_adc(fonte_fixa_adc);
+    }
+
+    // A reproducao define a duracao pela serie, se ela nao foi fixada
+    valor = getenv("ESTACAO_SIM_REPRODUCAO");
+    if (valor != NULL) {
+        const char *escala = getenv("ESTACAO_SIM_ESCALA");
+        uint32_t duracao = reproducao_iniciar(valor, escala != NULL ? (uint32_t)strtoul(escala, NULL, 10) : 1);
+        if (getenv("ESTACAO_SIM_DURACAO_MS") == NULL)
+            duracao_ms = duracao;
+    }
+
+    hal_sim_flash_iniciar(getenv("ESTACAO_SIM_FLASH"));
+    hal_sim_usb_iniciar(getenv("ESTACAO_SIM_USB"), getenv("ESTACAO_SIM_COMANDOS"));
+    hal_sim_rede_iniciar(getenv("ESTACAO_SIM_BROKER"), getenv("ESTACAO_SIM_PORTAS"));
+    hal_sim_uart_iniciar(getenv("ESTACAO_SIM_UART"));
+    hal_sim_oled_iniciar(getenv("ESTACAO_SIM_QUADROS"), getenv("ESTACAO_SIM_QUADROS_FORMATO"));
+
+    // Prioridade maxima: encerra no instante pedido, antes das outras tarefas
+    xTaskCreate(vSimFimTask, "SimFim", configMINIMAL_STACK_SIZE, NULL, configMAX_PRIORITIES - 1, NULL);
+    return true;
+}
@@ -0,0 +1,132 @@
+#ifndef HAL_SIM_H
+#define HAL_SIM_H
+
+#include "pico/stdlib.h"
+#include "imagem.h"
+
+// -------------------- HAL simulado --------------------
+// Substitui o SDK do Pico no build do host (sim/). Cada periferico guarda o
+// estado que o firmware programou e conta o que foi feito com ele; com
+// ESTACAO_SIM_TRACE cada evento tambem vira uma linha CSV:
+//
+//   tempo_ms,periferico,evento,a,b
+//
+// O tempo simulado anda 1 ms por tick do FreeRTOS e e ele que o firmware
+// ve (time_us_64, to_ms_since_boot). Configuracao por variaveis de
+// ambiente, lidas em stdio_init_all():
+//
+//   ESTACAO_SIM_DURACAO_MS  tempo simulado ate encerrar (padrao 60000)
+//   ESTACAO_SIM_TRACE       arquivo CSV com os eventos dos perifericos
+//   ESTACAO_SIM_FLASH       imagem da flash, carregada no inicio e salva no fim
+//   ESTACAO_SIM_USB         arquivo que recebe a telemetria (saida do CDC)
+//   ESTACAO_SIM_COMANDOS    arquivo entregue ao shell como entrada do CDC
+//   ESTACAO_SIM_ADC         "nivel,chuva" em contagens fixas, no lugar da
+//                           rampa padrao
+//   ESTACAO_SIM_REPRODUCAO  serie gravada que substitui o ADC (reproducao.h)
+//   ESTACAO_SIM_ESCALA      ms da serie por ms simulado na reproducao
+//   ESTACAO_SIM_QUADROS     diretorio que recebe cada quadro do OLED
+//                           (quadro_NNNNN.png), como o painel o mostraria
+//   ESTACAO_SIM_QUADROS_FORMATO  png (padrao) ou pbm
+//   ESTACAO_SIM_CENARIO     roteiro com passos da entrada e verificacoes de
+//                           latencia e ordem dos eventos (cenario.h)
+//   ESTACAO_SIM_CENARIO_JSON resultado do cenario (verificacoes, latencias e
+//                           recuperacao de cada falha) em JSON
+//   ESTACAO_SIM_BROKER      "ip[:porta]" que recebe as conexoes TCP da estacao
+//                           (padrao 127.0.0.1 na porta pedida; rede.c)
+//   ESTACAO_SIM_PORTAS      soma as portas em que o firmware escuta, para o
+//                           host (padrao 8000: o HTTP da estacao na 8080)
+//   ESTACAO_SIM_UART        terminal ligado a UART0 (Modbus RTU): "pty" cria
+//                           um pseudoterminal e imprime o caminho (uart.c)
+//   ESTACAO_SIM_SEMENTE     intercalacao das tarefas de mesma prioridade no
+//                           estacao_virtual (sim/virtual/virtual.h); 0 segue
+//                           a ordem de chegada. Vale mais que a do cenario
+//
+// No estacao_virtual o tempo e virtual: nao depende do relogio de parede e
+// as transferencias que prendem a CPU no hardware (I2C do display, PIO da
+// matriz, apagar e gravar a flash) o fazem andar pelo tempo que levariam.
+
+#define HAL_SIM_DURACAO_PADRAO_MS 60000
+
+typedef struct {
+    uint64_t adc_amostras;
+    uint64_t dma_transferencias;
+    uint32_t dma_irqs;
+    uint32_t i2c_transacoes;
+    uint64_t i2c_bytes;
+    uint64_t pio_palavras;
+    uint32_t pwm_mudancas;
+    uint32_t gpio_eventos;
+    uint32_t flash_apagamentos;
+    uint32_t flash_programacoes;
+    uint64_t usb_enviados;
+    uint64_t usb_recebidos;
+    uint32_t trocas_clock;
+    uint32_t rede_conexoes;
+    uint64_t rede_enviados;
+    uint64_t rede_recebidos;
+    uint64_t radio_desempenho_us;
+    uint64_t uart_enviados;
+    uint64_t uart_recebidos;
+} hal_sim_contadores_t;
+
+extern hal_sim_contadores_t hal_sim_contadores;
+
+// Fonte das conversoes do ADC: contagem de 12 bits do canal no instante
+// simulado indicado.
+typedef uint16_t (*hal_sim_fonte_adc_t)(uint canal, uint64_t tempo_us);
+
+void hal_sim_definir_fonte_adc(hal_sim_fonte_adc_t fonte);
+
+// Rampa triangular no nivel (20% a 90% em 40 s) e chuva constante em 30%,
+// com +-3 contagens de ruido: cruza o limiar padrao a cada ciclo.
+uint16_t hal_sim_fonte_padrao(uint canal, uint64_t tempo_us);
+
+// Registra um evento de periferico: vai para o trace (se aberto) e para os
+// observadores.
+void hal_sim_registrar(const char *periferico, const char *evento, uint32_t a, uint32_t b);
+
+// Recebe cada evento registrado, no contexto da tarefa que o gerou.
+typedef void (*hal_sim_observador_t)(const char *periferico, const char *evento, uint32_t a, uint32_t b);
+
+#define HAL_SIM_OBSERVADORES_MAX 4
+
+void hal_sim_observar(hal_sim_observador_t observador);
+
+// Chamada no fim da simulacao, antes do resumo.
+void hal_sim_ao_encerrar(void (*funcao)(void));
+
+// A simulacao termina com codigo 1 (verificacao de cenario falhou).
+void hal_sim_falhar(void);
+
+// A tarefa atual prende a CPU por us microssegundos, como uma transferencia
+// em espera ativa. So o kernel virtual conta esse tempo; no port POSIX o
+// tempo anda com o tick real.
+void hal_sim_ocupar_us(uint32_t us);
+
+// Nivel atual do PWM no GPIO (0 se o slice estiver desligado).
+uint16_t hal_sim_pwm_nivel(uint gpio);
+
+// Imprime o resumo da simulacao em stderr.
+void hal_sim_resumo(void);
+
+// Imagem que o OLED mostra agora, pelo estado do modelo do SSD1306 (GDDRAM,
+// remapeamentos, inversao, liga/desliga), e quadros recebidos ate aqui.
+void hal_sim_oled_imagem(imagem_t *imagem);
+uint32_t hal_sim_oled_quadros(void);
+
+// -------------------- Uso interno do HAL --------------------
+void hal_sim_adc_dma_avancar(uint64_t tempo_us, uint32_t intervalo_us);
+void hal_sim_irq(uint num); // chama o handler se a interrupcao esta habilitada
+void hal_sim_uart_avancar(void);
+void hal_sim_flash_iniciar(const char *arquivo);
+void hal_sim_flash_salvar(void);
+void hal_sim_usb_iniciar(const char *saida, const char *comandos);
+void hal_sim_usb_encerrar(void);
+void hal_sim_rede_iniciar(const char *broker, const char *portas);
+void hal_sim_rede_encerrar(void);
+void hal_sim_uart_iniciar(const char *terminal);
+void hal_sim_uart_encerrar(void);
+void hal_sim_oled_iniciar(const char *diretorio, const char *formato);
+bool hal_sim_oled_escrita(uint8_t endereco, const uint8_t *dados, size_t tamanho);
+
+#endif
@@ -0,0 +1,30 @@
+#ifndef SIM_HARDWARE_ADC_H
+#define SIM_HARDWARE_ADC_H
+
+#include "pico/stdlib.h"
+
+// Registradores que o firmware acessa direto (o FIFO e a fonte do DMA)
+typedef struct {
+    volatile uint32_t cs;
+    volatile uint32_t result;
+    volatile uint32_t fcs;
+    volatile uint32_t fifo;
+    volatile uint32_t div;
+    volatile uint32_t intr;
+} adc_hw_t;
+
+extern adc_hw_t hal_sim_adc_hw;
+#define adc_hw (&hal_sim_adc_hw)
+
+void adc_init(void);
+void adc_gpio_init(uint gpio);
+void adc_select_input(uint entrada);
+uint adc_get_selected_input(void);
+void adc_set_round_robin(uint mascara);
+void adc_fifo_setup(bool habilitar, bool dreq, uint limiar, bool erro, bool byte);
+void adc_set_clkdiv(float divisor);
+void adc_run(bool rodar);
+void adc_fifo_drain(void);
+uint16_t adc_read(void);
+
+#endif
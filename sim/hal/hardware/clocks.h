@@ -0,0 +1,16 @@
+#ifndef SIM_HARDWARE_CLOCKS_H
+#define SIM_HARDWARE_CLOCKS_H
+
+#include "pico/stdlib.h"
+
+enum clock_index {
+    clk_gpout0 = 0, clk_gpout1, clk_gpout2, clk_gpout3,
+    clk_ref, clk_sys, clk_peri, clk_usb, clk_adc, clk_rtc,
+    CLK_COUNT
+};
+
+// clk_sys comeca em 125 MHz; clk_usb e clk_adc ficam em 48 MHz (PLL da USB)
+uint32_t clock_get_hz(enum clock_index relogio);
+bool set_sys_clock_khz(uint32_t khz, bool obrigatorio);
+
+#endif
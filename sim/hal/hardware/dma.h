@@ -0,0 +1,60 @@
+#ifndef SIM_HARDWARE_DMA_H
+#define SIM_HARDWARE_DMA_H
+
+#include "pico/stdlib.h"
+
+#define NUM_DMA_CHANNELS 12
+
+// Os enderecos tem a largura do ponteiro do host (no RP2040 sao 32 bits)
+typedef struct {
+    volatile uintptr_t read_addr;
+    volatile uintptr_t write_addr;
+    volatile uint32_t transfer_count;
+    volatile uint32_t ctrl_trig;
+} dma_channel_hw_t;
+
+typedef struct {
+    dma_channel_hw_t ch[NUM_DMA_CHANNELS];
+    volatile uint32_t intr;
+    volatile uint32_t inte0;
+    volatile uint32_t intf0;
+    volatile uint32_t ints0;
+} dma_hw_t;
+
+extern dma_hw_t hal_sim_dma_hw;
+#define dma_hw (&hal_sim_dma_hw)
+
+enum dma_channel_transfer_size { DMA_SIZE_8 = 0, DMA_SIZE_16 = 1, DMA_SIZE_32 = 2 };
+
+// So os DREQs que o firmware usa
+#define DREQ_PIO0_TX0  0
+#define DREQ_ADC       36
+#define DREQ_FORCE     0x3f
+
+typedef struct {
+    uint8_t tamanho;        // enum dma_channel_transfer_size
+    bool incrementa_leitura;
+    bool incrementa_escrita;
+    bool anel_na_escrita;
+    uint8_t anel_bits;      // 0 = sem anel
+    uint8_t dreq;
+    uint8_t encadear;
+} dma_channel_config;
+
+int dma_claim_unused_channel(bool obrigatorio);
+void dma_channel_unclaim(uint canal);
+dma_channel_config dma_channel_get_default_config(uint canal);
+void channel_config_set_transfer_data_size(dma_channel_config *c, enum dma_channel_transfer_size tamanho);
+void channel_config_set_read_increment(dma_channel_config *c, bool incrementa);
+void channel_config_set_write_increment(dma_channel_config *c, bool incrementa);
+void channel_config_set_ring(dma_channel_config *c, bool escrita, uint bits);
+void channel_config_set_dreq(dma_channel_config *c, uint dreq);
+void channel_config_set_chain_to(dma_channel_config *c, uint canal);
+void dma_channel_configure(uint canal, const dma_channel_config *c, volatile void *escrita,
+                           const volatile void *leitura, uint32_t contagem, bool iniciar);
+void dma_channel_set_trans_count(uint canal, uint32_t contagem, bool iniciar);
+void dma_channel_set_irq0_enabled(uint canal, bool habilitar);
+bool dma_channel_is_busy(uint canal);
+void dma_channel_abort(uint canal);
+
+#endif
@@ -0,0 +1,13 @@
+#ifndef SIM_HARDWARE_FLASH_H
+#define SIM_HARDWARE_FLASH_H
+
+#include "pico/stdlib.h"
+
+#define FLASH_PAGE_SIZE   (1u << 8)
+#define FLASH_SECTOR_SIZE (1u << 12)
+
+// Mesma semantica da flash NOR: apagar leva a 0xFF, gravar so zera bits
+void flash_range_erase(uint32_t offset, size_t tamanho);
+void flash_range_program(uint32_t offset, const uint8_t *dados, size_t tamanho);
+
+#endif
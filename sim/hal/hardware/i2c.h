@@ -0,0 +1,22 @@
+#ifndef SIM_HARDWARE_I2C_H
+#define SIM_HARDWARE_I2C_H
+
+#include "pico/stdlib.h"
+
+typedef struct i2c_inst {
+    uint indice;
+    uint baudrate;
+} i2c_inst_t;
+
+extern i2c_inst_t hal_sim_i2c[2];
+#define i2c0 (&hal_sim_i2c[0])
+#define i2c1 (&hal_sim_i2c[1])
+
+uint i2c_init(i2c_inst_t *i2c, uint baudrate);
+uint i2c_set_baudrate(i2c_inst_t *i2c, uint baudrate);
+int i2c_write_blocking(i2c_inst_t *i2c, uint8_t endereco, const uint8_t *dados, size_t tamanho, bool sem_stop);
+int i2c_write_timeout_us(i2c_inst_t *i2c, uint8_t endereco, const uint8_t *dados, size_t tamanho, bool sem_stop,
+                         uint timeout_us);
+int i2c_read_blocking(i2c_inst_t *i2c, uint8_t endereco, uint8_t *dados, size_t tamanho, bool sem_stop);
+
+#endif
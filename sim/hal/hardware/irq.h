@@ -0,0 +1,18 @@
+#ifndef SIM_HARDWARE_IRQ_H
+#define SIM_HARDWARE_IRQ_H
+
+#include "pico/stdlib.h"
+
+#define DMA_IRQ_0 11
+#define DMA_IRQ_1 12
+#define UART0_IRQ 20
+#define UART1_IRQ 21
+#define NUM_IRQS  32
+
+typedef void (*irq_handler_t)(void);
+
+// Os handlers rodam no contexto do tick do FreeRTOS (sim/hal/adc_dma.c)
+void irq_set_exclusive_handler(uint num, irq_handler_t handler);
+void irq_set_enabled(uint num, bool habilitar);
+
+#endif
@@ -0,0 +1,85 @@
+#ifndef SIM_HARDWARE_PIO_H
+#define SIM_HARDWARE_PIO_H
+
+#include "pico/stdlib.h"
+#include "hardware/clocks.h"
+
+#define NUM_PIOS 2
+#define NUM_PIO_STATE_MACHINES 4
+
+typedef struct pio_hw {
+    uint indice;
+    uint32_t sm_usadas;
+    uint32_t instrucoes_usadas;
+} pio_hw_t;
+
+typedef pio_hw_t *PIO;
+
+extern pio_hw_t hal_sim_pio[NUM_PIOS];
+#define pio0 (&hal_sim_pio[0])
+#define pio1 (&hal_sim_pio[1])
+
+typedef struct pio_program {
+    const uint16_t *instructions;
+    uint8_t length;
+    int8_t origin;
+} pio_program_t;
+
+// Configuracao da maquina de estados; so o que final.pio usa
+typedef struct {
+    uint wrap_target, wrap;
+    uint set_base, set_count;
+    float clkdiv;
+    bool shift_direita, autopull;
+    uint limiar_pull;
+} pio_sm_config;
+
+enum pio_fifo_join { PIO_FIFO_JOIN_NONE = 0, PIO_FIFO_JOIN_TX = 1, PIO_FIFO_JOIN_RX = 2 };
+
+static inline pio_sm_config pio_get_default_sm_config(void) {
+    pio_sm_config c = { .wrap_target = 0, .wrap = 31, .clkdiv = 1.0f, .shift_direita = true, .limiar_pull = 32 };
+    return c;
+}
+
+static inline void sm_config_set_wrap(pio_sm_config *c, uint alvo, uint wrap) {
+    c->wrap_target = alvo;
+    c->wrap = wrap;
+}
+
+static inline void sm_config_set_set_pins(pio_sm_config *c, uint base, uint quantidade) {
+    c->set_base = base;
+    c->set_count = quantidade;
+}
+
+static inline void sm_config_set_clkdiv(pio_sm_config *c, float divisor) {
+    c->clkdiv = divisor;
+}
+
+static inline void sm_config_set_fifo_join(pio_sm_config *c, enum pio_fifo_join juncao) {
+    (void)c;
+    (void)juncao;
+}
+
+static inline void sm_config_set_out_shift(pio_sm_config *c, bool direita, bool autopull, uint limiar) {
+    c->shift_direita = direita;
+    c->autopull = autopull;
+    c->limiar_pull = limiar;
+}
+
+static inline void sm_config_set_out_special(pio_sm_config *c, bool fixo, bool habilitar_out, uint pino) {
+    (void)c;
+    (void)fixo;
+    (void)habilitar_out;
+    (void)pino;
+}
+
+uint pio_add_program(PIO pio, const pio_program_t *programa);
+int pio_claim_unused_sm(PIO pio, bool obrigatorio);
+void pio_gpio_init(PIO pio, uint pino);
+int pio_sm_set_consecutive_pindirs(PIO pio, uint sm, uint base, uint quantidade, bool saida);
+int pio_sm_init(PIO pio, uint sm, uint inicio, const pio_sm_config *c);
+void pio_sm_set_enabled(PIO pio, uint sm, bool habilitar);
+void pio_sm_set_clkdiv(PIO pio, uint sm, float divisor);
+void pio_sm_put_blocking(PIO pio, uint sm, uint32_t palavra);
+
+#endif
@@ -0,0 +1,22 @@
+#ifndef SIM_HARDWARE_PWM_H
+#define SIM_HARDWARE_PWM_H
+
+#include "pico/stdlib.h"
+
+#define NUM_PWM_SLICES 8
+
+static inline uint pwm_gpio_to_slice_num(uint gpio) {
+    return (gpio >> 1u) & 7u;
+}
+
+static inline uint pwm_gpio_to_channel(uint gpio) {
+    return gpio & 1u;
+}
+
+void pwm_set_wrap(uint slice, uint16_t wrap);
+void pwm_set_clkdiv(uint slice, float divisor);
+void pwm_set_enabled(uint slice, bool habilitar);
+void pwm_set_chan_level(uint slice, uint canal, uint16_t nivel);
+void pwm_set_gpio_level(uint gpio, uint16_t nivel);
+
+#endif
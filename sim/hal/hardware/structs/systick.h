@@ -0,0 +1,17 @@
+#ifndef SIM_HARDWARE_STRUCTS_SYSTICK_H
+#define SIM_HARDWARE_STRUCTS_SYSTICK_H
+
+#include <stdint.h>
+
+// Sem contador de ciclos no host: medir.c le sempre zero
+typedef struct {
+    volatile uint32_t csr;
+    volatile uint32_t rvr;
+    volatile uint32_t cvr;
+    volatile uint32_t calib;
+} systick_hw_t;
+
+extern systick_hw_t hal_sim_systick_hw;
+#define systick_hw (&hal_sim_systick_hw)
+
+#endif
@@ -0,0 +1,15 @@
+#ifndef SIM_HARDWARE_STRUCTS_XIP_CTRL_H
+#define SIM_HARDWARE_STRUCTS_XIP_CTRL_H
+
+#include <stdint.h>
+
+typedef struct {
+    volatile uint32_t ctrl;
+    volatile uint32_t flush;
+    volatile uint32_t stat;
+} xip_ctrl_hw_t;
+
+extern xip_ctrl_hw_t hal_sim_xip_ctrl_hw;
+#define xip_ctrl_hw (&hal_sim_xip_ctrl_hw)
+
+#endif
@@ -0,0 +1,14 @@
+#ifndef SIM_HARDWARE_SYNC_H
+#define SIM_HARDWARE_SYNC_H
+
+#include "pico/stdlib.h"
+
+// Mapeadas para a secao critica do FreeRTOS do host, que aninha
+uint32_t save_and_disable_interrupts(void);
+void restore_interrupts(uint32_t estado);
+
+static inline void __dmb(void) {
+    __sync_synchronize();
+}
+
+#endif
@@ -0,0 +1,13 @@
+#ifndef SIM_HARDWARE_TIMER_H
+#define SIM_HARDWARE_TIMER_H
+
+#include <stdint.h>
+
+// Tempo simulado: avanca 1 ms a cada tick do FreeRTOS (sim/hal/hal_sim.c)
+uint64_t time_us_64(void);
+
+static inline uint32_t time_us_32(void) {
+    return (uint32_t)time_us_64();
+}
+
+#endif
@@ -0,0 +1,32 @@
+#ifndef SIM_HARDWARE_UART_H
+#define SIM_HARDWARE_UART_H
+
+#include "pico/stdlib.h"
+
+typedef enum {
+    UART_PARITY_NONE,
+    UART_PARITY_EVEN,
+    UART_PARITY_ODD
+} uart_parity_t;
+
+typedef struct uart_inst {
+    uint indice;
+    uint baudrate;
+    uint bits_por_caractere; // com start, paridade e stop
+} uart_inst_t;
+
+extern uart_inst_t hal_sim_uart[2];
+#define uart0 (&hal_sim_uart[0])
+#define uart1 (&hal_sim_uart[1])
+
+uint uart_init(uart_inst_t *uart, uint baudrate);
+uint uart_set_baudrate(uart_inst_t *uart, uint baudrate);
+void uart_set_format(uart_inst_t *uart, uint bits_dados, uint bits_stop, uart_parity_t paridade);
+void uart_set_fifo_enabled(uart_inst_t *uart, bool habilitar);
+void uart_set_irq_enables(uart_inst_t *uart, bool rx_tem_dados, bool tx_precisa_dados);
+bool uart_is_readable(uart_inst_t *uart);
+char uart_getc(uart_inst_t *uart);
+void uart_write_blocking(uart_inst_t *uart, const uint8_t *dados, size_t tamanho);
+void uart_tx_wait_blocking(uart_inst_t *uart);
+
+#endif
@@ -0,0 +1,210 @@
+#include <stdio.h>
+#include <string.h>
+#include "imagem.h"
+
+void imagem_de_vertical(imagem_t *imagem, const uint8_t *buffer, uint16_t largura, uint16_t altura) {
+    uint16_t paginas = (uint16_t)((altura + 7) / 8);
+
+    memset(imagem, 0, sizeof(*imagem));
+    imagem->largura = largura;
+    imagem->altura = altura;
+    for (uint16_t x = 0; x < largura; x++) {
+        for (uint16_t y = 0; y < altura; y++)
+            imagem->pixels[y][x] = (buffer[x * paginas + y / 8] >> (y & 7)) & 1;
+    }
+}
+
+uint32_t imagem_acesos(const imagem_t *imagem) {
+    uint32_t acesos = 0;
+    for (uint16_t y = 0; y < imagem->altura; y++) {
+        for (uint16_t x = 0; x < imagem->largura; x++)
+            acesos += imagem->pixels[y][x];
+    }
+    return acesos;
+}
+
+uint32_t imagem_comparar(const imagem_t *a, const imagem_t *b) {
+    if (a->largura != b->largura || a->altura != b->altura)
+        return (uint32_t)a->largura * a->altura;
+
+    uint32_t diferentes = 0;
+    for (uint16_t y = 0; y < a->altura; y++) {
+        for (uint16_t x = 0; x < a->largura; x++)
+            diferentes += a->pixels[y][x] != b->pixels[y][x];
+    }
+    return diferentes;
+}
+
+// Linha empacotada em bytes, bit mais significativo a esquerda (PBM e PNG).
+static uint16_t empacotar_linha(const imagem_t *imagem, uint16_t y, uint8_t *linha) {
+    uint16_t bytes = (uint16_t)((imagem->largura + 7) / 8);
+    memset(linha, 0, bytes);
+    for (uint16_t x = 0; x < imagem->largura; x++) {
+        if (imagem->pixels[y][x])
+            linha[x / 8] |= (uint8_t)(0x80u >> (x & 7));
+    }
+    return bytes;
+}
+
+bool imagem_gravar(const imagem_t *imagem, const char *arquivo) {
+    size_t n = strlen(arquivo);
+    if (n >= 4 && strcmp(arquivo + n - 4, ".png") == 0)
+        return imagem_gravar_png(imagem, arquivo);
+    return imagem_gravar_pbm(imagem, arquivo);
+}
+
+// -------------------- PBM --------------------
+bool imagem_gravar_pbm(const imagem_t *imagem, const char *arquivo) {
+    FILE *f = fopen(arquivo, "wb");
+    if (f == NULL)
+        return false;
+
+    uint8_t linha[IMAGEM_LARGURA_MAX / 8];
+    fprintf(f, "P4\n%u %u\n", imagem->largura, imagem->altura);
+    for (uint16_t y = 0; y < imagem->altura; y++)
+        fwrite(linha, 1, empacotar_linha(imagem, y, linha), f);
+    return fclose(f) == 0;
+}
+
+// Le um inteiro do cabecalho, pulando espacos e comentarios.
+static bool ler_campo_pbm(FILE *f, unsigned *valor) {
+    int c = fgetc(f);
+    while (c == ' ' || c == '\t' || c == '\r' || c == '\n' || c == '#') {
+        if (c == '#') {
+            while (c != '\n' && c != EOF)
+                c = fgetc(f);
+        }
+        c = fgetc(f);
+    }
+    if (c < '0' || c > '9')
+        return false;
+
+    *valor = 0;
+    while (c >= '0' && c <= '9') {
+        *valor = *valor * 10 + (unsigned)(c - '0');
+        c = fgetc(f);
+    }
+    // c e o unico espaco entre o cabecalho e os dados
+    return c != EOF;
+}
+
+bool imagem_ler_pbm(imagem_t *imagem, const char *arquivo) {
+    FILE *f = fopen(arquivo, "rb");
+    if (f == NULL)
+        return false;
+
+    unsigned largura, altura;
+    bool ok = fgetc(f) == 'P' && fgetc(f) == '4' &&
+              ler_campo_pbm(f, &largura) && ler_campo_pbm(f, &altura) &&
+              largura <= IMAGEM_LARGURA_MAX && altura <= IMAGEM_ALTURA_MAX;
+
+    if (ok) {
+        memset(imagem, 0, sizeof(*imagem));
+        imagem->largura = (uint16_t)largura;
+        imagem->altura = (uint16_t)altura;
+
+        uint8_t linha[IMAGEM_LARGURA_MAX / 8];
+        size_t bytes = (largura + 7) / 8;
+        for (uint16_t y = 0; ok && y < altura; y++) {
+            ok = fread(linha, 1, bytes, f) == bytes;
+            for (uint16_t x = 0; ok && x < largura; x++)
+                imagem->pixels[y][x] = (linha[x / 8] >> (7 - (x & 7))) & 1;
+        }
+    }
+    fclose(f);
+    return ok;
+}
+
+// -------------------- PNG --------------------
+// Um unico IDAT com o fluxo zlib em blocos "stored" (deflate tipo 0): o
+// quadro de 128x64 tem 1088 bytes crus, entao comprimir nao vale a
+// dependencia.
+static uint32_t crc32_tabela[256];
+
+static uint32_t crc32_atualizar(uint32_t crc, const uint8_t *dados, size_t tamanho) {
+    if (crc32_tabela[1] == 0) {
+        for (uint32_t n = 0; n < 256; n++) {
+            uint32_t c = n;
+            for (int k = 0; k < 8; k++)
+                c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+            crc32_tabela[n] = c;
+        }
+    }
+    crc = ~crc;
+    for (size_t i = 0; i < tamanho; i++)
+        crc = crc32_tabela[(crc ^ dados[i]) & 0xFF] ^ (crc >> 8);
+    return ~crc;
+}
+
+static void escrever_be32(uint8_t *p, uint32_t valor) {
+    p[0] = (uint8_t)(valor >> 24);
+    p[1] = (uint8_t)(valor >> 16);
+    p[2] = (uint8_t)(valor >> 8);
+    p[3] = (uint8_t)valor;
+}
+
+static void gravar_chunk(FILE *f, const char *tipo, const uint8_t *dados, uint32_t tamanho) {
+    uint8_t cabecalho[8];
+    escrever_be32(cabecalho, tamanho);
+    memcpy(cabecalho + 4, tipo, 4);
+    fwrite(cabecalho, 1, 8, f);
+    if (tamanho > 0)
+        fwrite(dados, 1, tamanho, f);
+
+    uint8_t crc[4];
+    escrever_be32(crc, crc32_atualizar(crc32_atualizar(0, (const uint8_t *)tipo, 4), dados, tamanho));
+    fwrite(crc, 1, 4, f);
+}
+
+bool imagem_gravar_png(const imagem_t *imagem, const char *arquivo) {
+    static const uint8_t assinatura[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+
+    // Linhas cruas: byte de filtro (0, nenhum) + pixels empacotados
+    uint16_t bytes_linha = (uint16_t)((imagem->largura + 7) / 8);
+    uint32_t crus = (uint32_t)imagem->altura * (1u + bytes_linha);
+    uint8_t dados[IMAGEM_ALTURA_MAX * (1 + IMAGEM_LARGURA_MAX / 8)];
+    for (uint16_t y = 0; y < imagem->altura; y++) {
+        uint8_t *linha = &dados[y * (1u + bytes_linha)];
+        linha[0] = 0;
+        empacotar_linha(imagem, y, linha + 1);
+    }
+
+    // zlib: cabecalho, um bloco stored final (cabe em 65535 bytes), Adler-32
+    uint8_t idat[2 + 5 + sizeof(dados) + 4];
+    uint32_t n = 0;
+    idat[n++] = 0x78;
+    idat[n++] = 0x01;
+    idat[n++] = 0x01; // BFINAL = 1, BTYPE = 00
+    idat[n++] = (uint8_t)crus;
+    idat[n++] = (uint8_t)(crus >> 8);
+    idat[n++] = (uint8_t)~crus;
+    idat[n++] = (uint8_t)(~crus >> 8);
+    memcpy(&idat[n], dados, crus);
+    n += crus;
+
+    uint32_t s1 = 1, s2 = 0;
+    for (uint32_t i = 0; i < crus; i++) {
+        s1 = (s1 + dados[i]) % 65521u;
+        s2 = (s2 + s1) % 65521u;
+    }
+    escrever_be32(&idat[n], (s2 << 16) | s1);
+    n += 4;
+
+    uint8_t ihdr[13];
+    escrever_be32(ihdr, imagem->largura);
+    escrever_be32(ihdr + 4, imagem->altura);
+    ihdr[8] = 1;  // 1 bit por pixel
+    ihdr[9] = 0;  // escala de cinza
+    ihdr[10] = 0; // deflate
+    ihdr[11] = 0; // filtros padrao
+    ihdr[12] = 0; // sem entrelacamento
+
+    FILE *f = fopen(arquivo, "wb");
+    if (f == NULL)
+        return false;
+    fwrite(assinatura, 1, sizeof(assinatura), f);
+    gravar_chunk(f, "IHDR", ihdr, sizeof(ihdr));
+    gravar_chunk(f, "IDAT", idat, n);
+    gravar_chunk(f, "IEND", NULL, 0);
+    return fclose(f) == 0;
+}
@@ -0,0 +1,40 @@
+#ifndef IMAGEM_H
+#define IMAGEM_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// -------------------- Imagens monocromaticas --------------------
+// Quadros do display como 1 bit por pixel, para gravar em PBM (P4) ou PNG
+// (escala de cinza de 1 bit, deflate sem compressao: dispensa a zlib) e
+// comparar com imagens de referencia. No PNG o pixel aceso e branco, como
+// no painel; no PBM e 1, que os visualizadores mostram em preto.
+
+#define IMAGEM_LARGURA_MAX 128
+#define IMAGEM_ALTURA_MAX  64
+
+typedef struct {
+    uint16_t largura, altura;
+    uint8_t pixels[IMAGEM_ALTURA_MAX][IMAGEM_LARGURA_MAX]; // 1 = aceso
+} imagem_t;
+
+// Decodifica um framebuffer no layout do ssd1306_t.ram_buffer (sem o byte
+// 0x40 inicial): enderecamento vertical, um byte por coluna de cada pagina
+// de 8 linhas, byte x * paginas + pagina, bit 0 na linha de cima.
+void imagem_de_vertical(imagem_t *imagem, const uint8_t *buffer, uint16_t largura, uint16_t altura);
+
+// Pixels acesos.
+uint32_t imagem_acesos(const imagem_t *imagem);
+
+// Pixels diferentes entre duas imagens (tamanhos diferentes: todos).
+uint32_t imagem_comparar(const imagem_t *a, const imagem_t *b);
+
+// Grava pela extensao do arquivo: ".png" em PNG, qualquer outra em PBM.
+bool imagem_gravar(const imagem_t *imagem, const char *arquivo);
+bool imagem_gravar_pbm(const imagem_t *imagem, const char *arquivo);
+bool imagem_gravar_png(const imagem_t *imagem, const char *arquivo);
+
+// Le um PBM binario (P4), o formato das imagens de referencia.
+bool imagem_ler_pbm(imagem_t *imagem, const char *arquivo);
+
+#endif
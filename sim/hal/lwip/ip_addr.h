@@ -0,0 +1,24 @@
+#ifndef SIM_LWIP_IP_ADDR_H
+#define SIM_LWIP_IP_ADDR_H
+
+#include "lwip/err.h"
+
+// -------------------- lwIP simulado: enderecos IPv4 --------------------
+// addr em ordem de rede, como no lwIP.
+
+typedef struct {
+    u32_t addr;
+} ip_addr_t;
+
+#define IPADDR_TYPE_V4  0
+#define IPADDR_TYPE_ANY 46
+
+#define IPADDR_ANY 0u
+extern const ip_addr_t ip_addr_any;
+#define IP_ADDR_ANY (&ip_addr_any)
+#define IP_ANY_TYPE IP_ADDR_ANY
+
+// 1 se o texto e um IPv4 valido ("a.b.c.d")
+int ipaddr_aton(const char *texto, ip_addr_t *endereco);
+
+#endif
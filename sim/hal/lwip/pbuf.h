@@ -0,0 +1,19 @@
+#ifndef SIM_LWIP_PBUF_H
+#define SIM_LWIP_PBUF_H
+
+#include "lwip/err.h"
+
+// -------------------- lwIP simulado: pbuf --------------------
+// Cada recv() do socket vira um pbuf de um pedaco so (next = NULL).
+
+struct pbuf {
+    struct pbuf *next;
+    void *payload;
+    u16_t tot_len;
+    u16_t len;
+};
+
+u8_t pbuf_free(struct pbuf *p);
+u16_t pbuf_copy_partial(const struct pbuf *p, void *destino, u16_t tamanho, u16_t deslocamento);
+
+#endif
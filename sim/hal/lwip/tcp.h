@@ -0,0 +1,59 @@
+#ifndef SIM_LWIP_TCP_H
+#define SIM_LWIP_TCP_H
+
+#include "lwip/err.h"
+#include "lwip/ip_addr.h"
+#include "lwip/pbuf.h"
+
+// -------------------- lwIP simulado: API raw do TCP --------------------
+// Cada tcp_pcb e um socket nao bloqueante do host. A tarefa da rede
+// (rede.c) consulta os sockets a cada tick e chama os callbacks como a
+// tarefa tcpip do lwIP faria: conexao feita, dados recebidos (p = NULL
+// quando o outro lado fecha), bytes confirmados e erro (o pcb ja foi
+// liberado). O envio fica num buffer de TCP_SND_BUF bytes ate tcp_output.
+// Um pcb em escuta e um socket do host na porta pedida mais o deslocamento
+// de ESTACAO_SIM_PORTAS (80 vira 8080); as conexoes so sao aceitas com o
+// Wi-Fi associado.
+
+#define TCP_SND_BUF (4 * 1460)
+
+#define TCP_WRITE_FLAG_COPY 0x01
+#define TCP_WRITE_FLAG_MORE 0x02
+
+#define TCP_DEFAULT_LISTEN_BACKLOG 0xff
+
+struct tcp_pcb;
+
+typedef err_t (*tcp_connected_fn)(void *arg, struct tcp_pcb *pcb, err_t err);
+typedef err_t (*tcp_recv_fn)(void *arg, struct tcp_pcb *pcb, struct pbuf *p, err_t err);
+typedef err_t (*tcp_sent_fn)(void *arg, struct tcp_pcb *pcb, u16_t tamanho);
+typedef void (*tcp_err_fn)(void *arg, err_t err);
+typedef err_t (*tcp_accept_fn)(void *arg, struct tcp_pcb *novo, err_t err);
+
+struct tcp_pcb *tcp_new(void);
+struct tcp_pcb *tcp_new_ip_type(u8_t tipo);
+
+void tcp_arg(struct tcp_pcb *pcb, void *arg);
+void tcp_recv(struct tcp_pcb *pcb, tcp_recv_fn recv);
+void tcp_sent(struct tcp_pcb *pcb, tcp_sent_fn sent);
+void tcp_err(struct tcp_pcb *pcb, tcp_err_fn err);
+void tcp_accept(struct tcp_pcb *pcb, tcp_accept_fn accept);
+
+err_t tcp_bind(struct tcp_pcb *pcb, const ip_addr_t *ip, u16_t porta);
+// Devolve o pcb de escuta; o pcb passado deixa de valer, como no lwIP
+struct tcp_pcb *tcp_listen_with_backlog(struct tcp_pcb *pcb, u8_t backlog);
+#define tcp_listen(pcb) tcp_listen_with_backlog(pcb, TCP_DEFAULT_LISTEN_BACKLOG)
+
+err_t tcp_connect(struct tcp_pcb *pcb, const ip_addr_t *ip, u16_t porta, tcp_connected_fn conectado);
+err_t tcp_write(struct tcp_pcb *pcb, const void *dados, u16_t tamanho, u8_t flags);
+err_t tcp_output(struct tcp_pcb *pcb);
+void tcp_recved(struct tcp_pcb *pcb, u16_t tamanho);
+u16_t tcp_sndbuf(const struct tcp_pcb *pcb);
+err_t tcp_close(struct tcp_pcb *pcb);
+void tcp_abort(struct tcp_pcb *pcb);
+
+// Os segmentos ja saem quando o firmware chama tcp_output
+#define tcp_nagle_disable(pcb) ((void)(pcb))
+#define tcp_nagle_enable(pcb)  ((void)(pcb))
+
+#endif
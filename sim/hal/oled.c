@@ -0,0 +1,220 @@
+#include <stdio.h>
+#include <string.h>
+#include "hal_sim.h"
+
+// -------------------- Modelo do SSD1306 --------------------
+// Interpreta as escritas I2C no endereco do display como o controlador
+// faria: bytes de controle (Co, D/C), comandos com argumentos divididos em
+// varias transacoes, enderecamento horizontal, vertical ou por pagina e a
+// janela de colunas/paginas. A GDDRAM resultante vira a imagem que o painel
+// mostraria; cada transacao de dados (um ssd1306_send_data) e um quadro.
+
+#define OLED_ENDERECO 0x3C
+#define OLED_COLUNAS  128
+#define OLED_PAGINAS  8
+
+static struct {
+    uint8_t gddram[OLED_PAGINAS][OLED_COLUNAS];
+    uint8_t modo; // 0 horizontal, 1 vertical, 2 pagina
+    uint8_t col_ini, col_fim, pag_ini, pag_fim;
+    uint8_t col, pag;
+    uint8_t linha_inicial, deslocamento;
+    bool ligado, invertido, tudo_aceso;
+    bool seg_remap, com_remap;
+
+    // Comando esperando argumentos
+    uint8_t comando, argumentos[6], recebidos, esperados;
+} oled = {
+    .col_fim = OLED_COLUNAS - 1, .pag_fim = OLED_PAGINAS - 1, .modo = 2,
+};
+
+static const char *diretorio_quadros;
+static const char *extensao_quadros = "png";
+static uint32_t quadros;
+
+// Argumentos de cada comando (os nao listados nao tem nenhum).
+static uint8_t argumentos_do_comando(uint8_t comando) {
+    switch (comando) {
+    case 0x20: case 0x81: case 0x8D: case 0xA8: case 0xD3:
+    case 0xD5: case 0xD9: case 0xDA: case 0xDB:
+        return 1;
+    case 0x21: case 0x22: case 0xA3:
+        return 2;
+    case 0x29: case 0x2A:
+        return 5;
+    case 0x26: case 0x27:
+        return 6;
+    default:
+        return 0;
+    }
+}
+
+static void executar_comando(uint8_t comando, const uint8_t *arg) {
+    switch (comando) {
+    case 0x20:
+        oled.modo = arg[0] & 3;
+        break;
+    case 0x21:
+        oled.col_ini = oled.col = arg[0] & 0x7F;
+        oled.col_fim = arg[1] & 0x7F;
+        break;
+    case 0x22:
+        oled.pag_ini = oled.pag = arg[0] & 7;
+        oled.pag_fim = arg[1] & 7;
+        break;
+    case 0xD3:
+        oled.deslocamento = arg[0] & 0x3F;
+        break;
+    case 0xA0: case 0xA1:
+        oled.seg_remap = comando & 1;
+        break;
+    case 0xC0: case 0xC8:
+        oled.com_remap = comando == 0xC8;
+        break;
+    case 0xA4: case 0xA5:
+        oled.tudo_aceso = comando & 1;
+        break;
+    case 0xA6: case 0xA7:
+        oled.invertido = comando & 1;
+        break;
+    case 0xAE: case 0xAF:
+        oled.ligado = comando & 1;
+        break;
+    default:
+        if (comando >= 0x40 && comando <= 0x7F) {
+            oled.linha_inicial = comando & 0x3F;
+        } else if (comando >= 0xB0 && comando <= 0xB7) {
+            oled.pag = comando & 7;
+        } else if (comando <= 0x0F) {
+            oled.col = (uint8_t)((oled.col & 0xF0) | comando);
+        } else if (comando >= 0x10 && comando <= 0x17) {
+            oled.col = (uint8_t)((oled.col & 0x0F) | ((comando & 7) << 4));
+        }
+        break;
+    }
+}
+
+static void receber_comando(uint8_t byte) {
+    if (oled.esperados > 0) {
+        oled.argumentos[oled.recebidos++] = byte;
+        if (oled.recebidos == oled.esperados) {
+            oled.esperados = 0;
+            executar_comando(oled.comando, oled.argumentos);
+        }
+        return;
+    }
+    oled.comando = byte;
+    oled.recebidos = 0;
+    oled.esperados = argumentos_do_comando(byte);
+    if (oled.esperados == 0)
+        executar_comando(byte, NULL);
+}
+
+// Grava na posicao atual e avanca o ponteiro conforme o modo.
+static void receber_dado(uint8_t byte) {
+    oled.gddram[oled.pag][oled.col] = byte;
+
+    switch (oled.modo) {
+    case 0:
+        if (oled.col++ >= oled.col_fim) {
+            oled.col = oled.col_ini;
+            oled.pag = oled.pag >= oled.pag_fim ? oled.pag_ini : oled.pag + 1;
+        }
+        break;
+    case 1:
+        if (oled.pag++ >= oled.pag_fim) {
+            oled.pag = oled.pag_ini;
+            oled.col = oled.col >= oled.col_fim ? oled.col_ini : oled.col + 1;
+        }
+        break;
+    default:
+        if (oled.col < OLED_COLUNAS - 1)
+            oled.col++;
+        break;
+    }
+}
+
+// Imagem vista no painel. O modulo da BitDogLab e montado para SEG e COM
+// remapeados (A1/C8, ssd1306_config): so o contrario espelha a imagem.
+void hal_sim_oled_imagem(imagem_t *imagem) {
+    memset(imagem, 0, sizeof(*imagem));
+    imagem->largura = OLED_COLUNAS;
+    imagem->altura = OLED_PAGINAS * 8;
+
+    for (uint8_t y = 0; y < OLED_PAGINAS * 8; y++) {
+        uint8_t linha = (uint8_t)((y + oled.linha_inicial + oled.deslocamento) & 0x3F);
+        for (uint8_t x = 0; x < OLED_COLUNAS; x++) {
+            uint8_t coluna = oled.seg_remap ? x : OLED_COLUNAS - 1 - x;
+            uint8_t ram_linha = oled.com_remap ? linha : OLED_PAGINAS * 8 - 1 - linha;
+            bool aceso = (oled.gddram[ram_linha >> 3][coluna] >> (ram_linha & 7)) & 1;
+            if (oled.tudo_aceso)
+                aceso = true;
+            aceso ^= oled.invertido;
+            imagem->pixels[y][x] = oled.ligado && aceso;
+        }
+    }
+}
+
+static void quadro_completo(void) {
+    imagem_t imagem;
+    hal_sim_oled_imagem(&imagem);
+    quadros++;
+    hal_sim_registrar("oled", "quadro", quadros, imagem_acesos(&imagem));
+
+    if (diretorio_quadros != NULL) {
+        char arquivo[512];
+        snprintf(arquivo, sizeof(arquivo), "%s/quadro_%05u.%s", diretorio_quadros, quadros, extensao_quadros);
+        if (!imagem_gravar(&imagem, arquivo)) {
+            perror(arquivo);
+            exit(1);
+        }
+    }
+}
+
+bool hal_sim_oled_escrita(uint8_t endereco, const uint8_t *dados, size_t tamanho) {
+    if (endereco != OLED_ENDERECO)
+        return false;
+
+    bool houve_dados = false;
+    size_t i = 0;
+    while (i < tamanho) {
+        uint8_t controle = dados[i++];
+        bool dado = controle & 0x40;
+
+        if (controle & 0x80) {
+            // Co = 1: um unico byte e depois outro byte de controle
+            if (i < tamanho) {
+                if (dado)
+                    receber_dado(dados[i]);
+                else
+                    receber_comando(dados[i]);
+                houve_dados |= dado;
+                i++;
+            }
+            continue;
+        }
+
+        // Co = 0: o resto da transacao e do mesmo tipo
+        for (; i < tamanho; i++) {
+            if (dado)
+                receber_dado(dados[i]);
+            else
+                receber_comando(dados[i]);
+        }
+        houve_dados |= dado;
+    }
+
+    if (houve_dados)
+        quadro_completo();
+    return true;
+}
+
+void hal_sim_oled_iniciar(const char *diretorio, const char *formato) {
+    diretorio_quadros = diretorio;
+    if (formato != NULL)
+        extensao_quadros = strcmp(formato, "pbm") == 0 ? "pbm" : "png";
+}
+
+uint32_t hal_sim_oled_quadros(void) {
+    return quadros;
+}
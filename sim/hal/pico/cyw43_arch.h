@@ -0,0 +1,49 @@
+#ifndef SIM_PICO_CYW43_ARCH_H
+#define SIM_PICO_CYW43_ARCH_H
+
+#include "pico/stdlib.h"
+
+// -------------------- pico/cyw43_arch.h simulado --------------------
+// O radio esta sempre associado (a nao ser durante FALHA_REDE_QUEDA) e o
+// lwIP e a API raw de sim/hal/lwip, sobre sockets do host (rede.c). O modo
+// de economia so e registrado: o resumo mostra o tempo em desempenho.
+
+#define CYW43_AUTH_OPEN          0
+#define CYW43_AUTH_WPA2_AES_PSK  0x00400004
+
+#define CYW43_ITF_STA 0
+#define CYW43_ITF_AP  1
+
+#define CYW43_LINK_DOWN    0
+#define CYW43_LINK_JOIN    1
+#define CYW43_LINK_NOIP    2
+#define CYW43_LINK_UP      3
+#define CYW43_LINK_FAIL    (-1)
+
+// So se comparam entre si; o driver codifica modo e tempos nesses valores
+#define CYW43_NONE_PM        0x1u
+#define CYW43_AGGRESSIVE_PM  0x2u
+#define CYW43_PERFORMANCE_PM 0x3u
+#define CYW43_DEFAULT_PM     CYW43_PERFORMANCE_PM
+
+typedef struct {
+    uint32_t pm;
+} cyw43_t;
+
+extern cyw43_t cyw43_state;
+
+// Cria a tarefa que faz o papel da tcpip do lwIP (rede.c)
+int cyw43_arch_init(void);
+void cyw43_arch_deinit(void);
+void cyw43_arch_enable_sta_mode(void);
+
+// Espera a associacao: na hora, ou o prazo inteiro com a rede fora
+int cyw43_arch_wifi_connect_timeout_ms(const char *ssid, const char *senha, uint32_t autenticacao, uint32_t prazo_ms);
+int cyw43_tcpip_link_status(cyw43_t *self, int itf);
+int cyw43_wifi_pm(cyw43_t *self, uint32_t pm);
+
+// Trava o "nucleo do lwIP": a tarefa da rede chama os callbacks com ele
+void cyw43_arch_lwip_begin(void);
+void cyw43_arch_lwip_end(void);
+
+#endif
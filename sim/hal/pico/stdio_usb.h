@@ -0,0 +1,18 @@
+#ifndef SIM_PICO_STDIO_USB_H
+#define SIM_PICO_STDIO_USB_H
+
+#include "pico/stdlib.h"
+
+// O CDC simulado grava o que sai num arquivo (ESTACAO_SIM_USB) e entrega o
+// conteudo de ESTACAO_SIM_COMANDOS como entrada; ver sim/hal/usb.c.
+typedef struct stdio_driver {
+    void (*out_chars)(const char *buf, int len);
+    void (*out_flush)(void);
+    int (*in_chars)(char *buf, int len);
+} stdio_driver_t;
+
+extern stdio_driver_t stdio_usb;
+
+bool stdio_usb_connected(void);
+
+#endif
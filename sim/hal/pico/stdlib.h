@@ -0,0 +1,65 @@
+#ifndef SIM_PICO_STDLIB_H
+#define SIM_PICO_STDLIB_H
+
+// -------------------- pico/stdlib.h simulado --------------------
+// Subconjunto do SDK usado pelo firmware, implementado em sim/hal sobre o
+// tempo do FreeRTOS do host. Tipos e macros seguem os nomes do SDK para que
+// DispFilaTasks.c e lib/ compilem sem alteracao.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "pico/types.h"
+#include "hardware/gpio.h"
+#include "hardware/timer.h"
+
+#define PICO_ON_DEVICE 0
+
+// Sem XIP nem SRAM separadas: as marcacoes de secao nao tem efeito. No
+// build para o emulador do Cortex-M0+ (sim/ciclos) elas valem como no SDK,
+// e o script de link poe .time_critical na SRAM.
+#if defined(__arm__)
+#define __not_in_flash(grupo) __attribute__((section(".time_critical." grupo)))
+#define __not_in_flash_func(funcao) __not_in_flash(#funcao) funcao
+#define __no_inline_not_in_flash_func(funcao) __attribute__((noinline)) __not_in_flash_func(funcao)
+#define __time_critical_func(funcao) __not_in_flash_func(funcao)
+#define __scratch_x(grupo) __attribute__((section(".scratch_x." grupo)))
+#define __scratch_y(grupo) __attribute__((section(".scratch_y." grupo)))
+#else
+#define __not_in_flash(grupo)
+#define __not_in_flash_func(funcao) funcao
+#define __no_inline_not_in_flash_func(funcao) __attribute__((noinline)) funcao
+#define __time_critical_func(funcao) funcao
+#define __scratch_x(grupo)
+#define __scratch_y(grupo)
+#endif
+
+// A flash simulada fica em RAM (sim/hal/flash.c) e e lida pela "janela XIP"
+#define PICO_FLASH_SIZE_BYTES (2u * 1024u * 1024u)
+extern uint8_t hal_sim_flash[PICO_FLASH_SIZE_BYTES];
+#define XIP_BASE ((uintptr_t)hal_sim_flash)
+
+#define PICO_OK              0
+#define PICO_ERROR_TIMEOUT   (-1)
+#define PICO_ERROR_GENERIC   (-2)
+#define PICO_ERROR_NO_DATA   (-3)
+
+#define count_of(a) (sizeof(a) / sizeof((a)[0]))
+
+static inline absolute_time_t get_absolute_time(void) {
+    return time_us_64();
+}
+
+static inline uint32_t to_ms_since_boot(absolute_time_t t) {
+    return (uint32_t)(t / 1000u);
+}
+
+// Dentro de uma tarefa vira vTaskDelay; antes do escalonador so avanca
+// o relogio simulado.
+void sleep_ms(uint32_t ms);
+void sleep_us(uint64_t us);
+
+// Inicia o HAL simulado (flash, USB, registro de atividade, fim da
+// simulacao); ver sim/hal/hal_sim.h.
+bool stdio_init_all(void);
+
+#endif
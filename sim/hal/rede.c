@@ -0,0 +1,453 @@
+#define _DEFAULT_SOURCE
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <string.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include "hal_sim.h"
+#include "falhas.h"
+#include "pico/cyw43_arch.h"
+#include "lwip/tcp.h"
+#include "FreeRTOS.h"
+#include "task.h"
+#include "semphr.h"
+
+// -------------------- Wi-Fi e TCP sobre sockets do host --------------------
+// Toda conexao do firmware vai para o host de ESTACAO_SIM_BROKER (padrao
+// 127.0.0.1), na porta pedida ou na do proprio ESTACAO_SIM_BROKER: um
+// Mosquitto local faz o papel do broker do campo. Sem ninguem escutando, a
+// conexao e recusada e o firmware ve o broker fora do ar.
+//
+// Os servidores do firmware (tcp_listen) escutam em 127.0.0.1, na porta
+// pedida mais ESTACAO_SIM_PORTAS (padrao 8000: HTTP na 8080), para nao
+// precisar de root. Sem Wi-Fi as conexoes esperam no backlog do host.
+//
+// A tarefa "tcpip" atende os sockets a cada tick, com o nucleo travado.
+// Com o kernel virtual o tempo da rede e real e o da estacao nao: a
+// resposta do broker chega em poucos ticks, mas a execucao deixa de ser
+// reproduzivel pela semente.
+#define REDE_PERIODO_MS 1
+#define REDE_PEDACO     1460
+#define REDE_PEDACOS_POR_TICK 16
+#define REDE_ACEITES_POR_TICK 4
+#define REDE_DESLOCAMENTO_PADRAO 8000
+
+typedef enum {
+    PCB_NOVO,
+    PCB_CONECTANDO,
+    PCB_CONECTADO,
+    PCB_FECHADO_REMOTO, // o outro lado fechou; o firmware ainda nao chamou tcp_close
+    PCB_ESCUTANDO,
+    PCB_LIBERAR
+} estado_pcb_t;
+
+struct tcp_pcb {
+    int fd;
+    estado_pcb_t estado;
+    u16_t porta;
+    void *arg;
+    tcp_connected_fn conectado;
+    tcp_recv_fn receber;
+    tcp_sent_fn enviado;
+    tcp_err_fn erro;
+    tcp_accept_fn aceitar;
+    uint8_t saida[TCP_SND_BUF];
+    size_t pendente; // bytes em saida, ainda nao aceitos pelo socket
+    size_t entregues; // aceitos pelo socket e ainda nao avisados (tcp_sent)
+    struct tcp_pcb *proximo;
+};
+
+cyw43_t cyw43_state;
+const ip_addr_t ip_addr_any = { IPADDR_ANY };
+
+static struct tcp_pcb *pcbs;
+static SemaphoreHandle_t nucleo;
+static TaskHandle_t dono_nucleo;
+static uint32_t travas;
+static bool associado;
+static struct in_addr destino;
+static u16_t destino_porta; // 0: a porta que o firmware pediu
+static u16_t deslocamento_portas = REDE_DESLOCAMENTO_PADRAO;
+static uint64_t desempenho_desde_us;
+
+// -------------------- Nucleo --------------------
+// Recursivo como o do pico_cyw43_arch_lwip_sys_freertos
+void cyw43_arch_lwip_begin(void) {
+    if (nucleo == NULL)
+        return;
+    if (dono_nucleo != xTaskGetCurrentTaskHandle()) {
+        xSemaphoreTake(nucleo, portMAX_DELAY);
+        dono_nucleo = xTaskGetCurrentTaskHandle();
+    }
+    travas++;
+}
+
+void cyw43_arch_lwip_end(void) {
+    if (nucleo == NULL || --travas > 0)
+        return;
+    dono_nucleo = NULL;
+    xSemaphoreGive(nucleo);
+}
+
+// -------------------- pbuf e enderecos --------------------
+u8_t pbuf_free(struct pbuf *p) {
+    free(p);
+    return 1;
+}
+
+u16_t pbuf_copy_partial(const struct pbuf *p, void *dados, u16_t tamanho, u16_t deslocamento) {
+    if (deslocamento >= p->len)
+        return 0;
+    if (tamanho > p->len - deslocamento)
+        tamanho = (u16_t)(p->len - deslocamento);
+    memcpy(dados, (const uint8_t *)p->payload + deslocamento, tamanho);
+    return tamanho;
+}
+
+int ipaddr_aton(const char *texto, ip_addr_t *endereco) {
+    struct in_addr a;
+    if (inet_pton(AF_INET, texto, &a) != 1)
+        return 0;
+    endereco->addr = a.s_addr;
+    return 1;
+}
+
+// -------------------- TCP --------------------
+struct tcp_pcb *tcp_new(void) {
+    struct tcp_pcb *pcb = calloc(1, sizeof(*pcb));
+    if (pcb == NULL)
+        return NULL;
+    pcb->fd = -1;
+    pcb->proximo = pcbs;
+    pcbs = pcb;
+    return pcb;
+}
+
+struct tcp_pcb *tcp_new_ip_type(u8_t tipo) {
+    (void)tipo;
+    return tcp_new();
+}
+
+void tcp_arg(struct tcp_pcb *pcb, void *arg) { pcb->arg = arg; }
+void tcp_recv(struct tcp_pcb *pcb, tcp_recv_fn recv) { pcb->receber = recv; }
+void tcp_sent(struct tcp_pcb *pcb, tcp_sent_fn sent) { pcb->enviado = sent; }
+void tcp_err(struct tcp_pcb *pcb, tcp_err_fn err) { pcb->erro = err; }
+void tcp_accept(struct tcp_pcb *pcb, tcp_accept_fn accept) { pcb->aceitar = accept; }
+
+err_t tcp_bind(struct tcp_pcb *pcb, const ip_addr_t *ip, u16_t porta) {
+    (void)ip; // sempre 127.0.0.1 no host
+    pcb->porta = porta;
+    return ERR_OK;
+}
+
+struct tcp_pcb *tcp_listen_with_backlog(struct tcp_pcb *pcb, u8_t backlog) {
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (fd < 0)
+        return NULL;
+    int um = 1;
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &um, sizeof(um));
+    u16_t porta_host = (u16_t)(pcb->porta + deslocamento_portas);
+    struct sockaddr_in endereco = {
+        .sin_family = AF_INET,
+        .sin_addr.s_addr = htonl(INADDR_LOOPBACK),
+        .sin_port = htons(porta_host)
+    };
+    if (bind(fd, (struct sockaddr *)&endereco, sizeof(endereco)) < 0 || listen(fd, backlog) < 0) {
+        fprintf(stderr, "rede: nao foi possivel escutar na porta %u: %s\n", porta_host, strerror(errno));
+        close(fd);
+        return NULL;
+    }
+    fcntl(fd, F_SETFL, O_NONBLOCK);
+    pcb->fd = fd;
+    pcb->estado = PCB_ESCUTANDO;
+    hal_sim_registrar("rede", "escuta", pcb->porta, porta_host);
+    return pcb;
+}
+
+err_t tcp_connect(struct tcp_pcb *pcb, const ip_addr_t *ip, u16_t porta, tcp_connected_fn conectado) {
+    (void)ip;
+    if (!associado)
+        return ERR_RTE;
+    pcb->fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (pcb->fd < 0)
+        return ERR_MEM;
+    fcntl(pcb->fd, F_SETFL, O_NONBLOCK);
+
+    struct sockaddr_in endereco = {
+        .sin_family = AF_INET,
+        .sin_addr = destino,
+        .sin_port = htons(destino_porta ? destino_porta : porta)
+    };
+    if (connect(pcb->fd, (struct sockaddr *)&endereco, sizeof(endereco)) < 0 && errno != EINPROGRESS) {
+        close(pcb->fd);
+        pcb->fd = -1;
+        return ERR_RTE;
+    }
+    pcb->porta = porta;
+    pcb->conectado = conectado;
+    pcb->estado = PCB_CONECTANDO;
+    return ERR_OK;
+}
+
+u16_t tcp_sndbuf(const struct tcp_pcb *pcb) {
+    return (u16_t)(TCP_SND_BUF - pcb->pendente);
+}
+
+err_t tcp_write(struct tcp_pcb *pcb, const void *dados, u16_t tamanho, u8_t flags) {
+    (void)flags; // sempre copia
+    if (pcb->estado != PCB_CONECTADO && pcb->estado != PCB_FECHADO_REMOTO)
+        return ERR_CONN;
+    if (tamanho > tcp_sndbuf(pcb))
+        return ERR_MEM;
+    memcpy(&pcb->saida[pcb->pendente], dados, tamanho);
+    pcb->pendente += tamanho;
+    return ERR_OK;
+}
+
+// Entrega ao socket o que couber; o resto sai nos proximos ticks
+static void descarregar(struct tcp_pcb *pcb) {
+    if (pcb->pendente == 0 || pcb->fd < 0)
+        return;
+    ssize_t n = send(pcb->fd, pcb->saida, pcb->pendente, MSG_NOSIGNAL | MSG_DONTWAIT);
+    if (n <= 0)
+        return;
+    memmove(pcb->saida, &pcb->saida[n], pcb->pendente - (size_t)n);
+    pcb->pendente -= (size_t)n;
+    pcb->entregues += (size_t)n;
+    hal_sim_contadores.rede_enviados += (uint64_t)n;
+}
+
+err_t tcp_output(struct tcp_pcb *pcb) {
+    descarregar(pcb);
+    return ERR_OK;
+}
+
+void tcp_recved(struct tcp_pcb *pcb, u16_t tamanho) {
+    (void)pcb;
+    (void)tamanho; // a janela e a do socket do host
+}
+
+static void liberar(struct tcp_pcb *pcb) {
+    if (pcb->fd >= 0)
+        close(pcb->fd);
+    pcb->fd = -1;
+    pcb->estado = PCB_LIBERAR;
+}
+
+err_t tcp_close(struct tcp_pcb *pcb) {
+    descarregar(pcb);
+    if (pcb->estado == PCB_CONECTADO || pcb->estado == PCB_FECHADO_REMOTO)
+        hal_sim_registrar("rede", "fecha", pcb->porta, 0);
+    liberar(pcb);
+    return ERR_OK;
+}
+
+void tcp_abort(struct tcp_pcb *pcb) {
+    liberar(pcb);
+}
+
+// Erro do lado da rede: o pcb deixa de existir antes do callback, como no lwIP
+static void abortar(struct tcp_pcb *pcb, err_t err) {
+    liberar(pcb);
+    if (pcb->erro != NULL)
+        pcb->erro(pcb->arg, err);
+}
+
+// -------------------- Tarefa da rede --------------------
+// O pcb novo herda o arg do de escuta; se o callback recusar, e abortado
+static void aceitar(struct tcp_pcb *escuta) {
+    for (int i = 0; i < REDE_ACEITES_POR_TICK && associado; i++) {
+        int fd = accept(escuta->fd, NULL, NULL);
+        if (fd < 0)
+            return;
+        struct tcp_pcb *pcb = tcp_new();
+        if (pcb == NULL) {
+            close(fd);
+            return;
+        }
+        fcntl(fd, F_SETFL, O_NONBLOCK);
+        pcb->fd = fd;
+        pcb->estado = PCB_CONECTADO;
+        pcb->porta = escuta->porta;
+        pcb->arg = escuta->arg;
+        hal_sim_contadores.rede_conexoes++;
+        hal_sim_registrar("rede", "aceita", pcb->porta, 0);
+        err_t err = escuta->aceitar != NULL ? escuta->aceitar(escuta->arg, pcb, ERR_OK) : ERR_VAL;
+        if (err != ERR_OK && err != ERR_ABRT) {
+            hal_sim_registrar("rede", "recusa", pcb->porta, 0);
+            tcp_abort(pcb);
+        }
+    }
+}
+
+static void terminar_conexao(struct tcp_pcb *pcb) {
+    struct pollfd p = { .fd = pcb->fd, .events = POLLOUT };
+    if (poll(&p, 1, 0) <= 0)
+        return;
+    int erro = 0;
+    socklen_t tamanho = sizeof(erro);
+    getsockopt(pcb->fd, SOL_SOCKET, SO_ERROR, &erro, &tamanho);
+    if (erro != 0) {
+        hal_sim_registrar("rede", "recusada", pcb->porta, 0);
+        abortar(pcb, ERR_RST);
+        return;
+    }
+    pcb->estado = PCB_CONECTADO;
+    hal_sim_contadores.rede_conexoes++;
+    hal_sim_registrar("rede", "conecta", pcb->porta, 0);
+    if (pcb->conectado != NULL)
+        pcb->conectado(pcb->arg, pcb, ERR_OK);
+}
+
+static void receber(struct tcp_pcb *pcb) {
+    for (int i = 0; i < REDE_PEDACOS_POR_TICK && pcb->estado == PCB_CONECTADO; i++) {
+        struct pbuf *p = malloc(sizeof(struct pbuf) + REDE_PEDACO);
+        if (p == NULL)
+            return;
+        ssize_t n = recv(pcb->fd, p + 1, REDE_PEDACO, MSG_DONTWAIT);
+        if (n < 0) {
+            free(p);
+            if (errno != EAGAIN && errno != EWOULDBLOCK) {
+                hal_sim_registrar("rede", "reset", pcb->porta, 0);
+                abortar(pcb, ERR_RST);
+            }
+            return;
+        }
+        if (n == 0) {
+            free(p);
+            pcb->estado = PCB_FECHADO_REMOTO;
+            if (pcb->receber != NULL)
+                pcb->receber(pcb->arg, pcb, NULL, ERR_OK);
+            return;
+        }
+        hal_sim_contadores.rede_recebidos += (uint64_t)n;
+        *p = (struct pbuf){ .payload = p + 1, .tot_len = (u16_t)n, .len = (u16_t)n };
+        if (pcb->receber != NULL)
+            pcb->receber(pcb->arg, pcb, p, ERR_OK);
+        else
+            pbuf_free(p);
+    }
+}
+
+static void atender(struct tcp_pcb *pcb) {
+    if (pcb->estado == PCB_ESCUTANDO) {
+        aceitar(pcb);
+        return;
+    }
+    if (pcb->estado == PCB_CONECTANDO)
+        terminar_conexao(pcb);
+    if (pcb->estado != PCB_CONECTADO && pcb->estado != PCB_FECHADO_REMOTO)
+        return;
+    // O socket aceitou: conta como ACK, tambem o que saiu no tcp_output
+    descarregar(pcb);
+    size_t n = pcb->entregues;
+    pcb->entregues = 0;
+    if (n > 0 && pcb->enviado != NULL && pcb->enviado(pcb->arg, pcb, (u16_t)n) == ERR_ABRT)
+        return;
+    receber(pcb);
+}
+
+static void vRedeTask(void *params) {
+    (void)params;
+    while (true) {
+        vTaskDelay(pdMS_TO_TICKS(REDE_PERIODO_MS));
+        cyw43_arch_lwip_begin();
+
+        // Queda do Wi-Fi: derruba tudo de uma vez, como a perda do link
+        bool queda = associado && falhas_rede();
+        if (queda) {
+            associado = false;
+            hal_sim_registrar("rede", "queda", 0, 0);
+        }
+        for (struct tcp_pcb *pcb = pcbs; pcb != NULL; pcb = pcb->proximo) {
+            if (pcb->estado == PCB_LIBERAR || pcb->estado == PCB_NOVO)
+                continue;
+            if (!queda)
+                atender(pcb);
+            else if (pcb->estado != PCB_ESCUTANDO) // a escuta sobrevive, como no lwIP
+                abortar(pcb, ERR_ABRT);
+        }
+
+        // Os callbacks podem fechar qualquer pcb: so libera no fim da volta
+        for (struct tcp_pcb **p = &pcbs; *p != NULL;) {
+            struct tcp_pcb *pcb = *p;
+            if (pcb->estado == PCB_LIBERAR) {
+                *p = pcb->proximo;
+                free(pcb);
+            } else {
+                p = &pcb->proximo;
+            }
+        }
+        cyw43_arch_lwip_end();
+    }
+}
+
+// -------------------- CYW43 --------------------
+int cyw43_arch_init(void) {
+    if (nucleo != NULL)
+        return 0;
+    nucleo = xSemaphoreCreateMutex();
+    cyw43_state.pm = CYW43_DEFAULT_PM;
+    desempenho_desde_us = time_us_64();
+    xTaskCreate(vRedeTask, "tcpip", configMINIMAL_STACK_SIZE, NULL, 2, NULL); // TCPIP_THREAD_PRIO
+    return 0;
+}
+
+void cyw43_arch_deinit(void) {
+}
+
+void cyw43_arch_enable_sta_mode(void) {
+}
+
+int cyw43_arch_wifi_connect_timeout_ms(const char *ssid, const char *senha, uint32_t autenticacao, uint32_t prazo_ms) {
+    (void)ssid;
+    (void)senha;
+    (void)autenticacao;
+    if (falhas_rede()) {
+        vTaskDelay(pdMS_TO_TICKS(prazo_ms));
+        return PICO_ERROR_TIMEOUT;
+    }
+    if (!associado)
+        hal_sim_registrar("rede", "associa", 0, 0);
+    associado = true;
+    return 0;
+}
+
+int cyw43_tcpip_link_status(cyw43_t *self, int itf) {
+    (void)self;
+    (void)itf;
+    return associado ? CYW43_LINK_UP : CYW43_LINK_DOWN;
+}
+
+int cyw43_wifi_pm(cyw43_t *self, uint32_t pm) {
+    uint64_t agora = time_us_64();
+    if (self->pm == CYW43_PERFORMANCE_PM)
+        hal_sim_contadores.radio_desempenho_us += agora - desempenho_desde_us;
+    desempenho_desde_us = agora;
+    if (pm != self->pm)
+        hal_sim_registrar("radio", pm == CYW43_PERFORMANCE_PM ? "desempenho" : "economia", 0, 0);
+    self->pm = pm;
+    return 0;
+}
+
+void hal_sim_rede_iniciar(const char *broker, const char *portas) {
+    destino.s_addr = htonl(INADDR_LOOPBACK);
+    if (portas != NULL)
+        deslocamento_portas = (u16_t)strtoul(portas, NULL, 10);
+    if (broker == NULL)
+        return;
+    char host[64];
+    unsigned porta = 0;
+    if (sscanf(broker, "%63[^:]:%u", host, &porta) < 1 || inet_pton(AF_INET, host, &destino) != 1 || porta > 65535) {
+        fprintf(stderr, "ESTACAO_SIM_BROKER deve ser \"ip[:porta]\"\n");
+        exit(1);
+    }
+    destino_porta = (u16_t)porta;
+}
+
+void hal_sim_rede_encerrar(void) {
+    cyw43_wifi_pm(&cyw43_state, cyw43_state.pm); // fecha a conta do tempo em desempenho
+}
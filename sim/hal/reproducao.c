@@ -0,0 +1,342 @@
+#include <string.h>
+#include "reproducao.h"
+#include "hal_sim.h"
+#include "hardware/pwm.h"
+#include "serie_comp.h"
+#include "config.h"
+#include "FreeRTOS.h"
+#include "task.h"
+
+typedef struct {
+    int64_t tempo_ms;  // tempo da serie
+    uint16_t valor[2]; // nivel, chuva (centesimos de %)
+} ponto_t;
+
+static ponto_t *serie;
+static size_t num_pontos;
+static int64_t inicio_serie_ms;
+static uint32_t escala;
+static size_t cursor_adc; // o ADC so anda para frente no tempo
+
+// Pareamento das transicoes da entrada com as do LED
+static bool alerta_led;
+static bool pendente;
+static bool estado_pendente;
+static uint32_t tempo_pendente_ms;
+static uint32_t transicoes, detectadas, perdidas, espurias;
+static uint64_t soma_latencia_ms;
+static uint32_t min_latencia_ms = UINT32_MAX, max_latencia_ms;
+static uint32_t ultima_cor = UINT32_MAX;
+
+// -------------------- Carga --------------------
+static void adicionar(int64_t tempo_ms, uint16_t nivel, uint16_t chuva) {
+    static size_t capacidade;
+    if (num_pontos == capacidade) {
+        capacidade = capacidade ? capacidade * 2 : 1024;
+        serie = realloc(serie, capacidade * sizeof(ponto_t));
+        if (serie == NULL) {
+            fprintf(stderr, "reproducao: sem memoria\n");
+            exit(1);
+        }
+    }
+    serie[num_pontos++] = (ponto_t){ .tempo_ms = tempo_ms, .valor = { nivel, chuva } };
+}
+
+static uint16_t centesimos(const char *texto) {
+    double pct = strtod(texto, NULL);
+    if (pct < 0.0)
+        pct = 0.0;
+    if (pct > 100.0)
+        pct = 100.0;
+    return (uint16_t)(pct * 100.0 + 0.5);
+}
+
+// Divide a linha nos campos separados por virgula (altera a linha).
+static int campos(char *linha, char **saida, int max) {
+    int n = 0;
+    char *p = linha;
+    while (n < max) {
+        saida[n++] = p;
+        p = strchr(p, ',');
+        if (p == NULL)
+            break;
+        *p++ = '\0';
+    }
+    return n;
+}
+
+#define CSV_CAMPOS_MAX 16
+
+static void carregar_csv(FILE *f, char *cabecalho) {
+    char *nomes[CSV_CAMPOS_MAX];
+    int n = campos(cabecalho, nomes, CSV_CAMPOS_MAX);
+    int col_tempo = -1, col_nivel = -1, col_chuva = -1, col_tipo = -1;
+    double fator_tempo = 1.0;
+    for (int i = 0; i < n; i++) {
+        nomes[i][strcspn(nomes[i], "\r\n")] = '\0';
+        if (strcmp(nomes[i], "tempo_ms") == 0) {
+            col_tempo = i;
+        } else if (strcmp(nomes[i], "tempo_s") == 0) {
+            col_tempo = i;
+            fator_tempo = 1000.0;
+        } else if (strcmp(nomes[i], "nivel_agua") == 0 || strcmp(nomes[i], "nivel") == 0) {
+            col_nivel = i;
+        } else if (strcmp(nomes[i], "volume_chuva") == 0 || strcmp(nomes[i], "chuva") == 0) {
+            col_chuva = i;
+        } else if (strcmp(nomes[i], "tipo") == 0) {
+            col_tipo = i;
+        }
+    }
+    if (col_tempo < 0 || col_nivel < 0 || col_chuva < 0) {
+        fprintf(stderr, "reproducao: o CSV precisa das colunas tempo_ms|tempo_s, nivel_agua e volume_chuva\n");
+        exit(1);
+    }
+
+    char linha[256];
+    char *valores[CSV_CAMPOS_MAX];
+    while (fgets(linha, sizeof(linha), f) != NULL) {
+        n = campos(linha, valores, CSV_CAMPOS_MAX);
+        if (n <= col_tempo || n <= col_nivel || n <= col_chuva)
+            continue;
+        if (col_tipo >= 0 && (n <= col_tipo || strcmp(valores[col_tipo], "amostra") != 0))
+            continue;
+        adicionar((int64_t)(strtod(valores[col_tempo], NULL) * fator_tempo),
+                  centesimos(valores[col_nivel]), centesimos(valores[col_chuva]));
+    }
+}
+
+static void carregar_binario(FILE *f) {
+    amostra_comp_t a;
+    while (fread(&a, sizeof(a), 1, f) == 1)
+        adicionar(a.tempo_ms, a.nivel_agua, a.volume_chuva);
+}
+
+static int comparar_tempo(const void *a, const void *b) {
+    int64_t ta = ((const ponto_t *)a)->tempo_ms;
+    int64_t tb = ((const ponto_t *)b)->tempo_ms;
+    return (ta > tb) - (ta < tb);
+}
+
+// -------------------- Interpolacao --------------------
+// Tempo simulado (ms) <-> tempo da serie (ms)
+static inline int64_t tempo_serie(int64_t tempo_ms) {
+    return inicio_serie_ms + tempo_ms * escala;
+}
+
+static inline double segundos_serie(int64_t tempo_ms) {
+    return (double)tempo_serie(tempo_ms) / 1000.0;
+}
+
+static uint16_t interpolar(size_t i, uint canal, int64_t t) {
+    if (t <= serie[i].tempo_ms || i + 1 >= num_pontos)
+        return serie[i].valor[canal];
+    const ponto_t *a = &serie[i], *b = &serie[i + 1];
+    if (t >= b->tempo_ms || b->tempo_ms == a->tempo_ms)
+        return b->valor[canal];
+    int64_t v0 = a->valor[canal], v1 = b->valor[canal];
+    return (uint16_t)(v0 + (v1 - v0) * (t - a->tempo_ms) / (b->tempo_ms - a->tempo_ms));
+}
+
+// Indice do segmento [i, i+1] que contem t (o ultimo ponto apos o fim).
+static size_t segmento(int64_t t) {
+    size_t lo = 0, hi = num_pontos - 1;
+    while (lo < hi) {
+        size_t meio = (lo + hi + 1) / 2;
+        if (serie[meio].tempo_ms <= t)
+            lo = meio;
+        else
+            hi = meio - 1;
+    }
+    return lo;
+}
+
+static uint16_t valor_em(uint canal, int64_t tempo_ms) {
+    int64_t t = tempo_serie(tempo_ms);
+    return interpolar(segmento(t), canal, t);
+}
+
+static uint16_t fonte_reproducao(uint canal, uint64_t tempo_us) {
+    if (canal > 1)
+        return 0;
+    int64_t t = inicio_serie_ms + (int64_t)(tempo_us * escala / 1000u);
+    while (cursor_adc + 1 < num_pontos && serie[cursor_adc + 1].tempo_ms <= t)
+        cursor_adc++;
+    return (uint16_t)((interpolar(cursor_adc, canal, t) * 4095u + 5000u) / 10000u);
+}
+
+// -------------------- Limiares --------------------
+static bool alerta_em(int64_t tempo_ms, const config_estacao_t *c) {
+    return valor_em(0, tempo_ms) >= c->limiar_agua || valor_em(1, tempo_ms) >= c->limiar_chuva;
+}
+
+static inline int64_t div_teto(int64_t a, int64_t b) {
+    return a >= 0 ? (a + b - 1) / b : -((-a) / b);
+}
+
+// Dentro de um segmento cada canal e linear: a comparacao com o limiar muda
+// no maximo uma vez e a busca binaria acha o primeiro ms em que mudou.
+static int64_t virada(uint canal, uint16_t limiar, int64_t lo, int64_t hi) {
+    bool final = valor_em(canal, hi) >= limiar;
+    if ((valor_em(canal, lo) >= limiar) == final)
+        return -1;
+    while (lo < hi) {
+        int64_t meio = lo + (hi - lo) / 2;
+        if ((valor_em(canal, meio) >= limiar) == final)
+            hi = meio;
+        else
+            lo = meio + 1;
+    }
+    return lo;
+}
+
+// Primeiro ms simulado apos desde em que o estado de alerta da entrada
+// difere de estado; -1 se a serie nao muda mais.
+static int64_t proxima_transicao(int64_t desde, bool estado, const config_estacao_t *c) {
+    for (size_t i = segmento(tempo_serie(desde)); i + 1 < num_pontos; i++) {
+        int64_t lo = div_teto(serie[i].tempo_ms - inicio_serie_ms, escala);
+        int64_t hi = (serie[i + 1].tempo_ms - inicio_serie_ms) / escala;
+        if (lo <= desde)
+            lo = desde + 1;
+        if (lo > hi)
+            continue;
+
+        int64_t candidatos[3] = { lo, virada(0, c->limiar_agua, lo, hi), virada(1, c->limiar_chuva, lo, hi) };
+        int64_t primeiro = -1;
+        for (int k = 0; k < 3; k++) {
+            int64_t t = candidatos[k];
+            if (t >= 0 && (primeiro < 0 || t < primeiro) && alerta_em(t, c) != estado)
+                primeiro = t;
+        }
+        if (primeiro >= 0)
+            return primeiro;
+    }
+    return -1;
+}
+
+// -------------------- Eventos --------------------
+static void emitir(uint32_t tempo_ms, const char *origem, const char *evento, const char *valor) {
+    printf("%u,%.3f,%s,%s,%s\n", tempo_ms, segundos_serie(tempo_ms), origem, evento, valor);
+}
+
+static void transicao_entrada(uint32_t tempo_ms, bool estado) {
+    emitir(tempo_ms, "entrada", "alerta", estado ? "1" : "0");
+    transicoes++;
+    if (pendente)
+        perdidas++; // a anterior voltou antes de a estacao reagir
+    if (estado == alerta_led) {
+        pendente = false;
+    } else {
+        pendente = true;
+        estado_pendente = estado;
+        tempo_pendente_ms = tempo_ms;
+    }
+}
+
+static void transicao_led(uint32_t tempo_ms, bool estado) {
+    emitir(tempo_ms, "led", "alerta", estado ? "1" : "0");
+    alerta_led = estado;
+    if (!pendente || estado_pendente != estado) {
+        espurias++;
+        return;
+    }
+    uint32_t latencia = tempo_ms - tempo_pendente_ms;
+    detectadas++;
+    soma_latencia_ms += latencia;
+    if (latencia < min_latencia_ms)
+        min_latencia_ms = latencia;
+    if (latencia > max_latencia_ms)
+        max_latencia_ms = latencia;
+    pendente = false;
+}
+
+static void observar(const char *periferico, const char *evento, uint32_t a, uint32_t b) {
+    uint32_t agora = (uint32_t)(time_us_64() / 1000u);
+    char valor[16];
+    if (strcmp(periferico, "pwm") == 0 && strcmp(evento, "nivel") == 0) {
+        if (a == pwm_gpio_to_slice_num(REPRODUCAO_GPIO_ALERTA) * 2 + pwm_gpio_to_channel(REPRODUCAO_GPIO_ALERTA)) {
+            if ((b > 0) != alerta_led)
+                transicao_led(agora, b > 0);
+        } else if (a == pwm_gpio_to_slice_num(REPRODUCAO_GPIO_BUZZER) * 2 + pwm_gpio_to_channel(REPRODUCAO_GPIO_BUZZER)) {
+            snprintf(valor, sizeof(valor), "%u", b);
+            emitir(agora, "buzzer", "nivel", valor);
+        }
+    } else if (strcmp(periferico, "pio") == 0 && strcmp(evento, "palavra") == 0 && b != ultima_cor) {
+        ultima_cor = b;
+        snprintf(valor, sizeof(valor), "0x%08X", b);
+        emitir(agora, "matriz", "cor", valor);
+    }
+}
+
+// Acorda so nos instantes em que a entrada cruza um limiar. Os limiares
+// sao relidos a cada passo, entao um `set` pelo shell vale dali em diante.
+static void vReproducaoTask(void *params) {
+    (void)params;
+    config_estacao_t config;
+    config_obter(&config);
+    int64_t agora = xTaskGetTickCount();
+    bool estado = alerta_em(agora, &config);
+    if (estado)
+        transicao_entrada((uint32_t)agora, true);
+
+    while (true) {
+        int64_t proxima = proxima_transicao(agora, estado, &config);
+        if (proxima < 0)
+            break;
+        vTaskDelay((TickType_t)(proxima - xTaskGetTickCount()));
+        agora = proxima;
+
+        config_obter(&config);
+        if (alerta_em(agora, &config) != estado) {
+            estado = !estado;
+            transicao_entrada((uint32_t)agora, estado);
+        }
+    }
+    vTaskDelete(NULL);
+}
+
+static void resumo(void) {
+    fflush(stdout);
+    fprintf(stderr, "reproducao: %zu pontos, %.1f s da serie (escala %u)\n", num_pontos,
+            (double)(serie[num_pontos - 1].tempo_ms - serie[0].tempo_ms) / 1000.0, escala);
+    fprintf(stderr, "transicoes da entrada: %u; detectadas: %u; perdidas: %u; espurias: %u\n",
+            transicoes, detectadas, perdidas + (pendente ? 1u : 0u), espurias);
+    if (detectadas) {
+        fprintf(stderr, "latencia ate o LED: media %.1f ms, min %u ms, max %u ms simulados "
+                "(max %.1f s da serie)\n", (double)soma_latencia_ms / detectadas, min_latencia_ms,
+                max_latencia_ms, (double)max_latencia_ms * escala / 1000.0);
+    }
+}
+
+uint32_t reproducao_iniciar(const char *arquivo, uint32_t nova_escala) {
+    FILE *f = fopen(arquivo, "rb");
+    if (f == NULL) {
+        perror(arquivo);
+        exit(1);
+    }
+    char cabecalho[256];
+    if (fgets(cabecalho, sizeof(cabecalho), f) != NULL && strstr(cabecalho, "tempo") != NULL) {
+        carregar_csv(f, cabecalho);
+    } else {
+        rewind(f);
+        carregar_binario(f);
+    }
+    fclose(f);
+    if (num_pontos == 0) {
+        fprintf(stderr, "reproducao: %s nao tem pontos\n", arquivo);
+        exit(1);
+    }
+
+    qsort(serie, num_pontos, sizeof(ponto_t), comparar_tempo);
+    inicio_serie_ms = serie[0].tempo_ms;
+    escala = nova_escala ? nova_escala : 1;
+
+    hal_sim_definir_fonte_adc(fonte_reproducao);
+    hal_sim_observar(observar);
+    hal_sim_ao_encerrar(resumo);
+    printf("tempo_ms,tempo_serie_s,origem,evento,valor\n");
+
+    // Acima das tarefas do firmware: a transicao sai antes da reacao
+    xTaskCreate(vReproducaoTask, "Reproducao", configMINIMAL_STACK_SIZE, NULL, configMAX_PRIORITIES - 2, NULL);
+
+    return (uint32_t)((serie[num_pontos - 1].tempo_ms - inicio_serie_ms) / escala) + REPRODUCAO_MARGEM_MS;
+}
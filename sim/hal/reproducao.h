@@ -0,0 +1,38 @@
+#ifndef REPRODUCAO_H
+#define REPRODUCAO_H
+
+#include "pico/stdlib.h"
+
+// -------------------- Reproducao de series gravadas --------------------
+// Uma serie de nivel/chuva substitui o ADC simulado: os valores sao
+// interpolados linearmente entre os pontos e convertidos em contagens pela
+// curva ideal (0% = 0, 100% = 4095). O tempo da serie e comprimido por
+// escala (ms da serie por ms simulado), entao anos de historico cabem em
+// poucos minutos simulados.
+//
+// Formatos aceitos:
+//  - CSV com cabecalho: colunas tempo_ms ou tempo_s, nivel_agua (ou nivel)
+//    e volume_chuva (ou chuva), em %. Se houver coluna tipo, so as linhas
+//    "amostra" entram; a saida de `estacao_log despejar` serve direto;
+//  - binario: registros amostra_comp_t (tempo_ms, nivel e chuva em
+//    centesimos de %, little-endian).
+//
+// Na saida padrao sai um CSV com cada transicao de alerta da entrada
+// (instante exato em que a serie cruza os limiares configurados) e cada
+// acao dos atuadores, com o tempo simulado e o tempo da serie:
+//
+//   tempo_ms,tempo_serie_s,origem,evento,valor
+//
+// A deteccao da estacao e o LED vermelho acender ou apagar; a latencia de
+// cada transicao da entrada ate ele aparece no resumo final.
+
+#define REPRODUCAO_MARGEM_MS     2000 // tempo simulado apos o ultimo ponto
+#define REPRODUCAO_GPIO_ALERTA   13   // LED_R em DispFilaTasks.c
+#define REPRODUCAO_GPIO_BUZZER   21   // BUZZER em DispFilaTasks.c
+
+// Carrega a serie, troca a fonte do ADC e cria a tarefa que acompanha os
+// limiares. Retorna a duracao da simulacao em ms. Chamar antes do
+// escalonador.
+uint32_t reproducao_iniciar(const char *arquivo, uint32_t escala);
+
+#endif
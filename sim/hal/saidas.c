@@ -0,0 +1,244 @@
+#include <string.h>
+#include "hal_sim.h"
+#include "falhas.h"
+#include "hardware/gpio.h"
+#include "hardware/pwm.h"
+#include "hardware/pio.h"
+#include "hardware/i2c.h"
+
+// -------------------- GPIO --------------------
+static gpio_function_t funcoes[NUM_BANK0_GPIOS];
+static uint32_t saidas;
+static uint32_t valores;
+
+void gpio_init(uint gpio) {
+    gpio_set_function(gpio, GPIO_FUNC_SIO);
+    saidas &= ~(1u << gpio);
+    valores &= ~(1u << gpio);
+}
+
+void gpio_set_function(uint gpio, gpio_function_t funcao) {
+    funcoes[gpio] = funcao;
+    hal_sim_contadores.gpio_eventos++;
+    hal_sim_registrar("gpio", "funcao", gpio, funcao);
+}
+
+gpio_function_t gpio_get_function(uint gpio) {
+    return funcoes[gpio];
+}
+
+void gpio_set_dir(uint gpio, bool saida) {
+    if (saida)
+        saidas |= 1u << gpio;
+    else
+        saidas &= ~(1u << gpio);
+}
+
+void gpio_put(uint gpio, bool valor) {
+    if (((valores >> gpio) & 1u) == valor)
+        return;
+    valores ^= 1u << gpio;
+    hal_sim_contadores.gpio_eventos++;
+    hal_sim_registrar("gpio", "nivel", gpio, valor);
+}
+
+bool gpio_get(uint gpio) {
+    return (valores >> gpio) & 1u;
+}
+
+void gpio_pull_up(uint gpio) {
+    hal_sim_registrar("gpio", "pull_up", gpio, 1);
+}
+
+void gpio_pull_down(uint gpio) {
+    hal_sim_registrar("gpio", "pull_down", gpio, 1);
+}
+
+void gpio_disable_pulls(uint gpio) {
+    hal_sim_registrar("gpio", "pull_up", gpio, 0);
+}
+
+// -------------------- PWM --------------------
+// Eventos so quando o nivel de um canal muda; um GPIO le o canal do seu
+// slice (pwm_gpio_to_slice_num/pwm_gpio_to_channel).
+typedef struct {
+    uint16_t wrap;
+    float divisor;
+    bool habilitado;
+    uint16_t nivel[2];
+} slice_pwm_t;
+
+static slice_pwm_t slices[NUM_PWM_SLICES];
+
+void pwm_set_wrap(uint slice, uint16_t wrap) {
+    slices[slice].wrap = wrap;
+    hal_sim_registrar("pwm", "wrap", slice, wrap);
+}
+
+void pwm_set_clkdiv(uint slice, float divisor) {
+    slices[slice].divisor = divisor;
+    hal_sim_registrar("pwm", "clkdiv_x16", slice, (uint32_t)(divisor * 16.0f));
+}
+
+void pwm_set_enabled(uint slice, bool habilitar) {
+    slices[slice].habilitado = habilitar;
+    hal_sim_registrar("pwm", "enabled", slice, habilitar);
+}
+
+void pwm_set_chan_level(uint slice, uint canal, uint16_t nivel) {
+    if (slices[slice].nivel[canal] == nivel)
+        return;
+    slices[slice].nivel[canal] = nivel;
+    hal_sim_contadores.pwm_mudancas++;
+    hal_sim_registrar("pwm", "nivel", slice * 2 + canal, nivel);
+}
+
+void pwm_set_gpio_level(uint gpio, uint16_t nivel) {
+    pwm_set_chan_level(pwm_gpio_to_slice_num(gpio), pwm_gpio_to_channel(gpio), nivel);
+}
+
+uint16_t hal_sim_pwm_nivel(uint gpio) {
+    const slice_pwm_t *s = &slices[pwm_gpio_to_slice_num(gpio)];
+    return s->habilitado ? s->nivel[pwm_gpio_to_channel(gpio)] : 0;
+}
+
+// -------------------- PIO --------------------
+// O FIFO de TX simulado nunca enche: cada palavra e consumida na hora e
+// registrada (na matriz WS2812, a cor GRB nos 24 bits de cima). No tempo
+// virtual cada uma prende a CPU pelo que levaria para sair: 24 bits a
+// 800 kHz, ja que o FIFO de 4 palavras nao da conta de um quadro.
+#define PIO_PALAVRA_US 30
+pio_hw_t hal_sim_pio[NUM_PIOS] = { { .indice = 0 }, { .indice = 1 } };
+
+uint pio_add_program(PIO pio, const pio_program_t *programa) {
+    uint32_t mascara = (1u << programa->length) - 1;
+    for (uint inicio = 0; inicio + programa->length <= 32; inicio++) {
+        if (!(pio->instrucoes_usadas & (mascara << inicio))) {
+            pio->instrucoes_usadas |= mascara << inicio;
+            hal_sim_registrar("pio", "programa", pio->indice, inicio);
+            return inicio;
+        }
+    }
+    fprintf(stderr, "hal_sim: memoria de instrucoes do PIO%u cheia\n", pio->indice);
+    abort();
+}
+
+int pio_claim_unused_sm(PIO pio, bool obrigatorio) {
+    for (uint sm = 0; sm < NUM_PIO_STATE_MACHINES; sm++) {
+        if (!(pio->sm_usadas & (1u << sm))) {
+            pio->sm_usadas |= 1u << sm;
+            return (int)sm;
+        }
+    }
+    if (obrigatorio) {
+        fprintf(stderr, "hal_sim: nenhuma maquina de estados livre no PIO%u\n", pio->indice);
+        abort();
+    }
+    return -1;
+}
+
+void pio_gpio_init(PIO pio, uint pino) {
+    gpio_set_function(pino, pio->indice ? GPIO_FUNC_PIO1 : GPIO_FUNC_PIO0);
+}
+
+int pio_sm_set_consecutive_pindirs(PIO pio, uint sm, uint base, uint quantidade, bool saida) {
+    (void)pio;
+    (void)sm;
+    for (uint i = 0; i < quantidade; i++)
+        gpio_set_dir(base + i, saida);
+    return PICO_OK;
+}
+
+int pio_sm_init(PIO pio, uint sm, uint inicio, const pio_sm_config *c) {
+    hal_sim_registrar("pio", "init", pio->indice * NUM_PIO_STATE_MACHINES + sm, inicio);
+    pio_sm_set_clkdiv(pio, sm, c->clkdiv);
+    return PICO_OK;
+}
+
+void pio_sm_set_enabled(PIO pio, uint sm, bool habilitar) {
+    hal_sim_registrar("pio", "enabled", pio->indice * NUM_PIO_STATE_MACHINES + sm, habilitar);
+}
+
+void pio_sm_set_clkdiv(PIO pio, uint sm, float divisor) {
+    hal_sim_registrar("pio", "clkdiv_x256", pio->indice * NUM_PIO_STATE_MACHINES + sm, (uint32_t)(divisor * 256.0f));
+}
+
+void pio_sm_put_blocking(PIO pio, uint sm, uint32_t palavra) {
+    hal_sim_contadores.pio_palavras++;
+    hal_sim_registrar("pio", "palavra", pio->indice * NUM_PIO_STATE_MACHINES + sm, palavra);
+    hal_sim_ocupar_us(PIO_PALAVRA_US + falhas_pio_us());
+}
+
+// -------------------- I2C --------------------
+// Sem falha injetada (falhas.h), toda escrita e aceita (ACK) e registrada
+// com endereco e tamanho; as do endereco do OLED tambem vao para o modelo
+// do SSD1306 (oled.c). A transferencia prende a CPU por 9 bits (8 + ACK)
+// por byte, endereco incluido, na taxa programada: ~23 ms por quadro a
+// 400 kHz. Com falha, o endereco leva NAK ou o escravo estica o clock.
+i2c_inst_t hal_sim_i2c[2] = { { .indice = 0 }, { .indice = 1 } };
+
+uint i2c_init(i2c_inst_t *i2c, uint baudrate) {
+    hal_sim_registrar("i2c", "init", i2c->indice, baudrate);
+    return i2c_set_baudrate(i2c, baudrate);
+}
+
+uint i2c_set_baudrate(i2c_inst_t *i2c, uint baudrate) {
+    i2c->baudrate = baudrate;
+    hal_sim_registrar("i2c", "baudrate", i2c->indice, baudrate);
+    return baudrate;
+}
+
+static uint32_t duracao_i2c_us(const i2c_inst_t *i2c, size_t tamanho) {
+    if (i2c->baudrate == 0)
+        return 0;
+    return (uint32_t)(((uint64_t)tamanho + 1u) * 9u * 1000000u / i2c->baudrate);
+}
+
+// timeout_us = 0: sem limite, como i2c_write_blocking. Com limite, uma
+// transacao esticada alem dele prende a CPU so ate o timeout e nada chega
+// ao display.
+static int escrever_i2c(i2c_inst_t *i2c, uint8_t endereco, const uint8_t *dados, size_t tamanho, uint timeout_us) {
+    uint32_t atraso_us;
+    hal_sim_contadores.i2c_transacoes++;
+    if (falhas_i2c(&atraso_us)) {
+        hal_sim_registrar("i2c", "nak", ((uint32_t)i2c->indice << 8) | endereco, (uint32_t)tamanho);
+        hal_sim_ocupar_us(duracao_i2c_us(i2c, 0) + atraso_us);
+        return PICO_ERROR_GENERIC;
+    }
+    if (timeout_us > 0 && duracao_i2c_us(i2c, tamanho) + atraso_us > timeout_us) {
+        hal_sim_registrar("i2c", "timeout", ((uint32_t)i2c->indice << 8) | endereco, (uint32_t)tamanho);
+        hal_sim_ocupar_us(timeout_us);
+        return PICO_ERROR_TIMEOUT;
+    }
+    hal_sim_contadores.i2c_bytes += tamanho;
+    hal_sim_registrar("i2c", "escrita", ((uint32_t)i2c->indice << 8) | endereco, (uint32_t)tamanho);
+    hal_sim_oled_escrita(endereco, dados, tamanho);
+    hal_sim_ocupar_us(duracao_i2c_us(i2c, tamanho) + atraso_us);
+    return (int)tamanho;
+}
+
+int i2c_write_blocking(i2c_inst_t *i2c, uint8_t endereco, const uint8_t *dados, size_t tamanho, bool sem_stop) {
+    (void)sem_stop;
+    return escrever_i2c(i2c, endereco, dados, tamanho, 0);
+}
+
+int i2c_write_timeout_us(i2c_inst_t *i2c, uint8_t endereco, const uint8_t *dados, size_t tamanho, bool sem_stop,
+                         uint timeout_us) {
+    (void)sem_stop;
+    return escrever_i2c(i2c, endereco, dados, tamanho, timeout_us);
+}
+
+int i2c_read_blocking(i2c_inst_t *i2c, uint8_t endereco, uint8_t *dados, size_t tamanho, bool sem_stop) {
+    (void)sem_stop;
+    uint32_t atraso_us;
+    hal_sim_contadores.i2c_transacoes++;
+    if (falhas_i2c(&atraso_us)) {
+        hal_sim_registrar("i2c", "nak", ((uint32_t)i2c->indice << 8) | endereco, (uint32_t)tamanho);
+        hal_sim_ocupar_us(duracao_i2c_us(i2c, 0) + atraso_us);
+        return PICO_ERROR_GENERIC;
+    }
+    memset(dados, 0, tamanho);
+    hal_sim_registrar("i2c", "leitura", ((uint32_t)i2c->indice << 8) | endereco, (uint32_t)tamanho);
+    hal_sim_ocupar_us(duracao_i2c_us(i2c, tamanho) + atraso_us);
+    return (int)tamanho;
+}
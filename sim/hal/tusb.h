@@ -0,0 +1,10 @@
+#ifndef SIM_TUSB_H
+#define SIM_TUSB_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// O CDC simulado nunca enche (o host le tudo que chega)
+uint32_t tud_cdc_write_available(void);
+
+#endif
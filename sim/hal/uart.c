@@ -0,0 +1,147 @@
+#define _DEFAULT_SOURCE
+#define _XOPEN_SOURCE 600
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <termios.h>
+#include <unistd.h>
+#include "hal_sim.h"
+#include "hardware/irq.h"
+#include "hardware/uart.h"
+
+// -------------------- UART sobre um terminal do host --------------------
+// A UART0 le e escreve no descritor de ESTACAO_SIM_UART: com "pty" o HAL
+// cria um pseudoterminal e imprime o lado escravo (/dev/pts/N), onde um
+// mestre Modbus (tools/modbus_mestre rtu) se conecta; qualquer outro valor
+// e o caminho de um terminal ja existente (socat, adaptador USB-RS485).
+// Sem a variavel a UART nao recebe nada e o que e escrito so e contado.
+//
+// Os bytes chegam na hora em que o host os entrega, numa FIFO de 32 como a
+// do PL011. Com a interrupcao de recepcao habilitada, o tick chama o
+// handler da UART0_IRQ enquanto houver byte (todos os de um tick chegam no
+// mesmo instante). A escrita prende a CPU pelo tempo da linha: bits por
+// caractere (start, dados, paridade, stop) na taxa programada.
+#define UART_FIFO 32
+
+uart_inst_t hal_sim_uart[2] = { { .indice = 0 }, { .indice = 1 } };
+
+static int descritor = -1;
+static int escravo = -1; // mantido aberto: sem ninguem no pty o mestre nao le EIO
+static uint8_t fifo[UART_FIFO];
+static size_t fifo_n;
+static size_t fifo_i;
+static bool irq_rx;
+
+uint uart_init(uart_inst_t *uart, uint baudrate) {
+    uart->baudrate = baudrate;
+    uart->bits_por_caractere = 10; // 8N1
+    hal_sim_registrar("uart", "init", uart->indice, baudrate);
+    return baudrate;
+}
+
+void uart_set_fifo_enabled(uart_inst_t *uart, bool habilitar) {
+    (void)uart;
+    (void)habilitar; // a leitura do host ja chega em blocos
+}
+
+void uart_set_irq_enables(uart_inst_t *uart, bool rx_tem_dados, bool tx_precisa_dados) {
+    (void)tx_precisa_dados;
+    if (uart->indice == 0)
+        irq_rx = rx_tem_dados;
+}
+
+// Contexto do tick, como o DMA do ADC
+void hal_sim_uart_avancar(void) {
+    if (irq_rx && uart_is_readable(uart0))
+        hal_sim_irq(UART0_IRQ);
+}
+
+uint uart_set_baudrate(uart_inst_t *uart, uint baudrate) {
+    uart->baudrate = baudrate;
+    hal_sim_registrar("uart", "baud", uart->indice, baudrate);
+    return baudrate;
+}
+
+void uart_set_format(uart_inst_t *uart, uint bits_dados, uint bits_stop, uart_parity_t paridade) {
+    uart->bits_por_caractere = 1 + bits_dados + bits_stop + (paridade != UART_PARITY_NONE);
+}
+
+bool uart_is_readable(uart_inst_t *uart) {
+    if (uart->indice != 0 || descritor < 0)
+        return false;
+    if (fifo_i < fifo_n)
+        return true;
+    ssize_t lidos = read(descritor, fifo, sizeof(fifo));
+    if (lidos <= 0)
+        return false;
+    fifo_n = (size_t)lidos;
+    fifo_i = 0;
+    hal_sim_contadores.uart_recebidos += (uint64_t)lidos;
+    return true;
+}
+
+char uart_getc(uart_inst_t *uart) {
+    while (!uart_is_readable(uart))
+        hal_sim_ocupar_us(1000);
+    return (char)fifo[fifo_i++];
+}
+
+void uart_write_blocking(uart_inst_t *uart, const uint8_t *dados, size_t tamanho) {
+    hal_sim_contadores.uart_enviados += tamanho;
+    hal_sim_registrar("uart", "escrita", uart->indice, (uint32_t)tamanho);
+    if (uart->indice == 0 && descritor >= 0) {
+        size_t escritos = 0;
+        while (escritos < tamanho) {
+            ssize_t n = write(descritor, dados + escritos, tamanho - escritos);
+            if (n < 0 && errno != EAGAIN && errno != EINTR)
+                break; // terminal fechado: a linha fica muda
+            escritos += n > 0 ? (size_t)n : 0;
+        }
+    }
+    if (uart->baudrate != 0)
+        hal_sim_ocupar_us((uint32_t)((uint64_t)tamanho * uart->bits_por_caractere * 1000000u / uart->baudrate));
+}
+
+void uart_tx_wait_blocking(uart_inst_t *uart) {
+    (void)uart; // uart_write_blocking ja esperou a linha
+}
+
+static void modo_cru(int fd) {
+    struct termios t;
+    if (tcgetattr(fd, &t) == 0) {
+        cfmakeraw(&t);
+        tcsetattr(fd, TCSANOW, &t);
+    }
+}
+
+void hal_sim_uart_iniciar(const char *terminal) {
+    if (terminal == NULL)
+        return;
+    if (strcmp(terminal, "pty") != 0) {
+        descritor = open(terminal, O_RDWR | O_NOCTTY | O_NONBLOCK);
+        if (descritor < 0) {
+            perror(terminal);
+            exit(1);
+        }
+        modo_cru(descritor);
+        return;
+    }
+
+    descritor = posix_openpt(O_RDWR | O_NOCTTY | O_NONBLOCK);
+    if (descritor < 0 || grantpt(descritor) != 0 || unlockpt(descritor) != 0) {
+        perror("ESTACAO_SIM_UART");
+        exit(1);
+    }
+    const char *nome = ptsname(descritor);
+    escravo = open(nome, O_RDWR | O_NOCTTY);
+    if (escravo >= 0)
+        modo_cru(escravo);
+    fprintf(stderr, "uart0: %s\n", nome);
+}
+
+void hal_sim_uart_encerrar(void) {
+    if (escravo >= 0)
+        close(escravo);
+    if (descritor >= 0)
+        close(descritor);
+}
@@ -0,0 +1,71 @@
+#include "hal_sim.h"
+#include "pico/stdio_usb.h"
+#include "tusb.h"
+
+// -------------------- CDC da USB --------------------
+// Saida (telemetria COBS) vai para ESTACAO_SIM_USB, no mesmo formato que o
+// host leria de /dev/ttyACM0: tools/telemetria_decode funciona direto no
+// arquivo. A entrada vem de ESTACAO_SIM_COMANDOS, lida aos poucos como se
+// fosse digitada no terminal (um pedaco por chamada do shell).
+#define USB_CDC_FIFO 256
+
+static FILE *saida;
+static FILE *comandos;
+
+static void out_chars(const char *buf, int len) {
+    if (saida != NULL)
+        fwrite(buf, 1, (size_t)len, saida);
+    hal_sim_contadores.usb_enviados += (uint32_t)len;
+}
+
+static void out_flush(void) {
+    if (saida != NULL)
+        fflush(saida);
+}
+
+static int in_chars(char *buf, int len) {
+    if (comandos == NULL)
+        return PICO_ERROR_NO_DATA;
+    size_t n = fread(buf, 1, (size_t)len, comandos);
+    if (n == 0)
+        return PICO_ERROR_NO_DATA;
+    hal_sim_contadores.usb_recebidos += n;
+    return (int)n;
+}
+
+stdio_driver_t stdio_usb = {
+    .out_chars = out_chars,
+    .out_flush = out_flush,
+    .in_chars = in_chars
+};
+
+bool stdio_usb_connected(void) {
+    return true;
+}
+
+uint32_t tud_cdc_write_available(void) {
+    return USB_CDC_FIFO;
+}
+
+static FILE *abrir(const char *arquivo, const char *modo) {
+    if (arquivo == NULL)
+        return NULL;
+    FILE *f = fopen(arquivo, modo);
+    if (f == NULL) {
+        perror(arquivo);
+        exit(1);
+    }
+    return f;
+}
+
+void hal_sim_usb_iniciar(const char *arquivo_saida, const char *arquivo_comandos) {
+    saida = abrir(arquivo_saida, "wb");
+    comandos = abrir(arquivo_comandos, "rb");
+}
+
+void hal_sim_usb_encerrar(void) {
+    if (saida != NULL)
+        fclose(saida);
+    if (comandos != NULL)
+        fclose(comandos);
+}
@@ -0,0 +1,179 @@
+// Quadros de referencia do OLED: desenha cenas fixas com lib/ssd1306.c e
+// lib/painel.c, sem FreeRTOS, e grava ou compara as imagens que sairiam
+// pelo I2C. Serve de rede de seguranca para otimizar as primitivas de
+// desenho: qualquer pixel diferente da referencia aparece aqui.
+//
+//   estacao_quadros gravar <dir>    grava <cena>.pbm (referencia) e <cena>.png
+//   estacao_quadros comparar <dir> [saida]
+//                                   compara com <dir>/<cena>.pbm; cada cena
+//                                   divergente e gravada em
+//                                   <saida>/<cena>.atual.png (saida = dir se
+//                                   omitida) e o codigo de saida e 1
+//
+// As referencias ficam em sim/quadros/ e o alvo `quadros` do CMake roda a
+// comparacao contra elas.
+//   estacao_quadros listar          nomes das cenas
+#include <stdio.h>
+#include <string.h>
+#include "ssd1306.h"
+#include "painel.h"
+#include "imagem.h"
+
+// -------------------- Transporte --------------------
+// No lugar do I2C: guarda a ultima transacao de dados (0x40 + framebuffer),
+// que e exatamente o que o display receberia.
+static uint8_t transmitido[1 + WIDTH * HEIGHT / 8];
+static size_t transmitidos;
+
+int i2c_write_timeout_us(i2c_inst_t *i2c, uint8_t endereco, const uint8_t *dados, size_t tamanho, bool sem_stop,
+                         uint timeout_us) {
+    (void)i2c;
+    (void)endereco;
+    (void)sem_stop;
+    (void)timeout_us;
+    if (tamanho > 0 && dados[0] == 0x40 && tamanho <= sizeof(transmitido)) {
+        memcpy(transmitido, dados, tamanho);
+        transmitidos = tamanho;
+    }
+    return (int)tamanho;
+}
+
+// -------------------- Cenas --------------------
+static void cena_painel_normal(ssd1306_t *d) {
+    painel_desenhar(d, 453, 120, false);
+}
+
+static void cena_painel_alerta(ssd1306_t *d) {
+    painel_desenhar(d, 837, 912, true);
+}
+
+static void cena_painel_extremos(ssd1306_t *d) {
+    painel_desenhar(d, 0, 1000, false);
+}
+
+// Todos os caracteres da fonte, com a quebra de linha do draw_string
+static void cena_texto(ssd1306_t *d) {
+    char texto['~' - ' ' + 2];
+    for (char c = ' '; c <= '~'; c++)
+        texto[c - ' '] = c;
+    texto['~' - ' ' + 1] = '\0';
+    ssd1306_fill(d, false);
+    ssd1306_draw_string(d, texto, 0, 0);
+}
+
+// Retangulos, linhas nos oito octantes, tracos e bordas do quadro
+static void cena_primitivas(ssd1306_t *d) {
+    ssd1306_fill(d, false);
+    ssd1306_rect(d, 0, 0, WIDTH, HEIGHT, true, false);
+    ssd1306_rect(d, 4, 4, 30, 20, true, true);
+    ssd1306_rect(d, 8, 8, 22, 12, false, true);
+    ssd1306_rect(d, 28, 4, 1, 1, true, false);
+    ssd1306_rect(d, 30, 8, 2, 30, true, true);
+
+    static const int8_t pontas[][2] = {
+        { 30, 8 }, { 30, -8 }, { -30, 8 }, { -30, -8 },
+        { 8, 26 }, { 8, -26 }, { -8, 26 }, { -8, -26 },
+    };
+    for (uint8_t i = 0; i < count_of(pontas); i++)
+        ssd1306_line(d, 70, 32, (uint8_t)(70 + pontas[i][0]), (uint8_t)(32 + pontas[i][1]), true);
+
+    ssd1306_hline(d, 104, 124, 4, true);
+    ssd1306_hline(d, 110, 105, 6, true); // vazia: x1 < x0
+    ssd1306_vline(d, 124, 8, 59, true);
+    ssd1306_vline(d, 120, 60, 60, true);
+    ssd1306_rect(d, 40, 100, 12, 12, true, true);
+    ssd1306_pixel(d, 105, 45, false);
+    ssd1306_pixel(d, 127, 63, false);
+    ssd1306_pixel(d, 0, 0, false);
+}
+
+typedef struct {
+    const char *nome;
+    void (*desenhar)(ssd1306_t *d);
+} cena_t;
+
+static const cena_t cenas[] = {
+    { "painel_normal", cena_painel_normal },
+    { "painel_alerta", cena_painel_alerta },
+    { "painel_extremos", cena_painel_extremos },
+    { "texto", cena_texto },
+    { "primitivas", cena_primitivas },
+};
+
+// Desenha a cena num framebuffer limpo, envia e decodifica o que saiu.
+static bool renderizar(const cena_t *cena, imagem_t *imagem) {
+    ssd1306_t d;
+    ssd1306_init(&d, WIDTH, HEIGHT, false, 0x3C, NULL);
+    transmitidos = 0;
+
+    cena->desenhar(&d);
+    ssd1306_send_data(&d);
+    free(d.ram_buffer);
+
+    if (transmitidos != d.bufsize)
+        return false;
+    imagem_de_vertical(imagem, transmitido + 1, WIDTH, HEIGHT);
+    return true;
+}
+
+static void caminho(char *destino, size_t tamanho, const char *dir, const char *nome, const char *sufixo) {
+    snprintf(destino, tamanho, "%s/%s%s", dir, nome, sufixo);
+}
+
+int main(int argc, char **argv) {
+    if (argc == 2 && strcmp(argv[1], "listar") == 0) {
+        for (size_t i = 0; i < count_of(cenas); i++)
+            puts(cenas[i].nome);
+        return 0;
+    }
+
+    bool gravar = argc == 3 && strcmp(argv[1], "gravar") == 0;
+    bool comparar = (argc == 3 || argc == 4) && strcmp(argv[1], "comparar") == 0;
+    if (!gravar && !comparar) {
+        fprintf(stderr, "uso: %s gravar <dir> | comparar <dir> [saida] | listar\n", argv[0]);
+        return 2;
+    }
+    const char *dir = argv[2];
+    const char *saida = argc == 4 ? argv[3] : dir;
+
+    int divergentes = 0;
+    for (size_t i = 0; i < count_of(cenas); i++) {
+        char arquivo[512];
+        imagem_t atual;
+        if (!renderizar(&cenas[i], &atual)) {
+            fprintf(stderr, "%s: quadro nao transmitido inteiro\n", cenas[i].nome);
+            return 1;
+        }
+
+        if (gravar) {
+            caminho(arquivo, sizeof(arquivo), dir, cenas[i].nome, ".pbm");
+            bool ok = imagem_gravar_pbm(&atual, arquivo);
+            caminho(arquivo, sizeof(arquivo), dir, cenas[i].nome, ".png");
+            if (!ok || !imagem_gravar_png(&atual, arquivo)) {
+                perror(arquivo);
+                return 1;
+            }
+            printf("%-16s %4u pixels acesos\n", cenas[i].nome, imagem_acesos(&atual));
+            continue;
+        }
+
+        imagem_t referencia;
+        caminho(arquivo, sizeof(arquivo), dir, cenas[i].nome, ".pbm");
+        if (!imagem_ler_pbm(&referencia, arquivo)) {
+            fprintf(stderr, "%s: referencia ilegivel\n", arquivo);
+            divergentes++;
+            continue;
+        }
+
+        uint32_t diferentes = imagem_comparar(&atual, &referencia);
+        if (diferentes == 0) {
+            printf("%-16s ok\n", cenas[i].nome);
+            continue;
+        }
+        divergentes++;
+        caminho(arquivo, sizeof(arquivo), saida, cenas[i].nome, ".atual.png");
+        imagem_gravar_png(&atual, arquivo);
+        printf("%-16s %4u pixels diferentes (%s)\n", cenas[i].nome, diferentes, arquivo);
+    }
+    return divergentes ? 1 : 0;
+}
@@ -0,0 +1,36 @@
+#ifndef FREERTOS_H
+#define FREERTOS_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "FreeRTOSConfig.h"
+
+// -------------------- Kernel de tempo virtual --------------------
+// Substitui o FreeRTOS-Kernel no estacao_virtual: a mesma API que o
+// firmware usa, sobre tarefas cooperativas (ucontext) num relogio que so
+// anda quando as tarefas bloqueiam ou ocupam a CPU (virtual.h).
+
+typedef uint32_t TickType_t;
+typedef long BaseType_t;
+typedef unsigned long UBaseType_t;
+typedef unsigned long StackType_t;
+
+#define pdTRUE   ( ( BaseType_t ) 1 )
+#define pdFALSE  ( ( BaseType_t ) 0 )
+#define pdPASS   pdTRUE
+#define pdFAIL   pdFALSE
+
+#define portMAX_DELAY       ( ( TickType_t ) 0xFFFFFFFFu )
+#define portTICK_PERIOD_MS  ( ( TickType_t ) 1 )
+#define tskIDLE_PRIORITY    ( ( UBaseType_t ) 0 )
+
+#define portYIELD_FROM_ISR( x )  vTaskYieldFromISR( x )
+
+void vTaskEnterCritical(void);
+void vTaskExitCritical(void);
+void vTaskYieldFromISR(BaseType_t acordou);
+
+#define taskENTER_CRITICAL()  vTaskEnterCritical()
+#define taskEXIT_CRITICAL()   vTaskExitCritical()
+
+#endif
@@ -0,0 +1,16 @@
+#ifndef QUEUE_H
+#define QUEUE_H
+
+#include "FreeRTOS.h"
+
+typedef struct fila_virtual *QueueHandle_t;
+
+QueueHandle_t xQueueCreate(UBaseType_t comprimento, UBaseType_t tamanho_item);
+BaseType_t xQueueSend(QueueHandle_t fila, const void *item, TickType_t prazo);
+BaseType_t xQueueReceive(QueueHandle_t fila, void *item, TickType_t prazo);
+BaseType_t xQueueSendFromISR(QueueHandle_t fila, const void *item, BaseType_t *acordou);
+UBaseType_t uxQueueMessagesWaiting(QueueHandle_t fila);
+
+#define xQueueSendToBack( fila, item, prazo )  xQueueSend( ( fila ), ( item ), ( prazo ) )
+
+#endif
@@ -0,0 +1,15 @@
+#ifndef SEMAPHORE_H
+#define SEMAPHORE_H
+
+#include "queue.h"
+
+// Mutex como fila de um item vazio, como no FreeRTOS, com heranca de
+// prioridade: quem segura o mutex sobe a prioridade de quem espera por ele.
+typedef QueueHandle_t SemaphoreHandle_t;
+
+SemaphoreHandle_t xSemaphoreCreateMutex(void);
+
+#define xSemaphoreTake( s, prazo )  xQueueReceive( ( s ), NULL, ( prazo ) )
+#define xSemaphoreGive( s )         xQueueSend( ( s ), NULL, 0 )
+
+#endif
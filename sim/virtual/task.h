@@ -0,0 +1,34 @@
+#ifndef TASK_H
+#define TASK_H
+
+#include "FreeRTOS.h"
+
+typedef struct tarefa_virtual *TaskHandle_t;
+typedef void (*TaskFunction_t)(void *);
+
+#define taskSCHEDULER_SUSPENDED    ( ( BaseType_t ) 0 )
+#define taskSCHEDULER_NOT_STARTED  ( ( BaseType_t ) 1 )
+#define taskSCHEDULER_RUNNING      ( ( BaseType_t ) 2 )
+
+BaseType_t xTaskCreate(TaskFunction_t funcao, const char *nome, configSTACK_DEPTH_TYPE pilha,
+                       void *params, UBaseType_t prioridade, TaskHandle_t *tarefa);
+void vTaskDelete(TaskHandle_t tarefa);
+void vTaskStartScheduler(void);
+
+void vTaskDelay(TickType_t ticks);
+void vTaskDelayUntil(TickType_t *anterior, TickType_t incremento);
+void taskYIELD(void);
+
+TickType_t xTaskGetTickCount(void);
+TickType_t xTaskGetTickCountFromISR(void);
+TaskHandle_t xTaskGetCurrentTaskHandle(void);
+BaseType_t xTaskGetSchedulerState(void);
+
+void vTaskSuspendAll(void);
+BaseType_t xTaskResumeAll(void);
+
+uint32_t ulTaskNotifyTake(BaseType_t limpar, TickType_t prazo);
+BaseType_t xTaskNotifyGive(TaskHandle_t tarefa);
+void vTaskNotifyGiveFromISR(TaskHandle_t tarefa, BaseType_t *acordou);
+
+#endif
@@ -0,0 +1,493 @@
+#define _XOPEN_SOURCE 700
+#include <ucontext.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include "virtual.h"
+#include "FreeRTOS.h"
+#include "task.h"
+#include "queue.h"
+#include "semphr.h"
+#include "hal_sim.h"
+
+#define VIRTUAL_TAREFAS_MAX 32
+#define VIRTUAL_PILHA_BYTES (256 * 1024) // printf e a glibc pedem mais que as pilhas do firmware
+
+typedef enum {
+    TAREFA_PRONTA,
+    TAREFA_BLOQUEADA,
+    TAREFA_APAGADA
+} estado_tarefa_t;
+
+struct tarefa_virtual {
+    ucontext_t contexto;
+    void *pilha;
+    const char *nome;
+    TaskFunction_t funcao;
+    void *params;
+    UBaseType_t prioridade;      // efetiva (com heranca de mutex)
+    UBaseType_t prioridade_base;
+    estado_tarefa_t estado;
+    const void *espera;          // fila ou notificacao esperada; NULL: so o prazo
+    bool com_prazo;
+    TickType_t acordar;
+    uint64_t chegada;            // ordem nas listas de prontas e de espera
+    uint32_t notificacoes;
+    uint32_t ocupado_us;         // CPU ocupada que ainda nao fechou um tick
+    uint64_t ocupado_total_us;
+    uint32_t execucoes;
+    uint8_t indice;
+};
+
+struct fila_virtual {
+    uint8_t *itens;
+    UBaseType_t comprimento;
+    UBaseType_t tamanho_item;
+    UBaseType_t cabeca;
+    UBaseType_t contagem;
+    TaskHandle_t dono; // so em mutexes
+    bool mutex;
+    uint8_t indice;
+};
+
+static struct tarefa_virtual tarefas[VIRTUAL_TAREFAS_MAX];
+static uint8_t num_tarefas;
+static uint8_t num_filas;
+static TaskHandle_t atual;
+static ucontext_t escalonador;
+static BaseType_t estado_escalonador = taskSCHEDULER_NOT_STARTED;
+static TickType_t ticks;
+static uint32_t critico;  // aninhamento de taskENTER_CRITICAL
+static uint32_t suspenso; // aninhamento de vTaskSuspendAll
+static uint64_t chegadas;
+
+static uint64_t semente = 1;
+static uint64_t sorteio;
+static uint64_t trocas;
+static uint64_t assinatura = 0xCBF29CE484222325ull; // FNV-1a de 64 bits
+
+extern void vApplicationTickHook(void);
+
+// -------------------- Semente --------------------
+void virtual_definir_semente(uint64_t nova) {
+    semente = nova;
+    sorteio = nova;
+}
+
+uint64_t virtual_semente(void) {
+    return semente;
+}
+
+// splitmix64: cada semente da uma sequencia propria, igual em qualquer host
+static uint64_t sortear(void) {
+    uint64_t z = (sorteio += 0x9E3779B97F4A7C15ull);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+    return z ^ (z >> 31);
+}
+
+static void assinar(uint32_t valor) {
+    for (int i = 0; i < 4; i++) {
+        assinatura ^= (valor >> (8 * i)) & 0xFFu;
+        assinatura *= 0x100000001B3ull;
+    }
+}
+
+uint64_t virtual_assinatura(void) {
+    return assinatura;
+}
+
+uint64_t virtual_trocas(void) {
+    return trocas;
+}
+
+// -------------------- Listas --------------------
+static void tornar_pronta(TaskHandle_t t) {
+    t->estado = TAREFA_PRONTA;
+    t->espera = NULL;
+    t->com_prazo = false;
+    t->chegada = ++chegadas;
+}
+
+// Tarefa pronta que o FreeRTOS poria para rodar agora; NULL se todas
+// estiverem bloqueadas.
+static TaskHandle_t escolher(void) {
+    TaskHandle_t candidatas[VIRTUAL_TAREFAS_MAX];
+    uint8_t n = 0;
+    for (uint8_t i = 0; i < num_tarefas; i++) {
+        TaskHandle_t t = &tarefas[i];
+        if (t->estado != TAREFA_PRONTA)
+            continue;
+        if (n > 0 && t->prioridade < candidatas[0]->prioridade)
+            continue;
+        if (n > 0 && t->prioridade > candidatas[0]->prioridade)
+            n = 0;
+        candidatas[n++] = t;
+    }
+    if (n == 0)
+        return NULL;
+    if (semente != 0)
+        return candidatas[sortear() % n];
+
+    TaskHandle_t primeira = candidatas[0];
+    for (uint8_t i = 1; i < n; i++) {
+        if (candidatas[i]->chegada < primeira->chegada)
+            primeira = candidatas[i];
+    }
+    return primeira;
+}
+
+// Ha outra tarefa pronta com prioridade acima da atual (ou igual, se
+// iguais e true)?
+static bool ha_pronta(bool iguais) {
+    for (uint8_t i = 0; i < num_tarefas; i++) {
+        TaskHandle_t t = &tarefas[i];
+        if (t == atual || t->estado != TAREFA_PRONTA)
+            continue;
+        if (t->prioridade > atual->prioridade || (iguais && t->prioridade == atual->prioridade))
+            return true;
+    }
+    return false;
+}
+
+// Primeira tarefa esperando por espera: a de maior prioridade e, entre
+// iguais, a que chegou antes, como na lista de eventos do FreeRTOS.
+static TaskHandle_t liberar_espera(const void *espera) {
+    TaskHandle_t escolhida = NULL;
+    for (uint8_t i = 0; i < num_tarefas; i++) {
+        TaskHandle_t t = &tarefas[i];
+        if (t->estado != TAREFA_BLOQUEADA || t->espera != espera)
+            continue;
+        if (escolhida == NULL || t->prioridade > escolhida->prioridade ||
+            (t->prioridade == escolhida->prioridade && t->chegada < escolhida->chegada))
+            escolhida = t;
+    }
+    if (escolhida != NULL)
+        tornar_pronta(escolhida);
+    return escolhida;
+}
+
+// -------------------- Trocas --------------------
+static bool pode_trocar(void) {
+    return atual != NULL && critico == 0 && suspenso == 0;
+}
+
+static void ceder(void) {
+    swapcontext(&atual->contexto, &escalonador);
+}
+
+// A atual continua pronta, mas vai para o fim da fila da sua prioridade
+static void ceder_pronta(void) {
+    atual->chegada = ++chegadas;
+    ceder();
+}
+
+static void preempcao(void) {
+    if (pode_trocar() && ha_pronta(false))
+        ceder_pronta();
+}
+
+static void bloquear(const void *espera, TickType_t prazo) {
+    atual->estado = TAREFA_BLOQUEADA;
+    atual->espera = espera;
+    atual->com_prazo = prazo != portMAX_DELAY;
+    atual->acordar = ticks + prazo;
+    atual->chegada = ++chegadas;
+    ceder();
+}
+
+// Ticks que ainda restam ate limite; 0 se ja venceu.
+static TickType_t restante(TickType_t prazo, TickType_t limite) {
+    if (prazo == portMAX_DELAY)
+        return portMAX_DELAY;
+    return (int32_t)(limite - ticks) > 0 ? limite - ticks : 0;
+}
+
+// -------------------- Tick --------------------
+// Mesma ordem do xTaskIncrementTick: conta, acorda os prazos vencidos e
+// chama o hook (que avanca o ADC/DMA do HAL).
+static void tick(void) {
+    ticks++;
+    for (uint8_t i = 0; i < num_tarefas; i++) {
+        TaskHandle_t t = &tarefas[i];
+        if (t->estado == TAREFA_BLOQUEADA && t->com_prazo && (int32_t)(ticks - t->acordar) >= 0)
+            tornar_pronta(t);
+    }
+    vApplicationTickHook();
+}
+
+void virtual_ocupar_us(uint32_t us) {
+    if (atual == NULL)
+        return;
+    atual->ocupado_total_us += us;
+    atual->ocupado_us += us;
+    while (atual->ocupado_us >= 1000u) {
+        atual->ocupado_us -= 1000u;
+        tick();
+        // Em secao critica o tick so conta: ninguem entra ate ela acabar
+        if (pode_trocar() && ha_pronta(true))
+            ceder_pronta();
+    }
+}
+
+// -------------------- Tarefas --------------------
+static void entrada(void) {
+    atual->funcao(atual->params);
+    // Tarefa do FreeRTOS nao retorna; se retornar, sai de cena
+    atual->estado = TAREFA_APAGADA;
+    ceder();
+}
+
+BaseType_t xTaskCreate(TaskFunction_t funcao, const char *nome, configSTACK_DEPTH_TYPE pilha,
+                       void *params, UBaseType_t prioridade, TaskHandle_t *tarefa) {
+    (void)pilha;
+    if (num_tarefas == VIRTUAL_TAREFAS_MAX)
+        return pdFAIL;
+    TaskHandle_t t = &tarefas[num_tarefas];
+    memset(t, 0, sizeof(*t));
+    t->pilha = malloc(VIRTUAL_PILHA_BYTES);
+    if (t->pilha == NULL)
+        return pdFAIL;
+    t->indice = num_tarefas++;
+    t->nome = nome;
+    t->funcao = funcao;
+    t->params = params;
+    t->prioridade = t->prioridade_base = prioridade < configMAX_PRIORITIES ? prioridade : configMAX_PRIORITIES - 1;
+    tornar_pronta(t);
+
+    getcontext(&t->contexto);
+    t->contexto.uc_stack.ss_sp = t->pilha;
+    t->contexto.uc_stack.ss_size = VIRTUAL_PILHA_BYTES;
+    t->contexto.uc_link = NULL;
+    makecontext(&t->contexto, entrada, 0);
+    if (tarefa != NULL)
+        *tarefa = t;
+
+    preempcao();
+    return pdPASS;
+}
+
+void vTaskDelete(TaskHandle_t tarefa) {
+    TaskHandle_t t = tarefa != NULL ? tarefa : atual;
+    t->estado = TAREFA_APAGADA;
+    if (t == atual)
+        ceder(); // nao volta; a pilha fica ate o fim da simulacao
+}
+
+void vTaskStartScheduler(void) {
+    estado_escalonador = taskSCHEDULER_RUNNING;
+    while (true) {
+        TaskHandle_t t = escolher();
+        if (t == NULL) {
+            tick();
+            continue;
+        }
+        if (t != atual || trocas == 0) {
+            trocas++;
+            assinar(ticks);
+            assinar(t->indice);
+        }
+        atual = t;
+        t->execucoes++;
+        swapcontext(&escalonador, &t->contexto);
+    }
+}
+
+void vTaskDelay(TickType_t n) {
+    if (n == 0)
+        taskYIELD();
+    else
+        bloquear(NULL, n);
+}
+
+void vTaskDelayUntil(TickType_t *anterior, TickType_t incremento) {
+    TickType_t alvo = *anterior + incremento;
+    *anterior = alvo;
+    if ((int32_t)(alvo - ticks) > 0)
+        bloquear(NULL, alvo - ticks);
+}
+
+void taskYIELD(void) {
+    if (pode_trocar() && ha_pronta(true))
+        ceder_pronta();
+}
+
+TickType_t xTaskGetTickCount(void) {
+    return ticks;
+}
+
+TickType_t xTaskGetTickCountFromISR(void) {
+    return ticks;
+}
+
+TaskHandle_t xTaskGetCurrentTaskHandle(void) {
+    return atual;
+}
+
+BaseType_t xTaskGetSchedulerState(void) {
+    if (estado_escalonador == taskSCHEDULER_RUNNING && suspenso > 0)
+        return taskSCHEDULER_SUSPENDED;
+    return estado_escalonador;
+}
+
+void vTaskSuspendAll(void) {
+    suspenso++;
+}
+
+BaseType_t xTaskResumeAll(void) {
+    if (--suspenso == 0 && pode_trocar() && ha_pronta(false)) {
+        ceder_pronta();
+        return pdTRUE;
+    }
+    return pdFALSE;
+}
+
+void vTaskEnterCritical(void) {
+    critico++;
+}
+
+void vTaskExitCritical(void) {
+    if (--critico == 0)
+        preempcao();
+}
+
+void vTaskYieldFromISR(BaseType_t acordou) {
+    (void)acordou; // a troca acontece quando o tick devolve a CPU
+}
+
+// -------------------- Notificacoes --------------------
+uint32_t ulTaskNotifyTake(BaseType_t limpar, TickType_t prazo) {
+    TickType_t limite = ticks + prazo;
+    while (atual->notificacoes == 0) {
+        TickType_t resta = restante(prazo, limite);
+        if (resta == 0)
+            return 0;
+        bloquear(&atual->notificacoes, resta);
+    }
+    uint32_t valor = atual->notificacoes;
+    atual->notificacoes = limpar ? 0 : valor - 1;
+    return valor;
+}
+
+static bool notificar(TaskHandle_t t) {
+    t->notificacoes++;
+    if (t->estado == TAREFA_BLOQUEADA && t->espera == &t->notificacoes) {
+        tornar_pronta(t);
+        return atual != NULL && t->prioridade > atual->prioridade;
+    }
+    return false;
+}
+
+BaseType_t xTaskNotifyGive(TaskHandle_t tarefa) {
+    notificar(tarefa);
+    preempcao();
+    return pdPASS;
+}
+
+void vTaskNotifyGiveFromISR(TaskHandle_t tarefa, BaseType_t *acordou) {
+    bool maior = notificar(tarefa);
+    if (acordou != NULL && maior)
+        *acordou = pdTRUE;
+}
+
+// -------------------- Filas --------------------
+QueueHandle_t xQueueCreate(UBaseType_t comprimento, UBaseType_t tamanho_item) {
+    QueueHandle_t f = calloc(1, sizeof(*f));
+    if (f == NULL)
+        return NULL;
+    f->itens = malloc(comprimento * tamanho_item + 1);
+    if (f->itens == NULL) {
+        free(f);
+        return NULL;
+    }
+    f->comprimento = comprimento;
+    f->tamanho_item = tamanho_item;
+    f->indice = num_filas++;
+    return f;
+}
+
+SemaphoreHandle_t xSemaphoreCreateMutex(void) {
+    QueueHandle_t f = xQueueCreate(1, 0);
+    if (f != NULL) {
+        f->mutex = true;
+        f->contagem = 1;
+    }
+    return f;
+}
+
+static void colocar(QueueHandle_t f, const void *item) {
+    if (f->tamanho_item > 0) {
+        UBaseType_t posicao = (f->cabeca + f->contagem) % f->comprimento;
+        memcpy(&f->itens[posicao * f->tamanho_item], item, f->tamanho_item);
+    }
+    f->contagem++;
+    if (f->mutex && f->dono != NULL) {
+        f->dono->prioridade = f->dono->prioridade_base;
+        f->dono = NULL;
+    }
+}
+
+BaseType_t xQueueSend(QueueHandle_t f, const void *item, TickType_t prazo) {
+    TickType_t limite = ticks + prazo;
+    while (f->contagem == f->comprimento) {
+        TickType_t resta = restante(prazo, limite);
+        if (resta == 0) {
+            // Descarte: o firmware envia sem esperar e segue
+            if (!f->mutex)
+                hal_sim_registrar("fila", "cheia", f->indice, atual != NULL ? atual->indice : 0);
+            return pdFALSE;
+        }
+        bloquear(&f->contagem, resta);
+    }
+    colocar(f, item);
+    liberar_espera(f);
+    preempcao();
+    return pdPASS;
+}
+
+BaseType_t xQueueSendFromISR(QueueHandle_t f, const void *item, BaseType_t *acordou) {
+    if (f->contagem == f->comprimento)
+        return pdFALSE;
+    colocar(f, item);
+    TaskHandle_t t = liberar_espera(f);
+    if (acordou != NULL && t != NULL && atual != NULL && t->prioridade > atual->prioridade)
+        *acordou = pdTRUE;
+    return pdPASS;
+}
+
+BaseType_t xQueueReceive(QueueHandle_t f, void *item, TickType_t prazo) {
+    TickType_t limite = ticks + prazo;
+    while (f->contagem == 0) {
+        TickType_t resta = restante(prazo, limite);
+        if (resta == 0)
+            return pdFALSE;
+        // Heranca de prioridade: o dono roda no nivel de quem espera
+        if (f->mutex && f->dono != NULL && f->dono->prioridade < atual->prioridade)
+            f->dono->prioridade = atual->prioridade;
+        bloquear(f, resta);
+    }
+    if (f->tamanho_item > 0)
+        memcpy(item, &f->itens[f->cabeca * f->tamanho_item], f->tamanho_item);
+    f->cabeca = (f->cabeca + 1) % f->comprimento;
+    f->contagem--;
+    if (f->mutex)
+        f->dono = atual;
+    liberar_espera(&f->contagem);
+    preempcao();
+    return pdPASS;
+}
+
+UBaseType_t uxQueueMessagesWaiting(QueueHandle_t f) {
+    return f->contagem;
+}
+
+// -------------------- Resumo --------------------
+void virtual_resumo(FILE *saida) {
+    fprintf(saida, "escalonamento: semente %llu, %llu trocas, assinatura %016llx\n",
+            (unsigned long long)semente, (unsigned long long)trocas, (unsigned long long)assinatura);
+    for (uint8_t i = 0; i < num_tarefas; i++) {
+        const struct tarefa_virtual *t = &tarefas[i];
+        fprintf(saida, "tarefa %-12s prioridade %lu: %u execucoes, %.1f ms de CPU\n",
+                t->nome, t->prioridade_base, t->execucoes, (double)t->ocupado_total_us / 1000.0);
+    }
+}
@@ -0,0 +1,41 @@
+#ifndef VIRTUAL_H
+#define VIRTUAL_H
+
+#include <stdio.h>
+#include <stdint.h>
+
+// -------------------- Escalonamento deterministico --------------------
+// As tarefas sao corrotinas num unico thread e o tick e um contador: nada
+// depende do relogio de parede nem do escalonador do host. O codigo do
+// firmware custa zero tempo virtual; o tempo anda quando todas as tarefas
+// estao bloqueadas (um tick por vez, com vApplicationTickHook) ou quando o
+// HAL declara CPU ocupada (virtual_ocupar_us: I2C, PIO, flash).
+//
+// As trocas seguem as regras do FreeRTOS com preempcao e time slicing:
+//  - roda sempre a tarefa pronta de maior prioridade; quem acorda outra de
+//    prioridade maior (fila, notificacao, fim de secao critica) cede a CPU
+//    na hora;
+//  - com a CPU ocupada, a cada tick outra tarefa pronta de mesma prioridade
+//    pode entrar (time slicing) e uma de prioridade maior entra sempre;
+//  - entre tarefas prontas de mesma prioridade a escolha e da semente: 0
+//    segue a ordem de chegada (como as listas do FreeRTOS) e qualquer outro
+//    valor sorteia com um gerador proprio. A mesma semente repete a mesma
+//    intercalacao, tick a tick.
+//
+// A assinatura resume a sequencia de trocas (tick e tarefa de cada uma):
+// duas execucoes com a mesma assinatura intercalaram as tarefas igual.
+
+void virtual_definir_semente(uint64_t semente);
+uint64_t virtual_semente(void);
+
+// A tarefa atual ocupa a CPU por us microssegundos de tempo virtual. Fora
+// de tarefa (antes do escalonador) nao faz nada.
+void virtual_ocupar_us(uint32_t us);
+
+uint64_t virtual_assinatura(void);
+uint64_t virtual_trocas(void);
+
+// Semente, trocas, assinatura e, por tarefa, execucoes e CPU ocupada.
+void virtual_resumo(FILE *saida);
+
+#endif
@@ -0,0 +1,147 @@
+// -----------------------------------------------------------------------------
+// adc_captura: grava em arquivo o fluxo bruto do ADC enviado pelo firmware
+// de diagnostico AdcStream (endpoint bulk vendor, ver adc_stream/).
+//
+//   adc_captura saida.bin [segundos]
+//
+// O arquivo contem apenas as amostras de 16 bits, intercaladas ADC0/ADC1.
+// A cada segundo sao impressos taxa, buffers perdidos (lacunas de sequencia)
+// e overruns informados pelo dispositivo.
+// -----------------------------------------------------------------------------
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#include <sys/time.h>
+#include <libusb.h>
+
+extern "C" {
+#include "adc_stream_proto.h"
+}
+
+namespace {
+
+// Varias transferencias em voo para o host nunca deixar o endpoint ocioso
+constexpr int EM_VOO = 16;
+constexpr int TAMANHO_PEDIDO = ((ADC_STREAM_TRANSFERENCIA + 63) / 64) * 64;
+
+struct Estado {
+    std::FILE *saida = nullptr;
+    bool primeira = true;
+    uint32_t esperada = 0;
+    uint64_t bytes = 0;
+    uint64_t buffers = 0;
+    uint64_t perdidos = 0;
+    uint16_t overruns = 0;
+    uint64_t invalidas = 0;
+    bool erro = false;
+};
+
+void LIBUSB_CALL concluida(libusb_transfer *t) {
+    Estado &est = *static_cast<Estado *>(t->user_data);
+
+    if (t->status != LIBUSB_TRANSFER_COMPLETED) {
+        if (t->status != LIBUSB_TRANSFER_TIMED_OUT)
+            est.erro = true;
+    } else if (t->actual_length != (int)ADC_STREAM_TRANSFERENCIA) {
+        est.invalidas++;
+    } else {
+        adc_stream_cabecalho_t cab;
+        std::memcpy(&cab, t->buffer, sizeof(cab));
+        if (!est.primeira && cab.sequencia != est.esperada)
+            est.perdidos += cab.sequencia - est.esperada;
+        est.primeira = false;
+        est.esperada = cab.sequencia + 1;
+        est.overruns = cab.overruns;
+        est.buffers++;
+
+        size_t n = cab.amostras * sizeof(uint16_t);
+        std::fwrite(t->buffer + sizeof(cab), 1, n, est.saida);
+        est.bytes += n;
+    }
+
+    if (!est.erro)
+        libusb_submit_transfer(t);
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+    if (argc < 2) {
+        std::fprintf(stderr, "uso: %s <saida.bin> [segundos]\n", argv[0]);
+        return 2;
+    }
+    double duracao = argc >= 3 ? std::atof(argv[2]) : 10.0;
+
+    Estado est;
+    est.saida = std::fopen(argv[1], "wb");
+    if (!est.saida) {
+        std::perror(argv[1]);
+        return 1;
+    }
+
+    libusb_context *ctx = nullptr;
+    libusb_init(&ctx);
+    libusb_device_handle *dev = libusb_open_device_with_vid_pid(ctx, ADC_STREAM_VID, ADC_STREAM_PID);
+    if (!dev) {
+        std::fprintf(stderr, "dispositivo %04x:%04x nao encontrado\n", ADC_STREAM_VID, ADC_STREAM_PID);
+        return 1;
+    }
+    libusb_claim_interface(dev, 0);
+
+    std::vector<libusb_transfer *> transferencias;
+    std::vector<std::vector<unsigned char>> buffers(EM_VOO, std::vector<unsigned char>(TAMANHO_PEDIDO));
+    for (int i = 0; i < EM_VOO; i++) {
+        libusb_transfer *t = libusb_alloc_transfer(0);
+        libusb_fill_bulk_transfer(t, dev, ADC_STREAM_EP_IN, buffers[i].data(), TAMANHO_PEDIDO,
+                                  concluida, &est, 1000);
+        libusb_submit_transfer(t);
+        transferencias.push_back(t);
+    }
+
+    using relogio = std::chrono::steady_clock;
+    auto inicio = relogio::now();
+    auto ultimo = inicio;
+    uint64_t bytes_ultimo = 0;
+
+    while (!est.erro) {
+        timeval tv{0, 100000};
+        libusb_handle_events_timeout(ctx, &tv);
+
+        auto agora = relogio::now();
+        if (agora - ultimo >= std::chrono::seconds(1)) {
+            double dt = std::chrono::duration<double>(agora - ultimo).count();
+            double taxa = (est.bytes - bytes_ultimo) / sizeof(uint16_t) / dt;
+            std::fprintf(stderr, "%.0f amostras/s  buffers=%llu perdidos=%llu overruns=%u invalidas=%llu\n",
+                         taxa, (unsigned long long)est.buffers, (unsigned long long)est.perdidos,
+                         est.overruns, (unsigned long long)est.invalidas);
+            ultimo = agora;
+            bytes_ultimo = est.bytes;
+        }
+        if (std::chrono::duration<double>(agora - inicio).count() >= duracao)
+            break;
+    }
+
+    for (libusb_transfer *t : transferencias)
+        libusb_cancel_transfer(t);
+    for (int i = 0; i < 10; i++) {
+        timeval tv{0, 50000};
+        libusb_handle_events_timeout(ctx, &tv);
+    }
+    for (libusb_transfer *t : transferencias)
+        libusb_free_transfer(t);
+
+    libusb_release_interface(dev, 0);
+    libusb_close(dev);
+    libusb_exit(ctx);
+    std::fclose(est.saida);
+
+    bool ok = est.perdidos == 0 && est.overruns == 0 && !est.erro;
+    std::fprintf(stderr, "%s: %llu amostras gravadas, %llu buffers perdidos, %u overruns\n",
+                 ok ? "ok" : "FALHAS", (unsigned long long)(est.bytes / 2),
+                 (unsigned long long)est.perdidos, est.overruns);
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,265 @@
+#include "agregacao.h"
+
+#include <algorithm>
+#include <cstring>
+
+#if defined(__x86_64__)
+#include <immintrin.h>
+#define AGREGACAO_X86 1
+#endif
+
+namespace {
+
+// -------------------- Escalar --------------------
+inline bool alerta(uint16_t nivel, uint16_t chuva, Politica p) {
+    return nivel >= p.limiar_agua || chuva >= p.limiar_chuva; // avaliar_alerta
+}
+
+void estatisticas_escalar(const uint16_t *v, size_t n, Estatisticas &e) {
+    uint16_t minimo = e.minimo, maximo = e.maximo;
+    uint64_t soma = 0;
+    for (size_t i = 0; i < n; i++) {
+        minimo = std::min(minimo, v[i]);
+        maximo = std::max(maximo, v[i]);
+        soma += v[i];
+    }
+    e.minimo = minimo;
+    e.maximo = maximo;
+    e.soma += soma;
+    e.n += n;
+}
+
+// Tambem fecha o trecho das versoes vetoriais, a partir de i
+void alertas_de(const uint16_t *nivel, const uint16_t *chuva, size_t i, size_t n, Politica p, ContagemAlertas &c) {
+    bool anterior = c.anterior;
+    uint64_t em_alerta = 0, entradas = 0;
+    for (; i < n; i++) {
+        bool a = alerta(nivel[i], chuva[i], p);
+        em_alerta += a;
+        entradas += a && !anterior;
+        anterior = a;
+    }
+    c.em_alerta += em_alerta;
+    c.entradas += entradas;
+    c.anterior = anterior;
+}
+
+void alertas_escalar(const uint16_t *nivel, const uint16_t *chuva, size_t n, Politica p, ContagemAlertas &c) {
+    alertas_de(nivel, chuva, 0, n, p, c);
+}
+
+uint16_t subida_de(const uint16_t *v, size_t i, size_t n, size_t passo, uint16_t maximo) {
+    for (i = std::max(i, passo); i < n; i++)
+        if (v[i] > v[i - passo])
+            maximo = std::max(maximo, (uint16_t)(v[i] - v[i - passo]));
+    return maximo;
+}
+
+uint16_t subida_escalar(const uint16_t *v, size_t n, size_t passo) {
+    return subida_de(v, passo, n, passo, 0);
+}
+
+const NucleosAgregacao ESCALAR = {"escalar", estatisticas_escalar, alertas_escalar, subida_escalar};
+
+#ifdef AGREGACAO_X86
+// -------------------- SSE4.1 --------------------
+// Comparacao sem sinal de 16 bits: x >= l quando max(x, l) == x. A soma usa o
+// psadbw (soma de bytes em 64 bits) nos bytes baixos e altos, sem estouro.
+// minpos_epu16 reduz o minimo; o maximo e o minimo do complemento.
+#define ALVO_SSE4 __attribute__((target("sse4.1")))
+#define ALVO_AVX2 __attribute__((target("avx2,popcnt")))
+
+ALVO_SSE4 inline uint16_t reduzir_minimo(__m128i x) {
+    return (uint16_t)_mm_extract_epi16(_mm_minpos_epu16(x), 0);
+}
+
+ALVO_SSE4 inline uint16_t reduzir_maximo(__m128i x) {
+    return (uint16_t)~reduzir_minimo(_mm_xor_si128(x, _mm_set1_epi32(-1)));
+}
+
+ALVO_SSE4 inline __m128i acima_sse4(__m128i x, __m128i limiar) {
+    return _mm_cmpeq_epi16(_mm_max_epu16(x, limiar), x);
+}
+
+ALVO_SSE4 void estatisticas_sse4(const uint16_t *v, size_t n, Estatisticas &e) {
+    const __m128i baixo = _mm_set1_epi16(0x00ff), zero = _mm_setzero_si128();
+    __m128i minimo = _mm_set1_epi16((short)e.minimo), maximo = _mm_set1_epi16((short)e.maximo);
+    __m128i soma_baixa = zero, soma_alta = zero;
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i *>(v + i));
+        minimo = _mm_min_epu16(minimo, x);
+        maximo = _mm_max_epu16(maximo, x);
+        soma_baixa = _mm_add_epi64(soma_baixa, _mm_sad_epu8(_mm_and_si128(x, baixo), zero));
+        soma_alta = _mm_add_epi64(soma_alta, _mm_sad_epu8(_mm_srli_epi16(x, 8), zero));
+    }
+    __m128i soma = _mm_add_epi64(soma_baixa, _mm_slli_epi64(soma_alta, 8));
+    e.minimo = reduzir_minimo(minimo);
+    e.maximo = reduzir_maximo(maximo);
+    e.soma += (uint64_t)_mm_cvtsi128_si64(soma) + (uint64_t)_mm_extract_epi64(soma, 1);
+    e.n += i;
+    estatisticas_escalar(v + i, n - i, e);
+}
+
+// A mascara da amostra anterior e a atual deslocada de uma posicao, com a
+// ultima do vetor anterior entrando no comeco (palignr)
+ALVO_SSE4 void alertas_sse4(const uint16_t *nivel, const uint16_t *chuva, size_t n, Politica p, ContagemAlertas &c) {
+    const __m128i agua = _mm_set1_epi16((short)p.limiar_agua), limiar_chuva = _mm_set1_epi16((short)p.limiar_chuva);
+    __m128i antes = c.anterior ? _mm_set1_epi32(-1) : _mm_setzero_si128();
+    uint64_t bytes_alerta = 0, bytes_entrada = 0; // 2 bits de movemask por amostra
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m128i a = _mm_or_si128(acima_sse4(_mm_loadu_si128(reinterpret_cast<const __m128i *>(nivel + i)), agua),
+                                 acima_sse4(_mm_loadu_si128(reinterpret_cast<const __m128i *>(chuva + i)),
+                                            limiar_chuva));
+        __m128i anterior = _mm_alignr_epi8(a, antes, 14);
+        bytes_alerta += (unsigned)__builtin_popcount((unsigned)_mm_movemask_epi8(a));
+        bytes_entrada += (unsigned)__builtin_popcount((unsigned)_mm_movemask_epi8(_mm_andnot_si128(anterior, a)));
+        antes = a;
+    }
+    c.em_alerta += bytes_alerta / 2;
+    c.entradas += bytes_entrada / 2;
+    if (i > 0)
+        c.anterior = alerta(nivel[i - 1], chuva[i - 1], p);
+    alertas_de(nivel, chuva, i, n, p, c);
+}
+
+ALVO_SSE4 uint16_t subida_sse4(const uint16_t *v, size_t n, size_t passo) {
+    __m128i maximo = _mm_setzero_si128();
+    size_t i = passo;
+    for (; i + 8 <= n; i += 8) {
+        __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i *>(v + i));
+        __m128i y = _mm_loadu_si128(reinterpret_cast<const __m128i *>(v + i - passo));
+        maximo = _mm_max_epu16(maximo, _mm_subs_epu16(x, y));
+    }
+    return subida_de(v, i, n, passo, reduzir_maximo(maximo));
+}
+
+const NucleosAgregacao SSE4 = {"sse4", estatisticas_sse4, alertas_sse4, subida_sse4};
+
+// -------------------- AVX2 --------------------
+// As mesmas contas em 16 amostras. O palignr do AVX2 anda dentro de cada
+// metade de 128 bits; a metade que entra vem antes do permute2x128.
+ALVO_AVX2 inline __m128i metade_baixa(__m256i x) {
+    return _mm256_castsi256_si128(x);
+}
+
+ALVO_AVX2 inline __m256i acima_avx2(__m256i x, __m256i limiar) {
+    return _mm256_cmpeq_epi16(_mm256_max_epu16(x, limiar), x);
+}
+
+ALVO_AVX2 void estatisticas_avx2(const uint16_t *v, size_t n, Estatisticas &e) {
+    const __m256i baixo = _mm256_set1_epi16(0x00ff), zero = _mm256_setzero_si256();
+    __m256i minimo = _mm256_set1_epi16((short)e.minimo), maximo = _mm256_set1_epi16((short)e.maximo);
+    __m256i soma_baixa = zero, soma_alta = zero;
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(v + i));
+        minimo = _mm256_min_epu16(minimo, x);
+        maximo = _mm256_max_epu16(maximo, x);
+        soma_baixa = _mm256_add_epi64(soma_baixa, _mm256_sad_epu8(_mm256_and_si256(x, baixo), zero));
+        soma_alta = _mm256_add_epi64(soma_alta, _mm256_sad_epu8(_mm256_srli_epi16(x, 8), zero));
+    }
+    __m256i soma4 = _mm256_add_epi64(soma_baixa, _mm256_slli_epi64(soma_alta, 8));
+    __m128i soma = _mm_add_epi64(metade_baixa(soma4), _mm256_extracti128_si256(soma4, 1));
+    e.minimo = reduzir_minimo(_mm_min_epu16(metade_baixa(minimo), _mm256_extracti128_si256(minimo, 1)));
+    e.maximo = reduzir_maximo(_mm_max_epu16(metade_baixa(maximo), _mm256_extracti128_si256(maximo, 1)));
+    e.soma += (uint64_t)_mm_cvtsi128_si64(soma) + (uint64_t)_mm_extract_epi64(soma, 1);
+    e.n += i;
+    estatisticas_sse4(v + i, n - i, e);
+}
+
+ALVO_AVX2 void alertas_avx2(const uint16_t *nivel, const uint16_t *chuva, size_t n, Politica p, ContagemAlertas &c) {
+    const __m256i agua = _mm256_set1_epi16((short)p.limiar_agua);
+    const __m256i limiar_chuva = _mm256_set1_epi16((short)p.limiar_chuva);
+    __m256i antes = c.anterior ? _mm256_set1_epi32(-1) : _mm256_setzero_si256();
+    uint64_t bytes_alerta = 0, bytes_entrada = 0;
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        __m256i a = _mm256_or_si256(
+            acima_avx2(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(nivel + i)), agua),
+            acima_avx2(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(chuva + i)), limiar_chuva));
+        __m256i meio = _mm256_permute2x128_si256(antes, a, 0x21); // [antes.alta, a.baixa]
+        __m256i anterior = _mm256_alignr_epi8(a, meio, 14);
+        bytes_alerta += (unsigned)_mm_popcnt_u32((unsigned)_mm256_movemask_epi8(a));
+        bytes_entrada += (unsigned)_mm_popcnt_u32((unsigned)_mm256_movemask_epi8(_mm256_andnot_si256(anterior, a)));
+        antes = a;
+    }
+    c.em_alerta += bytes_alerta / 2;
+    c.entradas += bytes_entrada / 2;
+    if (i > 0)
+        c.anterior = alerta(nivel[i - 1], chuva[i - 1], p);
+    alertas_de(nivel, chuva, i, n, p, c);
+}
+
+ALVO_AVX2 uint16_t subida_avx2(const uint16_t *v, size_t n, size_t passo) {
+    __m256i maximo = _mm256_setzero_si256();
+    size_t i = passo;
+    for (; i + 16 <= n; i += 16) {
+        __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(v + i));
+        __m256i y = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(v + i - passo));
+        maximo = _mm256_max_epu16(maximo, _mm256_subs_epu16(x, y));
+    }
+    uint16_t m = reduzir_maximo(_mm_max_epu16(metade_baixa(maximo), _mm256_extracti128_si256(maximo, 1)));
+    return subida_de(v, i, n, passo, m);
+}
+
+const NucleosAgregacao AVX2 = {"avx2", estatisticas_avx2, alertas_avx2, subida_avx2};
+#endif
+
+bool suportado(const NucleosAgregacao &nucleos) {
+#ifdef AGREGACAO_X86
+    if (&nucleos == &AVX2)
+        return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("popcnt");
+    if (&nucleos == &SSE4)
+        return __builtin_cpu_supports("sse4.1");
+#endif
+    return &nucleos == &ESCALAR;
+}
+
+} // namespace
+
+std::vector<const NucleosAgregacao *> agregacao_disponiveis() {
+    std::vector<const NucleosAgregacao *> todos = {&ESCALAR};
+#ifdef AGREGACAO_X86
+    todos.push_back(&SSE4);
+    todos.push_back(&AVX2);
+#endif
+    std::vector<const NucleosAgregacao *> disponiveis;
+    for (const NucleosAgregacao *n : todos)
+        if (suportado(*n))
+            disponiveis.push_back(n);
+    return disponiveis;
+}
+
+const NucleosAgregacao &agregacao_nucleos() {
+    static const NucleosAgregacao *melhor = agregacao_disponiveis().back();
+    return *melhor;
+}
+
+const NucleosAgregacao *agregacao_nucleos(const char *nome) {
+    for (const NucleosAgregacao *n : agregacao_disponiveis())
+        if (std::strcmp(n->nome, nome) == 0)
+            return n;
+    return nullptr;
+}
+
+// -------------------- Subida entre trechos --------------------
+void SubidaContinua::somar(const uint16_t *v, size_t n) {
+    if (passo_ == 0 || n == 0)
+        return;
+    if (!cauda_.empty()) {
+        // Pares com a amostra antiga na cauda e a nova no comeco do trecho
+        emenda_.assign(cauda_.begin(), cauda_.end());
+        emenda_.insert(emenda_.end(), v, v + std::min(passo_, n));
+        maximo_ = std::max(maximo_, nucleos_.subida(emenda_.data(), emenda_.size(), passo_));
+    }
+    maximo_ = std::max(maximo_, nucleos_.subida(v, n, passo_));
+    if (n >= passo_) {
+        cauda_.assign(v + n - passo_, v + n);
+    } else {
+        cauda_.insert(cauda_.end(), v, v + n);
+        if (cauda_.size() > passo_)
+            cauda_.erase(cauda_.begin(), cauda_.end() - (std::ptrdiff_t)passo_);
+    }
+}
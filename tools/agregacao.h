@@ -0,0 +1,81 @@
+// -----------------------------------------------------------------------------
+// Nucleos de agregacao sobre as colunas do arquivo (tools/colunas.h): nivel e
+// chuva em centesimos de %, uint16 contiguos.
+//
+//   estatisticas  minimo, maximo e soma (a media sai da soma)
+//   alertas       amostras em alerta e entradas em alerta para um par de
+//                 limiares, com a regra do firmware (avaliar_alerta em
+//                 DispFilaTasks.c): nivel >= limiar_agua || chuva >=
+//                 limiar_chuva. Uma entrada e uma amostra em alerta depois de
+//                 uma fora dele, como o contador 'alertas' da estacao.
+//   subida        maior subida nivel[i] - nivel[i - passo] (0 se so desce)
+//
+// Tres versoes, escolhidas em tempo de execucao pelo que a CPU suporta
+// (__builtin_cpu_supports): AVX2 (16 amostras por instrucao), SSE4.1 (8) e
+// a escalar, que vale em qualquer host. Todas dao o mesmo resultado, bit a
+// bit; nao ha ponto flutuante. Os nucleos recebem um trecho contiguo e levam
+// o estado de um trecho para o seguinte, para varrer bloco a bloco.
+// -----------------------------------------------------------------------------
+
+#ifndef AGREGACAO_H
+#define AGREGACAO_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+struct Estatisticas {
+    uint16_t minimo = UINT16_MAX;
+    uint16_t maximo = 0;
+    uint64_t soma = 0;
+    uint64_t n = 0;
+
+    double media() const { return n ? (double)soma / (double)n : 0.0; }
+};
+
+struct Politica {
+    uint16_t limiar_agua;  // centesimos de %
+    uint16_t limiar_chuva;
+};
+
+struct ContagemAlertas {
+    uint64_t em_alerta = 0;
+    uint64_t entradas = 0;
+    bool anterior = false; // ultima amostra do trecho anterior
+};
+
+struct NucleosAgregacao {
+    const char *nome;
+    void (*estatisticas)(const uint16_t *v, size_t n, Estatisticas &e);
+    void (*alertas)(const uint16_t *nivel, const uint16_t *chuva, size_t n, Politica p, ContagemAlertas &c);
+    // Maior v[i] - v[i - passo] para i em [passo, n), saturada em 0
+    uint16_t (*subida)(const uint16_t *v, size_t n, size_t passo);
+};
+
+// A melhor versao suportada por esta CPU
+const NucleosAgregacao &agregacao_nucleos();
+
+// "escalar", "sse4" ou "avx2"; nullptr se nao existe ou a CPU nao suporta
+const NucleosAgregacao *agregacao_nucleos(const char *nome);
+
+// Versoes disponiveis nesta CPU, da escalar para a mais larga
+std::vector<const NucleosAgregacao *> agregacao_disponiveis();
+
+// Subida maxima de uma serie entregue em trechos (blocos e dias seguidos):
+// guarda as ultimas 'passo' amostras para a emenda entre um trecho e outro.
+class SubidaContinua {
+public:
+    SubidaContinua(const NucleosAgregacao &nucleos, size_t passo) : nucleos_(nucleos), passo_(passo) {}
+
+    void somar(const uint16_t *v, size_t n);
+    uint16_t maximo() const { return maximo_; }
+
+private:
+    const NucleosAgregacao &nucleos_;
+    size_t passo_;
+    std::vector<uint16_t> cauda_; // ate 'passo' amostras
+    std::vector<uint16_t> emenda_;
+    uint16_t maximo_ = 0;
+};
+
+#endif
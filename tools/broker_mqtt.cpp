@@ -0,0 +1,202 @@
+// -----------------------------------------------------------------------------
+// broker_mqtt: broker MQTT 3.1.1 minimo para testar o publicador da estacao
+// (lib/mqtt.h) no host, no lugar de um Mosquitto.
+//
+//   broker_mqtt [porta] [--cair-apos N] [--sem-puback]
+//
+// Aceita CONNECT, confirma cada PUBLISH QoS 1 com PUBACK e responde PINGREQ.
+// Cada mensagem sai numa linha "tempo_s,topico,dup,carga" na saida padrao.
+// --cair-apos N derruba a conexao depois de N mensagens (testa o reenvio com
+// DUP) e --sem-puback nunca confirma (testa o anel enchendo). No fim (Ctrl+C)
+// imprime conexoes, mensagens e lotes novos e repetidos (pelo "t").
+// -----------------------------------------------------------------------------
+
+#include <chrono>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+namespace {
+
+volatile std::sig_atomic_t parar = 0;
+
+struct Cliente {
+    int fd;
+    std::vector<uint8_t> entrada;
+};
+
+struct Contagem {
+    uint64_t mensagens = 0;
+    uint64_t repetidas = 0;
+    uint64_t conexoes = 0;
+    uint64_t lotes = 0;
+    long ultimo_t = -1;
+};
+
+double agora_s() {
+    using namespace std::chrono;
+    static const auto inicio = steady_clock::now();
+    return duration<double>(steady_clock::now() - inicio).count();
+}
+
+// Tamanho restante em base 128; 0 se ainda faltam bytes
+size_t ler_tamanho(const std::vector<uint8_t> &b, size_t &restante) {
+    restante = 0;
+    for (size_t i = 1; i < b.size() && i <= 4; i++) {
+        restante |= (size_t)(b[i] & 0x7F) << (7 * (i - 1));
+        if (!(b[i] & 0x80))
+            return i + 1;
+    }
+    return 0;
+}
+
+long campo_t(const std::string &carga) {
+    size_t p = carga.find("\"t\":");
+    return p == std::string::npos ? -1 : std::strtol(carga.c_str() + p + 4, nullptr, 10);
+}
+
+// Processa os pacotes completos; false para fechar a conexao
+bool atender(Cliente &c, Contagem &n, long cair_apos, bool sem_puback) {
+    while (c.entrada.size() >= 2) {
+        size_t restante;
+        size_t cabecalho = ler_tamanho(c.entrada, restante);
+        if (cabecalho == 0 || c.entrada.size() < cabecalho + restante)
+            return true;
+        const uint8_t *corpo = c.entrada.data() + cabecalho;
+        uint8_t tipo = c.entrada[0] & 0xF0;
+
+        if (tipo == 0x10) { // CONNECT
+            const uint8_t connack[] = { 0x20, 2, 0, 0 };
+            send(c.fd, connack, sizeof(connack), MSG_NOSIGNAL);
+            n.conexoes++;
+        } else if (tipo == 0x30 && restante >= 2) { // PUBLISH
+            uint8_t qos = (c.entrada[0] >> 1) & 3;
+            bool dup = c.entrada[0] & 0x08;
+            size_t n_topico = (size_t)corpo[0] << 8 | corpo[1];
+            std::string topico((const char *)corpo + 2, n_topico);
+            size_t p = 2 + n_topico;
+            uint16_t id = 0;
+            if (qos > 0) {
+                id = (uint16_t)(corpo[p] << 8 | corpo[p + 1]);
+                p += 2;
+            }
+            std::string carga((const char *)corpo + p, restante - p);
+            std::printf("%.3f,%s,%d,%s\n", agora_s(), topico.c_str(), dup, carga.c_str());
+            std::fflush(stdout);
+
+            long t = campo_t(carga);
+            bool lote = topico.size() >= 5 && topico.compare(topico.size() - 5, 5, "/lote") == 0;
+            if (lote && t >= 0) {
+                if (t <= n.ultimo_t)
+                    n.repetidas++;
+                else
+                    n.lotes++;
+                n.ultimo_t = t > n.ultimo_t ? t : n.ultimo_t;
+            }
+            n.mensagens++;
+
+            if (qos == 1 && !sem_puback) {
+                const uint8_t puback[] = { 0x40, 2, (uint8_t)(id >> 8), (uint8_t)id };
+                send(c.fd, puback, sizeof(puback), MSG_NOSIGNAL);
+            }
+            if (cair_apos > 0 && n.mensagens % (uint64_t)cair_apos == 0) {
+                std::fprintf(stderr, "broker: derrubando a conexao apos %llu mensagens\n",
+                             (unsigned long long)n.mensagens);
+                return false;
+            }
+        } else if (tipo == 0xC0) { // PINGREQ
+            const uint8_t pingresp[] = { 0xD0, 0 };
+            send(c.fd, pingresp, sizeof(pingresp), MSG_NOSIGNAL);
+        } else if (tipo == 0xE0) { // DISCONNECT
+            return false;
+        }
+        c.entrada.erase(c.entrada.begin(), c.entrada.begin() + (long)(cabecalho + restante));
+    }
+    return true;
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+    int porta = 1883;
+    long cair_apos = 0;
+    bool sem_puback = false;
+    for (int i = 1; i < argc; i++) {
+        if (std::strcmp(argv[i], "--cair-apos") == 0 && i + 1 < argc)
+            cair_apos = std::atol(argv[++i]);
+        else if (std::strcmp(argv[i], "--sem-puback") == 0)
+            sem_puback = true;
+        else if (argv[i][0] != '-')
+            porta = std::atoi(argv[i]);
+        else {
+            std::fprintf(stderr, "uso: %s [porta] [--cair-apos N] [--sem-puback]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    int escuta = socket(AF_INET, SOCK_STREAM, 0);
+    int um = 1;
+    setsockopt(escuta, SOL_SOCKET, SO_REUSEADDR, &um, sizeof(um));
+    sockaddr_in endereco{};
+    endereco.sin_family = AF_INET;
+    endereco.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    endereco.sin_port = htons((uint16_t)porta);
+    if (bind(escuta, (sockaddr *)&endereco, sizeof(endereco)) < 0 || listen(escuta, 4) < 0) {
+        std::perror("broker");
+        return 1;
+    }
+    std::signal(SIGINT, [](int) { parar = 1; });
+    std::signal(SIGTERM, [](int) { parar = 1; });
+    std::fprintf(stderr, "broker: escutando em 127.0.0.1:%d\n", porta);
+    std::printf("tempo_s,topico,dup,carga\n");
+
+    std::vector<Cliente> clientes;
+    Contagem n;
+    while (!parar) {
+        std::vector<pollfd> fds{{escuta, POLLIN, 0}};
+        for (const Cliente &c : clientes)
+            fds.push_back({c.fd, POLLIN, 0});
+        if (poll(fds.data(), fds.size(), 200) <= 0)
+            continue;
+
+        if (fds[0].revents & POLLIN) {
+            int fd = accept(escuta, nullptr, nullptr);
+            if (fd >= 0)
+                clientes.push_back({fd, {}});
+        }
+        for (size_t i = 1; i < fds.size(); i++) {
+            if (!(fds[i].revents & (POLLIN | POLLHUP | POLLERR)))
+                continue;
+            Cliente &c = clientes[i - 1];
+            uint8_t pedaco[2048];
+            ssize_t lidos = recv(c.fd, pedaco, sizeof(pedaco), 0);
+            bool manter = lidos > 0;
+            if (manter) {
+                c.entrada.insert(c.entrada.end(), pedaco, pedaco + lidos);
+                manter = atender(c, n, cair_apos, sem_puback);
+            }
+            if (!manter) {
+                close(c.fd);
+                c.fd = -1;
+            }
+        }
+        for (size_t i = clientes.size(); i-- > 0;) {
+            if (clientes[i].fd < 0)
+                clientes.erase(clientes.begin() + (long)i);
+        }
+    }
+
+    std::fprintf(stderr, "broker: %llu conexoes, %llu mensagens, %llu lotes, %llu repetidos\n",
+                 (unsigned long long)n.conexoes, (unsigned long long)n.mensagens,
+                 (unsigned long long)n.lotes, (unsigned long long)n.repetidas);
+    return 0;
+}
@@ -0,0 +1,256 @@
+#include "colunas.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+
+constexpr char MAGIA[8] = {'E', 'S', 'T', 'C', 'O', 'L', 0, 0};
+constexpr uint64_t MS_POR_DIA = 86400000ull;
+constexpr size_t RESERVA = COLUNAS_PAGINA + (size_t)COLUNAS_BLOCOS_MAX * COLUNAS_BLOCO;
+
+// Dias desde 1970-01-01 <-> data civil (calendario gregoriano proleptico)
+int64_t dias_de_civil(int64_t a, unsigned m, unsigned d) {
+    a -= m <= 2;
+    int64_t era = (a >= 0 ? a : a - 399) / 400;
+    unsigned ano_da_era = (unsigned)(a - era * 400);
+    unsigned dia_do_ano = (153 * (m > 2 ? m - 3 : m + 9) + 2) / 5 + d - 1;
+    unsigned dia_da_era = ano_da_era * 365 + ano_da_era / 4 - ano_da_era / 100 + dia_do_ano;
+    return era * 146097 + (int64_t)dia_da_era - 719468;
+}
+
+uint32_t civil_de_dias(int64_t z) {
+    z += 719468;
+    int64_t era = (z >= 0 ? z : z - 146096) / 146097;
+    unsigned dia_da_era = (unsigned)(z - era * 146097);
+    unsigned ano_da_era = (dia_da_era - dia_da_era / 1460 + dia_da_era / 36524 - dia_da_era / 146096) / 365;
+    unsigned dia_do_ano = dia_da_era - (365 * ano_da_era + ano_da_era / 4 - ano_da_era / 100);
+    unsigned mp = (5 * dia_do_ano + 2) / 153;
+    unsigned d = dia_do_ano - (153 * mp + 2) / 5 + 1;
+    unsigned m = mp < 10 ? mp + 3 : mp - 9;
+    int64_t a = (int64_t)ano_da_era + era * 400 + (m <= 2);
+    return (uint32_t)(a * 10000 + m * 100 + d);
+}
+
+int64_t dias_de(uint32_t dia) {
+    return dias_de_civil(dia / 10000, dia / 100 % 100, dia % 100);
+}
+
+std::string caminho_estacao(const std::string &raiz, uint32_t estacao) {
+    return raiz + "/" + std::to_string(estacao);
+}
+
+std::string caminho_dia(const std::string &raiz, uint32_t estacao, uint32_t dia) {
+    return caminho_estacao(raiz, estacao) + "/" + std::to_string(dia) + ".col";
+}
+
+bool numero(const char *texto, uint32_t &valor, const char *fim_esperado) {
+    char *fim;
+    errno = 0;
+    unsigned long v = std::strtoul(texto, &fim, 10);
+    if (fim == texto || errno != 0 || v > UINT32_MAX || std::strcmp(fim, fim_esperado) != 0)
+        return false;
+    valor = (uint32_t)v;
+    return true;
+}
+
+} // namespace
+
+uint32_t colunas_dia(uint64_t unix_ms) {
+    return civil_de_dias((int64_t)(unix_ms / MS_POR_DIA));
+}
+
+uint64_t colunas_inicio_dia_ms(uint32_t dia) {
+    return (uint64_t)dias_de(dia) * MS_POR_DIA;
+}
+
+uint32_t colunas_somar_dias(uint32_t dia, int dias) {
+    return civil_de_dias(dias_de(dia) + dias);
+}
+
+// -------------------- Escrita --------------------
+EscritorColunas::EscritorColunas(const std::string &raiz, uint32_t estacao) : raiz_(raiz), estacao_(estacao) {}
+
+EscritorColunas::~EscritorColunas() {
+    fechar();
+}
+
+void EscritorColunas::fechar() {
+    if (mapa_ != nullptr)
+        munmap(mapa_, RESERVA);
+    if (fd_ >= 0)
+        close(fd_);
+    mapa_ = nullptr;
+    fd_ = -1;
+    dia_ = 0;
+}
+
+bool EscritorColunas::abrir_dia(uint32_t dia) {
+    fechar();
+    mkdir(raiz_.c_str(), 0755);
+    mkdir(caminho_estacao(raiz_, estacao_).c_str(), 0755);
+    std::string caminho = caminho_dia(raiz_, estacao_, dia);
+    fd_ = open(caminho.c_str(), O_RDWR | O_CREAT, 0644);
+    struct stat st;
+    if (fd_ < 0 || fstat(fd_, &st) != 0) {
+        std::perror(caminho.c_str());
+        fechar();
+        return false;
+    }
+    bool novo = st.st_size == 0;
+    if (novo && ftruncate(fd_, COLUNAS_PAGINA) != 0) {
+        std::perror(caminho.c_str());
+        fechar();
+        return false;
+    }
+    // A reserva inteira: o arquivo cresce por baixo sem remapear
+    void *mapa = mmap(nullptr, RESERVA, PROT_READ | PROT_WRITE, MAP_SHARED, fd_, 0);
+    if (mapa == MAP_FAILED) {
+        std::perror(caminho.c_str());
+        fechar();
+        return false;
+    }
+    mapa_ = static_cast<uint8_t *>(mapa);
+    auto *c = reinterpret_cast<CabecalhoColunas *>(mapa_);
+    if (novo) {
+        std::memcpy(c->magia, MAGIA, sizeof(MAGIA));
+        c->versao = COLUNAS_VERSAO;
+        c->estacao = estacao_;
+        c->dia = dia;
+        c->linhas_por_bloco = COLUNAS_LINHAS_POR_BLOCO;
+    } else if (std::memcmp(c->magia, MAGIA, sizeof(MAGIA)) != 0 || c->versao != COLUNAS_VERSAO ||
+               c->linhas_por_bloco != COLUNAS_LINHAS_POR_BLOCO) {
+        std::fprintf(stderr, "%s: nao e um arquivo colunar desta versao\n", caminho.c_str());
+        fechar();
+        return false;
+    }
+    blocos_ = (uint32_t)(((size_t)std::max<off_t>(st.st_size, COLUNAS_PAGINA) - COLUNAS_PAGINA) / COLUNAS_BLOCO);
+    dia_ = dia;
+    return true;
+}
+
+bool EscritorColunas::anexar(uint64_t unix_ms, uint16_t nivel, uint16_t chuva, uint8_t bits) {
+    uint32_t dia = colunas_dia(unix_ms);
+    if (dia != dia_ && !abrir_dia(dia))
+        return false;
+    auto *c = reinterpret_cast<CabecalhoColunas *>(mapa_);
+    uint32_t linhas = c->linhas;
+    uint32_t b = linhas / COLUNAS_LINHAS_POR_BLOCO;
+    uint32_t i = linhas % COLUNAS_LINHAS_POR_BLOCO;
+    if (b >= COLUNAS_BLOCOS_MAX) {
+        c->descartadas++;
+        return false;
+    }
+    if (b >= blocos_) {
+        if (ftruncate(fd_, (off_t)(COLUNAS_PAGINA + (size_t)(b + 1) * COLUNAS_BLOCO)) != 0)
+            return false;
+        blocos_ = b + 1;
+    }
+
+    // O tempo nunca volta no arquivo: uma amostra fora de ordem fica com o
+    // tempo da anterior
+    uint32_t t = (uint32_t)(unix_ms - colunas_inicio_dia_ms(dia));
+    if (linhas > 0)
+        t = std::max(t, c->indice[(linhas - 1) / COLUNAS_LINHAS_POR_BLOCO].tempo_max);
+    uint8_t *bloco = mapa_ + COLUNAS_PAGINA + (size_t)b * COLUNAS_BLOCO;
+    reinterpret_cast<uint32_t *>(bloco + COLUNAS_DESLOC_TEMPO)[i] = t;
+    reinterpret_cast<uint16_t *>(bloco + COLUNAS_DESLOC_NIVEL)[i] = nivel;
+    reinterpret_cast<uint16_t *>(bloco + COLUNAS_DESLOC_CHUVA)[i] = chuva;
+    (bloco + COLUNAS_DESLOC_BITS)[i] = bits;
+    IndiceBloco &indice = c->indice[b];
+    indice.tempo_min = i == 0 ? t : std::min(indice.tempo_min, t);
+    indice.tempo_max = i == 0 ? t : std::max(indice.tempo_max, t);
+    __atomic_store_n(&c->linhas, linhas + 1, __ATOMIC_RELEASE);
+    return true;
+}
+
+// -------------------- Leitura --------------------
+DiaColunas::~DiaColunas() {
+    if (mapa_ != nullptr)
+        munmap(const_cast<uint8_t *>(mapa_), tamanho_);
+}
+
+DiaColunas::DiaColunas(DiaColunas &&outro) noexcept
+    : mapa_(outro.mapa_), tamanho_(outro.tamanho_), linhas_(outro.linhas_) {
+    outro.mapa_ = nullptr;
+}
+
+bool DiaColunas::abrir(const std::string &arquivo) {
+    int fd = open(arquivo.c_str(), O_RDONLY);
+    struct stat st;
+    if (fd < 0 || fstat(fd, &st) != 0 || (size_t)st.st_size < COLUNAS_PAGINA) {
+        if (fd >= 0)
+            close(fd);
+        return false;
+    }
+    void *mapa = mmap(nullptr, (size_t)st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (mapa == MAP_FAILED)
+        return false;
+    mapa_ = static_cast<const uint8_t *>(mapa);
+    tamanho_ = (size_t)st.st_size;
+    const CabecalhoColunas *c = cabecalho();
+    if (std::memcmp(c->magia, MAGIA, sizeof(MAGIA)) != 0 || c->versao != COLUNAS_VERSAO ||
+        c->linhas_por_bloco != COLUNAS_LINHAS_POR_BLOCO)
+        return false;
+    uint32_t cabem = (uint32_t)((tamanho_ - COLUNAS_PAGINA) / COLUNAS_BLOCO) * COLUNAS_LINHAS_POR_BLOCO;
+    linhas_ = std::min(__atomic_load_n(&c->linhas, __ATOMIC_ACQUIRE), cabem);
+    return true;
+}
+
+uint32_t DiaColunas::linhas_no_bloco(uint32_t b) const {
+    return std::min(COLUNAS_LINHAS_POR_BLOCO, linhas_ - b * COLUNAS_LINHAS_POR_BLOCO);
+}
+
+void DiaColunas::faixa(uint32_t b, uint32_t de_ms, uint32_t ate_ms, uint32_t &inicio, uint32_t &fim) const {
+    uint32_t n = linhas_no_bloco(b);
+    const IndiceBloco &i = indice(b);
+    if (i.tempo_max < de_ms || i.tempo_min >= ate_ms) {
+        inicio = fim = 0;
+        return;
+    }
+    if (i.tempo_min >= de_ms && i.tempo_max < ate_ms) {
+        inicio = 0;
+        fim = n;
+        return;
+    }
+    const uint32_t *t = tempo(b);
+    inicio = (uint32_t)(std::lower_bound(t, t + n, de_ms) - t);
+    fim = (uint32_t)(std::lower_bound(t + inicio, t + n, ate_ms) - t);
+}
+
+std::vector<ArquivoDia> colunas_listar(const std::string &raiz, uint32_t de, uint32_t ate) {
+    std::vector<ArquivoDia> arquivos;
+    DIR *d = opendir(raiz.c_str());
+    if (d == nullptr)
+        return arquivos;
+    while (dirent *e = readdir(d)) {
+        uint32_t estacao;
+        if (!numero(e->d_name, estacao, ""))
+            continue;
+        std::string pasta = caminho_estacao(raiz, estacao);
+        DIR *dias = opendir(pasta.c_str());
+        if (dias == nullptr)
+            continue;
+        while (dirent *f = readdir(dias)) {
+            uint32_t dia;
+            if (numero(f->d_name, dia, ".col") && dia >= de && dia <= ate)
+                arquivos.push_back({estacao, dia, pasta + "/" + f->d_name});
+        }
+        closedir(dias);
+    }
+    closedir(d);
+    std::sort(arquivos.begin(), arquivos.end(), [](const ArquivoDia &a, const ArquivoDia &b) {
+        return a.estacao != b.estacao ? a.estacao < b.estacao : a.dia < b.dia;
+    });
+    return arquivos;
+}
@@ -0,0 +1,150 @@
+// -----------------------------------------------------------------------------
+// Arquivo colunar das amostras recebidas pela central (estacao_ingest
+// --arquivo) e lido por estacao_consulta.
+//
+//   <raiz>/<estacao>/<AAAAMMDD>.col   um arquivo por estacao e dia (UTC)
+//
+// O arquivo so cresce. Uma pagina de cabecalho e, depois dela, blocos de
+// COLUNAS_LINHAS_POR_BLOCO linhas. Dentro do bloco cada coluna e contigua e
+// comeca numa pagina propria:
+//
+//   tempo  uint32  ms desde a meia-noite do dia   16 KB
+//   nivel  uint16  centesimos de %                 8 KB
+//   chuva  uint16  centesimos de %                 8 KB
+//   bits   uint8   COLUNAS_BIT_*                   4 KB
+//
+// Uma consulta que so precisa do nivel mapeia o arquivo e le 8 KB por bloco,
+// direto do page cache, sem copiar e sem tocar as paginas das outras
+// colunas. O cabecalho guarda o indice esparso: tempo minimo e maximo de
+// cada bloco, para pular os blocos fora do intervalo pedido.
+//
+// Inteiros em little-endian (o formato e o da memoria do host x86/ARM). O
+// escritor grava as colunas da linha e so depois publica a contagem no
+// cabecalho (release); um leitor ao mesmo tempo ve linhas inteiras.
+// -----------------------------------------------------------------------------
+
+#ifndef COLUNAS_H
+#define COLUNAS_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+constexpr uint32_t COLUNAS_VERSAO = 1;
+constexpr size_t COLUNAS_PAGINA = 4096;
+constexpr uint32_t COLUNAS_LINHAS_POR_BLOCO = 4096;
+constexpr uint32_t COLUNAS_BLOCOS_MAX = 448; // 1,8 milhao de linhas por dia (~21 Hz)
+
+constexpr size_t COLUNAS_DESLOC_TEMPO = 0;
+constexpr size_t COLUNAS_DESLOC_NIVEL = COLUNAS_DESLOC_TEMPO + COLUNAS_LINHAS_POR_BLOCO * sizeof(uint32_t);
+constexpr size_t COLUNAS_DESLOC_CHUVA = COLUNAS_DESLOC_NIVEL + COLUNAS_LINHAS_POR_BLOCO * sizeof(uint16_t);
+constexpr size_t COLUNAS_DESLOC_BITS = COLUNAS_DESLOC_CHUVA + COLUNAS_LINHAS_POR_BLOCO * sizeof(uint16_t);
+constexpr size_t COLUNAS_BLOCO = COLUNAS_DESLOC_BITS + COLUNAS_LINHAS_POR_BLOCO * sizeof(uint8_t);
+static_assert(COLUNAS_BLOCO % COLUNAS_PAGINA == 0, "colunas alinhadas em pagina");
+
+constexpr uint8_t COLUNAS_BIT_ALERTA = 1u << 0;  // amostra em alerta na estacao
+constexpr uint8_t COLUNAS_BIT_LACUNA = 1u << 1;  // quadros perdidos antes desta
+
+struct IndiceBloco {
+    uint32_t tempo_min;
+    uint32_t tempo_max;
+};
+
+struct CabecalhoColunas {
+    char magia[8];              // "ESTCOL\0\0"
+    uint32_t versao;
+    uint32_t estacao;
+    uint32_t dia;               // AAAAMMDD
+    uint32_t linhas_por_bloco;
+    uint32_t linhas;            // publicadas (escrita com release)
+    uint32_t descartadas;       // alem de COLUNAS_BLOCOS_MAX blocos
+    IndiceBloco indice[COLUNAS_BLOCOS_MAX];
+};
+static_assert(sizeof(CabecalhoColunas) <= COLUNAS_PAGINA, "cabecalho numa pagina");
+
+// Datas em UTC
+uint32_t colunas_dia(uint64_t unix_ms);            // AAAAMMDD
+uint64_t colunas_inicio_dia_ms(uint32_t dia);      // meia-noite em ms Unix
+uint32_t colunas_somar_dias(uint32_t dia, int dias);
+
+// -------------------- Escrita --------------------
+// Uma estacao, um escritor, uma thread. O arquivo do dia fica mapeado com a
+// reserva inteira (COLUNAS_BLOCOS_MAX blocos) e cresce um bloco por vez com
+// ftruncate; no outro dia, o arquivo troca.
+class EscritorColunas {
+public:
+    EscritorColunas(const std::string &raiz, uint32_t estacao);
+    ~EscritorColunas();
+    EscritorColunas(const EscritorColunas &) = delete;
+    EscritorColunas &operator=(const EscritorColunas &) = delete;
+
+    // Em ordem de tempo (um atraso vira o tempo da linha anterior). false se
+    // nao deu para abrir o arquivo ou o dia esta cheio
+    bool anexar(uint64_t unix_ms, uint16_t nivel, uint16_t chuva, uint8_t bits);
+
+private:
+    bool abrir_dia(uint32_t dia);
+    void fechar();
+
+    std::string raiz_;
+    uint32_t estacao_;
+    uint32_t dia_ = 0;
+    int fd_ = -1;
+    uint8_t *mapa_ = nullptr;
+    uint32_t blocos_ = 0; // ja com espaco no arquivo
+};
+
+// -------------------- Leitura --------------------
+// Mapeamento somente leitura de um arquivo do dia. As colunas sao ponteiros
+// para dentro do mapa; nada e copiado.
+class DiaColunas {
+public:
+    DiaColunas() = default;
+    ~DiaColunas();
+    DiaColunas(DiaColunas &&outro) noexcept;
+    DiaColunas(const DiaColunas &) = delete;
+    DiaColunas &operator=(const DiaColunas &) = delete;
+
+    bool abrir(const std::string &arquivo);
+
+    uint32_t estacao() const { return cabecalho()->estacao; }
+    uint32_t dia() const { return cabecalho()->dia; }
+    uint32_t linhas() const { return linhas_; }
+    uint32_t blocos() const { return (linhas_ + COLUNAS_LINHAS_POR_BLOCO - 1) / COLUNAS_LINHAS_POR_BLOCO; }
+    uint32_t linhas_no_bloco(uint32_t b) const;
+    const IndiceBloco &indice(uint32_t b) const { return cabecalho()->indice[b]; }
+
+    const uint32_t *tempo(uint32_t b) const { return coluna<uint32_t>(b, COLUNAS_DESLOC_TEMPO); }
+    const uint16_t *nivel(uint32_t b) const { return coluna<uint16_t>(b, COLUNAS_DESLOC_NIVEL); }
+    const uint16_t *chuva(uint32_t b) const { return coluna<uint16_t>(b, COLUNAS_DESLOC_CHUVA); }
+    const uint8_t *bits(uint32_t b) const { return coluna<uint8_t>(b, COLUNAS_DESLOC_BITS); }
+
+    // Linhas [inicio, fim) do bloco com tempo em [de_ms, ate_ms) (ms do dia).
+    // Usa o indice para os blocos inteiros dentro ou fora e busca binaria
+    // nas bordas; supoe o tempo crescente dentro do bloco.
+    void faixa(uint32_t b, uint32_t de_ms, uint32_t ate_ms, uint32_t &inicio, uint32_t &fim) const;
+
+private:
+    const CabecalhoColunas *cabecalho() const { return reinterpret_cast<const CabecalhoColunas *>(mapa_); }
+
+    template <typename T>
+    const T *coluna(uint32_t b, size_t deslocamento) const {
+        return reinterpret_cast<const T *>(mapa_ + COLUNAS_PAGINA + (size_t)b * COLUNAS_BLOCO + deslocamento);
+    }
+
+    const uint8_t *mapa_ = nullptr;
+    size_t tamanho_ = 0;
+    uint32_t linhas_ = 0;
+};
+
+struct ArquivoDia {
+    uint32_t estacao;
+    uint32_t dia;
+    std::string caminho;
+};
+
+// Arquivos das estacoes com dia em [de, ate], ordenados por estacao e dia
+std::vector<ArquivoDia> colunas_listar(const std::string &raiz, uint32_t de, uint32_t ate);
+
+#endif
@@ -0,0 +1,543 @@
+// -----------------------------------------------------------------------------
+// estacao_consulta: consultas e medidas sobre o arquivo colunar da central
+// (tools/colunas.h).
+//
+//   estacao_consulta gerar <raiz> [--estacoes N] [--dias D] [--taxa HZ]
+//   estacao_consulta max-nivel <raiz> [--dias D]
+//   estacao_consulta bench <raiz> [--dias D] [--repeticoes R] [--passo N]
+//   estacao_consulta resumo <raiz> [--dias D] [--politica A:C] [--passo N]
+//   estacao_consulta politica <raiz> --politica A:C [--politica A:C ...]
+//                    [--dias D]
+//
+// gerar escreve D dias completos (ate hoje, UTC) de N estacoes com a rampa do
+// simulador e chuvas de algumas horas, pelo mesmo escritor do estacao_ingest.
+//
+// max-nivel responde "nivel maximo de cada estacao nos ultimos D dias"
+// (padrao 7): so le a coluna nivel, e a tempo so nas bordas do intervalo e
+// no bloco do maximo. Imprime estacao,nivel_max,instante em CSV.
+//
+// bench varre as colunas mapeadas R vezes (padrao 5) e mede GB/s por
+// consulta: so o nivel, nivel+chuva+bits e as quatro colunas. A primeira
+// volta pode vir do disco; as outras, do page cache. Depois mede os nucleos
+// de agregacao (tools/agregacao.h) de cada versao que a CPU suporta e
+// confere que todas chegam ao resultado da escalar.
+//
+// resumo da, por estacao, minimo, maximo e media do nivel e da chuva,
+// amostras e entradas em alerta e a maior subida do nivel em N amostras
+// (padrao 10, 1 s a 100 ms). politica reavalia o historico inteiro com
+// outros limiares, em % como no 'set' do shell (padrao 70:80): amostras e
+// entradas em alerta e estacoes atingidas por politica. A regra e a do
+// firmware, sobre os mesmos centesimos que a estacao comparou; as entradas
+// contam a partir do comeco do intervalo. --nucleo escalar|sse4|avx2 fixa
+// a versao (padrao: a mais larga que a CPU suporta).
+// -----------------------------------------------------------------------------
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <string>
+#include <vector>
+
+#include "agregacao.h"
+#include "colunas.h"
+
+namespace {
+
+using Relogio = std::chrono::steady_clock;
+
+constexpr uint64_t MS_POR_DIA = 86400000ull;
+constexpr uint16_t LIMIAR_AGUA = 7000; // CONFIG_PADRAO_LIMIAR_AGUA
+constexpr uint16_t LIMIAR_CHUVA = 8000;
+
+uint64_t agora_unix_ms() {
+    return (uint64_t)std::chrono::duration_cast<std::chrono::milliseconds>(
+               std::chrono::system_clock::now().time_since_epoch())
+        .count();
+}
+
+double segundos_desde(Relogio::time_point inicio) {
+    return std::chrono::duration<double>(Relogio::now() - inicio).count();
+}
+
+// -------------------- Intervalo --------------------
+// [de, ate) em ms Unix, recortado para cada arquivo do dia
+struct Intervalo {
+    uint64_t de_ms;
+    uint64_t ate_ms;
+
+    void no_dia(uint32_t dia, uint32_t &de, uint32_t &ate) const {
+        uint64_t inicio = colunas_inicio_dia_ms(dia);
+        de = de_ms > inicio ? (uint32_t)std::min<uint64_t>(de_ms - inicio, MS_POR_DIA) : 0;
+        ate = ate_ms > inicio ? (uint32_t)std::min<uint64_t>(ate_ms - inicio, MS_POR_DIA) : 0;
+    }
+};
+
+Intervalo ultimos_dias(int dias) {
+    uint64_t agora = agora_unix_ms();
+    return {agora - (uint64_t)dias * MS_POR_DIA, agora + 1};
+}
+
+std::vector<DiaColunas> abrir(const std::string &raiz, const Intervalo &intervalo) {
+    std::vector<DiaColunas> dias;
+    for (const ArquivoDia &a : colunas_listar(raiz, colunas_dia(intervalo.de_ms), colunas_dia(intervalo.ate_ms - 1))) {
+        DiaColunas d;
+        if (d.abrir(a.caminho))
+            dias.push_back(std::move(d));
+        else
+            std::fprintf(stderr, "estacao_consulta: %s invalido, ignorado\n", a.caminho.c_str());
+    }
+    return dias;
+}
+
+// -------------------- Varreduras --------------------
+// Lacos simples sobre colunas contiguas: o compilador os vetoriza
+uint16_t maximo(const uint16_t *v, uint32_t n) {
+    uint16_t m = 0;
+    for (uint32_t i = 0; i < n; i++)
+        m = std::max(m, v[i]);
+    return m;
+}
+
+struct Maximo {
+    uint32_t estacao = 0;
+    uint16_t nivel = 0;
+    uint64_t instante_ms = 0;
+    bool achou = false;
+};
+
+// Maximo por bloco so na coluna nivel; a posicao, so no bloco vencedor
+std::vector<Maximo> max_nivel(const std::vector<DiaColunas> &dias, const Intervalo &intervalo, uint64_t &bytes) {
+    std::vector<Maximo> resultado;
+    for (const DiaColunas &d : dias) {
+        if (resultado.empty() || resultado.back().estacao != d.estacao()) {
+            resultado.push_back({});
+            resultado.back().estacao = d.estacao();
+        }
+        Maximo &m = resultado.back();
+        uint32_t de, ate;
+        intervalo.no_dia(d.dia(), de, ate);
+        for (uint32_t b = 0; b < d.blocos(); b++) {
+            uint32_t inicio, fim;
+            d.faixa(b, de, ate, inicio, fim);
+            if (inicio == fim)
+                continue;
+            const uint16_t *nivel = d.nivel(b);
+            uint16_t v = maximo(nivel + inicio, fim - inicio);
+            bytes += (fim - inicio) * sizeof(uint16_t);
+            if (m.achou && v <= m.nivel)
+                continue;
+            uint32_t i = (uint32_t)(std::find(nivel + inicio, nivel + fim, v) - nivel);
+            m.nivel = v;
+            m.instante_ms = colunas_inicio_dia_ms(d.dia()) + d.tempo(b)[i];
+            m.achou = true;
+        }
+    }
+    return resultado;
+}
+
+struct Resumo {
+    uint64_t linhas = 0;
+    uint64_t alerta = 0;    // linhas com o bit de alerta
+    uint64_t soma_tempo = 0;
+    uint16_t nivel_max = 0;
+    uint16_t chuva_max = 0;
+};
+
+// Consultas do bench, sempre sobre blocos inteiros
+enum class Consulta { NIVEL, TRES_COLUNAS, TODAS };
+
+void varrer(const std::vector<DiaColunas> &dias, Consulta c, Resumo &r, uint64_t &bytes) {
+    for (const DiaColunas &d : dias) {
+        for (uint32_t b = 0; b < d.blocos(); b++) {
+            uint32_t n = d.linhas_no_bloco(b);
+            r.linhas += n;
+            r.nivel_max = std::max(r.nivel_max, maximo(d.nivel(b), n));
+            bytes += n * sizeof(uint16_t);
+            if (c == Consulta::NIVEL)
+                continue;
+            r.chuva_max = std::max(r.chuva_max, maximo(d.chuva(b), n));
+            const uint8_t *bits = d.bits(b);
+            uint32_t alerta = 0;
+            for (uint32_t i = 0; i < n; i++)
+                alerta += bits[i] & COLUNAS_BIT_ALERTA;
+            r.alerta += alerta;
+            bytes += n * (sizeof(uint16_t) + sizeof(uint8_t));
+            if (c == Consulta::TRES_COLUNAS)
+                continue;
+            const uint32_t *tempo = d.tempo(b);
+            uint64_t soma = 0;
+            for (uint32_t i = 0; i < n; i++)
+                soma += tempo[i];
+            r.soma_tempo += soma;
+            bytes += n * sizeof(uint32_t);
+        }
+    }
+}
+
+// Pedacos de bloco dentro do intervalo, em ordem de estacao e tempo
+template <typename F>
+void trechos(const std::vector<DiaColunas> &dias, const Intervalo &intervalo, F trecho) {
+    for (const DiaColunas &d : dias) {
+        uint32_t de, ate;
+        intervalo.no_dia(d.dia(), de, ate);
+        for (uint32_t b = 0; b < d.blocos(); b++) {
+            uint32_t inicio, fim;
+            d.faixa(b, de, ate, inicio, fim);
+            if (inicio < fim)
+                trecho(d, b, inicio, fim);
+        }
+    }
+}
+
+struct ResumoEstacao {
+    uint32_t estacao;
+    Estatisticas nivel, chuva;
+    ContagemAlertas alertas;
+    SubidaContinua subida;
+};
+
+std::vector<ResumoEstacao> resumir(const std::vector<DiaColunas> &dias, const Intervalo &intervalo,
+                                   const NucleosAgregacao &k, Politica p, size_t passo) {
+    std::vector<ResumoEstacao> resumos;
+    trechos(dias, intervalo, [&](const DiaColunas &d, uint32_t b, uint32_t inicio, uint32_t fim) {
+        if (resumos.empty() || resumos.back().estacao != d.estacao())
+            resumos.push_back({d.estacao(), {}, {}, {}, SubidaContinua(k, passo)});
+        ResumoEstacao &r = resumos.back();
+        const uint16_t *nivel = d.nivel(b) + inicio, *chuva = d.chuva(b) + inicio;
+        size_t n = fim - inicio;
+        k.estatisticas(nivel, n, r.nivel);
+        k.estatisticas(chuva, n, r.chuva);
+        k.alertas(nivel, chuva, n, p, r.alertas);
+        r.subida.somar(nivel, n);
+    });
+    return resumos;
+}
+
+struct ResultadoPolitica {
+    uint64_t em_alerta = 0;
+    uint64_t entradas = 0;
+    uint64_t linhas = 0;
+    unsigned estacoes = 0; // com alguma amostra em alerta
+};
+
+// Le so nivel e chuva; o estado de alerta segue de um bloco e de um dia
+// para o outro e recomeca em cada estacao
+ResultadoPolitica avaliar_politica(const std::vector<DiaColunas> &dias, const Intervalo &intervalo,
+                                   const NucleosAgregacao &k, Politica p) {
+    ResultadoPolitica r;
+    uint32_t estacao = 0;
+    bool primeira = true;
+    ContagemAlertas c;
+    auto fechar = [&] {
+        r.em_alerta += c.em_alerta;
+        r.entradas += c.entradas;
+        r.estacoes += c.em_alerta > 0;
+        c = ContagemAlertas{};
+    };
+    trechos(dias, intervalo, [&](const DiaColunas &d, uint32_t b, uint32_t inicio, uint32_t fim) {
+        if (!primeira && d.estacao() != estacao)
+            fechar();
+        primeira = false;
+        estacao = d.estacao();
+        k.alertas(d.nivel(b) + inicio, d.chuva(b) + inicio, fim - inicio, p, c);
+        r.linhas += fim - inicio;
+    });
+    fechar();
+    return r;
+}
+
+// Os tres nucleos sobre os blocos inteiros, para o bench
+struct ResultadoNucleos {
+    Estatisticas nivel;
+    ContagemAlertas alertas;
+    uint16_t subida = 0;
+
+    bool operator==(const ResultadoNucleos &o) const {
+        return nivel.minimo == o.nivel.minimo && nivel.maximo == o.nivel.maximo && nivel.soma == o.nivel.soma &&
+               nivel.n == o.nivel.n && alertas.em_alerta == o.alertas.em_alerta &&
+               alertas.entradas == o.alertas.entradas && subida == o.subida;
+    }
+};
+
+// -------------------- Comandos --------------------
+int gerar(const std::string &raiz, unsigned estacoes, int dias, double taxa) {
+    uint32_t hoje = colunas_dia(agora_unix_ms());
+    uint64_t inicio = colunas_inicio_dia_ms(colunas_somar_dias(hoje, 1 - dias));
+    uint64_t fim = colunas_inicio_dia_ms(colunas_somar_dias(hoje, 1));
+    double passo_ms = 1000.0 / taxa;
+    auto t0 = Relogio::now();
+    uint64_t linhas = 0;
+    for (unsigned e = 1; e <= estacoes; e++) {
+        EscritorColunas escritor(raiz, e);
+        uint64_t fase = (uint64_t)e * 7919u * 1000u;
+        for (double t = (double)inicio; t < (double)fim; t += passo_ms) {
+            uint64_t ms = (uint64_t)t;
+            // Rampa de 80 s do simulador e uma chuva forte de ~2 h a cada 12 h
+            uint64_t p = (ms + fase) % 80000;
+            uint16_t nivel = (uint16_t)(2000 + (p < 40000 ? p : 80000 - p) * 7000 / 40000);
+            double onda = std::sin((double)((ms + fase) % 43200000) / 43200000.0 * 2 * M_PI);
+            uint16_t chuva = (uint16_t)(3000 + (onda > 0.85 ? (onda - 0.85) / 0.15 * 6000 : 0));
+            bool alerta = nivel >= LIMIAR_AGUA || chuva >= LIMIAR_CHUVA;
+            uint8_t bits = alerta ? COLUNAS_BIT_ALERTA : 0;
+            if (!escritor.anexar(ms, nivel, chuva, bits)) {
+                std::fprintf(stderr, "estacao_consulta: falha ao gravar a estacao %u\n", e);
+                return 1;
+            }
+            linhas++;
+        }
+    }
+    double s = segundos_desde(t0);
+    std::printf("gerado: %u estacoes x %d dias, %llu linhas em %.1f s (%.1f M linhas/s)\n", estacoes, dias,
+                (unsigned long long)linhas, s, (double)linhas / s / 1e6);
+    return 0;
+}
+
+int comando_max_nivel(const std::string &raiz, int dias) {
+    Intervalo intervalo = ultimos_dias(dias);
+    std::vector<DiaColunas> arquivos = abrir(raiz, intervalo);
+    uint64_t bytes = 0;
+    auto t0 = Relogio::now();
+    std::vector<Maximo> maximos = max_nivel(arquivos, intervalo, bytes);
+    double s = segundos_desde(t0);
+
+    std::printf("estacao,nivel_max,instante\n");
+    for (const Maximo &m : maximos) {
+        if (!m.achou)
+            continue;
+        time_t segundos = (time_t)(m.instante_ms / 1000);
+        tm utc;
+        gmtime_r(&segundos, &utc);
+        char quando[32];
+        std::strftime(quando, sizeof(quando), "%Y-%m-%dT%H:%M:%SZ", &utc);
+        std::printf("%u,%.2f,%s\n", m.estacao, m.nivel / 100.0, quando);
+    }
+    std::fprintf(stderr, "%zu arquivos, %.1f MB da coluna nivel em %.3f s (%.2f GB/s)\n", arquivos.size(),
+                 (double)bytes / 1e6, s, (double)bytes / s / 1e9);
+    return 0;
+}
+
+int bench(const std::string &raiz, int dias, int repeticoes, size_t passo) {
+    Intervalo intervalo = ultimos_dias(dias);
+    auto t0 = Relogio::now();
+    std::vector<DiaColunas> arquivos = abrir(raiz, intervalo);
+    std::printf("%zu arquivos abertos e mapeados em %.1f ms\n", arquivos.size(), segundos_desde(t0) * 1e3);
+    if (arquivos.empty())
+        return 1;
+
+    struct {
+        Consulta consulta;
+        const char *nome;
+    } consultas[] = {
+        {Consulta::NIVEL, "nivel"},
+        {Consulta::TRES_COLUNAS, "nivel+chuva+bits"},
+        {Consulta::TODAS, "todas as colunas"},
+    };
+    uint64_t gravados = 0; // amostras com o bit de alerta da estacao
+    for (const auto &c : consultas) {
+        double melhor = 0, soma = 0;
+        uint64_t bytes = 0;
+        Resumo r;
+        for (int i = 0; i < repeticoes; i++) {
+            r = Resumo{};
+            bytes = 0;
+            auto inicio = Relogio::now();
+            varrer(arquivos, c.consulta, r, bytes);
+            double gbs = (double)bytes / segundos_desde(inicio) / 1e9;
+            melhor = std::max(melhor, gbs);
+            soma += gbs;
+        }
+        std::printf("%-18s %8.1f MB  %6.2f GB/s (melhor)  %6.2f GB/s (media)  %llu linhas, nivel max %.2f",
+                    c.nome, (double)bytes / 1e6, melhor, soma / repeticoes, (unsigned long long)r.linhas,
+                    r.nivel_max / 100.0);
+        if (c.consulta != Consulta::NIVEL)
+            std::printf(", chuva max %.2f, %.1f%% em alerta", r.chuva_max / 100.0,
+                        r.linhas ? 100.0 * (double)r.alerta / (double)r.linhas : 0.0);
+        std::printf("\n");
+        gravados = r.alerta;
+    }
+
+    // Nucleos de agregacao: GB/s das colunas que cada um le
+    Intervalo tudo{0, UINT64_MAX};
+    Politica padrao{LIMIAR_AGUA, LIMIAR_CHUVA};
+    ResultadoNucleos referencia;
+    bool confere = true;
+    for (const NucleosAgregacao *k : agregacao_disponiveis()) {
+        double melhor[3] = {0, 0, 0};
+        uint64_t bytes = 0;
+        ResultadoNucleos r;
+        for (int i = 0; i < repeticoes; i++) {
+            r = ResultadoNucleos{};
+            bytes = 0;
+            SubidaContinua subida(*k, passo);
+            double s[3];
+            auto inicio = Relogio::now();
+            trechos(arquivos, tudo, [&](const DiaColunas &d, uint32_t b, uint32_t de, uint32_t ate) {
+                k->estatisticas(d.nivel(b) + de, ate - de, r.nivel);
+                bytes += (ate - de) * sizeof(uint16_t);
+            });
+            s[0] = segundos_desde(inicio);
+            inicio = Relogio::now();
+            trechos(arquivos, tudo, [&](const DiaColunas &d, uint32_t b, uint32_t de, uint32_t ate) {
+                k->alertas(d.nivel(b) + de, d.chuva(b) + de, ate - de, padrao, r.alertas);
+            });
+            s[1] = segundos_desde(inicio);
+            inicio = Relogio::now();
+            trechos(arquivos, tudo, [&](const DiaColunas &d, uint32_t b, uint32_t de, uint32_t ate) {
+                subida.somar(d.nivel(b) + de, ate - de);
+            });
+            s[2] = segundos_desde(inicio);
+            r.subida = subida.maximo();
+            for (int j = 0; j < 3; j++)
+                melhor[j] = std::max(melhor[j], (double)(j == 1 ? 2 * bytes : bytes) / s[j] / 1e9);
+        }
+        if (k == agregacao_disponiveis().front())
+            referencia = r;
+        bool igual = r == referencia;
+        confere = confere && igual;
+        std::printf("nucleo %-8s estatisticas %6.2f GB/s  alertas %6.2f GB/s  subida %6.2f GB/s  "
+                    "(media %.2f, %llu em alerta, %llu entradas, subida %.2f)%s\n",
+                    k->nome, melhor[0], melhor[1], melhor[2], r.nivel.media() / 100.0,
+                    (unsigned long long)r.alertas.em_alerta, (unsigned long long)r.alertas.entradas,
+                    r.subida / 100.0, igual ? "" : "  DIFERE DA ESCALAR");
+    }
+    // Estacoes com os limiares de fabrica: os dois numeros sao iguais
+    std::printf("bit de alerta gravado em %llu amostras; limiares %.2f:%.2f reavaliados: %llu\n",
+                (unsigned long long)gravados, LIMIAR_AGUA / 100.0, LIMIAR_CHUVA / 100.0,
+                (unsigned long long)referencia.alertas.em_alerta);
+    return confere ? 0 : 1;
+}
+
+int comando_resumo(const std::string &raiz, int dias, const NucleosAgregacao &k, Politica p, size_t passo) {
+    Intervalo intervalo = ultimos_dias(dias);
+    std::vector<DiaColunas> arquivos = abrir(raiz, intervalo);
+    auto t0 = Relogio::now();
+    std::vector<ResumoEstacao> resumos = resumir(arquivos, intervalo, k, p, passo);
+    double s = segundos_desde(t0);
+
+    std::printf("estacao,linhas,nivel_min,nivel_max,nivel_media,chuva_min,chuva_max,chuva_media,em_alerta,entradas,"
+                "subida_max\n");
+    uint64_t linhas = 0;
+    for (const ResumoEstacao &r : resumos) {
+        std::printf("%u,%llu,%.2f,%.2f,%.2f,%.2f,%.2f,%.2f,%llu,%llu,%.2f\n", r.estacao,
+                    (unsigned long long)r.nivel.n, r.nivel.minimo / 100.0, r.nivel.maximo / 100.0,
+                    r.nivel.media() / 100.0, r.chuva.minimo / 100.0, r.chuva.maximo / 100.0, r.chuva.media() / 100.0,
+                    (unsigned long long)r.alertas.em_alerta, (unsigned long long)r.alertas.entradas,
+                    r.subida.maximo() / 100.0);
+        linhas += r.nivel.n;
+    }
+    std::fprintf(stderr, "nucleo %s: %llu linhas de %zu arquivos em %.3f s (%.0f M linhas/s)\n", k.nome,
+                 (unsigned long long)linhas, arquivos.size(), s, (double)linhas / s / 1e6);
+    return 0;
+}
+
+int comando_politica(const std::string &raiz, int dias, const NucleosAgregacao &k,
+                     const std::vector<Politica> &politicas) {
+    Intervalo intervalo = ultimos_dias(dias);
+    std::vector<DiaColunas> arquivos = abrir(raiz, intervalo);
+    std::printf("limiar_agua,limiar_chuva,em_alerta,entradas,estacoes,segundos,linhas_por_s\n");
+    for (const Politica &p : politicas) {
+        auto t0 = Relogio::now();
+        ResultadoPolitica r = avaliar_politica(arquivos, intervalo, k, p);
+        double s = segundos_desde(t0);
+        std::printf("%.2f,%.2f,%llu,%llu,%u,%.3f,%.0f\n", p.limiar_agua / 100.0, p.limiar_chuva / 100.0,
+                    (unsigned long long)r.em_alerta, (unsigned long long)r.entradas, r.estacoes, s,
+                    (double)r.linhas / s);
+    }
+    std::fprintf(stderr, "nucleo %s, %zu arquivos dos ultimos %d dias\n", k.nome, arquivos.size(), dias);
+    return 0;
+}
+
+// "70:80" ou "65.5:80" (% como no shell) para centesimos
+bool ler_politica(const char *texto, Politica &p) {
+    char *fim;
+    double agua = std::strtod(texto, &fim);
+    if (fim == texto || *fim != ':')
+        return false;
+    const char *resto = fim + 1;
+    double chuva = std::strtod(resto, &fim);
+    if (fim == resto || *fim != 0 || agua < 0 || agua > 100 || chuva < 0 || chuva > 100)
+        return false;
+    p.limiar_agua = (uint16_t)std::lround(agua * 100);
+    p.limiar_chuva = (uint16_t)std::lround(chuva * 100);
+    return true;
+}
+
+int uso(const char *programa) {
+    std::fprintf(stderr,
+                 "uso: %s gerar <raiz> [--estacoes N] [--dias D] [--taxa HZ]\n"
+                 "     %s max-nivel <raiz> [--dias D]\n"
+                 "     %s bench <raiz> [--dias D] [--repeticoes R] [--passo N]\n"
+                 "     %s resumo <raiz> [--dias D] [--politica A:C] [--passo N]\n"
+                 "     %s politica <raiz> --politica A:C [--politica A:C ...] [--dias D]\n"
+                 "     (resumo e politica aceitam --nucleo escalar|sse4|avx2)\n",
+                 programa, programa, programa, programa, programa);
+    return 2;
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+    if (argc < 3)
+        return uso(argv[0]);
+    std::string comando = argv[1];
+    std::string raiz = argv[2];
+    unsigned estacoes = 20;
+    int dias = 7;
+    double taxa = 1;
+    int repeticoes = 5;
+    size_t passo = 10;
+    std::vector<Politica> politicas;
+    const NucleosAgregacao *nucleos = &agregacao_nucleos();
+    for (int i = 3; i < argc; i++) {
+        if (std::strcmp(argv[i], "--estacoes") == 0 && i + 1 < argc)
+            estacoes = (unsigned)std::atoi(argv[++i]);
+        else if (std::strcmp(argv[i], "--dias") == 0 && i + 1 < argc)
+            dias = std::max(1, std::atoi(argv[++i]));
+        else if (std::strcmp(argv[i], "--taxa") == 0 && i + 1 < argc)
+            taxa = std::atof(argv[++i]);
+        else if (std::strcmp(argv[i], "--repeticoes") == 0 && i + 1 < argc)
+            repeticoes = std::max(1, std::atoi(argv[++i]));
+        else if (std::strcmp(argv[i], "--passo") == 0 && i + 1 < argc)
+            passo = (size_t)std::max(1, std::atoi(argv[++i]));
+        else if (std::strcmp(argv[i], "--politica") == 0 && i + 1 < argc) {
+            Politica p;
+            if (!ler_politica(argv[++i], p))
+                return uso(argv[0]);
+            politicas.push_back(p);
+        } else if (std::strcmp(argv[i], "--nucleo") == 0 && i + 1 < argc) {
+            nucleos = agregacao_nucleos(argv[++i]);
+            if (nucleos == nullptr) {
+                std::fprintf(stderr, "estacao_consulta: nucleo %s nao existe ou esta CPU nao suporta\n", argv[i]);
+                return 2;
+            }
+        } else
+            return uso(argv[0]);
+    }
+
+    if (comando == "gerar") {
+        if (taxa <= 0 || taxa * 86400 > (double)COLUNAS_BLOCOS_MAX * COLUNAS_LINHAS_POR_BLOCO) {
+            std::fprintf(stderr, "estacao_consulta: --taxa deve caber em %u linhas por dia\n",
+                         COLUNAS_BLOCOS_MAX * COLUNAS_LINHAS_POR_BLOCO);
+            return 2;
+        }
+        return gerar(raiz, estacoes, dias, taxa);
+    }
+    if (comando == "max-nivel")
+        return comando_max_nivel(raiz, dias);
+    if (comando == "bench")
+        return bench(raiz, dias, repeticoes, passo);
+    if (comando == "resumo")
+        return comando_resumo(raiz, dias, *nucleos, politicas.empty() ? Politica{LIMIAR_AGUA, LIMIAR_CHUVA}
+                                                                       : politicas.front(), passo);
+    if (comando == "politica") {
+        if (politicas.empty())
+            politicas.push_back({LIMIAR_AGUA, LIMIAR_CHUVA});
+        return comando_politica(raiz, dias, *nucleos, politicas);
+    }
+    return uso(argv[0]);
+}
@@ -0,0 +1,847 @@
+// -----------------------------------------------------------------------------
+// estacao_ingest: recebe a telemetria de muitas estacoes na central, por TCP
+// e UDP, e mede vazao e latencia da ingestao.
+//
+//   estacao_ingest [porta] [--io N] [--trabalhadores N] [--segundos S]
+//                  [--estado estacoes.csv] [--arquivo DIR]
+//
+// Cada quadro e o mesmo da USB (lib/telemetria_proto.h: COBS, terminado por
+// 0x00). So falta dizer de qual estacao ele veio:
+//   TCP  a conexao comeca com o id da estacao (uint32 LE) e segue com os
+//        quadros, como no CDC
+//   UDP  cada datagrama e [id uint32 LE][um ou mais quadros]
+// Padrao na porta 7700, TCP e UDP.
+//
+// Caminho de um quadro:
+//   1. Cada thread de E/S tem o seu epoll e os seus sockets (SO_REUSEPORT: o
+//      kernel divide conexoes e datagramas). Ela so separa os quadros nos
+//      zeros e os copia para lotes de LOTE_QUADROS, um lote aberto por
+//      fragmento, que vao para a fila do fragmento no fim de cada volta do
+//      epoll.
+//   2. A estacao define o fragmento. Cada fragmento tem uma fila MPSC sem
+//      trava (as threads de E/S produzem) e a sua tabela de estacoes.
+//   3. O trabalhador i consome o fragmento i. Sem nada la, rouba o fragmento
+//      mais atrasado. A fila tem um dono por vez (tentar_assumir), entao a
+//      tabela do fragmento nunca e disputada e os quadros de uma estacao
+//      saem em ordem.
+// O trabalhador decodifica o COBS, confere o CRC e a sequencia, e atualiza a
+// estacao: ultima leitura, maximo, transicoes de alerta, perdidos. A latencia
+// vai da volta do recv que trouxe o primeiro quadro do lote ate o fim do
+// lote, num histograma por trabalhador.
+//
+// A cada segundo uma linha com quadros/s, MB/s, p50 e p99 do intervalo e
+// lotes roubados; no fim (Ctrl+C ou --segundos) os totais. --estado grava a
+// tabela final em CSV. --arquivo grava cada amostra no arquivo colunar de
+// DIR (tools/colunas.h), pelo trabalhador que tem o fragmento, com a hora de
+// chegada do lote. Carga: tools/ingest_carga; consultas: estacao_consulta.
+// -----------------------------------------------------------------------------
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <csignal>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <sys/epoll.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+extern "C" {
+#include "cobs.h"
+#include "crc16.h"
+#include "telemetria_proto.h"
+}
+
+#include "colunas.h"
+
+namespace {
+
+using Relogio = std::chrono::steady_clock;
+
+constexpr uint16_t PORTA_PADRAO = 7700;
+constexpr size_t QUADRO_MAX = COBS_TAMANHO_MAX(TELEMETRIA_CARGA_MAX + 4);
+constexpr size_t LOTE_QUADROS = 64;
+constexpr unsigned MENSAGENS_UDP = 64; // datagramas por recvmmsg
+constexpr size_t DATAGRAMA_MAX = 2048;
+constexpr unsigned LOTES_POR_VEZ = 8;  // depois devolve a fila
+constexpr uint32_t ATRASO_ROUBO = 2;   // lotes na fila de outro para valer roubar
+constexpr uint32_t ESTACAO_INVALIDA = UINT32_MAX;
+
+std::atomic<bool> parar{false};
+
+void ao_sinal(int) {
+    parar.store(true, std::memory_order_relaxed);
+}
+
+uint64_t agora_ns() {
+    return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(Relogio::now().time_since_epoch()).count();
+}
+
+uint64_t agora_unix_ms() {
+    return (uint64_t)std::chrono::duration_cast<std::chrono::milliseconds>(
+               std::chrono::system_clock::now().time_since_epoch())
+        .count();
+}
+
+// -------------------- Fila MPSC sem trava --------------------
+// Intrusiva, de Vyukov: produtores so fazem um exchange na cabeca; o
+// consumidor anda pela cauda. Um no e visivel quando o anterior aponta para
+// ele. O consumidor e quem tem a fila assumida; trocar de dono com
+// acquire/release mantem a cauda coerente entre threads.
+struct No {
+    std::atomic<No *> proximo{nullptr};
+};
+
+class FilaMpsc {
+public:
+    FilaMpsc() : cabeca_(&vazio_), cauda_(&vazio_) {}
+
+    void empurrar(No *no) {
+        pendentes_.fetch_add(1, std::memory_order_relaxed);
+        no->proximo.store(nullptr, std::memory_order_relaxed);
+        No *anterior = cabeca_.exchange(no, std::memory_order_acq_rel);
+        anterior->proximo.store(no, std::memory_order_release);
+    }
+
+    // So com a fila assumida. nullptr se vazia ou se um produtor esta no
+    // meio do empurrar (o no aparece na proxima tentativa).
+    No *retirar() {
+        No *cauda = cauda_;
+        No *proximo = cauda->proximo.load(std::memory_order_acquire);
+        if (cauda == &vazio_) {
+            if (proximo == nullptr)
+                return nullptr;
+            cauda_ = cauda = proximo;
+            proximo = proximo->proximo.load(std::memory_order_acquire);
+        }
+        if (proximo == nullptr) {
+            if (cauda != cabeca_.load(std::memory_order_acquire))
+                return nullptr;
+            empurrar_vazio();
+            proximo = cauda->proximo.load(std::memory_order_acquire);
+            if (proximo == nullptr)
+                return nullptr;
+        }
+        cauda_ = proximo;
+        pendentes_.fetch_sub(1, std::memory_order_relaxed);
+        return cauda;
+    }
+
+    bool tentar_assumir() {
+        return !ocupada_.load(std::memory_order_relaxed) && !ocupada_.exchange(true, std::memory_order_acquire);
+    }
+
+    void liberar() {
+        ocupada_.store(false, std::memory_order_release);
+    }
+
+    uint32_t pendentes() const {
+        return pendentes_.load(std::memory_order_relaxed);
+    }
+
+private:
+    void empurrar_vazio() {
+        vazio_.proximo.store(nullptr, std::memory_order_relaxed);
+        No *anterior = cabeca_.exchange(&vazio_, std::memory_order_acq_rel);
+        anterior->proximo.store(&vazio_, std::memory_order_release);
+    }
+
+    alignas(64) std::atomic<No *> cabeca_;
+    alignas(64) No *cauda_;
+    No vazio_;
+    std::atomic<bool> ocupada_{false};
+    alignas(64) std::atomic<uint32_t> pendentes_{0};
+};
+
+struct Quadro {
+    uint32_t estacao;
+    uint8_t tamanho;
+    uint8_t bytes[QUADRO_MAX];
+};
+
+struct Lote : No {
+    uint64_t recebido_ns = 0;
+    uint64_t recebido_unix_ms = 0; // tempo das amostras no arquivo
+    uint32_t n = 0;
+    Quadro quadros[LOTE_QUADROS];
+};
+
+// -------------------- Tabela de estacoes --------------------
+// Enderecamento aberto com sondagem linear. Os ids ficam num vetor separado
+// (16 por linha de cache) e o estado, de 32 bytes, no mesmo indice: a busca
+// so toca a linha do estado que encontrou.
+struct EstadoEstacao {
+    uint32_t id;
+    uint32_t quadros;
+    uint32_t perdidos;  // lacunas de sequencia
+    uint32_t invalidos; // COBS ou CRC
+    uint32_t alertas;   // entradas em alerta
+    uint32_t tempo_ms;  // da ultima amostra, no relogio da estacao
+    uint16_t nivel;     // centesimos de %
+    uint16_t chuva;
+    uint16_t nivel_max;
+    uint8_t esperada;   // proxima sequencia
+    uint8_t bits;
+};
+static_assert(sizeof(EstadoEstacao) == 32, "duas estacoes por linha de cache");
+
+constexpr uint8_t ESTACAO_ALERTA = 1u << 0;
+constexpr uint8_t ESTACAO_INICIADA = 1u << 1;
+
+class TabelaEstacoes {
+public:
+    TabelaEstacoes() { redimensionar(10); }
+
+    EstadoEstacao &obter(uint32_t id) {
+        if (2 * (n_ + 1) > ids_.size())
+            redimensionar(bits_ + 1);
+        size_t i = posicao(id);
+        while (ids_[i] != id && ids_[i] != ESTACAO_INVALIDA)
+            i = (i + 1) & (ids_.size() - 1);
+        if (ids_[i] == ESTACAO_INVALIDA) {
+            ids_[i] = id;
+            estados_[i] = EstadoEstacao{};
+            estados_[i].id = id;
+            n_++;
+        }
+        return estados_[i];
+    }
+
+    template <typename F>
+    void para_cada(F f) const {
+        for (size_t i = 0; i < ids_.size(); i++)
+            if (ids_[i] != ESTACAO_INVALIDA)
+                f(estados_[i]);
+    }
+
+    size_t tamanho() const { return n_; }
+
+private:
+    // Fibonacci: os bits altos espalham ids seguidos e ids de mesmo resto
+    size_t posicao(uint32_t id) const {
+        return (size_t)(((uint64_t)id * 0x9E3779B97F4A7C15ull) >> (64 - bits_));
+    }
+
+    void redimensionar(unsigned bits) {
+        std::vector<uint32_t> ids(std::move(ids_));
+        std::vector<EstadoEstacao> estados(std::move(estados_));
+        bits_ = bits;
+        ids_.assign((size_t)1 << bits, ESTACAO_INVALIDA);
+        estados_.resize((size_t)1 << bits);
+        for (size_t j = 0; j < ids.size(); j++) {
+            if (ids[j] == ESTACAO_INVALIDA)
+                continue;
+            size_t i = posicao(ids[j]);
+            while (ids_[i] != ESTACAO_INVALIDA)
+                i = (i + 1) & (ids_.size() - 1);
+            ids_[i] = ids[j];
+            estados_[i] = estados[j];
+        }
+    }
+
+    std::vector<uint32_t> ids_;
+    std::vector<EstadoEstacao> estados_;
+    unsigned bits_ = 0;
+    size_t n_ = 0;
+};
+
+struct Fragmento {
+    FilaMpsc fila;
+    TabelaEstacoes tabela; // so de quem assumiu a fila
+    std::unordered_map<uint32_t, std::unique_ptr<EscritorColunas>> arquivo; // idem; com --arquivo
+};
+
+// -------------------- Histograma de latencia --------------------
+// Log-linear em ns: 16 faixas por potencia de 2 (erro < 6,25%). Um escritor
+// por histograma; o relatorio le com relaxed, sem parar ninguem.
+class Histograma {
+public:
+    static constexpr size_t BALDES = 61 * 16;
+
+    void registrar(uint64_t ns, uint64_t peso) {
+        std::atomic<uint64_t> &b = baldes_[balde(ns)];
+        b.store(b.load(std::memory_order_relaxed) + peso, std::memory_order_relaxed);
+    }
+
+    void somar_em(std::vector<uint64_t> &total) const {
+        for (size_t i = 0; i < BALDES; i++)
+            total[i] += baldes_[i].load(std::memory_order_relaxed);
+    }
+
+    static size_t balde(uint64_t v) {
+        if (v < 16)
+            return (size_t)v;
+        unsigned e = 63u - (unsigned)__builtin_clzll(v);
+        return (size_t)(e - 3) * 16 + ((v >> (e - 4)) & 15);
+    }
+
+    // Meio da faixa do balde
+    static double valor(size_t b) {
+        if (b < 16)
+            return (double)b;
+        unsigned e = (unsigned)(b / 16) + 3;
+        double base = (double)((16 + b % 16) << (e - 4));
+        return base + (double)(1ull << (e - 4)) / 2;
+    }
+
+    static double percentil(const std::vector<uint64_t> &contagens, double p) {
+        uint64_t total = 0;
+        for (uint64_t c : contagens)
+            total += c;
+        if (total == 0)
+            return 0;
+        uint64_t alvo = (uint64_t)(p * (double)(total - 1));
+        uint64_t acumulado = 0;
+        for (size_t i = 0; i < contagens.size(); i++) {
+            acumulado += contagens[i];
+            if (acumulado > alvo)
+                return valor(i);
+        }
+        return valor(contagens.size() - 1);
+    }
+
+private:
+    std::array<std::atomic<uint64_t>, BALDES> baldes_{};
+};
+
+struct alignas(64) ContadoresTrabalhador {
+    std::atomic<uint64_t> quadros{0};
+    std::atomic<uint64_t> bytes{0};
+    std::atomic<uint64_t> invalidos{0};
+    std::atomic<uint64_t> perdidos{0};
+    std::atomic<uint64_t> lotes{0};
+    std::atomic<uint64_t> roubados{0}; // lotes de outro fragmento
+    std::atomic<uint64_t> arquivadas{0};
+    std::atomic<uint64_t> nao_arquivadas{0};
+    Histograma latencia;
+};
+
+struct alignas(64) ContadoresEs {
+    std::atomic<uint64_t> conexoes{0};
+    std::atomic<uint64_t> abertas{0};
+    std::atomic<uint64_t> datagramas{0};
+    std::atomic<uint64_t> rejeitados{0}; // envelope sem id ou quadro longo demais
+};
+
+template <typename T>
+void somar(std::atomic<T> &a, T v) {
+    a.store(a.load(std::memory_order_relaxed) + v, std::memory_order_relaxed);
+}
+
+std::vector<std::unique_ptr<Fragmento>> fragmentos;
+std::atomic<bool> es_terminou{false};
+const char *raiz_arquivo = nullptr;
+
+size_t fragmento_de(uint32_t estacao) {
+    return (size_t)((estacao * 0x85EBCA6Bu) >> 8) % fragmentos.size();
+}
+
+// -------------------- Trabalhadores --------------------
+void arquivar(Fragmento &f, uint32_t estacao, uint64_t unix_ms, const telemetria_amostra_t &a, bool lacuna,
+              ContadoresTrabalhador &c) {
+    std::unique_ptr<EscritorColunas> &escritor = f.arquivo[estacao];
+    if (!escritor)
+        escritor = std::make_unique<EscritorColunas>(raiz_arquivo, estacao);
+    uint8_t bits = (uint8_t)((a.alerta ? COLUNAS_BIT_ALERTA : 0) | (lacuna ? COLUNAS_BIT_LACUNA : 0));
+    if (escritor->anexar(unix_ms, a.nivel_agua, a.volume_chuva, bits))
+        somar(c.arquivadas, (uint64_t)1);
+    else
+        somar(c.nao_arquivadas, (uint64_t)1);
+}
+
+void aplicar(const Quadro &q, uint64_t recebido_unix_ms, Fragmento &f, ContadoresTrabalhador &c) {
+    EstadoEstacao &e = f.tabela.obter(q.estacao);
+    uint8_t quadro[QUADRO_MAX];
+    size_t n = cobs_decodificar(q.bytes, q.tamanho, quadro);
+    if (n < sizeof(telemetria_cabecalho_t) + 2 ||
+        crc16(quadro, n - 2) != (uint16_t)(quadro[n - 2] | quadro[n - 1] << 8)) {
+        e.invalidos++;
+        somar(c.invalidos, (uint64_t)1);
+        return;
+    }
+    telemetria_cabecalho_t cab;
+    std::memcpy(&cab, quadro, sizeof(cab));
+    int lacuna = (e.bits & ESTACAO_INICIADA) ? telemetria_lacuna(e.esperada, cab.sequencia) : 0;
+    if (lacuna > 0) {
+        e.perdidos += (uint32_t)lacuna;
+        somar(c.perdidos, (uint64_t)lacuna);
+    }
+    if (lacuna >= 0)
+        e.esperada = (uint8_t)(cab.sequencia + 1);
+    e.bits |= ESTACAO_INICIADA;
+    e.quadros++;
+
+    telemetria_amostra_t a;
+    if ((cab.tipo == TELEMETRIA_AMOSTRA || cab.tipo == TELEMETRIA_ALERTA) &&
+        n - sizeof(cab) - 2 == sizeof(a)) {
+        std::memcpy(&a, quadro + sizeof(cab), sizeof(a));
+        if (lacuna < 0) {
+            // Atrasado: vai para o arquivo, mas nao volta a ultima leitura
+            if (raiz_arquivo != nullptr)
+                arquivar(f, q.estacao, recebido_unix_ms, a, false, c);
+            return;
+        }
+        e.tempo_ms = a.tempo_ms;
+        e.nivel = a.nivel_agua;
+        e.chuva = a.volume_chuva;
+        e.nivel_max = std::max(e.nivel_max, a.nivel_agua);
+        if (a.alerta && !(e.bits & ESTACAO_ALERTA))
+            e.alertas++;
+        e.bits = (uint8_t)(a.alerta ? e.bits | ESTACAO_ALERTA : e.bits & ~ESTACAO_ALERTA);
+        if (raiz_arquivo != nullptr)
+            arquivar(f, q.estacao, recebido_unix_ms, a, lacuna > 0, c);
+    }
+}
+
+unsigned drenar(Fragmento &f, ContadoresTrabalhador &c) {
+    unsigned lotes = 0;
+    while (lotes < LOTES_POR_VEZ) {
+        Lote *lote = static_cast<Lote *>(f.fila.retirar());
+        if (lote == nullptr)
+            break;
+        uint64_t bytes = 0;
+        for (uint32_t i = 0; i < lote->n; i++) {
+            const Quadro &q = lote->quadros[i];
+            aplicar(q, lote->recebido_unix_ms, f, c);
+            bytes += q.tamanho + 1u;
+        }
+        c.latencia.registrar(agora_ns() - lote->recebido_ns, lote->n);
+        somar(c.quadros, (uint64_t)lote->n);
+        somar(c.bytes, bytes);
+        delete lote;
+        lotes++;
+    }
+    return lotes;
+}
+
+void trabalhar(size_t eu, ContadoresTrabalhador &c) {
+    size_t total = fragmentos.size();
+    unsigned ocioso = 0;
+    while (true) {
+        unsigned lotes = 0;
+        for (size_t k = 0; k < total && lotes == 0; k++) {
+            Fragmento &f = *fragmentos[(eu + k) % total];
+            uint32_t pendentes = f.fila.pendentes();
+            if (pendentes == 0 || (k > 0 && pendentes < ATRASO_ROUBO) || !f.fila.tentar_assumir())
+                continue;
+            lotes = drenar(f, c);
+            f.fila.liberar();
+            if (k > 0)
+                somar(c.roubados, (uint64_t)lotes);
+        }
+        somar(c.lotes, (uint64_t)lotes);
+        if (lotes > 0) {
+            ocioso = 0;
+            continue;
+        }
+        if (es_terminou.load(std::memory_order_acquire) &&
+            std::all_of(fragmentos.begin(), fragmentos.end(),
+                        [](const std::unique_ptr<Fragmento> &f) { return f->fila.pendentes() == 0; }))
+            return;
+        if (++ocioso < 64)
+            std::this_thread::yield();
+        else
+            std::this_thread::sleep_for(std::chrono::microseconds(50));
+    }
+}
+
+// -------------------- E/S --------------------
+struct Conexao {
+    int fd;
+    uint32_t estacao = 0;
+    uint8_t id_lido = 0; // bytes do id ja recebidos
+    bool descartando = false;
+    uint8_t n = 0;
+    uint8_t parcial[QUADRO_MAX];
+};
+
+class ThreadEs {
+public:
+    ThreadEs(uint16_t porta, ContadoresEs &c) : contadores_(c), abertos_(fragmentos.size(), nullptr) {
+        epoll_ = epoll_create1(0);
+        tcp_ = abrir_socket(SOCK_STREAM, porta);
+        udp_ = abrir_socket(SOCK_DGRAM, porta);
+        if (epoll_ < 0 || tcp_ < 0 || udp_ < 0 || listen(tcp_, 1024) < 0) {
+            std::perror("estacao_ingest");
+            std::exit(1);
+        }
+        int buffer = 4 << 20;
+        setsockopt(udp_, SOL_SOCKET, SO_RCVBUF, &buffer, sizeof(buffer));
+        observar(tcp_, &tcp_);
+        observar(udp_, &udp_);
+    }
+
+    ~ThreadEs() {
+        close(tcp_);
+        close(udp_);
+        close(epoll_);
+    }
+
+    void executar() {
+        epoll_event eventos[64];
+        while (!parar.load(std::memory_order_relaxed)) {
+            int n = epoll_wait(epoll_, eventos, 64, 100);
+            for (int i = 0; i < n; i++) {
+                void *p = eventos[i].data.ptr;
+                if (p == &tcp_)
+                    aceitar();
+                else if (p == &udp_)
+                    ler_udp();
+                else
+                    ler_tcp(static_cast<Conexao *>(p));
+            }
+            publicar();
+        }
+        for (auto &c : conexoes_) {
+            if (c)
+                close(c->fd);
+        }
+    }
+
+private:
+    static int abrir_socket(int tipo, uint16_t porta) {
+        int fd = socket(AF_INET, tipo | SOCK_NONBLOCK, 0);
+        int um = 1;
+        setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &um, sizeof(um));
+        setsockopt(fd, SOL_SOCKET, SO_REUSEPORT, &um, sizeof(um));
+        sockaddr_in endereco{};
+        endereco.sin_family = AF_INET;
+        endereco.sin_port = htons(porta);
+        endereco.sin_addr.s_addr = htonl(INADDR_ANY);
+        if (fd >= 0 && bind(fd, (const sockaddr *)&endereco, sizeof(endereco)) < 0) {
+            close(fd);
+            return -1;
+        }
+        return fd;
+    }
+
+    void observar(int fd, void *p) {
+        epoll_event e{};
+        e.events = EPOLLIN;
+        e.data.ptr = p;
+        epoll_ctl(epoll_, EPOLL_CTL_ADD, fd, &e);
+    }
+
+    void aceitar() {
+        int fd;
+        while ((fd = accept4(tcp_, nullptr, nullptr, SOCK_NONBLOCK)) >= 0) {
+            if ((size_t)fd >= conexoes_.size())
+                conexoes_.resize((size_t)fd + 1);
+            conexoes_[fd] = std::make_unique<Conexao>();
+            conexoes_[fd]->fd = fd;
+            observar(fd, conexoes_[fd].get());
+            somar(contadores_.conexoes, (uint64_t)1);
+            somar(contadores_.abertas, (uint64_t)1);
+        }
+    }
+
+    void fechar(Conexao *c) {
+        int fd = c->fd;
+        epoll_ctl(epoll_, EPOLL_CTL_DEL, fd, nullptr);
+        close(fd);
+        conexoes_[fd].reset();
+        somar(contadores_.abertas, (uint64_t)-1);
+    }
+
+    // Junta o quadro ao lote aberto do fragmento da estacao
+    void entregar(uint32_t estacao, const uint8_t *bytes, size_t tamanho, uint64_t recebido_ns) {
+        Lote *&lote = abertos_[fragmento_de(estacao)];
+        if (lote == nullptr) {
+            lote = new Lote;
+            lote->recebido_ns = recebido_ns;
+            lote->recebido_unix_ms = agora_unix_ms();
+        }
+        Quadro &q = lote->quadros[lote->n++];
+        q.estacao = estacao;
+        q.tamanho = (uint8_t)tamanho;
+        std::memcpy(q.bytes, bytes, tamanho);
+        if (lote->n == LOTE_QUADROS) {
+            fragmentos[fragmento_de(estacao)]->fila.empurrar(lote);
+            lote = nullptr;
+        }
+    }
+
+    void publicar() {
+        for (size_t f = 0; f < abertos_.size(); f++) {
+            if (abertos_[f] != nullptr) {
+                fragmentos[f]->fila.empurrar(abertos_[f]);
+                abertos_[f] = nullptr;
+            }
+        }
+    }
+
+    // Separa os quadros nos zeros; o que sobra fica para o proximo recv
+    void separar(Conexao &c, const uint8_t *dados, size_t n, uint64_t recebido_ns) {
+        for (size_t i = 0; i < n; i++) {
+            if (dados[i] == 0) {
+                if (c.n > 0 && !c.descartando)
+                    entregar(c.estacao, c.parcial, c.n, recebido_ns);
+                c.n = 0;
+                c.descartando = false;
+            } else if (c.n == QUADRO_MAX) {
+                if (!c.descartando)
+                    somar(contadores_.rejeitados, (uint64_t)1);
+                c.descartando = true;
+            } else {
+                c.parcial[c.n++] = dados[i];
+            }
+        }
+    }
+
+    void ler_tcp(Conexao *c) {
+        uint8_t buffer[65536];
+        while (true) {
+            ssize_t lidos = recv(c->fd, buffer, sizeof(buffer), 0);
+            if (lidos == 0 || (lidos < 0 && errno != EAGAIN && errno != EINTR)) {
+                fechar(c);
+                return;
+            }
+            if (lidos < 0)
+                return;
+            uint64_t recebido_ns = agora_ns();
+            const uint8_t *p = buffer;
+            size_t n = (size_t)lidos;
+            while (c->id_lido < 4 && n > 0) {
+                c->estacao |= (uint32_t)*p++ << (8 * c->id_lido++);
+                n--;
+            }
+            if (c->id_lido == 4 && c->estacao == ESTACAO_INVALIDA) {
+                somar(contadores_.rejeitados, (uint64_t)1);
+                fechar(c);
+                return;
+            }
+            separar(*c, p, n, recebido_ns);
+            if ((size_t)lidos < sizeof(buffer))
+                return;
+        }
+    }
+
+    void ler_udp() {
+        static thread_local std::vector<uint8_t> buffers(MENSAGENS_UDP * DATAGRAMA_MAX);
+        iovec iov[MENSAGENS_UDP];
+        mmsghdr mensagens[MENSAGENS_UDP];
+        for (unsigned i = 0; i < MENSAGENS_UDP; i++) {
+            iov[i] = {&buffers[i * DATAGRAMA_MAX], DATAGRAMA_MAX};
+            mensagens[i] = {};
+            mensagens[i].msg_hdr.msg_iov = &iov[i];
+            mensagens[i].msg_hdr.msg_iovlen = 1;
+        }
+        int n;
+        while ((n = recvmmsg(udp_, mensagens, MENSAGENS_UDP, MSG_DONTWAIT, nullptr)) > 0) {
+            uint64_t recebido_ns = agora_ns();
+            somar(contadores_.datagramas, (uint64_t)n);
+            for (int i = 0; i < n; i++) {
+                const uint8_t *d = &buffers[(size_t)i * DATAGRAMA_MAX];
+                size_t tamanho = mensagens[i].msg_len;
+                uint32_t estacao = tamanho >= 4 ? (uint32_t)(d[0] | d[1] << 8 | d[2] << 16 | (uint32_t)d[3] << 24)
+                                                : ESTACAO_INVALIDA;
+                if (tamanho < 5 || estacao == ESTACAO_INVALIDA) {
+                    somar(contadores_.rejeitados, (uint64_t)1);
+                    continue;
+                }
+                // O fim do datagrama tambem fecha o quadro
+                Conexao c{};
+                c.estacao = estacao;
+                separar(c, d + 4, tamanho - 4, recebido_ns);
+                if (c.n > 0 && !c.descartando)
+                    entregar(estacao, c.parcial, c.n, recebido_ns);
+            }
+            if ((unsigned)n < MENSAGENS_UDP)
+                break;
+        }
+    }
+
+    ContadoresEs &contadores_;
+    int epoll_ = -1;
+    int tcp_ = -1;
+    int udp_ = -1;
+    std::vector<std::unique_ptr<Conexao>> conexoes_; // pelo fd
+    std::vector<Lote *> abertos_;                   // por fragmento
+};
+
+// -------------------- Relatorio --------------------
+struct Totais {
+    uint64_t quadros = 0, bytes = 0, invalidos = 0, perdidos = 0, lotes = 0, roubados = 0;
+    uint64_t arquivadas = 0, nao_arquivadas = 0;
+    std::vector<uint64_t> latencia = std::vector<uint64_t>(Histograma::BALDES);
+};
+
+Totais somar_trabalhadores(const std::vector<std::unique_ptr<ContadoresTrabalhador>> &ts) {
+    Totais t;
+    for (const auto &c : ts) {
+        t.quadros += c->quadros.load(std::memory_order_relaxed);
+        t.bytes += c->bytes.load(std::memory_order_relaxed);
+        t.invalidos += c->invalidos.load(std::memory_order_relaxed);
+        t.perdidos += c->perdidos.load(std::memory_order_relaxed);
+        t.lotes += c->lotes.load(std::memory_order_relaxed);
+        t.roubados += c->roubados.load(std::memory_order_relaxed);
+        t.arquivadas += c->arquivadas.load(std::memory_order_relaxed);
+        t.nao_arquivadas += c->nao_arquivadas.load(std::memory_order_relaxed);
+        c->latencia.somar_em(t.latencia);
+    }
+    return t;
+}
+
+void gravar_estado(const char *arquivo) {
+    FILE *f = std::fopen(arquivo, "w");
+    if (f == nullptr) {
+        std::perror(arquivo);
+        return;
+    }
+    std::fprintf(f, "estacao,quadros,perdidos,invalidos,alertas,tempo_ms,nivel,chuva,nivel_max,alerta\n");
+    for (const auto &fr : fragmentos) {
+        fr->tabela.para_cada([f](const EstadoEstacao &e) {
+            std::fprintf(f, "%u,%u,%u,%u,%u,%u,%.2f,%.2f,%.2f,%u\n", e.id, e.quadros, e.perdidos, e.invalidos,
+                         e.alertas, e.tempo_ms, e.nivel / 100.0, e.chuva / 100.0, e.nivel_max / 100.0,
+                         e.bits & ESTACAO_ALERTA);
+        });
+    }
+    std::fclose(f);
+}
+
+void aumentar_limite_arquivos() {
+    rlimit r;
+    if (getrlimit(RLIMIT_NOFILE, &r) == 0 && r.rlim_cur < r.rlim_max) {
+        r.rlim_cur = r.rlim_max;
+        setrlimit(RLIMIT_NOFILE, &r);
+    }
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+    uint16_t porta = PORTA_PADRAO;
+    unsigned n_es = 1;
+    unsigned n_trabalhadores = std::max(1u, std::thread::hardware_concurrency() - 1);
+    double segundos = 0;
+    const char *estado = nullptr;
+    for (int i = 1; i < argc; i++) {
+        if (std::strcmp(argv[i], "--io") == 0 && i + 1 < argc)
+            n_es = (unsigned)std::max(1, std::atoi(argv[++i]));
+        else if (std::strcmp(argv[i], "--trabalhadores") == 0 && i + 1 < argc)
+            n_trabalhadores = (unsigned)std::max(1, std::atoi(argv[++i]));
+        else if (std::strcmp(argv[i], "--segundos") == 0 && i + 1 < argc)
+            segundos = std::atof(argv[++i]);
+        else if (std::strcmp(argv[i], "--estado") == 0 && i + 1 < argc)
+            estado = argv[++i];
+        else if (std::strcmp(argv[i], "--arquivo") == 0 && i + 1 < argc)
+            raiz_arquivo = argv[++i];
+        else if (argv[i][0] != '-')
+            porta = (uint16_t)std::atoi(argv[i]);
+        else {
+            std::fprintf(stderr,
+                         "uso: %s [porta] [--io N] [--trabalhadores N] [--segundos S] [--estado arquivo.csv] "
+                         "[--arquivo DIR]\n",
+                         argv[0]);
+            return 2;
+        }
+    }
+    std::signal(SIGINT, ao_sinal);
+    std::signal(SIGTERM, ao_sinal);
+    aumentar_limite_arquivos();
+
+    for (unsigned i = 0; i < n_trabalhadores; i++)
+        fragmentos.push_back(std::make_unique<Fragmento>());
+    std::vector<std::unique_ptr<ContadoresTrabalhador>> contadores;
+    std::vector<std::thread> trabalhadores;
+    for (unsigned i = 0; i < n_trabalhadores; i++)
+        contadores.push_back(std::make_unique<ContadoresTrabalhador>());
+    for (unsigned i = 0; i < n_trabalhadores; i++)
+        trabalhadores.emplace_back(trabalhar, i, std::ref(*contadores[i]));
+
+    std::vector<std::unique_ptr<ContadoresEs>> contadores_es;
+    std::vector<std::unique_ptr<ThreadEs>> es;
+    std::vector<std::thread> threads_es;
+    for (unsigned i = 0; i < n_es; i++) {
+        contadores_es.push_back(std::make_unique<ContadoresEs>());
+        es.push_back(std::make_unique<ThreadEs>(porta, *contadores_es[i]));
+    }
+    for (auto &t : es)
+        threads_es.emplace_back(&ThreadEs::executar, t.get());
+    std::fprintf(stderr, "estacao_ingest: porta %u (TCP e UDP), %u de E/S, %u trabalhadores\n", porta, n_es,
+                 n_trabalhadores);
+
+    auto inicio = Relogio::now();
+    auto ultimo = inicio;
+    Totais anterior;
+    while (!parar.load(std::memory_order_relaxed)) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        auto agora = Relogio::now();
+        if (segundos > 0 && agora - inicio >= std::chrono::duration<double>(segundos))
+            break;
+        if (agora - ultimo < std::chrono::seconds(1))
+            continue;
+
+        double dt = std::chrono::duration<double>(agora - ultimo).count();
+        Totais t = somar_trabalhadores(contadores);
+        std::vector<uint64_t> intervalo(Histograma::BALDES);
+        for (size_t b = 0; b < Histograma::BALDES; b++)
+            intervalo[b] = t.latencia[b] - anterior.latencia[b];
+        uint64_t abertas = 0, pendentes = 0;
+        for (const auto &c : contadores_es)
+            abertas += c->abertas.load(std::memory_order_relaxed);
+        for (const auto &f : fragmentos)
+            pendentes += f->fila.pendentes();
+        std::printf("%6.1f s: %9.0f quadros/s %7.2f MB/s  p50 %8.1f us  p99 %8.1f us  conexoes %llu  "
+                    "roubados %llu  na fila %llu\n",
+                    std::chrono::duration<double>(agora - inicio).count(), (double)(t.quadros - anterior.quadros) / dt,
+                    (double)(t.bytes - anterior.bytes) / dt / 1e6, Histograma::percentil(intervalo, 0.5) / 1e3,
+                    Histograma::percentil(intervalo, 0.99) / 1e3, (unsigned long long)abertas,
+                    (unsigned long long)(t.roubados - anterior.roubados), (unsigned long long)pendentes);
+        std::fflush(stdout);
+        anterior = std::move(t);
+        ultimo = agora;
+    }
+
+    parar.store(true, std::memory_order_relaxed);
+    for (auto &t : threads_es)
+        t.join();
+    es_terminou.store(true, std::memory_order_release);
+    for (auto &t : trabalhadores)
+        t.join();
+    double total_s = std::chrono::duration<double>(Relogio::now() - inicio).count();
+
+    Totais t = somar_trabalhadores(contadores);
+    uint64_t conexoes = 0, datagramas = 0, rejeitados = 0;
+    for (const auto &c : contadores_es) {
+        conexoes += c->conexoes.load();
+        datagramas += c->datagramas.load();
+        rejeitados += c->rejeitados.load();
+    }
+    size_t estacoes = 0;
+    uint64_t alertas = 0;
+    for (const auto &f : fragmentos) {
+        estacoes += f->tabela.tamanho();
+        f->tabela.para_cada([&](const EstadoEstacao &e) { alertas += e.alertas; });
+    }
+    std::printf("total: %llu quadros em %.1f s (%.0f/s, %.2f MB/s) de %zu estacoes; %llu conexoes TCP, "
+                "%llu datagramas\n",
+                (unsigned long long)t.quadros, total_s, (double)t.quadros / total_s, (double)t.bytes / total_s / 1e6,
+                estacoes, (unsigned long long)conexoes, (unsigned long long)datagramas);
+    std::printf("latencia (us): p50 %.1f, p99 %.1f, p99.9 %.1f, max %.1f\n",
+                Histograma::percentil(t.latencia, 0.5) / 1e3, Histograma::percentil(t.latencia, 0.99) / 1e3,
+                Histograma::percentil(t.latencia, 0.999) / 1e3, Histograma::percentil(t.latencia, 1.0) / 1e3);
+    std::printf("invalidos: %llu, perdidos: %llu, rejeitados: %llu, alertas: %llu, lotes: %llu (%llu roubados)\n",
+                (unsigned long long)t.invalidos, (unsigned long long)t.perdidos, (unsigned long long)rejeitados,
+                (unsigned long long)alertas, (unsigned long long)t.lotes, (unsigned long long)t.roubados);
+    if (raiz_arquivo != nullptr)
+        std::printf("arquivo %s: %llu amostras gravadas, %llu nao gravadas\n", raiz_arquivo,
+                    (unsigned long long)t.arquivadas, (unsigned long long)t.nao_arquivadas);
+    if (estado != nullptr)
+        gravar_estado(estado);
+    return 0;
+}
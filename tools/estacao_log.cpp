@@ -0,0 +1,215 @@
+// -----------------------------------------------------------------------------
+// estacao_log: decodifica uma copia da regiao de log da flash e avalia a
+// compressao da serie de amostras.
+//
+//   estacao_log despejar log.bin   -> CSV com eventos e amostras, em ordem
+//   estacao_log taxa [horas] [descarga_s]
+//                                  -> taxa de compressao em dados sinteticos,
+//                                     fechando blocos como o firmware (60 s)
+//
+// A copia pode ser obtida com:
+//   picotool save -r 0x10100000 0x10200000 log.bin
+// -----------------------------------------------------------------------------
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <random>
+#include <string>
+#include <vector>
+
+extern "C" {
+#include "crc16.h"
+#include "registro_log.h"
+#include "serie_comp.h"
+}
+
+namespace {
+
+// FLASH_LOG_DESCARGA_MS (lib/flash_log.h): a vJoystickTask fecha o bloco da
+// serie quando ele enche ou quando a primeira amostra fica mais velha que isso.
+constexpr double DESCARGA_PADRAO_S = 60.0;
+
+struct Pagina {
+    cabecalho_pagina_t cabecalho;
+    const uint8_t *dados;
+};
+
+int despejar(const char *caminho) {
+    std::ifstream arquivo(caminho, std::ios::binary);
+    if (!arquivo) {
+        std::fprintf(stderr, "nao foi possivel abrir %s\n", caminho);
+        return 1;
+    }
+    std::vector<uint8_t> imagem((std::istreambuf_iterator<char>(arquivo)), std::istreambuf_iterator<char>());
+
+    // A ordem fisica e circular; a sequencia das paginas da a ordem real.
+    std::vector<Pagina> paginas;
+    size_t corrompidas = 0;
+    for (size_t off = 0; off + REGISTRO_LOG_TAMANHO_PAGINA <= imagem.size(); off += REGISTRO_LOG_TAMANHO_PAGINA) {
+        Pagina p;
+        std::memcpy(&p.cabecalho, &imagem[off], sizeof(p.cabecalho));
+        p.dados = &imagem[off + sizeof(cabecalho_pagina_t)];
+        if (p.cabecalho.magia != REGISTRO_LOG_MAGIA && p.cabecalho.magia != REGISTRO_LOG_MAGIA_SERIE &&
+            p.cabecalho.magia != REGISTRO_LOG_MAGIA_CAPTURA)
+            continue;
+        if (crc16(p.dados, REGISTRO_LOG_TAMANHO_DADOS) != p.cabecalho.crc) {
+            corrompidas++;
+            continue;
+        }
+        paginas.push_back(p);
+    }
+    std::sort(paginas.begin(), paginas.end(),
+              [](const Pagina &a, const Pagina &b) { return a.cabecalho.sequencia < b.cabecalho.sequencia; });
+
+    std::printf("sequencia,tipo,tempo_ms,nivel_agua,volume_chuva,alerta\n");
+    for (const Pagina &p : paginas) {
+        if (p.cabecalho.magia == REGISTRO_LOG_MAGIA) {
+            uint16_t n = std::min<uint16_t>(p.cabecalho.quantidade, REGISTRO_LOG_POR_PAGINA);
+            for (uint16_t i = 0; i < n; i++) {
+                registro_log_t r;
+                std::memcpy(&r, p.dados + i * sizeof(r), sizeof(r));
+                std::printf("%u,%s,%u,%.2f,%.2f,%u\n", p.cabecalho.sequencia,
+                            r.tipo == REGISTRO_ALERTA ? "alerta" : "amostra", r.tempo_ms,
+                            r.nivel_agua / 100.0, r.volume_chuva / 100.0, r.alerta);
+            }
+        } else if (p.cabecalho.magia == REGISTRO_LOG_MAGIA_CAPTURA) {
+            // Pares (nivel, chuva) em contagens cruas; o tempo e relativo ao disparo
+            cabecalho_captura_t cap;
+            std::memcpy(&cap, p.dados, sizeof(cap));
+            const uint8_t *amostras = p.dados + sizeof(cap);
+            uint16_t n = std::min<uint16_t>(p.cabecalho.quantidade, REGISTRO_LOG_CAPTURA_POR_PAGINA);
+            double periodo_par_ms = 2000.0 / cap.taxa_hz;
+            for (uint16_t i = 0; i + 1 < n; i += 2) {
+                uint16_t nivel, chuva;
+                std::memcpy(&nivel, amostras + i * 2, 2);
+                std::memcpy(&chuva, amostras + (i + 1) * 2, 2);
+                int indice = cap.inicio + i - cap.pre_disparo;
+                std::printf("%u,captura,%.3f,%.2f,%.2f,\n", p.cabecalho.sequencia,
+                            cap.tempo_disparo_ms + (indice / 2) * periodo_par_ms,
+                            nivel * 100.0 / 4095.0, chuva * 100.0 / 4095.0);
+            }
+        } else {
+            serie_decomp_t d;
+            amostra_comp_t a;
+            serie_decomp_iniciar(&d, p.dados, REGISTRO_LOG_TAMANHO_DADOS, p.cabecalho.quantidade);
+            while (serie_decomp_proxima(&d, &a)) {
+                std::printf("%u,amostra,%u,%.2f,%.2f,\n", p.cabecalho.sequencia, a.tempo_ms,
+                            a.nivel_agua / 100.0, a.volume_chuva / 100.0);
+            }
+        }
+    }
+    std::fprintf(stderr, "%zu paginas validas, %zu corrompidas\n", paginas.size(), corrompidas);
+    return 0;
+}
+
+// Converte uma leitura de 12 bits exatamente como o firmware faz.
+uint16_t centesimos(int bruto) {
+    bruto = std::clamp(bruto, 0, 4095);
+    float percentual = (bruto / 4095.0f) * 100.0f;
+    return (uint16_t)(percentual * 100.0f);
+}
+
+// Serie sintetica de rio: nivel base com ciclo diario, uma cheia lenta por
+// semana, chuva em pancadas esparsas e ruido de +-2 contagens no ADC.
+std::vector<amostra_comp_t> serie_sintetica(double horas) {
+    std::mt19937 rng(2024);
+    std::uniform_int_distribution<int> ruido(-2, 2);
+    std::uniform_int_distribution<int> jitter(0, 2);
+    std::uniform_real_distribution<double> chance(0.0, 1.0);
+
+    std::vector<amostra_comp_t> serie;
+    uint32_t tempo = 0;
+    double chuva = 0.0;
+    for (size_t i = 0; i < (size_t)(horas * 3600.0); i++) {
+        double t = i / 3600.0;
+        double cheia = 25.0 * std::exp(-std::pow(std::fmod(t, 168.0) - 84.0, 2) / 200.0);
+        double nivel = 35.0 + 3.0 * std::sin(2 * M_PI * t / 24.0) + cheia;
+        if (chance(rng) < 1.0 / 7200.0)
+            chuva = 60.0 + 30.0 * chance(rng);
+        chuva *= 0.999;
+
+        amostra_comp_t a;
+        a.tempo_ms = tempo;
+        a.nivel_agua = centesimos((int)std::lround(nivel / 100.0 * 4095.0) + ruido(rng));
+        a.volume_chuva = centesimos(chuva < 1.0 ? 0 : (int)std::lround(chuva / 100.0 * 4095.0) + ruido(rng));
+        serie.push_back(a);
+        tempo += 1000 + jitter(rng);
+    }
+    return serie;
+}
+
+int taxa(double horas, double descarga_s) {
+    const uint32_t descarga_ms = (uint32_t)(descarga_s * 1000.0);
+    std::vector<amostra_comp_t> original = serie_sintetica(horas);
+    std::vector<amostra_comp_t> reconstruida;
+    size_t paginas = 0;
+
+    uint8_t bloco[REGISTRO_LOG_TAMANHO_DADOS];
+    serie_comp_t c;
+    serie_comp_iniciar(&c, bloco, sizeof(bloco));
+
+    auto fechar_bloco = [&]() {
+        serie_decomp_t d;
+        amostra_comp_t a;
+        serie_decomp_iniciar(&d, bloco, sizeof(bloco), c.amostras);
+        while (serie_decomp_proxima(&d, &a))
+            reconstruida.push_back(a);
+        paginas++;
+        serie_comp_iniciar(&c, bloco, sizeof(bloco));
+    };
+
+    uint32_t inicio_bloco_ms = 0;
+    for (const amostra_comp_t &a : original) {
+        if (descarga_ms > 0 && c.amostras > 0 && a.tempo_ms - inicio_bloco_ms >= descarga_ms)
+            fechar_bloco();
+        if (!serie_comp_adicionar(&c, &a)) {
+            fechar_bloco();
+            serie_comp_adicionar(&c, &a);
+        }
+        if (c.amostras == 1)
+            inicio_bloco_ms = a.tempo_ms;
+    }
+    if (c.amostras > 0)
+        fechar_bloco();
+
+    bool exato = reconstruida.size() == original.size() &&
+                 std::equal(original.begin(), original.end(), reconstruida.begin(),
+                            [](const amostra_comp_t &a, const amostra_comp_t &b) {
+                                return a.tempo_ms == b.tempo_ms && a.nivel_agua == b.nivel_agua &&
+                                       a.volume_chuva == b.volume_chuva;
+                            });
+
+    double bytes_crus = (double)original.size() * sizeof(registro_log_t);
+    double bytes_comp = (double)paginas * REGISTRO_LOG_TAMANHO_PAGINA;
+    std::printf("amostras:            %zu (%.1f h a 1 Hz)\n", original.size(), horas);
+    if (descarga_ms > 0)
+        std::printf("descarga:            bloco fechado a cada %.0f s\n", descarga_s);
+    else
+        std::printf("descarga:            desligada (blocos so fecham cheios)\n");
+    std::printf("paginas de 256 B:    %zu (%.1f amostras/pagina)\n", paginas, original.size() / (double)paginas);
+    std::printf("registros crus:      %.0f bytes\n", bytes_crus);
+    std::printf("comprimido:          %.0f bytes (com cabecalhos)\n", bytes_comp);
+    std::printf("taxa de compressao:  %.2fx\n", bytes_crus / bytes_comp);
+    std::printf("autonomia do log:    %.1f dias em 1 MB\n",
+                (1024.0 * 1024.0 / bytes_comp) * horas / 24.0);
+    std::printf("reconstrucao exata:  %s\n", exato ? "sim" : "NAO");
+    return exato ? 0 : 1;
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+    if (argc >= 3 && std::strcmp(argv[1], "despejar") == 0)
+        return despejar(argv[2]);
+    if (argc >= 2 && std::strcmp(argv[1], "taxa") == 0)
+        return taxa(argc >= 3 ? std::atof(argv[2]) : 24.0 * 14,
+                    argc >= 4 ? std::atof(argv[3]) : DESCARGA_PADRAO_S);
+
+    std::fprintf(stderr, "uso: %s despejar <log.bin> | taxa [horas] [descarga_s]\n", argv[0]);
+    return 2;
+}
@@ -0,0 +1,267 @@
+// -----------------------------------------------------------------------------
+// http_carga: mede latencia e vazao do servidor de estado da estacao
+// (lib/http.h), na placa ou no simulador.
+//
+//   http_carga [ip[:porta]] [--conexoes N] [--sse N] [--segundos S]
+//
+// Cada uma das N conexoes (padrao 1) mantem um GET / em voo por vez, com
+// keep-alive, e mede o tempo ate o fim do corpo. As N conexoes --sse (padrao
+// 0) assinam /eventos e contam eventos e o intervalo entre eles. Todo corpo e
+// conferido: JSON inteiro, do tamanho anunciado e com "t" que nunca volta. Um
+// retrato reescrito no meio do envio aparece em invalidas.
+//
+// Padrao 127.0.0.1:8080, a porta do estacao_virtual (ESTACAO_SIM_PORTAS).
+// -----------------------------------------------------------------------------
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+namespace {
+
+using Relogio = std::chrono::steady_clock;
+
+struct Conexao {
+    int fd = -1;
+    bool sse = false;
+    std::string entrada;
+    Relogio::time_point enviado;
+    Relogio::time_point ultimo_evento;
+    bool tem_evento = false;
+    long ultimo_t = -1;
+};
+
+struct Resultado {
+    std::vector<double> latencias_ms;
+    std::vector<double> intervalos_ms;
+    unsigned long eventos = 0;
+    unsigned long pings = 0;
+    unsigned long invalidas = 0;
+    unsigned long reconexoes = 0;
+    unsigned long long bytes = 0;
+};
+
+double ms(Relogio::duration d) {
+    return std::chrono::duration<double, std::milli>(d).count();
+}
+
+int conectar(const sockaddr_in &endereco) {
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (fd < 0)
+        return -1;
+    if (connect(fd, (const sockaddr *)&endereco, sizeof(endereco)) < 0) {
+        close(fd);
+        return -1;
+    }
+    int um = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &um, sizeof(um));
+    return fd;
+}
+
+bool enviar(int fd, const char *caminho) {
+    std::string pedido = std::string("GET ") + caminho + " HTTP/1.1\r\nHost: estacao\r\n\r\n";
+    return send(fd, pedido.data(), pedido.size(), MSG_NOSIGNAL) == (ssize_t)pedido.size();
+}
+
+// JSON do retrato: chaves balanceadas, sem lixo, e "t" que nao volta
+bool conferir(Conexao &c, const std::string &json) {
+    if (json.size() < 2 || json.front() != '{' || json.back() != '}')
+        return false;
+    int nivel = 0;
+    for (char ch : json) {
+        nivel += ch == '{';
+        nivel -= ch == '}';
+        if (nivel < 0 || ch == '\0')
+            return false;
+    }
+    size_t p = json.find("\"t\":");
+    if (nivel != 0 || p == std::string::npos)
+        return false;
+    long t = std::strtol(json.c_str() + p + 4, nullptr, 10);
+    bool ok = t >= c.ultimo_t;
+    c.ultimo_t = t;
+    return ok;
+}
+
+// Respostas completas do GET; false se a conexao deve ser refeita
+bool ler_respostas(Conexao &c, Resultado &r) {
+    while (true) {
+        size_t fim = c.entrada.find("\r\n\r\n");
+        if (fim == std::string::npos)
+            return true;
+        size_t p = c.entrada.find("Content-Length: ");
+        if (c.entrada.compare(0, 12, "HTTP/1.1 200") != 0 || p == std::string::npos || p > fim) {
+            r.invalidas++;
+            return false;
+        }
+        size_t tamanho = std::strtoul(c.entrada.c_str() + p + 16, nullptr, 10);
+        if (c.entrada.size() < fim + 4 + tamanho)
+            return true;
+        r.latencias_ms.push_back(ms(Relogio::now() - c.enviado));
+        r.invalidas += !conferir(c, c.entrada.substr(fim + 4, tamanho));
+        c.entrada.erase(0, fim + 4 + tamanho);
+        c.enviado = Relogio::now();
+        if (!enviar(c.fd, "/"))
+            return false;
+    }
+}
+
+void ler_eventos(Conexao &c, Resultado &r) {
+    size_t cabecalho = c.entrada.find("\r\n\r\n");
+    if (!c.tem_evento && cabecalho != std::string::npos && c.entrada.compare(0, 4, "HTTP") == 0)
+        c.entrada.erase(0, cabecalho + 4);
+    while (true) {
+        size_t fim = c.entrada.find("\n\n");
+        if (fim == std::string::npos || c.entrada.compare(0, 4, "HTTP") == 0)
+            return;
+        std::string evento = c.entrada.substr(0, fim);
+        c.entrada.erase(0, fim + 2);
+        if (evento[0] == ':') {
+            r.pings++;
+            continue;
+        }
+        auto agora = Relogio::now();
+        if (c.tem_evento)
+            r.intervalos_ms.push_back(ms(agora - c.ultimo_evento));
+        c.ultimo_evento = agora;
+        c.tem_evento = true;
+        r.eventos++;
+        r.invalidas += evento.compare(0, 6, "data: ") != 0 || !conferir(c, evento.substr(6));
+    }
+}
+
+bool abrir(Conexao &c, const sockaddr_in &endereco) {
+    c.fd = conectar(endereco);
+    c.entrada.clear();
+    c.tem_evento = false;
+    c.ultimo_t = -1;
+    if (c.fd < 0)
+        return false;
+    c.enviado = Relogio::now();
+    return enviar(c.fd, c.sse ? "/eventos" : "/");
+}
+
+double percentil(std::vector<double> &v, double p) {
+    if (v.empty())
+        return 0;
+    size_t i = std::min(v.size() - 1, (size_t)(p * (double)v.size()));
+    std::nth_element(v.begin(), v.begin() + (long)i, v.end());
+    return v[i];
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+    std::string destino = "127.0.0.1:8080";
+    int n_get = 1;
+    int n_sse = 0;
+    double segundos = 10;
+    for (int i = 1; i < argc; i++) {
+        if (std::strcmp(argv[i], "--conexoes") == 0 && i + 1 < argc)
+            n_get = std::atoi(argv[++i]);
+        else if (std::strcmp(argv[i], "--sse") == 0 && i + 1 < argc)
+            n_sse = std::atoi(argv[++i]);
+        else if (std::strcmp(argv[i], "--segundos") == 0 && i + 1 < argc)
+            segundos = std::atof(argv[++i]);
+        else if (argv[i][0] != '-')
+            destino = argv[i];
+        else {
+            std::fprintf(stderr, "uso: %s [ip[:porta]] [--conexoes N] [--sse N] [--segundos S]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    sockaddr_in endereco{};
+    endereco.sin_family = AF_INET;
+    std::string host = destino.substr(0, destino.find(':'));
+    endereco.sin_port = htons(destino.find(':') == std::string::npos
+                                  ? 80
+                                  : (uint16_t)std::atoi(destino.c_str() + destino.find(':') + 1));
+    if (inet_pton(AF_INET, host.c_str(), &endereco.sin_addr) != 1) {
+        std::fprintf(stderr, "http_carga: endereco invalido: %s\n", destino.c_str());
+        return 2;
+    }
+
+    std::vector<Conexao> conexoes(n_get + n_sse);
+    for (int i = 0; i < n_get + n_sse; i++) {
+        conexoes[i].sse = i >= n_get;
+        if (!abrir(conexoes[i], endereco)) {
+            std::perror("http_carga: conexao");
+            return 1;
+        }
+    }
+
+    Resultado r;
+    auto inicio = Relogio::now();
+    auto fim = inicio + std::chrono::duration_cast<Relogio::duration>(std::chrono::duration<double>(segundos));
+    while (Relogio::now() < fim) {
+        std::vector<pollfd> fds;
+        for (const Conexao &c : conexoes)
+            fds.push_back({c.fd, POLLIN, 0});
+        if (poll(fds.data(), fds.size(), 100) <= 0)
+            continue;
+
+        for (size_t i = 0; i < conexoes.size(); i++) {
+            if (!(fds[i].revents & (POLLIN | POLLHUP | POLLERR)))
+                continue;
+            Conexao &c = conexoes[i];
+            char pedaco[4096];
+            ssize_t lidos = recv(c.fd, pedaco, sizeof(pedaco), 0);
+            bool manter = lidos > 0;
+            if (manter) {
+                r.bytes += (unsigned long long)lidos;
+                c.entrada.append(pedaco, (size_t)lidos);
+                if (c.sse)
+                    ler_eventos(c, r);
+                else
+                    manter = ler_respostas(c, r);
+            }
+            if (!manter) {
+                // Keep-alive fechado pelo servidor (ocioso ou sem vaga)
+                close(c.fd);
+                r.reconexoes++;
+                if (!abrir(c, endereco)) {
+                    std::perror("http_carga: reconexao");
+                    return 1;
+                }
+            }
+        }
+    }
+    double total_s = std::chrono::duration<double>(Relogio::now() - inicio).count();
+    for (Conexao &c : conexoes)
+        close(c.fd);
+
+    std::printf("respostas: %zu em %.1f s, %.1f req/s, %.1f kB/s\n", r.latencias_ms.size(), total_s,
+                (double)r.latencias_ms.size() / total_s, (double)r.bytes / total_s / 1000.0);
+    if (!r.latencias_ms.empty()) {
+        double media = 0;
+        for (double l : r.latencias_ms)
+            media += l;
+        media /= (double)r.latencias_ms.size();
+        std::printf("latencia (ms): media %.3f, p50 %.3f, p90 %.3f, p99 %.3f, max %.3f\n", media,
+                    percentil(r.latencias_ms, 0.5), percentil(r.latencias_ms, 0.9),
+                    percentil(r.latencias_ms, 0.99), percentil(r.latencias_ms, 1.0));
+    }
+    if (n_sse > 0) {
+        std::printf("sse: %lu eventos, %.1f/s por cliente, %lu pings", r.eventos,
+                    (double)r.eventos / total_s / n_sse, r.pings);
+        if (!r.intervalos_ms.empty())
+            std::printf(", intervalo p50 %.1f ms, max %.1f ms", percentil(r.intervalos_ms, 0.5),
+                        percentil(r.intervalos_ms, 1.0));
+        std::printf("\n");
+    }
+    std::printf("invalidas: %lu, reconexoes: %lu\n", r.invalidas, r.reconexoes);
+    return r.invalidas > 0 ? 1 : 0;
+}
@@ -0,0 +1,324 @@
+// -----------------------------------------------------------------------------
+// ingest_carga: simula milhares de estacoes mandando telemetria para o
+// estacao_ingest, com o mesmo quadro da USB (lib/telemetria_proto.h).
+//
+//   ingest_carga [ip[:porta]] [--estacoes N] [--tcp N] [--taxa HZ]
+//                [--segundos S] [--threads T] [--corromper P]
+//
+// As N estacoes (padrao 10000) mandam uma amostra a cada 1/HZ s (padrao 10,
+// o periodo de amostragem do firmware). Cada uma segue a rampa do simulador
+// (nivel de 20% a 90% e de volta em 40 s, fases diferentes), manda o quadro
+// de alerta na transicao, como a vJoystickTask, e os contadores a cada 50
+// amostras. As --tcp primeiras (padrao 1000) usam uma conexao cada, que
+// comeca com o id; as outras mandam um datagrama UDP por amostra
+// (sendmmsg em rajadas). --corromper P estraga o CRC de uma fracao P dos
+// quadros, para conferir a contagem de invalidos no servidor.
+//
+// Um quadro que nao cabe no socket e descartado e contado; a sequencia pula
+// e o servidor o ve como perdido.
+// -----------------------------------------------------------------------------
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+extern "C" {
+#include "cobs.h"
+#include "crc16.h"
+#include "telemetria_proto.h"
+}
+
+namespace {
+
+using Relogio = std::chrono::steady_clock;
+
+constexpr size_t QUADRO_MAX = COBS_TAMANHO_MAX(TELEMETRIA_CARGA_MAX + 4) + 1; // com o 0x00
+constexpr unsigned RAJADA_UDP = 64;
+constexpr size_t SAIDA_TCP_MAX = 8192;        // atraso aceito por conexao antes de descartar
+constexpr uint32_t CONTADORES_A_CADA = 50;    // amostras
+constexpr uint16_t LIMIAR_AGUA = 7000;        // CONFIG_PADRAO_LIMIAR_AGUA
+constexpr uint16_t LIMIAR_CHUVA = 8000;
+constexpr uint64_t CICLO_RAMPA_MS = 80000;    // sobe em 40 s, desce em 40 s
+
+struct Estacao {
+    uint32_t id;
+    int fd = -1; // TCP; -1 para UDP
+    uint8_t sequencia = 0;
+    bool alerta = false;
+    uint32_t amostras = 0;
+    uint64_t fase_ms;
+    Relogio::time_point proxima;
+    std::vector<uint8_t> saida; // TCP que o socket ainda nao aceitou
+};
+
+struct Resultado {
+    uint64_t quadros = 0;
+    uint64_t bytes = 0;
+    uint64_t descartados = 0;
+    uint64_t corrompidos = 0;
+};
+
+struct Parametros {
+    sockaddr_in destino{};
+    double taxa = 10;
+    double corromper = 0;
+    Relogio::time_point inicio;
+    Relogio::time_point fim;
+};
+
+// Mesma forma de hal_sim_fonte_padrao: nivel em rampa triangular, chuva fixa
+uint16_t nivel_em(uint64_t t_ms) {
+    uint64_t p = t_ms % CICLO_RAMPA_MS;
+    uint64_t meio = CICLO_RAMPA_MS / 2;
+    uint64_t subida = p < meio ? p : CICLO_RAMPA_MS - p;
+    return (uint16_t)(2000 + subida * 7000 / meio);
+}
+
+// [tipo][sequencia][carga][crc LE] em COBS, com o 0x00 no fim
+size_t montar(uint8_t tipo, uint8_t sequencia, const void *carga, size_t tamanho, bool corromper, uint8_t *saida) {
+    uint8_t quadro[sizeof(telemetria_cabecalho_t) + TELEMETRIA_CARGA_MAX + 2];
+    quadro[0] = tipo;
+    quadro[1] = sequencia;
+    std::memcpy(&quadro[2], carga, tamanho);
+    uint16_t crc = crc16(quadro, tamanho + 2);
+    if (corromper)
+        crc ^= 0x5A5A;
+    quadro[tamanho + 2] = (uint8_t)crc;
+    quadro[tamanho + 3] = (uint8_t)(crc >> 8);
+    size_t n = cobs_codificar(quadro, tamanho + 4, saida);
+    saida[n] = 0;
+    return n + 1;
+}
+
+int conectar_tcp(const sockaddr_in &destino, uint32_t id) {
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (fd < 0 || connect(fd, (const sockaddr *)&destino, sizeof(destino)) < 0) {
+        if (fd >= 0)
+            close(fd);
+        return -1;
+    }
+    uint8_t hello[4] = {(uint8_t)id, (uint8_t)(id >> 8), (uint8_t)(id >> 16), (uint8_t)(id >> 24)};
+    send(fd, hello, sizeof(hello), MSG_NOSIGNAL);
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+    return fd;
+}
+
+void escoar(Estacao &e) {
+    if (e.saida.empty())
+        return;
+    ssize_t n = send(e.fd, e.saida.data(), e.saida.size(), MSG_NOSIGNAL);
+    if (n > 0)
+        e.saida.erase(e.saida.begin(), e.saida.begin() + n);
+}
+
+void simular(std::vector<Estacao> &estacoes, const Parametros &p, Resultado &r, unsigned semente) {
+    std::mt19937 aleatorio(semente);
+    std::uniform_real_distribution<double> sorteio(0, 1);
+    auto periodo = std::chrono::duration_cast<Relogio::duration>(std::chrono::duration<double>(1.0 / p.taxa));
+
+    int udp = socket(AF_INET, SOCK_DGRAM, 0);
+    connect(udp, (const sockaddr *)&p.destino, sizeof(p.destino));
+    std::vector<uint8_t> datagramas(RAJADA_UDP * (4 + 2 * QUADRO_MAX));
+    iovec iov[RAJADA_UDP];
+    mmsghdr mensagens[RAJADA_UDP];
+    unsigned pendentes = 0;
+    auto enviar_udp = [&]() {
+        if (pendentes == 0)
+            return;
+        int enviados = sendmmsg(udp, mensagens, pendentes, 0);
+        enviados = std::max(enviados, 0);
+        for (unsigned i = 0; i < pendentes; i++) {
+            if ((int)i < enviados)
+                r.bytes += mensagens[i].msg_len;
+            else
+                r.descartados++;
+        }
+        pendentes = 0;
+    };
+
+    for (Estacao &e : estacoes)
+        e.proxima = p.inicio + std::chrono::duration_cast<Relogio::duration>(periodo * sorteio(aleatorio));
+
+    while (Relogio::now() < p.fim) {
+        auto agora = Relogio::now();
+        auto mais_cedo = agora + std::chrono::milliseconds(1);
+        for (Estacao &e : estacoes) {
+            if (e.fd >= 0)
+                escoar(e);
+            if (e.proxima > agora) {
+                mais_cedo = std::min(mais_cedo, e.proxima);
+                continue;
+            }
+            e.proxima += periodo;
+
+            // O mesmo que a vJoystickTask manda numa leitura
+            uint64_t t_ms = (uint64_t)std::chrono::duration_cast<std::chrono::milliseconds>(agora - p.inicio).count();
+            telemetria_amostra_t a{};
+            a.tempo_ms = (uint32_t)t_ms;
+            a.nivel_agua = nivel_em(t_ms + e.fase_ms);
+            a.volume_chuva = 3000;
+            a.alerta = a.nivel_agua >= LIMIAR_AGUA || a.volume_chuva >= LIMIAR_CHUVA;
+            uint8_t quadros[3 * QUADRO_MAX];
+            size_t n = 0;
+            unsigned tipos = 0;
+            auto anexar = [&](uint8_t tipo, const void *carga, size_t tamanho) {
+                bool corromper = p.corromper > 0 && sorteio(aleatorio) < p.corromper;
+                r.corrompidos += corromper;
+                n += montar(tipo, e.sequencia++, carga, tamanho, corromper, &quadros[n]);
+                tipos++;
+            };
+            anexar(TELEMETRIA_AMOSTRA, &a, sizeof(a));
+            if (a.alerta != e.alerta) {
+                anexar(TELEMETRIA_ALERTA, &a, sizeof(a));
+                e.alerta = a.alerta;
+            }
+            if (++e.amostras % CONTADORES_A_CADA == 0) {
+                telemetria_contadores_t c{};
+                c.tempo_ms = a.tempo_ms;
+                anexar(TELEMETRIA_CONTADORES, &c, sizeof(c));
+            }
+            r.quadros += tipos;
+
+            if (e.fd >= 0) {
+                if (e.saida.size() + n > SAIDA_TCP_MAX) {
+                    r.descartados += tipos;
+                    continue;
+                }
+                e.saida.insert(e.saida.end(), quadros, quadros + n);
+                size_t antes = e.saida.size();
+                escoar(e);
+                r.bytes += antes - e.saida.size();
+                continue;
+            }
+            uint8_t *d = &datagramas[pendentes * (4 + 2 * QUADRO_MAX)];
+            d[0] = (uint8_t)e.id;
+            d[1] = (uint8_t)(e.id >> 8);
+            d[2] = (uint8_t)(e.id >> 16);
+            d[3] = (uint8_t)(e.id >> 24);
+            n = std::min(n, 2 * QUADRO_MAX); // amostra, alerta e contadores juntos nao passam disso
+            std::memcpy(d + 4, quadros, n);
+            iov[pendentes] = {d, 4 + n};
+            mensagens[pendentes] = {};
+            mensagens[pendentes].msg_hdr.msg_iov = &iov[pendentes];
+            mensagens[pendentes].msg_hdr.msg_iovlen = 1;
+            if (++pendentes == RAJADA_UDP)
+                enviar_udp();
+        }
+        enviar_udp();
+        std::this_thread::sleep_until(mais_cedo);
+    }
+    for (Estacao &e : estacoes) {
+        if (e.fd >= 0)
+            close(e.fd);
+    }
+    close(udp);
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+    std::string destino = "127.0.0.1:7700";
+    unsigned n_estacoes = 10000;
+    unsigned n_tcp = 1000;
+    unsigned n_threads = 2;
+    double segundos = 10;
+    Parametros p;
+    for (int i = 1; i < argc; i++) {
+        if (std::strcmp(argv[i], "--estacoes") == 0 && i + 1 < argc)
+            n_estacoes = (unsigned)std::atoi(argv[++i]);
+        else if (std::strcmp(argv[i], "--tcp") == 0 && i + 1 < argc)
+            n_tcp = (unsigned)std::atoi(argv[++i]);
+        else if (std::strcmp(argv[i], "--taxa") == 0 && i + 1 < argc)
+            p.taxa = std::atof(argv[++i]);
+        else if (std::strcmp(argv[i], "--segundos") == 0 && i + 1 < argc)
+            segundos = std::atof(argv[++i]);
+        else if (std::strcmp(argv[i], "--threads") == 0 && i + 1 < argc)
+            n_threads = (unsigned)std::max(1, std::atoi(argv[++i]));
+        else if (std::strcmp(argv[i], "--corromper") == 0 && i + 1 < argc)
+            p.corromper = std::atof(argv[++i]);
+        else if (argv[i][0] != '-')
+            destino = argv[i];
+        else {
+            std::fprintf(stderr,
+                         "uso: %s [ip[:porta]] [--estacoes N] [--tcp N] [--taxa HZ] [--segundos S] [--threads T] "
+                         "[--corromper P]\n",
+                         argv[0]);
+            return 2;
+        }
+    }
+    n_tcp = std::min(n_tcp, n_estacoes);
+    if (p.taxa <= 0) {
+        std::fprintf(stderr, "ingest_carga: --taxa deve ser positiva\n");
+        return 2;
+    }
+
+    p.destino.sin_family = AF_INET;
+    size_t dois_pontos = destino.find(':');
+    p.destino.sin_port = htons(dois_pontos == std::string::npos ? 7700 : (uint16_t)std::atoi(destino.c_str() + dois_pontos + 1));
+    if (inet_pton(AF_INET, destino.substr(0, dois_pontos).c_str(), &p.destino.sin_addr) != 1) {
+        std::fprintf(stderr, "ingest_carga: endereco invalido: %s\n", destino.c_str());
+        return 2;
+    }
+
+    rlimit limite;
+    if (getrlimit(RLIMIT_NOFILE, &limite) == 0) {
+        limite.rlim_cur = limite.rlim_max;
+        setrlimit(RLIMIT_NOFILE, &limite);
+    }
+
+    // Estacoes distribuidas entre as threads, TCP e UDP misturados
+    std::vector<std::vector<Estacao>> grupos(n_threads);
+    std::mt19937 aleatorio(1);
+    for (unsigned i = 0; i < n_estacoes; i++) {
+        Estacao e;
+        e.id = i + 1;
+        e.fase_ms = aleatorio() % CICLO_RAMPA_MS;
+        if (i < n_tcp) {
+            e.fd = conectar_tcp(p.destino, e.id);
+            if (e.fd < 0) {
+                std::perror("ingest_carga: conexao");
+                return 1;
+            }
+        }
+        grupos[i % n_threads].push_back(std::move(e));
+    }
+
+    p.inicio = Relogio::now();
+    p.fim = p.inicio + std::chrono::duration_cast<Relogio::duration>(std::chrono::duration<double>(segundos));
+    std::vector<Resultado> resultados(n_threads);
+    std::vector<std::thread> threads;
+    for (unsigned t = 0; t < n_threads; t++)
+        threads.emplace_back(simular, std::ref(grupos[t]), std::cref(p), std::ref(resultados[t]), t + 1);
+    for (auto &t : threads)
+        t.join();
+    double total_s = std::chrono::duration<double>(Relogio::now() - p.inicio).count();
+
+    Resultado r;
+    for (const Resultado &x : resultados) {
+        r.quadros += x.quadros;
+        r.bytes += x.bytes;
+        r.descartados += x.descartados;
+        r.corrompidos += x.corrompidos;
+    }
+    std::printf("estacoes: %u (%u TCP, %u UDP) a %.1f Hz\n", n_estacoes, n_tcp, n_estacoes - n_tcp, p.taxa);
+    std::printf("quadros: %llu em %.1f s (%.0f/s, %.2f MB/s), %llu descartados no envio, %llu corrompidos\n",
+                (unsigned long long)r.quadros, total_s, (double)r.quadros / total_s, (double)r.bytes / total_s / 1e6,
+                (unsigned long long)r.descartados, (unsigned long long)r.corrompidos);
+    return 0;
+}
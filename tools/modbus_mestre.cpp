@@ -0,0 +1,423 @@
+// -----------------------------------------------------------------------------
+// modbus_mestre: mestre Modbus minimo para testar o escravo da estacao
+// (lib/modbus.h), na placa ou no simulador, pelos dois transportes.
+//
+//   modbus_mestre tcp [ip[:porta]] <comando>
+//   modbus_mestre rtu <terminal> [--baud B] [--escravo N] <comando>
+//
+// Comandos:
+//   entradas [inicio] [n]          input registers (04), decodificados
+//   retencao [inicio] [n]          holding registers (03)
+//   escrever <registrador> <v,...> um valor pela 06, varios pela 16
+//   varrer [--segundos S]          le os 18 input registers sem parar e mede
+//                                  a latencia; confere cada resposta
+//
+// A varredura acusa imagem misturada: severidade e bits que nao batem entre
+// si, contador de leituras ou tempo que volta, e a mesma leitura com
+// registradores diferentes. Sai com 1 se achar alguma.
+//
+// Padrao do tcp: 127.0.0.1:8502, a porta do estacao_virtual
+// (ESTACAO_SIM_PORTAS). No rtu, o terminal impresso pelo simulador com
+// ESTACAO_SIM_UART=pty ou o adaptador USB-RS485 da placa, a 19200 8E1.
+// -----------------------------------------------------------------------------
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <termios.h>
+#include <unistd.h>
+
+namespace {
+
+using Relogio = std::chrono::steady_clock;
+using Bytes = std::vector<uint8_t>;
+
+constexpr int ESPERA_MS = 1000;
+
+// Mesmo mapa de lib/modbus.h
+constexpr unsigned ENTRADAS = 18;
+constexpr unsigned BIT_ALERTA = 1u << 0;
+constexpr unsigned BIT_NIVEL_ACIMA = 1u << 1;
+constexpr unsigned BIT_CHUVA_ACIMA = 1u << 2;
+constexpr unsigned BIT_MQTT = 1u << 3;
+
+uint16_t crc_modbus(const uint8_t *dados, size_t tamanho) {
+    uint16_t crc = 0xFFFF;
+    for (size_t i = 0; i < tamanho; i++) {
+        crc ^= dados[i];
+        for (int b = 0; b < 8; b++)
+            crc = crc & 1 ? (uint16_t)((crc >> 1) ^ 0xA001) : (uint16_t)(crc >> 1);
+    }
+    return crc;
+}
+
+// Le exatamente n bytes ou desiste depois de ESPERA_MS sem nada
+bool ler(int fd, uint8_t *destino, size_t n) {
+    while (n > 0) {
+        pollfd p{fd, POLLIN, 0};
+        if (poll(&p, 1, ESPERA_MS) <= 0)
+            return false;
+        ssize_t lidos = read(fd, destino, n);
+        if (lidos <= 0)
+            return false;
+        destino += lidos;
+        n -= (size_t)lidos;
+    }
+    return true;
+}
+
+class Transporte {
+public:
+    virtual ~Transporte() = default;
+    // PDU de pedido -> PDU de resposta; false se nao houve resposta valida
+    virtual bool pedir(const Bytes &pdu, Bytes &resposta) = 0;
+};
+
+class Tcp : public Transporte {
+public:
+    explicit Tcp(int fd) : fd_(fd) {}
+    ~Tcp() override { close(fd_); }
+
+    bool pedir(const Bytes &pdu, Bytes &resposta) override {
+        transacao_++;
+        Bytes adu = {(uint8_t)(transacao_ >> 8), (uint8_t)transacao_, 0, 0,
+                     (uint8_t)((pdu.size() + 1) >> 8), (uint8_t)(pdu.size() + 1), 1};
+        adu.insert(adu.end(), pdu.begin(), pdu.end());
+        if (send(fd_, adu.data(), adu.size(), MSG_NOSIGNAL) != (ssize_t)adu.size())
+            return false;
+
+        uint8_t mbap[7];
+        if (!ler(fd_, mbap, sizeof(mbap)))
+            return false;
+        unsigned tamanho = (unsigned)mbap[4] << 8 | mbap[5];
+        if ((mbap[0] << 8 | mbap[1]) != transacao_ || mbap[2] != 0 || mbap[3] != 0 || tamanho < 2)
+            return false;
+        resposta.resize(tamanho - 1);
+        return ler(fd_, resposta.data(), resposta.size());
+    }
+
+private:
+    int fd_;
+    uint16_t transacao_ = 0;
+};
+
+class Rtu : public Transporte {
+public:
+    Rtu(int fd, uint8_t escravo) : fd_(fd), escravo_(escravo) {}
+    ~Rtu() override { close(fd_); }
+
+    bool pedir(const Bytes &pdu, Bytes &resposta) override {
+        Bytes quadro = {escravo_};
+        quadro.insert(quadro.end(), pdu.begin(), pdu.end());
+        uint16_t crc = crc_modbus(quadro.data(), quadro.size());
+        quadro.push_back((uint8_t)crc);
+        quadro.push_back((uint8_t)(crc >> 8));
+        tcflush(fd_, TCIFLUSH); // resto de uma resposta atrasada
+        if (write(fd_, quadro.data(), quadro.size()) != (ssize_t)quadro.size())
+            return false;
+
+        // Endereco e funcao dizem o tamanho do resto
+        uint8_t r[260];
+        if (!ler(fd_, r, 3))
+            return false;
+        size_t total;
+        if (r[1] & 0x80)
+            total = 5;
+        else if (r[1] == 0x03 || r[1] == 0x04)
+            total = 5u + r[2];
+        else
+            total = 8;
+        if (!ler(fd_, r + 3, total - 3))
+            return false;
+        if (r[0] != escravo_ || crc_modbus(r, total - 2) != (uint16_t)(r[total - 2] | r[total - 1] << 8))
+            return false;
+        resposta.assign(r + 1, r + total - 2);
+        return true;
+    }
+
+private:
+    int fd_;
+    uint8_t escravo_;
+};
+
+std::unique_ptr<Transporte> abrir_tcp(const std::string &destino) {
+    sockaddr_in endereco{};
+    endereco.sin_family = AF_INET;
+    size_t dois_pontos = destino.find(':');
+    endereco.sin_port = htons(dois_pontos == std::string::npos ? 502 : (uint16_t)std::atoi(destino.c_str() + dois_pontos + 1));
+    if (inet_pton(AF_INET, destino.substr(0, dois_pontos).c_str(), &endereco.sin_addr) != 1) {
+        std::fprintf(stderr, "modbus_mestre: endereco invalido: %s\n", destino.c_str());
+        return nullptr;
+    }
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (fd < 0 || connect(fd, (const sockaddr *)&endereco, sizeof(endereco)) < 0) {
+        std::perror("modbus_mestre: conexao");
+        if (fd >= 0)
+            close(fd);
+        return nullptr;
+    }
+    int um = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &um, sizeof(um));
+    return std::make_unique<Tcp>(fd);
+}
+
+speed_t velocidade(long baud) {
+    switch (baud) {
+    case 9600: return B9600;
+    case 19200: return B19200;
+    case 38400: return B38400;
+    case 57600: return B57600;
+    case 115200: return B115200;
+    default: return 0;
+    }
+}
+
+std::unique_ptr<Transporte> abrir_rtu(const std::string &terminal, long baud, uint8_t escravo) {
+    speed_t v = velocidade(baud);
+    if (v == 0) {
+        std::fprintf(stderr, "modbus_mestre: baud nao suportado: %ld\n", baud);
+        return nullptr;
+    }
+    int fd = open(terminal.c_str(), O_RDWR | O_NOCTTY);
+    if (fd < 0) {
+        std::perror(terminal.c_str());
+        return nullptr;
+    }
+    termios t{};
+    tcgetattr(fd, &t);
+    cfmakeraw(&t);
+    t.c_cflag |= PARENB | CLOCAL | CREAD; // 8E1
+    t.c_cflag &= ~(PARODD | CSTOPB);
+    cfsetispeed(&t, v);
+    cfsetospeed(&t, v);
+    tcsetattr(fd, TCSANOW, &t);
+    return std::make_unique<Rtu>(fd, escravo);
+}
+
+Bytes pdu_leitura(uint8_t funcao, unsigned inicio, unsigned n) {
+    return {funcao, (uint8_t)(inicio >> 8), (uint8_t)inicio, (uint8_t)(n >> 8), (uint8_t)n};
+}
+
+const char *nome_excecao(uint8_t codigo) {
+    switch (codigo) {
+    case 1: return "funcao ilegal";
+    case 2: return "endereco ilegal";
+    case 3: return "valor ilegal";
+    default: return "desconhecida";
+    }
+}
+
+// Registradores da resposta de 03/04; false (e mensagem) para excecao
+bool ler_registradores(Transporte &t, uint8_t funcao, unsigned inicio, unsigned n, std::vector<uint16_t> &regs) {
+    Bytes r;
+    if (!t.pedir(pdu_leitura(funcao, inicio, n), r) || r.empty()) {
+        std::fprintf(stderr, "modbus_mestre: sem resposta\n");
+        return false;
+    }
+    if (r[0] == (funcao | 0x80) && r.size() >= 2) {
+        std::fprintf(stderr, "modbus_mestre: excecao %u (%s)\n", r[1], nome_excecao(r[1]));
+        return false;
+    }
+    if (r[0] != funcao || r.size() != 2u + 2u * n || r[1] != 2 * n) {
+        std::fprintf(stderr, "modbus_mestre: resposta malformada\n");
+        return false;
+    }
+    regs.resize(n);
+    for (unsigned i = 0; i < n; i++)
+        regs[i] = (uint16_t)(r[2 + 2 * i] << 8 | r[3 + 2 * i]);
+    return true;
+}
+
+uint32_t par(const std::vector<uint16_t> &regs, unsigned i) {
+    return (uint32_t)regs[i] << 16 | regs[i + 1];
+}
+
+void mostrar_entradas(const std::vector<uint16_t> &e) {
+    std::printf("nivel %.2f%%  chuva %.2f%%  severidade %u  bits 0x%x (alerta %u, nivel %u, chuva %u, mqtt %u)\n",
+                e[0] / 100.0, e[1] / 100.0, e[2], e[3], !!(e[3] & BIT_ALERTA), !!(e[3] & BIT_NIVEL_ACIMA),
+                !!(e[3] & BIT_CHUVA_ACIMA), !!(e[3] & BIT_MQTT));
+    std::printf("leituras %u  tempo %u ms  alertas %u\n", par(e, 4), par(e, 6), par(e, 8));
+    std::printf("descartes: telemetria %u, log %u, capturas %u, tlog %u\n", par(e, 10), par(e, 12), par(e, 14),
+                par(e, 16));
+}
+
+// Uma imagem coerente: os bits e a severidade vem da mesma leitura
+bool coerente(const std::vector<uint16_t> &e) {
+    unsigned acima = !!(e[3] & BIT_NIVEL_ACIMA) + !!(e[3] & BIT_CHUVA_ACIMA);
+    return e[2] == acima && !!(e[3] & BIT_ALERTA) == (acima > 0);
+}
+
+double percentil(std::vector<double> &v, double p) {
+    if (v.empty())
+        return 0;
+    size_t i = std::min(v.size() - 1, (size_t)(p * (double)v.size()));
+    std::nth_element(v.begin(), v.begin() + (long)i, v.end());
+    return v[i];
+}
+
+int varrer(Transporte &t, double segundos) {
+    std::vector<double> latencias_ms;
+    std::vector<uint16_t> anterior;
+    unsigned long falhas = 0;
+    unsigned long incoerentes = 0;
+    unsigned long imagens = 0;
+
+    auto inicio = Relogio::now();
+    auto fim = inicio + std::chrono::duration_cast<Relogio::duration>(std::chrono::duration<double>(segundos));
+    while (Relogio::now() < fim) {
+        std::vector<uint16_t> e;
+        auto antes = Relogio::now();
+        if (!ler_registradores(t, 0x04, 0, ENTRADAS, e)) {
+            falhas++;
+            continue;
+        }
+        latencias_ms.push_back(std::chrono::duration<double, std::milli>(Relogio::now() - antes).count());
+
+        bool ok = coerente(e);
+        if (!anterior.empty()) {
+            uint32_t leituras = par(e, 4), leituras_antes = par(anterior, 4);
+            if (leituras == leituras_antes)
+                ok = ok && e == anterior;
+            else
+                ok = ok && leituras > leituras_antes && par(e, 6) >= par(anterior, 6);
+            imagens += leituras != leituras_antes;
+        }
+        if (!ok) {
+            incoerentes++;
+            mostrar_entradas(e);
+        }
+        anterior = e;
+    }
+    double total_s = std::chrono::duration<double>(Relogio::now() - inicio).count();
+
+    std::printf("pedidos: %zu em %.1f s, %.1f/s; %lu imagens novas, %lu sem resposta\n", latencias_ms.size(),
+                total_s, (double)latencias_ms.size() / total_s, imagens, falhas);
+    if (!latencias_ms.empty())
+        std::printf("latencia (ms): p50 %.3f, p90 %.3f, p99 %.3f, max %.3f\n", percentil(latencias_ms, 0.5),
+                    percentil(latencias_ms, 0.9), percentil(latencias_ms, 0.99), percentil(latencias_ms, 1.0));
+    std::printf("incoerentes: %lu\n", incoerentes);
+    return incoerentes > 0 || latencias_ms.empty() ? 1 : 0;
+}
+
+int escrever(Transporte &t, unsigned registrador, const std::string &lista) {
+    std::vector<uint16_t> valores;
+    for (const char *p = lista.c_str(); *p;) {
+        char *fim;
+        unsigned long v = std::strtoul(p, &fim, 0);
+        if (fim == p || v > 0xFFFF) {
+            std::fprintf(stderr, "modbus_mestre: valor invalido: %s\n", p);
+            return 2;
+        }
+        valores.push_back((uint16_t)v);
+        p = *fim == ',' ? fim + 1 : fim;
+    }
+    Bytes pdu;
+    if (valores.size() == 1) {
+        pdu = {0x06, (uint8_t)(registrador >> 8), (uint8_t)registrador, (uint8_t)(valores[0] >> 8),
+               (uint8_t)valores[0]};
+    } else {
+        pdu = pdu_leitura(0x10, registrador, (unsigned)valores.size());
+        pdu.push_back((uint8_t)(2 * valores.size()));
+        for (uint16_t v : valores) {
+            pdu.push_back((uint8_t)(v >> 8));
+            pdu.push_back((uint8_t)v);
+        }
+    }
+    Bytes r;
+    if (!t.pedir(pdu, r) || r.empty()) {
+        std::fprintf(stderr, "modbus_mestre: sem resposta\n");
+        return 1;
+    }
+    if (r[0] & 0x80) {
+        std::fprintf(stderr, "modbus_mestre: excecao %u (%s)\n", r.size() > 1 ? r[1] : 0,
+                     nome_excecao(r.size() > 1 ? r[1] : 0));
+        return 1;
+    }
+    std::printf("ok: %zu registrador(es) a partir de %u\n", valores.size(), registrador);
+    return 0;
+}
+
+int uso(const char *programa) {
+    std::fprintf(stderr,
+                 "uso: %s tcp [ip[:porta]] <comando>\n"
+                 "     %s rtu <terminal> [--baud B] [--escravo N] <comando>\n"
+                 "comandos: entradas [inicio] [n] | retencao [inicio] [n] | escrever <reg> <v,...> | "
+                 "varrer [--segundos S]\n",
+                 programa, programa);
+    return 2;
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+    if (argc < 2)
+        return uso(argv[0]);
+    std::string modo = argv[1];
+    std::vector<std::string> args;
+    std::string destino = modo == "tcp" ? "127.0.0.1:8502" : "";
+    long baud = 19200;
+    int escravo = 1;
+    double segundos = 10;
+    for (int i = 2; i < argc; i++) {
+        if (std::strcmp(argv[i], "--baud") == 0 && i + 1 < argc)
+            baud = std::atol(argv[++i]);
+        else if (std::strcmp(argv[i], "--escravo") == 0 && i + 1 < argc)
+            escravo = std::atoi(argv[++i]);
+        else if (std::strcmp(argv[i], "--segundos") == 0 && i + 1 < argc)
+            segundos = std::atof(argv[++i]);
+        else if (argv[i][0] == '-')
+            return uso(argv[0]);
+        else
+            args.push_back(argv[i]);
+    }
+    // O primeiro argumento e o destino se nao for um comando
+    static const char *comandos[] = {"entradas", "retencao", "escrever", "varrer"};
+    if (!args.empty() && std::none_of(std::begin(comandos), std::end(comandos),
+                                      [&](const char *c) { return args[0] == c; })) {
+        destino = args[0];
+        args.erase(args.begin());
+    }
+    if (args.empty() || destino.empty() || (modo != "tcp" && modo != "rtu"))
+        return uso(argv[0]);
+
+    std::unique_ptr<Transporte> t =
+        modo == "tcp" ? abrir_tcp(destino) : abrir_rtu(destino, baud, (uint8_t)escravo);
+    if (!t)
+        return 1;
+
+    const std::string &comando = args[0];
+    unsigned a = args.size() > 1 ? (unsigned)std::strtoul(args[1].c_str(), nullptr, 0) : 0;
+    if (comando == "entradas" || comando == "retencao") {
+        bool entradas = comando == "entradas";
+        unsigned n = args.size() > 2 ? (unsigned)std::strtoul(args[2].c_str(), nullptr, 0)
+                                     : (entradas ? ENTRADAS - a : 12 - std::min(a, 12u));
+        std::vector<uint16_t> regs;
+        if (!ler_registradores(*t, entradas ? 0x04 : 0x03, a, n, regs))
+            return 1;
+        if (entradas && a == 0 && n == ENTRADAS) {
+            mostrar_entradas(regs);
+        } else {
+            for (unsigned i = 0; i < n; i++)
+                std::printf("%u: %u (0x%04x)\n", a + i, regs[i], regs[i]);
+        }
+        return 0;
+    }
+    if (comando == "escrever" && args.size() == 3)
+        return escrever(*t, a, args[2]);
+    if (comando == "varrer")
+        return varrer(*t, segundos);
+    return uso(argv[0]);
+}
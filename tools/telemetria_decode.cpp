@@ -0,0 +1,229 @@
+// -----------------------------------------------------------------------------
+// telemetria_decode: le o fluxo binario da estacao (USB CDC) e imprime os
+// quadros em CSV, verificando COBS, CRC e lacunas de sequencia.
+//
+//   telemetria_decode /dev/ttyACM0      (porta serial, configurada em modo raw)
+//   telemetria_decode captura.bin       (arquivo gravado antes)
+//   telemetria_decode -                 (entrada padrao)
+//
+// Com --tlog PiscaLed.tlog, as entradas do log tokenizado sao formatadas
+// usando a tabela de strings extraida do ELF no build do firmware.
+//
+// Comandos do shell podem ser enviados pela mesma porta, de outro terminal:
+//   echo "set limiar_agua 65.5" > /dev/ttyACM0
+// e as respostas aparecem aqui como linhas "resposta,...".
+// -----------------------------------------------------------------------------
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+#include <fcntl.h>
+#include <termios.h>
+#include <unistd.h>
+
+extern "C" {
+#include "cobs.h"
+#include "crc16.h"
+#include "telemetria_proto.h"
+#include "tlog_proto.h"
+}
+
+namespace {
+
+struct Estatisticas {
+    unsigned long quadros = 0;
+    unsigned long invalidos = 0;   // COBS ou CRC
+    unsigned long perdidos = 0;    // lacunas de sequencia
+    bool primeira = true;
+    uint8_t esperada = 0;
+};
+
+std::vector<char> tabela_tlog;
+
+// Reproduz o printf com os argumentos crus: cada especificador consome uma
+// palavra; f/e/g/a reinterpretam os bits como float.
+std::string formatar_tlog(uint32_t id, const uint32_t *args, uint32_t n) {
+    if (id >= tabela_tlog.size())
+        return "<id " + std::to_string(id) + " fora da tabela>";
+
+    const char *fmt = &tabela_tlog[id];
+    std::string saida;
+    uint32_t usado = 0;
+    char pedaco[64];
+
+    while (*fmt) {
+        if (*fmt != '%') {
+            saida += *fmt++;
+            continue;
+        }
+        if (fmt[1] == '%') {
+            saida += '%';
+            fmt += 2;
+            continue;
+        }
+        std::string spec = "%";
+        fmt++;
+        while (*fmt && std::strchr("-+ #0123456789.hlzjt", *fmt))
+            spec += *fmt++;
+        char conversao = *fmt ? *fmt++ : 'u';
+        uint32_t valor = usado < n ? args[usado++] : 0;
+
+        // Os modificadores de tamanho sao descartados: todo argumento tem 32 bits
+        std::string base;
+        for (char c : spec)
+            if (!std::strchr("hlzjt", c))
+                base += c;
+
+        if (std::strchr("fFeEgGaA", conversao)) {
+            float f;
+            std::memcpy(&f, &valor, sizeof(f));
+            std::snprintf(pedaco, sizeof(pedaco), (base + conversao).c_str(), (double)f);
+        } else if (conversao == 'd' || conversao == 'i') {
+            std::snprintf(pedaco, sizeof(pedaco), (base + 'd').c_str(), (int)(int32_t)valor);
+        } else if (conversao == 'c') {
+            std::snprintf(pedaco, sizeof(pedaco), (base + 'c').c_str(), (int)valor);
+        } else if (std::strchr("uxXo", conversao)) {
+            std::snprintf(pedaco, sizeof(pedaco), (base + conversao).c_str(), (unsigned)valor);
+        } else {
+            std::snprintf(pedaco, sizeof(pedaco), "<%%%c?>", conversao);
+        }
+        saida += pedaco;
+    }
+    return saida;
+}
+
+template <typename T>
+bool carga(const uint8_t *dados, size_t tamanho, T &saida) {
+    if (tamanho != sizeof(T))
+        return false;
+    std::memcpy(&saida, dados, sizeof(T));
+    return true;
+}
+
+void processar(const std::vector<uint8_t> &codificado, Estatisticas &est) {
+    uint8_t quadro[COBS_TAMANHO_MAX(TELEMETRIA_CARGA_MAX + 4)];
+    if (codificado.empty() || codificado.size() > sizeof(quadro)) {
+        est.invalidos++;
+        return;
+    }
+    size_t n = cobs_decodificar(codificado.data(), codificado.size(), quadro);
+    if (n < sizeof(telemetria_cabecalho_t) + 2) {
+        est.invalidos++;
+        return;
+    }
+    uint16_t crc = (uint16_t)(quadro[n - 2] | (quadro[n - 1] << 8));
+    if (crc16(quadro, n - 2) != crc) {
+        est.invalidos++;
+        return;
+    }
+
+    telemetria_cabecalho_t cab;
+    std::memcpy(&cab, quadro, sizeof(cab));
+    int lacuna = est.primeira ? 0 : telemetria_lacuna(est.esperada, cab.sequencia);
+    if (lacuna > 0)
+        est.perdidos += (unsigned long)lacuna;
+    est.primeira = false;
+    if (lacuna >= 0)
+        est.esperada = (uint8_t)(cab.sequencia + 1);
+    est.quadros++;
+
+    const uint8_t *dados = quadro + sizeof(cab);
+    size_t tamanho = n - sizeof(cab) - 2;
+    telemetria_amostra_t a;
+    telemetria_contadores_t c;
+
+    switch (cab.tipo) {
+    case TELEMETRIA_AMOSTRA:
+    case TELEMETRIA_ALERTA:
+        if (carga(dados, tamanho, a))
+            std::printf("%s,%u,%.2f,%.2f,%u\n", cab.tipo == TELEMETRIA_ALERTA ? "alerta" : "amostra",
+                        a.tempo_ms, a.nivel_agua / 100.0, a.volume_chuva / 100.0, a.alerta);
+        break;
+    case TELEMETRIA_CONTADORES:
+        if (carga(dados, tamanho, c))
+            std::printf("contadores,%u,telemetria=%u,log=%u,capturas=%u,tlog=%u\n", c.tempo_ms,
+                        c.telemetria_descartados, c.log_descartados, c.capturas_perdidas,
+                        c.tlog_descartados);
+        break;
+    case TELEMETRIA_LOG: {
+        uint32_t palavras[TLOG_ENTRADA_MAX];
+        if (tamanho < 8 || tamanho > sizeof(palavras) || tamanho % 4 != 0)
+            break;
+        std::memcpy(palavras, dados, tamanho);
+        uint32_t id = TLOG_ID(palavras[0]);
+        uint32_t n = std::min<uint32_t>(TLOG_ARGS(palavras[0]), tamanho / 4 - 2);
+        if (tabela_tlog.empty())
+            std::printf("log,%u,id=%u,args=%u\n", palavras[1], id, n);
+        else
+            std::printf("log,%u,\"%s\"\n", palavras[1], formatar_tlog(id, palavras + 2, n).c_str());
+        break;
+    }
+    case TELEMETRIA_RESPOSTA:
+        std::printf("resposta,\"%.*s\"\n", (int)tamanho, reinterpret_cast<const char *>(dados));
+        break;
+    default:
+        std::printf("desconhecido,%u,tipo=%u,bytes=%zu\n", 0u, cab.tipo, tamanho);
+        break;
+    }
+}
+
+void configurar_serial(int fd) {
+    termios t;
+    if (tcgetattr(fd, &t) != 0)
+        return; // nao e terminal (arquivo ou pipe)
+    cfmakeraw(&t);
+    t.c_cc[VMIN] = 1;
+    t.c_cc[VTIME] = 0;
+    tcsetattr(fd, TCSANOW, &t);
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+    const char *origem = nullptr;
+    for (int i = 1; i < argc; i++) {
+        if (std::strcmp(argv[i], "--tlog") == 0 && i + 1 < argc) {
+            std::ifstream tabela(argv[++i], std::ios::binary);
+            tabela_tlog.assign(std::istreambuf_iterator<char>(tabela), std::istreambuf_iterator<char>());
+            tabela_tlog.push_back('\0');
+        } else {
+            origem = argv[i];
+        }
+    }
+    if (!origem) {
+        std::fprintf(stderr, "uso: %s [--tlog PiscaLed.tlog] <porta|arquivo|->\n", argv[0]);
+        return 2;
+    }
+
+    int fd = std::strcmp(origem, "-") == 0 ? STDIN_FILENO : open(origem, O_RDONLY | O_NOCTTY);
+    if (fd < 0) {
+        std::perror(origem);
+        return 1;
+    }
+    configurar_serial(fd);
+
+    Estatisticas est;
+    std::vector<uint8_t> atual;
+    uint8_t buffer[4096];
+    ssize_t lidos;
+    while ((lidos = read(fd, buffer, sizeof(buffer))) > 0) {
+        for (ssize_t i = 0; i < lidos; i++) {
+            if (buffer[i] == 0) {
+                processar(atual, est);
+                atual.clear();
+            } else {
+                atual.push_back(buffer[i]);
+            }
+        }
+        std::fflush(stdout);
+    }
+
+    std::fprintf(stderr, "%lu quadros, %lu invalidos, %lu perdidos (lacunas de sequencia)\n",
+                 est.quadros, est.invalidos, est.perdidos);
+    return 0;
+}